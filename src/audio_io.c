@@ -6,14 +6,40 @@
 #include <unistd.h>
 #include <errno.h>
 #include <alloca.h>
+
+// ALSA's name for each sample_format_t, in order of preference
+static const snd_pcm_format_t alsa_formats[SAMPLE_FORMAT_COUNT] = {
+    SND_PCM_FORMAT_FLOAT_LE,
+    SND_PCM_FORMAT_S32_LE,
+    SND_PCM_FORMAT_S24_3LE,
+    SND_PCM_FORMAT_S16_LE,
+};
+
+/**
+ * The first format in alsa_formats the device takes, or -1. Opened with
+ * SND_PCM_NO_AUTO_FORMAT, the plug layer only offers what the hardware has.
+ */
+static int audio_native_format(snd_pcm_t *handle) {
+    snd_pcm_hw_params_t *hw_params;
+    snd_pcm_hw_params_alloca(&hw_params);
+    
+    if (snd_pcm_hw_params_any(handle, hw_params) < 0) {
+        return -1;
+    }
+    for (int f = 0; f < SAMPLE_FORMAT_COUNT; f++) {
+        if (snd_pcm_hw_params_test_format(handle, hw_params, alsa_formats[f]) == 0) {
+            return f;
+        }
+    }
+    return -1;
+}
+
 /**
  * Common PCM setup for both capture and playback.
  */
-static int audio_setup_pcm(snd_pcm_t *handle,
-                           unsigned int sample_rate,
-                           unsigned int channels,
-                           size_t period_size,
-                           snd_pcm_stream_t stream_type) {
+static int audio_setup_pcm(audio_device_t *dev, const audio_device_config_t *config) {
+    snd_pcm_t *handle = dev->handle;
+    unsigned int sample_rate = config->sample_rate;
     snd_pcm_hw_params_t *hw_params;
     int err;
     
@@ -26,17 +52,29 @@ static int audio_setup_pcm(snd_pcm_t *handle,
         return err;
     }
     
-    // Set access type (interleaved)
-    err = snd_pcm_hw_params_set_access(handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    // Set access type (interleaved), preferring direct DMA access when asked
+    snd_pcm_access_t access = SND_PCM_ACCESS_RW_INTERLEAVED;
+    dev->mmap = false;
+    if (config->use_mmap) {
+        if (snd_pcm_hw_params_test_access(handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0) {
+            access = SND_PCM_ACCESS_MMAP_INTERLEAVED;
+            dev->mmap = true;
+        } else {
+            fprintf(stderr, "Note: %s device has no mmap access, using read/write\n",
+                    dev->stream == SND_PCM_STREAM_CAPTURE ? "capture" : "playback");
+        }
+    }
+    err = snd_pcm_hw_params_set_access(handle, hw_params, access);
     if (err < 0) {
         fprintf(stderr, "Cannot set access type: %s\n", snd_strerror(err));
         return err;
     }
     
-    // Set sample format (32-bit float)
-    err = snd_pcm_hw_params_set_format(handle, hw_params, SND_PCM_FORMAT_FLOAT_LE);
+    // Set sample format (picked by audio_device_open)
+    err = snd_pcm_hw_params_set_format(handle, hw_params, alsa_formats[dev->format]);
     if (err < 0) {
-        fprintf(stderr, "Cannot set sample format: %s\n", snd_strerror(err));
+        fprintf(stderr, "Cannot set sample format %s: %s\n",
+                sample_format_name(dev->format), snd_strerror(err));
         return err;
     }
     
@@ -47,27 +85,27 @@ static int audio_setup_pcm(snd_pcm_t *handle,
         fprintf(stderr, "Cannot set sample rate: %s\n", snd_strerror(err));
         return err;
     }
-    if (actual_rate != sample_rate) {
-        fprintf(stderr, "Warning: Requested rate %u Hz, got %u Hz\n", sample_rate, actual_rate);
-    }
+    // Callers convert from whatever the hardware settled on
+    dev->sample_rate = actual_rate;
     
     // Set number of channels
-    err = snd_pcm_hw_params_set_channels(handle, hw_params, channels);
+    err = snd_pcm_hw_params_set_channels(handle, hw_params, config->channels);
     if (err < 0) {
         fprintf(stderr, "Cannot set channel count: %s\n", snd_strerror(err));
         return err;
     }
     
     // Set period size
-    snd_pcm_uframes_t period_frames = period_size;
+    snd_pcm_uframes_t period_frames = config->period_size;
     err = snd_pcm_hw_params_set_period_size_near(handle, hw_params, &period_frames, 0);
     if (err < 0) {
         fprintf(stderr, "Cannot set period size: %s\n", snd_strerror(err));
         return err;
     }
     
-    // Set buffer size (4 periods)
-    snd_pcm_uframes_t buffer_frames = period_frames * 4;
+    // Set buffer size (period_count periods of whatever period we were granted)
+    unsigned int period_count = config->period_count ? config->period_count : 4;
+    snd_pcm_uframes_t buffer_frames = period_frames * period_count;
     err = snd_pcm_hw_params_set_buffer_size_near(handle, hw_params, &buffer_frames);
     if (err < 0) {
         fprintf(stderr, "Cannot set buffer size: %s\n", snd_strerror(err));
@@ -81,6 +119,21 @@ static int audio_setup_pcm(snd_pcm_t *handle,
         return err;
     }
     
+    // Record what the driver actually granted; it may differ from the request
+    err = snd_pcm_hw_params_get_period_size(hw_params, &period_frames, 0);
+    if (err < 0) {
+        fprintf(stderr, "Cannot read back period size: %s\n", snd_strerror(err));
+        return err;
+    }
+    err = snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_frames);
+    if (err < 0) {
+        fprintf(stderr, "Cannot read back buffer size: %s\n", snd_strerror(err));
+        return err;
+    }
+    dev->period_size = period_frames;
+    dev->buffer_size = buffer_frames;
+    dev->period_count = (unsigned int)(buffer_frames / period_frames);
+    
     // Prepare device
     err = snd_pcm_prepare(handle);
     if (err < 0) {
@@ -91,67 +144,267 @@ static int audio_setup_pcm(snd_pcm_t *handle,
     return 0;
 }
 
-audio_device_t* audio_capture_open(const char *device_name,
-                                    unsigned int sample_rate,
-                                    unsigned int channels,
-                                    size_t period_size) {
+void audio_device_config_init(audio_device_config_t *config,
+                              const char *device_name,
+                              unsigned int sample_rate,
+                              unsigned int channels,
+                              size_t period_size) {
+    config->device_name = device_name;
+    config->sample_rate = sample_rate;
+    config->channels = channels;
+    config->period_size = period_size;
+    config->period_count = 4;
+    config->use_mmap = false;
+    config->format = SAMPLE_FORMAT_AUTO;
+    config->dither = true;
+}
+
+audio_device_t* audio_device_open(const audio_device_config_t *config,
+                                  snd_pcm_stream_t stream) {
+    const char *direction = stream == SND_PCM_STREAM_CAPTURE ? "capture" : "playback";
+    if (config->format != SAMPLE_FORMAT_AUTO &&
+        (config->format < 0 || config->format >= SAMPLE_FORMAT_COUNT)) {
+        fprintf(stderr, "Cannot open %s device %s: unknown sample format %d\n",
+                direction, config->device_name, config->format);
+        return NULL;
+    }
+    
     audio_device_t *dev = malloc(sizeof(audio_device_t));
     if (!dev) {
         return NULL;
     }
     
-    int err = snd_pcm_open(&dev->handle, device_name, SND_PCM_STREAM_CAPTURE, 0);
+    bool pick = config->format == SAMPLE_FORMAT_AUTO;
+    int err = snd_pcm_open(&dev->handle, config->device_name, stream,
+                           pick ? SND_PCM_NO_AUTO_FORMAT : 0);
     if (err < 0) {
-        fprintf(stderr, "Cannot open capture device %s: %s\n", device_name, snd_strerror(err));
+        fprintf(stderr, "Cannot open %s device %s: %s\n",
+                direction, config->device_name, snd_strerror(err));
         free(dev);
         return NULL;
     }
     
-    err = audio_setup_pcm(dev->handle, sample_rate, channels, period_size, SND_PCM_STREAM_CAPTURE);
+    dev->format = pick ? SAMPLE_FORMAT_F32 : (sample_format_t)config->format;
+    if (pick) {
+        int native = audio_native_format(dev->handle);
+        if (native >= 0) {
+            dev->format = (sample_format_t)native;
+        } else {
+            // Nothing we can convert ourselves: let alsa-lib convert to float
+            fprintf(stderr, "Note: %s device has no native format we handle, "
+                    "converting in alsa-lib\n", direction);
+            snd_pcm_close(dev->handle);
+            err = snd_pcm_open(&dev->handle, config->device_name, stream, 0);
+            if (err < 0) {
+                fprintf(stderr, "Cannot open %s device %s: %s\n",
+                        direction, config->device_name, snd_strerror(err));
+                free(dev);
+                return NULL;
+            }
+        }
+    }
+    
+    dev->stream = stream;
+    dev->sample_rate = config->sample_rate;
+    dev->channels = config->channels;
+    dev->mmap_offset = 0;
+    dev->convert = NULL;
+    dev->use_dither = config->dither && stream == SND_PCM_STREAM_PLAYBACK &&
+                      (dev->format == SAMPLE_FORMAT_S16 || dev->format == SAMPLE_FORMAT_S24_3);
+    sample_dither_init(&dev->dither, 1);
+    atomic_init(&dev->xruns, 0);
+    atomic_init(&dev->suspends, 0);
+    
+    err = audio_setup_pcm(dev, config);
     if (err < 0) {
         snd_pcm_close(dev->handle);
         free(dev);
         return NULL;
     }
     
-    dev->sample_rate = sample_rate;
-    dev->channels = channels;
-    dev->period_size = period_size;
+    // Read/write access converts through a period of the device format;
+    // mmap access converts straight out of or into the DMA area
+    if (dev->format != SAMPLE_FORMAT_F32 && !dev->mmap) {
+        dev->convert = malloc(dev->period_size * dev->channels * sample_format_bytes(dev->format));
+        if (!dev->convert) {
+            fprintf(stderr, "Cannot allocate %s conversion buffer\n", direction);
+            snd_pcm_close(dev->handle);
+            free(dev);
+            return NULL;
+        }
+    }
     
     return dev;
 }
 
+audio_device_t* audio_capture_open(const char *device_name,
+                                    unsigned int sample_rate,
+                                    unsigned int channels,
+                                    size_t period_size) {
+    audio_device_config_t config;
+    audio_device_config_init(&config, device_name, sample_rate, channels, period_size);
+    return audio_device_open(&config, SND_PCM_STREAM_CAPTURE);
+}
+
 audio_device_t* audio_playback_open(const char *device_name,
                                      unsigned int sample_rate,
                                      unsigned int channels,
                                      size_t period_size) {
-    audio_device_t *dev = malloc(sizeof(audio_device_t));
-    if (!dev) {
-        return NULL;
+    audio_device_config_t config;
+    audio_device_config_init(&config, device_name, sample_rate, channels, period_size);
+    return audio_device_open(&config, SND_PCM_STREAM_PLAYBACK);
+}
+
+/**
+ * audio_device_mmap_begin in the device's own format.
+ */
+static ssize_t audio_mmap_area_begin(audio_device_t *dev, void **area, size_t frames) {
+    int err;
+    
+    // Capture in mmap mode never auto-starts; kick it after open or recovery
+    if (dev->stream == SND_PCM_STREAM_CAPTURE &&
+        snd_pcm_state(dev->handle) == SND_PCM_STATE_PREPARED) {
+        err = snd_pcm_start(dev->handle);
+        if (err < 0) {
+            return audio_device_recover(dev, err);
+        }
     }
     
-    int err = snd_pcm_open(&dev->handle, device_name, SND_PCM_STREAM_PLAYBACK, 0);
-    if (err < 0) {
-        fprintf(stderr, "Cannot open playback device %s: %s\n", device_name, snd_strerror(err));
-        free(dev);
-        return NULL;
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(dev->handle);
+    if (avail < 0) {
+        return audio_device_recover(dev, (int)avail);
+    }
+    
+    // Block until a full request fits; a not-yet-started playback device
+    // always has its whole buffer free, so this can't stall before start
+    while ((size_t)avail < frames) {
+        err = snd_pcm_wait(dev->handle, 1000);
+        if (err < 0) {
+            return audio_device_recover(dev, err);
+        }
+        avail = snd_pcm_avail_update(dev->handle);
+        if (avail < 0) {
+            return audio_device_recover(dev, (int)avail);
+        }
     }
     
-    err = audio_setup_pcm(dev->handle, sample_rate, channels, period_size, SND_PCM_STREAM_PLAYBACK);
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t contiguous = frames;
+    
+    err = snd_pcm_mmap_begin(dev->handle, &areas, &offset, &contiguous);
     if (err < 0) {
-        snd_pcm_close(dev->handle);
-        free(dev);
-        return NULL;
+        return audio_device_recover(dev, err);
+    }
+    
+    // Interleaved: every channel shares one area, first/step are in bits
+    dev->mmap_offset = offset;
+    *area = (char*)areas[0].addr + areas[0].first / 8 + offset * (areas[0].step / 8);
+    return (ssize_t)contiguous;
+}
+
+ssize_t audio_device_mmap_begin(audio_device_t *dev, float **area, size_t frames) {
+    if (dev->format != SAMPLE_FORMAT_F32) {
+        return -EINVAL;
     }
     
-    dev->sample_rate = sample_rate;
-    dev->channels = channels;
-    dev->period_size = period_size;
+    void *raw;
+    ssize_t n = audio_mmap_area_begin(dev, &raw, frames);
+    *area = (float*)raw;
+    return n;
+}
+
+int audio_device_mmap_commit(audio_device_t *dev, size_t frames) {
+    snd_pcm_sframes_t result = snd_pcm_mmap_commit(dev->handle, dev->mmap_offset, frames);
     
-    return dev;
+    if (result < 0) {
+        return audio_device_recover(dev, (int)result);
+    }
+    if ((size_t)result != frames) {
+        return audio_device_recover(dev, -EPIPE);
+    }
+    return 0;
+}
+
+/**
+ * Copy-based transfer on top of the mmap API so read/write work in both
+ * modes, converting between float and the device format on the way.
+ */
+static ssize_t audio_mmap_transfer(audio_device_t *dev, float *capture_dst,
+                                   const float *playback_src, size_t frames) {
+    size_t done = 0;
+    
+    while (done < frames) {
+        void *area;
+        ssize_t n = audio_mmap_area_begin(dev, &area, frames - done);
+        if (n <= 0) {
+            return done > 0 ? (ssize_t)done : n;
+        }
+        
+        size_t samples = (size_t)n * dev->channels;
+        size_t offset = done * dev->channels;
+        if (capture_dst) {
+            sample_format_to_float(dev->format, area, &capture_dst[offset], samples);
+        } else {
+            sample_format_from_float(dev->format, &playback_src[offset], area, samples,
+                                     dev->use_dither ? &dev->dither : NULL);
+        }
+        
+        int err = audio_device_mmap_commit(dev, (size_t)n);
+        if (err < 0) {
+            return err;
+        }
+        done += (size_t)n;
+    }
+    
+    return (ssize_t)done;
+}
+
+/**
+ * Read/write access in a non-float format: a period at a time through the
+ * conversion buffer. Returns frames moved, or negative if none were.
+ */
+static ssize_t audio_rw_convert(audio_device_t *dev, float *capture_dst,
+                                const float *playback_src, size_t frames) {
+    size_t done = 0;
+    
+    while (done < frames) {
+        size_t want = frames - done < dev->period_size ? frames - done : dev->period_size;
+        size_t offset = done * dev->channels;
+        snd_pcm_sframes_t result;
+        
+        if (capture_dst) {
+            result = snd_pcm_readi(dev->handle, dev->convert, want);
+            if (result > 0) {
+                sample_format_to_float(dev->format, dev->convert, &capture_dst[offset],
+                                       (size_t)result * dev->channels);
+            }
+        } else {
+            sample_format_from_float(dev->format, &playback_src[offset], dev->convert,
+                                     want * dev->channels, dev->use_dither ? &dev->dither : NULL);
+            result = snd_pcm_writei(dev->handle, dev->convert, want);
+        }
+        
+        if (result < 0) {
+            return done > 0 ? (ssize_t)done : audio_device_recover(dev, (int)result);
+        }
+        done += (size_t)result;
+        if ((size_t)result < want) {
+            break;
+        }
+    }
+    
+    return (ssize_t)done;
 }
 
 ssize_t audio_capture_read(audio_device_t *dev, float *buffer, size_t frames) {
+    if (dev->mmap) {
+        return audio_mmap_transfer(dev, buffer, NULL, frames);
+    }
+    if (dev->convert) {
+        return audio_rw_convert(dev, buffer, NULL, frames);
+    }
+    
     snd_pcm_sframes_t result = snd_pcm_readi(dev->handle, buffer, frames);
     
     if (result < 0) {
@@ -162,6 +415,13 @@ ssize_t audio_capture_read(audio_device_t *dev, float *buffer, size_t frames) {
 }
 
 ssize_t audio_playback_write(audio_device_t *dev, const float *buffer, size_t frames) {
+    if (dev->mmap) {
+        return audio_mmap_transfer(dev, NULL, buffer, frames);
+    }
+    if (dev->convert) {
+        return audio_rw_convert(dev, NULL, buffer, frames);
+    }
+    
     snd_pcm_sframes_t result = snd_pcm_writei(dev->handle, buffer, frames);
     
     if (result < 0) {
@@ -171,18 +431,29 @@ ssize_t audio_playback_write(audio_device_t *dev, const float *buffer, size_t fr
     return result;
 }
 
+size_t audio_device_delay(audio_device_t *dev) {
+    snd_pcm_sframes_t delay = 0;
+    
+    if (snd_pcm_delay(dev->handle, &delay) < 0 || delay < 0) {
+        return 0;
+    }
+    return (size_t)delay;
+}
+
 void audio_device_close(audio_device_t *dev) {
     if (dev) {
         snd_pcm_drain(dev->handle);
         snd_pcm_close(dev->handle);
+        free(dev->convert);
         free(dev);
     }
 }
 
 int audio_device_recover(audio_device_t *dev, int err) {
     if (err == -EPIPE) {
-        // Buffer overrun/underrun
-        fprintf(stderr, "XRUN detected, recovering...\n");
+        // Buffer overrun/underrun: counted only, as this runs on the audio
+        // thread; the status line reports it
+        atomic_fetch_add_explicit(&dev->xruns, 1, memory_order_relaxed);
         err = snd_pcm_prepare(dev->handle);
         if (err < 0) {
             fprintf(stderr, "Cannot recover from xrun: %s\n", snd_strerror(err));
@@ -190,6 +461,7 @@ int audio_device_recover(audio_device_t *dev, int err) {
         return err;
     } else if (err == -ESTRPIPE) {
         // Device suspended
+        atomic_fetch_add_explicit(&dev->suspends, 1, memory_order_relaxed);
         while ((err = snd_pcm_resume(dev->handle)) == -EAGAIN) {
             sleep(1);
         }
@@ -3,19 +3,69 @@
 
 #include <alsa/asoundlib.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sample_format.h"
 
 /**
  * ALSA audio I/O wrapper for capture and playback.
  * Simplified interface for real-time audio processing.
+ *
+ * Callers always see interleaved float. The device itself runs in whatever
+ * format was negotiated (see audio_device_config_t.format); for anything
+ * but FLOAT_LE, audio_capture_read and audio_playback_write convert at the
+ * boundary (sample_format.h), dithering on the way out, so alsa-lib's plug
+ * layer never has to and only native-size samples cross the bus.
  */
 
 typedef struct {
     snd_pcm_t *handle;
-    unsigned int sample_rate;
+    snd_pcm_stream_t stream;
+    unsigned int sample_rate;  // Negotiated; may differ from the requested rate
     unsigned int channels;
-    size_t period_size;      // Frames per period (ALSA callback chunk)
+    size_t period_size;      // Negotiated frames per period (ALSA callback chunk)
+    size_t buffer_size;      // Negotiated device buffer, in frames
+    unsigned int period_count;  // buffer_size / period_size
+    bool mmap;               // Negotiated MMAP_INTERLEAVED access
+    snd_pcm_uframes_t mmap_offset;  // Offset of the area handed out by mmap_begin
+    sample_format_t format;  // Negotiated device format
+    void *convert;           // One period in the device format (read/write access, non-float)
+    sample_dither_t dither;  // Playback: dither for the integer formats
+    bool use_dither;
+    atomic_uint xruns;       // Overruns/underruns recovered so far (any thread may read)
+    atomic_uint suspends;    // Suspend/resume cycles recovered so far (any thread may read)
 } audio_device_t;
 
+/**
+ * Device open parameters. Fill with audio_device_config_init() and then
+ * override optional fields.
+ */
+typedef struct {
+    const char *device_name;
+    unsigned int sample_rate;
+    unsigned int channels;
+    size_t period_size;      // Requested frames per period
+    unsigned int period_count;  // Periods per device buffer (default 4)
+    bool use_mmap;           // Try MMAP_INTERLEAVED, fall back to RW if unsupported
+    int format;              // A sample_format_t, or SAMPLE_FORMAT_AUTO (default): the first
+                             // of FLOAT, S32, S24_3, S16 the hardware has without conversion
+    bool dither;             // TPDF-dither playback to S16 and S24 (default true)
+} audio_device_config_t;
+
+void audio_device_config_init(audio_device_config_t *config,
+                              const char *device_name,
+                              unsigned int sample_rate,
+                              unsigned int channels,
+                              size_t period_size);
+
+/**
+ * Open a capture or playback device from a config.
+ * Returns NULL on failure, including a format that is neither a
+ * sample_format_t nor SAMPLE_FORMAT_AUTO.
+ */
+audio_device_t* audio_device_open(const audio_device_config_t *config,
+                                  snd_pcm_stream_t stream);
+
 /**
  * Open audio capture device (microphone/line-in).
  * Returns NULL on failure.
@@ -36,23 +86,63 @@ audio_device_t* audio_playback_open(const char *device_name,
 
 /**
  * Read audio samples from capture device.
+ * Works in both RW and mmap mode (mmap mode copies out of the DMA area),
+ * converting from the device format.
  * Returns number of frames actually read, or negative on error.
  */
 ssize_t audio_capture_read(audio_device_t *dev, float *buffer, size_t frames);
 
 /**
  * Write audio samples to playback device.
+ * Works in both RW and mmap mode (mmap mode copies into the DMA area),
+ * converting to the device format.
  * Returns number of frames actually written, or negative on error.
  */
 ssize_t audio_playback_write(audio_device_t *dev, const float *buffer, size_t frames);
 
+/**
+ * Zero-copy access to the DMA area (mmap mode with a FLOAT_LE device only;
+ * -EINVAL otherwise, where audio_capture_read/audio_playback_write convert
+ * straight out of or into the area instead).
+ * Waits until at least one frame can be transferred, then points *area at
+ * interleaved float frames inside the device buffer: captured frames to
+ * read, or free space to fill for playback. Returns the number of
+ * contiguous frames (at most frames), 0 after recovering from an xrun, or
+ * negative on error. Every successful begin must be followed by
+ * audio_device_mmap_commit.
+ */
+ssize_t audio_device_mmap_begin(audio_device_t *dev, float **area, size_t frames);
+
+/**
+ * Whether audio_device_mmap_begin can hand out the DMA area (mmap access
+ * to a float device).
+ */
+static inline bool audio_device_zero_copy(const audio_device_t *dev) {
+    return dev->mmap && dev->format == SAMPLE_FORMAT_F32;
+}
+
+/**
+ * Hand frames of the area from audio_device_mmap_begin back to the device.
+ * Returns 0 on success (including after recovering from an xrun), or
+ * negative on error.
+ */
+int audio_device_mmap_commit(audio_device_t *dev, size_t frames);
+
+/**
+ * Frames between the application and the converter: for capture, frames
+ * captured but not read yet; for playback, frames written but not played
+ * yet. Returns 0 if the device can't report it.
+ */
+size_t audio_device_delay(audio_device_t *dev);
+
 /**
  * Close and free audio device.
  */
 void audio_device_close(audio_device_t *dev);
 
 /**
- * Recover from ALSA xrun (overrun/underrun).
+ * Recover from ALSA xrun (overrun/underrun). Counts it in xruns or
+ * suspends without printing, so it is safe on the audio thread.
  */
 int audio_device_recover(audio_device_t *dev, int err);
 
@@ -0,0 +1,559 @@
+#define _GNU_SOURCE
+#include "batch.h"
+#include "effect_graph.h"
+#include "convolver.h"
+#include "wav_io.h"
+#include "rt_thread.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * One worker's share of the files: order[front, back), packed as
+ * front | back << 32 so both ends move with one compare-and-swap.
+ */
+typedef struct {
+    alignas(RING_BUFFER_CACHE_LINE) atomic_uint_least64_t range;
+} batch_deque_t;
+
+typedef struct batch batch_t;
+
+typedef struct {
+    batch_t *batch;
+    unsigned int index;
+    pthread_t thread;
+    float *block;                // chunk_frames frames of the widest layout
+    effect_graph_t *graph;       // Kept across files while it can be reset
+    
+    // Totals, read once the worker has been joined
+    size_t files_ok;
+    size_t files_failed;
+    uint64_t frames;
+    double audio_seconds;
+    uint64_t busy_ns;
+    size_t steals;
+    size_t graph_builds;
+} batch_worker_t;
+
+struct batch {
+    const batch_config_t *config;
+    size_t chunk_frames;
+    size_t *order;               // Input indices, dealt into the deques
+    batch_deque_t *deques;
+    batch_worker_t *workers;
+    unsigned int worker_count;
+};
+
+static uint64_t range_pack(uint32_t front, uint32_t back) {
+    return (uint64_t)front | (uint64_t)back << 32;
+}
+
+static uint32_t range_front(uint64_t range) {
+    return (uint32_t)range;
+}
+
+static uint32_t range_back(uint64_t range) {
+    return (uint32_t)(range >> 32);
+}
+
+/**
+ * Take from the front of the worker's own deque. Returns the input index,
+ * or -1 when the deque is empty.
+ */
+static long batch_take(batch_t *b, unsigned int worker) {
+    atomic_uint_least64_t *range = &b->deques[worker].range;
+    uint64_t r = atomic_load(range);
+    
+    while (range_front(r) < range_back(r)) {
+        if (atomic_compare_exchange_weak(range, &r, range_pack(range_front(r) + 1,
+                                                                range_back(r)))) {
+            return (long)b->order[range_front(r)];
+        }
+    }
+    return -1;
+}
+
+/**
+ * Move the back half of the fullest other deque into the (empty) deque of
+ * worker. Returns false once there is nothing left to steal.
+ */
+static bool batch_steal(batch_t *b, unsigned int worker) {
+    while (true) {
+        unsigned int victim = worker;
+        uint64_t victim_range = 0;
+        uint32_t most = 0;
+        for (unsigned int i = 0; i < b->worker_count; i++) {
+            uint64_t r = atomic_load(&b->deques[i].range);
+            uint32_t left = range_back(r) - range_front(r);
+            if (i != worker && range_front(r) < range_back(r) && left > most) {
+                victim = i;
+                victim_range = r;
+                most = left;
+            }
+        }
+        if (most == 0) {
+            return false;
+        }
+        
+        uint32_t front = range_front(victim_range);
+        uint32_t back = range_back(victim_range);
+        uint32_t split = back - (most + 1) / 2;
+        if (atomic_compare_exchange_strong(&b->deques[victim].range, &victim_range,
+                                           range_pack(front, split))) {
+            atomic_store(&b->deques[worker].range, range_pack(split, back));
+            return true;
+        }
+        // The victim or another thief got there first: look again
+    }
+}
+
+static const char* base_name(const char *path) {
+    const char *name = strrchr(path, '/');
+    return name ? name + 1 : path;
+}
+
+/**
+ * output_dir/<input's file name>.
+ */
+static char* batch_output_path(const char *output_dir, const char *input) {
+    const char *name = base_name(input);
+    size_t len = strlen(output_dir) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%s", output_dir, name);
+    }
+    return path;
+}
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} batch_file_id_t;
+
+static int compare_ids(const void *a, const void *b) {
+    const batch_file_id_t *x = a, *y = b;
+    if (x->dev != y->dev) {
+        return x->dev < y->dev ? -1 : 1;
+    }
+    return x->ino < y->ino ? -1 : x->ino > y->ino;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(base_name(*(const char *const*)a), base_name(*(const char *const*)b));
+}
+
+/**
+ * Refuse a batch whose outputs would clobber its inputs or each other. An
+ * output that is an input (output_dir is the input directory, or links to
+ * it) would be truncated while it is still being read, or mapped; two
+ * inputs with the same file name would both write one output. Reports
+ * every clash on stderr. Returns 0 if every output is distinct.
+ */
+static int batch_check_outputs(const batch_config_t *config) {
+    size_t count = config->count;
+    batch_file_id_t *ids = malloc(count * sizeof(batch_file_id_t));
+    const char **names = malloc(count * sizeof(char*));
+    if (!ids || !names) {
+        free(ids);
+        free(names);
+        fprintf(stderr, "✗ Error: Out of memory\n");
+        return -1;
+    }
+    
+    size_t known = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct stat st;
+        if (stat(config->inputs[i], &st) == 0) {
+            ids[known].dev = st.st_dev;
+            ids[known].ino = st.st_ino;
+            known++;
+        }
+        names[i] = config->inputs[i];
+    }
+    qsort(ids, known, sizeof(batch_file_id_t), compare_ids);
+    qsort(names, count, sizeof(char*), compare_names);
+    
+    int result = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && compare_names(&names[i - 1], &names[i]) == 0) {
+            fprintf(stderr, "✗ Error: '%s' and '%s' would both be written to '%s/%s'\n",
+                    names[i - 1], names[i], config->output_dir, base_name(names[i]));
+            result = -1;
+        }
+        
+        char *output = batch_output_path(config->output_dir, names[i]);
+        struct stat st;
+        if (output && stat(output, &st) == 0) {
+            batch_file_id_t id = { st.st_dev, st.st_ino };
+            if (bsearch(&id, ids, known, sizeof(batch_file_id_t), compare_ids)) {
+                fprintf(stderr, "✗ Error: Output '%s' is one of the inputs\n", output);
+                result = -1;
+            }
+        }
+        free(output);
+    }
+    free(ids);
+    free(names);
+    return result;
+}
+
+/**
+ * Render one file, reusing the worker's graph when it can. Returns 0 on
+ * success.
+ */
+static int batch_render(batch_worker_t *w, const char *input_file, const char *output_file) {
+    const batch_config_t *config = w->batch->config;
+    size_t chunk = w->batch->chunk_frames;
+    
+    wav_io_input_t input;
+    if (wav_io_input_open(&input, input_file, config->map_input) != 0) {
+        fprintf(stderr, "✗ Error: Failed to open input file '%s'\n", input_file);
+        return -1;
+    }
+    unsigned int channels = input.channels;
+    const convolver_ir_t *ir = config->effects.ir;
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS ||
+        (ir && ir->channels != 1 && ir->channels != channels)) {
+        fprintf(stderr, "✗ Error: '%s': %u channels don't fit the effects\n", input_file,
+                channels);
+        wav_io_input_close(&input);
+        return -1;
+    }
+    
+    wav_io_reader_t reader;
+    if (wav_io_reader_init(&reader, &input, config->sample_rate) != 0) {
+        fprintf(stderr, "✗ Error: '%s': Can't convert %u Hz to %u Hz\n", input_file,
+                input.sample_rate, config->sample_rate);
+        wav_io_input_close(&input);
+        return -1;
+    }
+    unsigned int sample_rate = reader.sample_rate;
+    
+    effect_graph_t *graph = w->graph;
+    if (!graph || graph->channels != channels || graph->sample_rate != (float)sample_rate ||
+        effect_graph_reset(graph) != 0) {
+        effect_graph_free(graph);
+        graph = w->graph = effect_graph_from_config(&config->effects, sample_rate, channels, 0);
+        w->graph_builds++;
+        if (!graph) {
+            fprintf(stderr, "✗ Error: '%s': Failed to create effect graph\n", input_file);
+            wav_io_reader_free(&reader);
+            wav_io_input_close(&input);
+            return -1;
+        }
+    }
+    
+    drwav out;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = channels;
+    format.sampleRate = sample_rate;
+    format.bitsPerSample = 32;
+    if (!drwav_init_file_write(&out, output_file, &format, NULL)) {
+        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", output_file);
+        wav_io_reader_free(&reader);
+        wav_io_input_close(&input);
+        return -1;
+    }
+    
+    // As --stream: run the latency in as silence after the file, drop it
+    // from the front
+    size_t skip = effect_graph_latency(graph);
+    wav_io_reader_pad(&reader, skip);
+    
+    int result = 0;
+    uint64_t written = 0;
+    while (true) {
+        frame_ring_span_t span = { w->block, chunk, NULL, 0 };
+        size_t frames = wav_io_reader_read(&reader, &span);
+        if (frames == 0) {
+            break;
+        }
+        effect_graph_process(graph, w->block, frames);
+        
+        size_t dropped = skip < frames ? skip : frames;
+        skip -= dropped;
+        size_t keep = frames - dropped;
+        if (drwav_write_pcm_frames(&out, keep, &w->block[dropped * channels]) != keep) {
+            fprintf(stderr, "✗ Error: Failed to write '%s'\n", output_file);
+            result = -1;
+            break;
+        }
+        written += keep;
+    }
+    
+    drwav_uninit(&out);
+    w->frames += written;
+    w->audio_seconds += (double)input.total_frames / input.sample_rate;
+    wav_io_reader_free(&reader);
+    wav_io_input_close(&input);
+    return result;
+}
+
+static void* batch_worker(void *arg) {
+    batch_worker_t *w = (batch_worker_t*)arg;
+    batch_t *b = w->batch;
+    const batch_config_t *config = b->config;
+    
+    // As every other file mode, so the outputs come out the same bits
+    rt_flush_denormals();
+    
+    while (true) {
+        long index = batch_take(b, w->index);
+        if (index < 0) {
+            if (!batch_steal(b, w->index)) {
+                break;
+            }
+            w->steals++;
+            continue;
+        }
+        
+        uint64_t t0 = utils_now_ns();
+        const char *input = config->inputs[index];
+        char *output = batch_output_path(config->output_dir, input);
+        if (output && batch_render(w, input, output) == 0) {
+            w->files_ok++;
+        } else {
+            w->files_failed++;
+        }
+        free(output);
+        w->busy_ns += utils_now_ns() - t0;
+    }
+    
+    effect_graph_free(w->graph);
+    w->graph = NULL;
+    return NULL;
+}
+
+static uint64_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+typedef struct {
+    size_t index;
+    uint64_t size;
+} batch_job_t;
+
+static int job_longest_first(const void *a, const void *b) {
+    const batch_job_t *x = a, *y = b;
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/**
+ * Sort the inputs longest first and deal them round-robin: worker w's
+ * deque gets the w-th, (w + n)-th, ... longest files, in that order.
+ */
+static int batch_deal(batch_t *b) {
+    size_t count = b->config->count;
+    unsigned int n = b->worker_count;
+    batch_job_t *jobs = malloc(count * sizeof(batch_job_t));
+    if (!jobs) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].index = i;
+        jobs[i].size = file_size(b->config->inputs[i]);
+    }
+    qsort(jobs, count, sizeof(batch_job_t), job_longest_first);
+    
+    size_t pos = 0;
+    for (unsigned int w = 0; w < n; w++) {
+        size_t front = pos;
+        for (size_t i = w; i < count; i += n) {
+            b->order[pos++] = jobs[i].index;
+        }
+        atomic_init(&b->deques[w].range, range_pack((uint32_t)front, (uint32_t)pos));
+    }
+    free(jobs);
+    return 0;
+}
+
+int batch_run(const batch_config_t *config, batch_stats_t *stats) {
+    batch_t b;
+    memset(&b, 0, sizeof(b));
+    b.config = config;
+    b.chunk_frames = config->chunk_frames ? config->chunk_frames : BATCH_CHUNK_FRAMES;
+    
+    if (config->count == 0 || config->count > UINT32_MAX) {
+        fprintf(stderr, "✗ Error: No files to render\n");
+        return 1;
+    }
+    if (batch_check_outputs(config) != 0) {
+        // Nothing is written: renaming would leave outputs nobody asked for
+        if (stats) {
+            memset(stats, 0, sizeof(*stats));
+            stats->files_failed = config->count;
+        }
+        return 1;
+    }
+    unsigned int n = config->workers;
+    if (n == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cores > 0 ? (unsigned int)cores : 1;
+    }
+    if (n > config->count) {
+        n = (unsigned int)config->count;
+    }
+    b.worker_count = n;
+    
+    b.order = malloc(config->count * sizeof(size_t));
+    b.deques = aligned_alloc(RING_BUFFER_CACHE_LINE, n * sizeof(batch_deque_t));
+    b.workers = calloc(n, sizeof(batch_worker_t));
+    bool ok = b.order && b.deques && b.workers && batch_deal(&b) == 0;
+    for (unsigned int i = 0; ok && i < n; i++) {
+        b.workers[i].batch = &b;
+        b.workers[i].index = i;
+        b.workers[i].block = malloc(b.chunk_frames * EFFECT_MAX_CHANNELS * sizeof(float));
+        ok = b.workers[i].block != NULL;
+    }
+    if (!ok) {
+        fprintf(stderr, "✗ Error: Out of memory\n");
+    }
+    
+    uint64_t start = utils_now_ns();
+    unsigned int started = 0;
+    for (; ok && started < n; started++) {
+        if (pthread_create(&b.workers[started].thread, NULL, batch_worker,
+                           &b.workers[started]) != 0) {
+            // Those running steal the files of the ones that never started
+            fprintf(stderr, "Warning: Started only %u of %u workers\n", started, n);
+            ok = started > 0;
+            break;
+        }
+    }
+    for (unsigned int i = 0; i < started; i++) {
+        pthread_join(b.workers[i].thread, NULL);
+    }
+    
+    batch_stats_t total;
+    memset(&total, 0, sizeof(total));
+    total.wall_seconds = (utils_now_ns() - start) / 1e9;
+    total.workers = started;
+    for (unsigned int i = 0; i < started; i++) {
+        const batch_worker_t *w = &b.workers[i];
+        total.files_ok += w->files_ok;
+        total.files_failed += w->files_failed;
+        total.frames += w->frames;
+        total.audio_seconds += w->audio_seconds;
+        total.busy_seconds += w->busy_ns / 1e9;
+        total.steals += w->steals;
+        total.graph_builds += w->graph_builds;
+    }
+    if (stats) {
+        *stats = total;
+    }
+    
+    for (unsigned int i = 0; b.workers && i < n; i++) {
+        free(b.workers[i].block);
+    }
+    free(b.workers);
+    free(b.deques);
+    free(b.order);
+    return ok && total.files_failed == 0 && total.files_ok == config->count ? 0 : 1;
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char *const*)a, *(char *const*)b);
+}
+
+/**
+ * Append a copy of path to the growing list.
+ */
+static int paths_push(char ***paths, size_t *count, size_t *capacity, const char *path) {
+    if (*count == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        char **bigger = realloc(*paths, grown * sizeof(char*));
+        if (!bigger) {
+            return -1;
+        }
+        *paths = bigger;
+        *capacity = grown;
+    }
+    char *copy = strdup(path);
+    if (!copy) {
+        return -1;
+    }
+    (*paths)[(*count)++] = copy;
+    return 0;
+}
+
+static bool has_wav_extension(const char *name) {
+    size_t len = strlen(name);
+    return len > 4 && strcasecmp(name + len - 4, ".wav") == 0;
+}
+
+int batch_collect(const char *path, char ***paths, size_t *count) {
+    size_t capacity = 0;
+    *paths = NULL;
+    *count = 0;
+    
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+    
+    int result = 0;
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path);
+        if (!dir) {
+            return -1;
+        }
+        struct dirent *entry;
+        while (result == 0 && (entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.' || !has_wav_extension(entry->d_name)) {
+                continue;
+            }
+            size_t len = strlen(path) + strlen(entry->d_name) + 2;
+            char *full = malloc(len);
+            if (!full) {
+                result = -1;
+                break;
+            }
+            snprintf(full, len, "%s/%s", path, entry->d_name);
+            result = paths_push(paths, count, &capacity, full);
+            free(full);
+        }
+        closedir(dir);
+        if (result == 0 && *count > 1) {
+            qsort(*paths, *count, sizeof(char*), compare_paths);
+        }
+    } else {
+        FILE *list = fopen(path, "r");
+        if (!list) {
+            return -1;
+        }
+        char line[4096];
+        while (result == 0 && fgets(line, sizeof(line), list)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0' && line[0] != '#') {
+                result = paths_push(paths, count, &capacity, line);
+            }
+        }
+        fclose(list);
+    }
+    
+    if (result != 0) {
+        batch_free_paths(*paths, *count);
+        *paths = NULL;
+        *count = 0;
+    }
+    return result;
+}
+
+void batch_free_paths(char **paths, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(paths[i]);
+    }
+    free(paths);
+}
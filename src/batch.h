@@ -0,0 +1,72 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "effects.h"
+
+/**
+ * Batch rendering: many files over a fixed pool of worker threads in one
+ * process.
+ *
+ * Files are sorted longest first and dealt round-robin into one deque per
+ * worker. A worker takes from the front of its own deque; once that is
+ * empty it steals the back half of the fullest other one. A deque is a
+ * range of a shared index array packed into a single 64-bit word, so a
+ * take or a steal is one compare-and-swap and no lock is ever held.
+ * Dealing longest first and stealing keeps every core busy until the last
+ * few files.
+ *
+ * Each worker allocates its block buffer once. Its effect graph is built
+ * for the first file and reset (effect_graph_reset) for the next rather
+ * than rebuilt, as long as the rate and channel count stay the same and
+ * every node can be reset (a convolver can't: that graph is rebuilt per
+ * file). Files stream through in blocks with the same latency compensation
+ * as --stream, so every output is identical to rendering that file alone.
+ */
+
+#define BATCH_CHUNK_FRAMES 4096     // Default frames per read-process-write step
+
+typedef struct {
+    const char *const *inputs;
+    size_t count;
+    const char *output_dir;     // Outputs take their input's file name here
+    effect_chain_config_t effects;
+    unsigned int sample_rate;   // Render every file at this rate (0 = each file's own)
+    unsigned int workers;       // 0 = one per online core; never more than count
+    bool map_input;             // Map float input (wav_io_input_open)
+    size_t chunk_frames;        // 0 = BATCH_CHUNK_FRAMES
+} batch_config_t;
+
+typedef struct {
+    size_t files_ok;
+    size_t files_failed;
+    uint64_t frames;            // Frames written over all files
+    double audio_seconds;       // Input duration over the files rendered
+    double wall_seconds;
+    double busy_seconds;        // Rendering time summed over the workers
+    unsigned int workers;
+    size_t steals;
+    size_t graph_builds;        // Files that needed a new graph (the rest reset one)
+} batch_stats_t;
+
+/**
+ * Collect the files to render from path: every *.wav in it when it is a
+ * directory (sorted by name), otherwise one path per line of a list file
+ * (blank lines and # comments skipped). Returns 0 and a malloc'd array,
+ * freed with batch_free_paths, or -1 if path can't be read.
+ */
+int batch_collect(const char *path, char ***paths, size_t *count);
+
+void batch_free_paths(char **paths, size_t count);
+
+/**
+ * Render every input into output_dir. Reports each failed file on stderr
+ * and carries on with the rest. Renders nothing if an output would be one
+ * of the inputs or two inputs share a file name. Fills stats (may be
+ * NULL). Returns 0 if every file rendered, non-zero otherwise.
+ */
+int batch_run(const batch_config_t *config, batch_stats_t *stats);
+
+#endif // BATCH_H
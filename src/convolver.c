@@ -0,0 +1,527 @@
+#include "convolver.h"
+#include "rt_thread.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define CONVOLVER_ALIGN 64
+#define CONVOLVER_SIMD_FLOATS (CONVOLVER_ALIGN / sizeof(float))
+
+static bool is_power_of_2(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+/**
+ * Zeroed, cache-aligned floats; zeroing also faults the pages in here
+ * rather than on the audio thread.
+ */
+static float* conv_alloc(size_t count) {
+    size_t bytes = (count * sizeof(float) + CONVOLVER_ALIGN - 1) / CONVOLVER_ALIGN * CONVOLVER_ALIGN;
+    if (bytes == 0) {
+        bytes = CONVOLVER_ALIGN;
+    }
+    float *p = aligned_alloc(CONVOLVER_ALIGN, bytes);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+// ============================================================================
+// KERNELS
+// ============================================================================
+
+/**
+ * acc += a * b over stride complex bins (split re/im, stride a multiple of
+ * the SIMD width and 16-byte aligned).
+ */
+static void conv_cmac(float *restrict acc_re, float *restrict acc_im,
+                      const float *a_re, const float *a_im,
+                      const float *b_re, const float *b_im, size_t stride) {
+    size_t k = 0;
+#if defined(__SSE2__)
+    for (; k + 4 <= stride; k += 4) {
+        __m128 ar = _mm_load_ps(&a_re[k]), ai = _mm_load_ps(&a_im[k]);
+        __m128 br = _mm_load_ps(&b_re[k]), bi = _mm_load_ps(&b_im[k]);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+        _mm_store_ps(&acc_re[k], _mm_add_ps(_mm_load_ps(&acc_re[k]), re));
+        _mm_store_ps(&acc_im[k], _mm_add_ps(_mm_load_ps(&acc_im[k]), im));
+    }
+#elif defined(__ARM_NEON)
+    for (; k + 4 <= stride; k += 4) {
+        float32x4_t ar = vld1q_f32(&a_re[k]), ai = vld1q_f32(&a_im[k]);
+        float32x4_t br = vld1q_f32(&b_re[k]), bi = vld1q_f32(&b_im[k]);
+        float32x4_t re = vsubq_f32(vmulq_f32(ar, br), vmulq_f32(ai, bi));
+        float32x4_t im = vaddq_f32(vmulq_f32(ar, bi), vmulq_f32(ai, br));
+        vst1q_f32(&acc_re[k], vaddq_f32(vld1q_f32(&acc_re[k]), re));
+        vst1q_f32(&acc_im[k], vaddq_f32(vld1q_f32(&acc_im[k]), im));
+    }
+#endif
+    for (; k < stride; k++) {
+        acc_re[k] += a_re[k] * b_re[k] - a_im[k] * b_im[k];
+        acc_im[k] += a_re[k] * b_im[k] + a_im[k] * b_re[k];
+    }
+}
+
+/**
+ * Dot product of n floats; a may be unaligned.
+ */
+static float conv_dot(const float *a, const float *b, size_t n) {
+    size_t k = 0;
+    float sum = 0.0f;
+#if defined(__SSE2__)
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (; k + 8 <= n; k += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&a[k]), _mm_loadu_ps(&b[k])));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(&a[k + 4]), _mm_loadu_ps(&b[k + 4])));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON)
+    float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+    for (; k + 8 <= n; k += 8) {
+        s0 = vaddq_f32(s0, vmulq_f32(vld1q_f32(&a[k]), vld1q_f32(&b[k])));
+        s1 = vaddq_f32(s1, vmulq_f32(vld1q_f32(&a[k + 4]), vld1q_f32(&b[k + 4])));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(s0, s1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; k < n; k++) {
+        sum += a[k] * b[k];
+    }
+    return sum;
+}
+
+// ============================================================================
+// UPOLS LEVEL
+// ============================================================================
+
+static void part_free(convolver_part_t *part) {
+    fft_free(part->fft);
+    free(part->filter_re);
+    free(part->filter_im);
+    free(part->delay_re);
+    free(part->delay_im);
+    free(part->window);
+    free(part->acc_re);
+    free(part->acc_im);
+    free(part->time);
+    memset(part, 0, sizeof(*part));
+}
+
+/**
+ * Partition IR[start, end) into blocks and precompute their spectra.
+ */
+static int part_init(convolver_part_t *part, const convolver_ir_t *ir, size_t start, size_t end,
+                     size_t block, unsigned int channels) {
+    memset(part, 0, sizeof(*part));
+    part->block = block;
+    part->bins = block + 1;
+    part->stride = (part->bins + CONVOLVER_SIMD_FLOATS - 1) / CONVOLVER_SIMD_FLOATS *
+                   CONVOLVER_SIMD_FLOATS;
+    part->partitions = (end - start + block - 1) / block;
+    part->ir_channels = ir->channels;
+    
+    size_t filter = ir->channels * part->partitions * part->stride;
+    size_t delay = channels * part->partitions * part->stride;
+    part->fft = fft_create(2 * block);
+    part->filter_re = conv_alloc(filter);
+    part->filter_im = conv_alloc(filter);
+    part->delay_re = conv_alloc(delay);
+    part->delay_im = conv_alloc(delay);
+    part->window = conv_alloc(channels * 2 * block);
+    part->acc_re = conv_alloc(part->stride);
+    part->acc_im = conv_alloc(part->stride);
+    part->time = conv_alloc(2 * block);
+    
+    if (!part->fft || !part->filter_re || !part->filter_im || !part->delay_re ||
+        !part->delay_im || !part->window || !part->acc_re || !part->acc_im || !part->time) {
+        part_free(part);
+        return -1;
+    }
+    
+    // Overlap-save: each partition zero padded to the FFT size. The
+    // inverse FFT's factor of 2 * block is folded in here
+    float scale = 1.0f / (float)(2 * block);
+    for (unsigned int ic = 0; ic < ir->channels; ic++) {
+        for (size_t p = 0; p < part->partitions; p++) {
+            memset(part->time, 0, 2 * block * sizeof(float));
+            for (size_t n = 0; n < block; n++) {
+                size_t i = start + p * block + n;
+                if (i >= end) break;
+                part->time[n] = ir->samples[i * ir->channels + ic] * scale;
+            }
+            
+            size_t offset = (ic * part->partitions + p) * part->stride;
+            fft_forward(part->fft, part->time, &part->filter_re[offset], &part->filter_im[offset]);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Convolve channel c's window (previous block, then the block just
+ * completed) into part->time; the block's output is the second half.
+ * Slides the window on by one block.
+ */
+static const float* part_block(convolver_part_t *part, unsigned int c) {
+    size_t block = part->block;
+    size_t partitions = part->partitions;
+    size_t stride = part->stride;
+    unsigned int ic = part->ir_channels == 1 ? 0 : c;
+    float *window = &part->window[c * 2 * block];
+    float *delay_re = &part->delay_re[c * partitions * stride];
+    float *delay_im = &part->delay_im[c * partitions * stride];
+    const float *filter_re = &part->filter_re[ic * partitions * stride];
+    const float *filter_im = &part->filter_im[ic * partitions * stride];
+    
+    fft_forward(part->fft, window, &delay_re[part->slot * stride], &delay_im[part->slot * stride]);
+    memcpy(window, &window[block], block * sizeof(float));
+    
+    // Partition p meets the spectrum from p blocks ago
+    memset(part->acc_re, 0, stride * sizeof(float));
+    memset(part->acc_im, 0, stride * sizeof(float));
+    size_t slot = part->slot;
+    for (size_t p = 0; p < partitions; p++) {
+        conv_cmac(part->acc_re, part->acc_im, &filter_re[p * stride], &filter_im[p * stride],
+                  &delay_re[slot * stride], &delay_im[slot * stride], stride);
+        slot = slot == 0 ? partitions - 1 : slot - 1;
+    }
+    
+    fft_inverse(part->fft, part->acc_re, part->acc_im, part->time);
+    return &part->time[block];
+}
+
+/**
+ * After every channel has run part_block: the next spectrum goes in the
+ * following slot.
+ */
+static void part_advance(convolver_part_t *part) {
+    part->slot = part->slot + 1 == part->partitions ? 0 : part->slot + 1;
+}
+
+// ============================================================================
+// TAIL WORKER
+// ============================================================================
+
+static void* convolver_worker(void *arg) {
+    convolver_t *conv = (convolver_t*)arg;
+    size_t block = conv->tail_block;
+    unsigned int channels = conv->channels;
+    float *frames = conv->tail_frames;
+    
+    while (!atomic_load_explicit(&conv->stop, memory_order_acquire)) {
+        // Whole blocks only; the audio thread never needs the output of a
+        // block it hasn't finished sending
+        frame_ring_span_t span;
+        if (frame_ring_read_acquire(conv->tail_in, block, &span) < block) {
+            frame_ring_wait_readable(conv->tail_in, block, RING_BUFFER_WAIT_FOREVER);
+            continue;
+        }
+        
+        for (unsigned int c = 0; c < channels; c++) {
+            float *window = &conv->tail.window[c * 2 * block + block];
+            const float *in = frame_ring_f32_data1(&span);
+            for (size_t i = 0; i < span.frames1; i++) {
+                window[i] = in[i * channels + c];
+            }
+            in = frame_ring_f32_data2(&span);
+            for (size_t i = 0; i < span.frames2; i++) {
+                window[span.frames1 + i] = in[i * channels + c];
+            }
+            
+            const float *out = part_block(&conv->tail, c);
+            for (size_t i = 0; i < block; i++) {
+                frames[i * channels + c] = out[i];
+            }
+        }
+        part_advance(&conv->tail);
+        
+        size_t sent = 0;
+        while (sent < block && !atomic_load_explicit(&conv->stop, memory_order_acquire)) {
+            size_t n = frame_ring_f32_write(conv->tail_out, &frames[sent * channels], block - sent);
+            if (n == 0) {
+                frame_ring_wait_writable(conv->tail_out, block - sent, RING_BUFFER_WAIT_FOREVER);
+            }
+            sent += n;
+        }
+        
+        // Only now, so an empty input ring means every block's output is out
+        frame_ring_read_release(conv->tail_in, block);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// CONVOLVER
+// ============================================================================
+
+convolver_t* convolver_create(const convolver_ir_t *ir, unsigned int channels,
+                              size_t head_block, size_t tail_block, float mix,
+                              bool realtime) {
+    if (head_block == 0) {
+        head_block = CONVOLVER_HEAD_BLOCK;
+    }
+    if (tail_block == 0) {
+        tail_block = head_block > CONVOLVER_TAIL_BLOCK ? head_block : CONVOLVER_TAIL_BLOCK;
+    }
+    
+    if (!ir || !ir->samples || ir->frames == 0 || channels == 0 ||
+        (ir->channels != 1 && ir->channels != channels) ||
+        !is_power_of_2(head_block) || !is_power_of_2(tail_block) ||
+        tail_block < head_block || 2 * head_block < FFT_MIN_SIZE) {
+        return NULL;
+    }
+    
+    convolver_t *conv = calloc(1, sizeof(convolver_t));
+    if (!conv) {
+        return NULL;
+    }
+    
+    conv->channels = channels;
+    conv->ir_channels = ir->channels;
+    conv->head_block = head_block;
+    conv->tail_block = tail_block;
+    conv->mix = mix;
+    conv->realtime = realtime;
+    atomic_init(&conv->stop, false);
+    atomic_init(&conv->late_frames, 0);
+    
+    size_t length = ir->frames;
+    size_t tail_start = 2 * tail_block;
+    conv->fir_length = length < head_block ? length : head_block;
+    conv->has_head = length > head_block;
+    conv->has_tail = length > tail_start;
+    
+    conv->fir_taps = conv_alloc(ir->channels * head_block);
+    conv->fir_history = conv_alloc(channels * 2 * head_block);
+    conv->head_out = conv_alloc(channels * head_block);
+    conv->wet = conv_alloc(channels * head_block);
+    conv->tail_scratch = conv_alloc(channels * head_block);
+    if (!conv->fir_taps || !conv->fir_history || !conv->head_out || !conv->wet ||
+        !conv->tail_scratch) {
+        convolver_free(conv);
+        return NULL;
+    }
+    
+    for (unsigned int ic = 0; ic < ir->channels; ic++) {
+        for (size_t k = 0; k < conv->fir_length; k++) {
+            conv->fir_taps[ic * head_block + k] = ir->samples[k * ir->channels + ic];
+        }
+    }
+    
+    if (conv->has_head) {
+        size_t end = length < tail_start ? length : tail_start;
+        if (part_init(&conv->head, ir, head_block, end, head_block, channels) != 0) {
+            convolver_free(conv);
+            return NULL;
+        }
+    }
+    
+    if (conv->has_tail) {
+        ring_buffer_options_t options;
+        ring_buffer_options_init(&options);
+        options.waitable = true;
+        
+        conv->tail_frames = conv_alloc(channels * tail_block);
+        conv->tail_in = frame_ring_f32_create(4 * tail_block, channels, &options);
+        conv->tail_out = frame_ring_f32_create(4 * tail_block, channels, &options);
+        if (!conv->tail_frames || !conv->tail_in || !conv->tail_out ||
+            part_init(&conv->tail, ir, tail_start, length, tail_block, channels) != 0) {
+            convolver_free(conv);
+            return NULL;
+        }
+        
+        // The first two tail blocks are due before the worker can have made
+        // them; the IR has nothing there, so they are silence
+        for (int i = 0; i < 2; i++) {
+            frame_ring_f32_write(conv->tail_out, conv->tail_frames, tail_block);
+        }
+        
+        // Normal scheduling, but denormal flushing and a prefaulted stack
+        rt_config_t rt;
+        rt_config_init(&rt);
+        if (rt_thread_create(&conv->worker, &rt, 0, convolver_worker, conv, NULL) != 0) {
+            convolver_free(conv);
+            return NULL;
+        }
+        conv->worker_started = true;
+    }
+    
+    return conv;
+}
+
+void convolver_free(convolver_t *conv) {
+    if (!conv) {
+        return;
+    }
+    
+    if (conv->worker_started) {
+        atomic_store_explicit(&conv->stop, true, memory_order_release);
+        frame_ring_close(conv->tail_in);
+        frame_ring_close(conv->tail_out);
+        pthread_join(conv->worker, NULL);
+    }
+    
+    part_free(&conv->head);
+    part_free(&conv->tail);
+    frame_ring_free(conv->tail_in);
+    frame_ring_free(conv->tail_out);
+    free(conv->tail_frames);
+    free(conv->tail_scratch);
+    free(conv->fir_taps);
+    free(conv->fir_history);
+    free(conv->head_out);
+    free(conv->wet);
+    free(conv);
+}
+
+/**
+ * Hand frames dry frames to the worker and add the tail due over them to
+ * conv->wet.
+ */
+static void convolver_tail(convolver_t *conv, const float *buffer, size_t frames) {
+    unsigned int channels = conv->channels;
+    float *tail = conv->tail_scratch;
+    
+    if (conv->realtime) {
+        // A stalled worker can leave no room; the frames that don't fit go
+        // as silence once there is, so the worker's input keeps time
+        while (conv->tail_gap > 0) {
+            frame_ring_span_t span;
+            size_t n = frame_ring_write_acquire(conv->tail_in, conv->tail_gap, &span);
+            if (n == 0) break;
+            memset(span.data1, 0, span.frames1 * conv->tail_in->stride);
+            memset(span.data2, 0, span.frames2 * conv->tail_in->stride);
+            frame_ring_write_commit(conv->tail_in, n);
+            conv->tail_gap -= n;
+        }
+        size_t sent = 0;
+        if (conv->tail_gap == 0) {
+            sent = frame_ring_f32_write(conv->tail_in, buffer, frames);
+        }
+        conv->tail_gap += frames - sent;
+    } else {
+        size_t sent = 0;
+        while (sent < frames) {
+            size_t n = frame_ring_f32_write(conv->tail_in, &buffer[sent * channels], frames - sent);
+            if (n == 0) {
+                frame_ring_wait_writable(conv->tail_in, frames - sent, RING_BUFFER_WAIT_FOREVER);
+            }
+            sent += n;
+        }
+    }
+    
+    size_t got = 0;
+    if (conv->realtime) {
+        // Frames that missed their block are worthless now; skip them so
+        // what follows stays lined up
+        while (conv->tail_debt > 0) {
+            size_t n = conv->tail_debt < frames ? conv->tail_debt : frames;
+            n = frame_ring_f32_read(conv->tail_out, tail, n);
+            if (n == 0) break;
+            conv->tail_debt -= n;
+        }
+        if (conv->tail_debt == 0) {
+            got = frame_ring_f32_read(conv->tail_out, tail, frames);
+        }
+        if (got < frames) {
+            memset(&tail[got * channels], 0, (frames - got) * channels * sizeof(float));
+            conv->tail_debt += frames - got;
+            atomic_fetch_add_explicit(&conv->late_frames, frames - got, memory_order_relaxed);
+        }
+    } else {
+        while (got < frames) {
+            size_t n = frame_ring_f32_read(conv->tail_out, &tail[got * channels], frames - got);
+            if (n == 0) {
+                frame_ring_wait_readable(conv->tail_out, frames - got, RING_BUFFER_WAIT_FOREVER);
+            }
+            got += n;
+        }
+    }
+    
+    float *wet = conv->wet;
+    for (size_t k = 0; k < frames * channels; k++) {
+        wet[k] += tail[k];
+    }
+}
+
+void convolver_process(convolver_t *conv, float *buffer, size_t frames) {
+    unsigned int channels = conv->channels;
+    size_t head_block = conv->head_block;
+    size_t mask = head_block - 1;
+    float wet_gain = conv->mix;
+    float dry_gain = 1.0f - conv->mix;
+    float *wet = conv->wet;
+    
+    while (frames > 0) {
+        // Up to the end of the current head block
+        size_t n = head_block - conv->head_pos;
+        if (n > frames) n = frames;
+        size_t pos = conv->fir_pos;
+        
+        for (unsigned int c = 0; c < channels; c++) {
+            unsigned int ic = conv->ir_channels == 1 ? 0 : c;
+            const float *taps = &conv->fir_taps[ic * head_block];
+            float *history = &conv->fir_history[c * 2 * head_block];
+            float *window = NULL;
+            if (conv->has_head) {
+                window = &conv->head.window[c * 2 * head_block + head_block + conv->head_pos];
+            }
+            const float *head = &conv->head_out[c * head_block + conv->head_pos];
+            pos = conv->fir_pos;
+            
+            for (size_t i = 0; i < n; i++) {
+                float x = buffer[i * channels + c];
+                
+                // Newest sample first, stored twice so the taps never wrap
+                pos = (pos - 1) & mask;
+                history[pos] = x;
+                history[pos + head_block] = x;
+                float y = conv_dot(&history[pos], taps, conv->fir_length);
+                
+                if (conv->has_head) {
+                    window[i] = x;
+                    y += head[i];
+                }
+                wet[i * channels + c] = y;
+            }
+        }
+        conv->fir_pos = pos;
+        
+        if (conv->has_tail) {
+            convolver_tail(conv, buffer, n);
+        }
+        
+        for (size_t k = 0; k < n * channels; k++) {
+            buffer[k] = dry_gain * buffer[k] + wet_gain * wet[k];
+        }
+        
+        conv->head_pos += n;
+        if (conv->head_pos == head_block) {
+            conv->head_pos = 0;
+            if (conv->has_head) {
+                for (unsigned int c = 0; c < channels; c++) {
+                    memcpy(&conv->head_out[c * head_block], part_block(&conv->head, c),
+                           head_block * sizeof(float));
+                }
+                part_advance(&conv->head);
+            }
+        }
+        
+        buffer += n * channels;
+        frames -= n;
+    }
+}
+
+uint64_t convolver_late_frames(const convolver_t *conv) {
+    return atomic_load_explicit(&conv->late_frames, memory_order_relaxed);
+}
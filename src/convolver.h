@@ -0,0 +1,137 @@
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "fft.h"
+#include "frame_ring.h"
+
+/**
+ * Partitioned FFT convolution with an impulse response (reverb, cabinet).
+ *
+ * The IR is split three ways so an IR of several seconds costs little more
+ * per block than a short one, with no added latency:
+ *
+ *   [0, head_block)           direct FIR on the audio thread
+ *   [head_block, 2 tail_block) uniformly partitioned overlap-save (UPOLS) on
+ *                             the audio thread, head_block partitions
+ *   [2 tail_block, end)       UPOLS on a worker thread, tail_block partitions
+ *
+ * Each UPOLS level keeps a frequency-domain delay line of past input
+ * spectra, so a block costs one forward FFT, one complex multiply-add per
+ * partition and one inverse FFT. The head block's result is due one block
+ * after its input, which is exactly the delay of the IR range it covers;
+ * the tail's result is due two tail blocks after, which gives the worker a
+ * whole tail block to compute it. Audio reaches the worker and comes back
+ * through two frame rings.
+ *
+ * Every FFT plan, spectrum, delay line and ring is allocated by
+ * convolver_create; convolver_process never allocates.
+ */
+
+#define CONVOLVER_HEAD_BLOCK 64     // Default head_block
+#define CONVOLVER_TAIL_BLOCK 1024   // Default tail_block
+
+/**
+ * Interleaved IR samples. channels is 1 (the same IR for every channel) or
+ * the stream's channel count (one IR per channel). convolver_create takes
+ * the samples as they are; effect_graph_add_convolver converts an IR
+ * recorded at another sample_rate to the graph's first.
+ */
+typedef struct convolver_ir {
+    const float *samples;
+    size_t frames;
+    unsigned int channels;
+    unsigned int sample_rate;   // Recorded at (0 = the stream's rate)
+} convolver_ir_t;
+
+/**
+ * One UPOLS level: block-sized partitions of an IR range, convolved with
+ * FFTs of 2 * block points.
+ */
+typedef struct {
+    size_t block;
+    size_t bins;                // block + 1
+    size_t stride;              // Floats per spectrum, bins rounded up for SIMD
+    size_t partitions;
+    unsigned int ir_channels;
+    fft_t *fft;
+    float *filter_re;           // [ir_channel][partition] spectra, scaled by 1/(2 block)
+    float *filter_im;
+    float *delay_re;            // [channel][partition] input spectra, a ring per channel
+    float *delay_im;
+    float *window;              // [channel] last 2 * block input samples
+    float *acc_re;              // Scratch: one spectrum
+    float *acc_im;
+    float *time;                // Scratch: 2 * block samples
+    size_t slot;                // Delay line slot of the newest spectrum
+} convolver_part_t;
+
+typedef struct {
+    unsigned int channels;
+    unsigned int ir_channels;
+    size_t head_block;
+    size_t tail_block;
+    float mix;                  // Wet level; dry is 1 - mix
+    bool realtime;              // Never wait on the worker (late tail is dropped)
+    
+    // Direct FIR over the first head_block IR samples
+    size_t fir_length;          // Up to head_block
+    float *fir_taps;            // [ir_channel][head_block], zero padded
+    float *fir_history;         // [channel][2 * head_block], doubled
+    size_t fir_pos;
+    
+    // Head level, fed and drained on the audio thread
+    bool has_head;
+    convolver_part_t head;
+    size_t head_pos;            // Frames into the current head block
+    float *head_out;            // [channel][head_block] due during this block
+    
+    // Tail level, on the worker
+    bool has_tail;
+    convolver_part_t tail;
+    frame_ring_t *tail_in;      // Dry frames to the worker
+    frame_ring_t *tail_out;     // Wet frames back, primed with 2 * tail_block zeros
+    float *tail_frames;         // Worker scratch: tail_block frames
+    float *tail_scratch;        // Audio thread scratch: head_block frames
+    size_t tail_debt;           // Late frames still to drop from tail_out
+    size_t tail_gap;            // Dry frames still to send as silence (realtime)
+    atomic_bool stop;
+    pthread_t worker;
+    bool worker_started;
+    atomic_uint_least64_t late_frames;
+    
+    float *wet;                 // Audio thread scratch: head_block frames
+} convolver_t;
+
+/**
+ * Build a convolver for channels interleaved channels. head_block and
+ * tail_block are powers of 2 with head_block <= tail_block (0 = the
+ * defaults); the FIR head truncates to the IR's length. realtime picks how
+ * a late tail is handled: zeros in its place (live audio) or waiting for
+ * the worker (file rendering, which must be exact). Returns NULL on
+ * failure or when the IR doesn't suit channels.
+ */
+convolver_t* convolver_create(const convolver_ir_t *ir, unsigned int channels,
+                              size_t head_block, size_t tail_block, float mix,
+                              bool realtime);
+
+/**
+ * Stop the worker and free everything.
+ */
+void convolver_free(convolver_t *conv);
+
+/**
+ * Convolve frames interleaved frames in place.
+ */
+void convolver_process(convolver_t *conv, float *buffer, size_t frames);
+
+/**
+ * Frames of tail the realtime mode had to replace with silence so far.
+ */
+uint64_t convolver_late_frames(const convolver_t *conv);
+
+#endif // CONVOLVER_H
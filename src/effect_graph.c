@@ -0,0 +1,650 @@
+#include "effect_graph.h"
+#include "convolver.h"
+#include "limiter.h"
+#include "resampler.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Default node state per node: enough for the largest built-in node
+#define EFFECT_GRAPH_NODE_RESERVE (sizeof(effect_chain_t) + EFFECT_GRAPH_ALIGN)
+
+static size_t align_up(size_t size) {
+    return (size + EFFECT_GRAPH_ALIGN - 1) & ~(size_t)(EFFECT_GRAPH_ALIGN - 1);
+}
+
+effect_graph_t* effect_graph_create(float sample_rate, unsigned int channels,
+                                    size_t max_frames, size_t arena_size) {
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS) {
+        return NULL;
+    }
+    if (max_frames == 0) {
+        max_frames = effect_chain_chunk_frames(channels);
+    }
+    if (arena_size == 0) {
+        arena_size = EFFECT_GRAPH_MAX_NODES * EFFECT_GRAPH_NODE_RESERVE;
+    }
+    
+    // Room for what compile carves out after the nodes
+    arena_size = align_up(arena_size) +
+                 align_up(EFFECT_GRAPH_MAX_NODES * sizeof(effect_node_t)) +
+                 align_up(max_frames * channels * sizeof(float));
+    
+    effect_graph_t *graph = calloc(1, sizeof(effect_graph_t));
+    if (!graph) {
+        return NULL;
+    }
+    
+    graph->arena = aligned_alloc(EFFECT_GRAPH_ALIGN, arena_size);
+    if (!graph->arena) {
+        free(graph);
+        return NULL;
+    }
+    
+    // Zeroing also faults every page in here rather than on the audio thread
+    memset(graph->arena, 0, arena_size);
+    graph->arena_size = arena_size;
+    graph->sample_rate = sample_rate;
+    graph->channels = channels;
+    graph->max_frames = max_frames;
+    
+    return graph;
+}
+
+void effect_graph_free(effect_graph_t *graph) {
+    if (graph) {
+        for (unsigned int i = 0; i < graph->node_count; i++) {
+            if (graph->nodes[i].destroy) {
+                graph->nodes[i].destroy(graph->nodes[i].state);
+            }
+        }
+        free(graph->pad);
+        free(graph->arena);
+        free(graph);
+    }
+}
+
+void* effect_graph_alloc(effect_graph_t *graph, size_t size) {
+    size_t offset = align_up(graph->arena_used);
+    if (offset > graph->arena_size || size > graph->arena_size - offset) {
+        return NULL;
+    }
+    
+    graph->arena_used = offset + size;
+    return graph->arena + offset;  // Zeroed at create, never reused
+}
+
+void* effect_graph_add_node(effect_graph_t *graph, effect_node_process_t process,
+                            size_t state_size) {
+    return effect_graph_add_node_ex(graph, process, NULL, state_size);
+}
+
+void* effect_graph_add_node_ex(effect_graph_t *graph, effect_node_process_t process,
+                               effect_node_destroy_t destroy, size_t state_size) {
+    if (graph->compiled || graph->node_count == EFFECT_GRAPH_MAX_NODES) {
+        return NULL;
+    }
+    
+    void *state = effect_graph_alloc(graph, state_size);
+    if (!state) {
+        return NULL;
+    }
+    
+    graph->nodes[graph->node_count].process = process;
+    graph->nodes[graph->node_count].destroy = destroy;
+    graph->nodes[graph->node_count].reset = NULL;
+    graph->nodes[graph->node_count].state = state;
+    graph->node_count++;
+    return state;
+}
+
+int effect_graph_set_reset(effect_graph_t *graph, const void *state, effect_node_reset_t reset) {
+    for (unsigned int i = 0; i < graph->node_count; i++) {
+        if (graph->nodes[i].state == state) {
+            graph->nodes[i].reset = reset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Built-in node callbacks
+
+static void graph_gain_process(void *state, float *buffer, size_t frames,
+                               unsigned int channels) {
+    gain_process((gain_effect_t*)state, buffer, frames * channels);
+}
+
+// A fixed gain has no history
+static void graph_stateless_reset(void *state) {
+    (void)state;
+}
+
+static void graph_filter_process(void *state, float *buffer, size_t frames,
+                                 unsigned int channels) {
+    (void)channels;
+    biquad_cascade_process((biquad_cascade_t*)state, buffer, frames);
+}
+
+static void graph_filter_reset(void *state) {
+    biquad_cascade_reset((biquad_cascade_t*)state);
+}
+
+static void graph_compressor_process(void *state, float *buffer, size_t frames,
+                                     unsigned int channels) {
+    (void)channels;
+    compressor_multi_process((compressor_multi_t*)state, buffer, frames);
+}
+
+static void graph_compressor_reset(void *state) {
+    compressor_multi_t *comp = (compressor_multi_t*)state;
+    memset(comp->envelope, 0, sizeof(comp->envelope));
+}
+
+static void graph_chain_process(void *state, float *buffer, size_t frames,
+                                unsigned int channels) {
+    (void)channels;
+    effect_chain_process((effect_chain_t*)state, buffer, frames);
+}
+
+static void graph_chain_reset(void *state) {
+    effect_chain_reset((effect_chain_t*)state);
+}
+
+// The convolver's tables are too big for the arena; the node holds a pointer
+static void graph_convolver_process(void *state, float *buffer, size_t frames,
+                                    unsigned int channels) {
+    (void)channels;
+    convolver_process(*(convolver_t**)state, buffer, frames);
+}
+
+static void graph_convolver_destroy(void *state) {
+    convolver_free(*(convolver_t**)state);
+}
+
+// Likewise the limiter's delay line
+static void graph_limiter_process(void *state, float *buffer, size_t frames,
+                                  unsigned int channels) {
+    (void)channels;
+    limiter_process(*(limiter_t**)state, buffer, frames);
+}
+
+static void graph_limiter_destroy(void *state) {
+    limiter_free(*(limiter_t**)state);
+}
+
+static void graph_limiter_reset(void *state) {
+    limiter_reset(*(limiter_t**)state);
+}
+
+int effect_graph_add_gain(effect_graph_t *graph, float gain_db) {
+    gain_effect_t *gain = effect_graph_add_node(graph, graph_gain_process, sizeof(gain_effect_t));
+    if (!gain) {
+        return -1;
+    }
+    gain_init(gain, gain_db);
+    return effect_graph_set_reset(graph, gain, graph_stateless_reset);
+}
+
+static int graph_add_filter(effect_graph_t *graph, const biquad_cascade_t *design) {
+    biquad_cascade_t *filter = effect_graph_add_node(graph, graph_filter_process,
+                                                     sizeof(biquad_cascade_t));
+    if (!filter) {
+        return -1;
+    }
+    *filter = *design;
+    return effect_graph_set_reset(graph, filter, graph_filter_reset);
+}
+
+int effect_graph_add_lowpass(effect_graph_t *graph, float cutoff_freq, unsigned int order) {
+    biquad_cascade_t design;
+    if (biquad_cascade_lowpass(&design, graph->sample_rate, cutoff_freq, order,
+                               graph->channels) != 0) {
+        return -1;
+    }
+    return graph_add_filter(graph, &design);
+}
+
+int effect_graph_add_highpass(effect_graph_t *graph, float cutoff_freq, unsigned int order) {
+    biquad_cascade_t design;
+    if (biquad_cascade_highpass(&design, graph->sample_rate, cutoff_freq, order,
+                                graph->channels) != 0) {
+        return -1;
+    }
+    return graph_add_filter(graph, &design);
+}
+
+int effect_graph_add_compressor(effect_graph_t *graph, float threshold_db, float ratio,
+                                float attack_ms, float release_ms) {
+    compressor_multi_t *comp = effect_graph_add_node(graph, graph_compressor_process,
+                                                     sizeof(compressor_multi_t));
+    if (!comp) {
+        return -1;
+    }
+    
+    compressor_t design;
+    compressor_init(&design, threshold_db, ratio, attack_ms, release_ms, graph->sample_rate);
+    compressor_multi_init(comp, &design, graph->channels);
+    return effect_graph_set_reset(graph, comp, graph_compressor_reset);
+}
+
+effect_chain_t* effect_graph_add_chain(effect_graph_t *graph, const effect_chain_config_t *config) {
+    effect_chain_t *chain = effect_graph_add_node(graph, graph_chain_process,
+                                                  sizeof(effect_chain_t));
+    if (!chain) {
+        return NULL;
+    }
+    
+    effect_chain_configure(chain, config, graph->sample_rate, graph->channels);
+    effect_graph_set_reset(graph, chain, graph_chain_reset);
+    if (!graph->chain) {
+        graph->chain = chain;
+    }
+    return chain;
+}
+
+/**
+ * ir at the graph's rate, into *out with malloc'd *samples. The taps are
+ * scaled by the rate ratio: the same response over more (or fewer) taps
+ * would otherwise come out louder (or quieter).
+ */
+static int graph_resample_ir(const effect_graph_t *graph, const convolver_ir_t *ir,
+                             convolver_ir_t *out, float **samples) {
+    if (!ir->samples || ir->frames == 0 || ir->channels == 0) {
+        return -1;
+    }
+    
+    resampler_t *rs = resampler_create(ir->channels, ir->sample_rate, graph->sample_rate);
+    // Room for the interpolation filter's reach past the last tap
+    size_t frames = resampler_output_frames(ir->frames + RESAMPLER_TAPS / 2, ir->sample_rate,
+                                            graph->sample_rate);
+    float *converted = malloc(frames * ir->channels * sizeof(float));
+    if (!rs || !converted) {
+        resampler_free(rs);
+        free(converted);
+        return -1;
+    }
+    
+    size_t produced = resampler_process(rs, ir->samples, ir->frames, NULL, converted, frames);
+    resampler_drain(rs, &converted[produced * ir->channels], frames - produced);
+    resampler_free(rs);
+    
+    float scale = (float)ir->sample_rate / graph->sample_rate;
+    for (size_t i = 0; i < frames * ir->channels; i++) {
+        converted[i] *= scale;
+    }
+    
+    *out = *ir;
+    out->samples = converted;
+    out->frames = frames;
+    out->sample_rate = 0;
+    *samples = converted;
+    return 0;
+}
+
+int effect_graph_add_convolver(effect_graph_t *graph, const struct convolver_ir *ir, float mix,
+                               bool realtime) {
+    // Refuse before starting a worker thread that would have nowhere to go
+    if (graph->compiled || graph->node_count == EFFECT_GRAPH_MAX_NODES) {
+        return -1;
+    }
+    
+    // The convolver copies the taps into its spectra, so a converted IR
+    // only has to outlive convolver_create
+    convolver_ir_t converted;
+    float *samples = NULL;
+    if (ir && ir->sample_rate != 0 && (float)ir->sample_rate != graph->sample_rate) {
+        if (graph_resample_ir(graph, ir, &converted, &samples) != 0) {
+            return -1;
+        }
+        ir = &converted;
+    }
+    
+    convolver_t *conv = convolver_create(ir, graph->channels, 0, 0, mix, realtime);
+    free(samples);
+    if (!conv) {
+        return -1;
+    }
+    
+    convolver_t **node = effect_graph_add_node_ex(graph, graph_convolver_process,
+                                                  graph_convolver_destroy, sizeof(convolver_t*));
+    if (!node) {
+        convolver_free(conv);
+        return -1;
+    }
+    *node = conv;
+    return 0;
+}
+
+int effect_graph_add_limiter(effect_graph_t *graph, float ceiling_db, float lookahead_ms,
+                             float release_ms) {
+    if (graph->compiled || graph->node_count == EFFECT_GRAPH_MAX_NODES) {
+        return -1;
+    }
+    
+    limiter_t *lim = limiter_create(graph->channels, graph->sample_rate, ceiling_db,
+                                    lookahead_ms, release_ms);
+    if (!lim) {
+        return -1;
+    }
+    
+    limiter_t **node = effect_graph_add_node_ex(graph, graph_limiter_process,
+                                                graph_limiter_destroy, sizeof(limiter_t*));
+    if (!node) {
+        limiter_free(lim);
+        return -1;
+    }
+    *node = lim;
+    effect_graph_set_reset(graph, node, graph_limiter_reset);
+    graph->latency += limiter_latency(lim);
+    return 0;
+}
+
+size_t effect_graph_latency(const effect_graph_t *graph) {
+    return graph->latency;
+}
+
+int effect_graph_set_latency(effect_graph_t *graph, size_t latency) {
+    size_t nodes = graph->latency - graph->pad_frames;
+    if (latency < nodes) {
+        return -1;
+    }
+    
+    size_t frames = latency - nodes;
+    float *pad = NULL;
+    if (frames > 0) {
+        pad = malloc(frames * graph->channels * sizeof(float));
+        if (!pad) {
+            return -1;
+        }
+        // Written out rather than calloc'd, so no page faults on the audio thread
+        memset(pad, 0, frames * graph->channels * sizeof(float));
+    }
+    
+    free(graph->pad);
+    graph->pad = pad;
+    graph->pad_frames = frames;
+    graph->pad_pos = 0;
+    graph->latency = latency;
+    return 0;
+}
+
+int effect_graph_reset(effect_graph_t *graph) {
+    for (unsigned int i = 0; i < graph->node_count; i++) {
+        if (!graph->nodes[i].reset) {
+            return -1;
+        }
+    }
+    for (unsigned int i = 0; i < graph->node_count; i++) {
+        graph->nodes[i].reset(graph->nodes[i].state);
+    }
+    if (graph->pad) {
+        memset(graph->pad, 0, graph->pad_frames * graph->channels * sizeof(float));
+        graph->pad_pos = 0;
+    }
+    return 0;
+}
+
+int effect_graph_compile(effect_graph_t *graph) {
+    if (graph->compiled) {
+        return 0;
+    }
+    
+    effect_node_t *schedule = effect_graph_alloc(graph, graph->node_count * sizeof(effect_node_t));
+    float *scratch = effect_graph_alloc(graph, graph->max_frames * graph->channels * sizeof(float));
+    if (!schedule || !scratch) {
+        return -1;
+    }
+    
+    memcpy(schedule, graph->nodes, graph->node_count * sizeof(effect_node_t));
+    graph->schedule = schedule;
+    graph->scratch = scratch;
+    graph->compiled = true;
+    return 0;
+}
+
+effect_graph_t* effect_graph_from_config(const effect_chain_config_t *config, float sample_rate,
+                                         unsigned int channels, size_t max_frames) {
+    effect_graph_t *graph = effect_graph_create(sample_rate, channels, max_frames, 0);
+    if (!graph) {
+        return NULL;
+    }
+    
+    // The chain takes the low-pass, so a high-pass next to it gets its own
+    // node. Both are linear, so running it ahead of the chain's gain is the
+    // same as running it right before the compressor.
+    bool ok = true;
+    if (config->enabled && config->lowpass_freq > 0 && config->highpass_freq > 0) {
+        unsigned int order = config->filter_order ? config->filter_order : 2;
+        ok = effect_graph_add_highpass(graph, config->highpass_freq, order) == 0;
+    }
+    
+    // Always present, even bypassed, so the chain can be retuned live
+    ok = ok && effect_graph_add_chain(graph, config) != NULL;
+    
+    if (ok && config->enabled && config->ir) {
+        ok = effect_graph_add_convolver(graph, config->ir, config->ir_mix,
+                                        config->ir_realtime) == 0;
+    }
+    
+    // Last, so nothing after it can push a peak back over the ceiling
+    if (ok && config->enabled && config->limit) {
+        ok = effect_graph_add_limiter(graph, config->limit_ceiling_db,
+                                      config->limit_lookahead_ms, LIMITER_RELEASE_MS) == 0;
+    }
+    
+    if (!ok || effect_graph_compile(graph) != 0) {
+        effect_graph_free(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+/**
+ * Run frames through the padding delay line: swap each frame with the one
+ * stored pad_frames ago.
+ */
+static void graph_pad_process(effect_graph_t *graph, float *buffer, size_t frames) {
+    unsigned int channels = graph->channels;
+    size_t pos = graph->pad_pos;
+    
+    for (size_t i = 0; i < frames; i++) {
+        float *line = &graph->pad[pos * channels];
+        float *frame = &buffer[i * channels];
+        for (unsigned int c = 0; c < channels; c++) {
+            float in = frame[c];
+            frame[c] = line[c];
+            line[c] = in;
+        }
+        if (++pos == graph->pad_frames) {
+            pos = 0;
+        }
+    }
+    graph->pad_pos = pos;
+}
+
+void effect_graph_process(effect_graph_t *graph, float *buffer, size_t frames) {
+    const effect_node_t *schedule = graph->schedule;
+    unsigned int count = graph->node_count;
+    unsigned int channels = graph->channels;
+    
+    // A lone node does its own chunking
+    if (count == 1) {
+        schedule[0].process(schedule[0].state, buffer, frames, channels);
+        if (graph->pad) {
+            graph_pad_process(graph, buffer, frames);
+        }
+        return;
+    }
+    
+    size_t chunk = graph->max_frames;
+    for (size_t pos = 0; pos < frames; pos += chunk) {
+        size_t n = frames - pos;
+        if (n > chunk) n = chunk;
+        float *block = &buffer[pos * channels];
+        
+        for (unsigned int i = 0; i < count; i++) {
+            schedule[i].process(schedule[i].state, block, n, channels);
+        }
+        if (graph->pad) {
+            graph_pad_process(graph, block, n);
+        }
+    }
+}
+
+void effect_graph_process_split(effect_graph_t *graph, const frame_ring_span_t *span) {
+    effect_graph_process(graph, span->data1, span->frames1);
+    if (span->frames2 > 0) {
+        effect_graph_process(graph, span->data2, span->frames2);
+    }
+}
+
+// Crossfade state for the block that switches graphs
+typedef struct {
+    effect_graph_t *from;   // NULL = dry
+    effect_graph_t *to;
+    size_t done;            // Frames faded so far
+    size_t total;           // Frames in the block
+} graph_fade_t;
+
+/**
+ * Run both graphs, the new one on a copy in its scratch buffer, and mix
+ * linearly from old to new across the block. Both run at the runner's
+ * latency and the new one has been primed, so the two outputs line up.
+ */
+static void graph_fade_span(graph_fade_t *fade, float *buffer, size_t frames) {
+    effect_graph_t *to = fade->to;
+    unsigned int channels = to->channels;
+    float *scratch = to->scratch;
+    
+    for (size_t pos = 0; pos < frames; pos += to->max_frames) {
+        size_t n = frames - pos;
+        if (n > to->max_frames) n = to->max_frames;
+        float *block = &buffer[pos * channels];
+        
+        memcpy(scratch, block, n * channels * sizeof(float));
+        if (fade->from) {
+            effect_graph_process(fade->from, block, n);
+        }
+        effect_graph_process(to, scratch, n);
+        
+        for (size_t i = 0; i < n; i++) {
+            float t = (float)(fade->done + i + 1) / (float)fade->total;
+            for (unsigned int c = 0; c < channels; c++) {
+                size_t k = i * channels + c;
+                block[k] += (scratch[k] - block[k]) * t;
+            }
+        }
+        fade->done += n;
+    }
+}
+
+/**
+ * Run the next graph on a copy of frames, dropping its output: it fills its
+ * delay lines and settles its state before it's heard.
+ */
+static void graph_prime_span(effect_graph_t *graph, const float *buffer, size_t frames) {
+    unsigned int channels = graph->channels;
+    
+    for (size_t pos = 0; pos < frames; pos += graph->max_frames) {
+        size_t n = frames - pos;
+        if (n > graph->max_frames) n = graph->max_frames;
+        memcpy(graph->scratch, &buffer[pos * channels], n * channels * sizeof(float));
+        effect_graph_process(graph, graph->scratch, n);
+    }
+}
+
+void effect_graph_runner_init(effect_graph_runner_t *runner, effect_graph_t *graph) {
+    atomic_init(&runner->pending, NULL);
+    atomic_init(&runner->retired, NULL);
+    runner->current = graph;
+    runner->next = NULL;
+    runner->primed = 0;
+    runner->channels = graph ? graph->channels : 0;
+    runner->latency = graph ? graph->latency : 0;
+}
+
+int effect_graph_runner_publish(effect_graph_runner_t *runner, effect_graph_t *graph) {
+    if (!graph || !graph->compiled ||
+        (runner->channels != 0 && graph->channels != runner->channels)) {
+        return -1;
+    }
+    if (graph->latency != runner->latency &&
+        effect_graph_set_latency(graph, runner->latency) != 0) {
+        return -1;
+    }
+    
+    effect_graph_t *expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(&runner->pending, &expected, graph,
+                                                 memory_order_release,
+                                                 memory_order_relaxed)) {
+        return -1;
+    }
+    runner->channels = graph->channels;
+    return 0;
+}
+
+effect_graph_t* effect_graph_runner_collect(effect_graph_runner_t *runner) {
+    return atomic_exchange_explicit(&runner->retired, NULL, memory_order_acquire);
+}
+
+void effect_graph_runner_process_split(effect_graph_runner_t *runner,
+                                       const frame_ring_span_t *span) {
+    effect_graph_t *current = runner->current;
+    size_t frames = span->frames1 + span->frames2;
+    if (frames == 0) {
+        return;
+    }
+    
+    // Take a graph only once the last retired one is gone, so the slot is free
+    if (!runner->next &&
+        atomic_load_explicit(&runner->pending, memory_order_relaxed) != NULL &&
+        atomic_load_explicit(&runner->retired, memory_order_acquire) == NULL) {
+        runner->next = atomic_exchange_explicit(&runner->pending, NULL, memory_order_acquire);
+        runner->primed = 0;
+    }
+    
+    effect_graph_t *next = runner->next;
+    if (next && runner->primed >= next->latency) {
+        graph_fade_t fade = { current, next, 0, frames };
+        graph_fade_span(&fade, span->data1, span->frames1);
+        if (span->frames2 > 0) {
+            graph_fade_span(&fade, span->data2, span->frames2);
+        }
+        
+        runner->current = next;
+        runner->next = NULL;
+        if (current) {
+            atomic_store_explicit(&runner->retired, current, memory_order_release);
+        }
+        return;
+    }
+    
+    // Until the next graph's output is real audio, it runs unheard
+    if (next) {
+        graph_prime_span(next, span->data1, span->frames1);
+        if (span->frames2 > 0) {
+            graph_prime_span(next, span->data2, span->frames2);
+        }
+        runner->primed += frames;
+    }
+    if (current) {
+        effect_graph_process_split(current, span);
+    }
+}
+
+effect_chain_t* effect_graph_runner_chain(effect_graph_runner_t *runner) {
+    return runner->current ? runner->current->chain : NULL;
+}
+
+size_t effect_graph_runner_latency(const effect_graph_runner_t *runner) {
+    return runner->current ? runner->current->latency : 0;
+}
+
+void effect_graph_runner_destroy(effect_graph_runner_t *runner) {
+    effect_graph_free(runner->current);
+    effect_graph_free(runner->next);
+    effect_graph_free(atomic_exchange(&runner->pending, NULL));
+    effect_graph_free(atomic_exchange(&runner->retired, NULL));
+    runner->current = NULL;
+    runner->next = NULL;
+}
@@ -0,0 +1,265 @@
+#ifndef EFFECT_GRAPH_H
+#define EFFECT_GRAPH_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "effects.h"
+#include "frame_ring.h"
+
+/**
+ * Effect graph: a series of nodes, each a process callback plus its state,
+ * run in order over the same interleaved buffer.
+ *
+ * A graph is built off the audio thread: effect_graph_create allocates one
+ * cache-aligned arena, every effect_graph_add_* carves the node's state from
+ * it, and effect_graph_compile lays the nodes out as a flat schedule in the
+ * arena together with the graph's scratch buffer. Processing then touches
+ * nothing but the arena and the caller's buffer, and runs every node over
+ * one max_frames chunk before moving to the next so a large block crosses
+ * memory once.
+ *
+ * The built-in nodes wrap the effects in effects.h. A chain node is a whole
+ * effect_chain_t, which keeps its fused kernels and realtime setters (and
+ * so param_queue_apply) inside a graph.
+ */
+
+#define EFFECT_GRAPH_ALIGN 64          // Arena allocations start on a cache line
+#define EFFECT_GRAPH_MAX_NODES 16
+
+/**
+ * Process frames interleaved frames of channels channels in place.
+ */
+typedef void (*effect_node_process_t)(void *state, float *buffer, size_t frames,
+                                      unsigned int channels);
+
+/**
+ * Release whatever a node's state owns outside the arena (threads, large
+ * tables). Called by effect_graph_free.
+ */
+typedef void (*effect_node_destroy_t)(void *state);
+
+/**
+ * Clear a node's history (filter state, envelopes, delay lines), keeping
+ * its settings, so the next block starts a new stream.
+ */
+typedef void (*effect_node_reset_t)(void *state);
+
+typedef struct {
+    effect_node_process_t process;
+    effect_node_destroy_t destroy;   // NULL when the state is all in the arena
+    effect_node_reset_t reset;       // NULL when the node can't be reset
+    void *state;                     // In the graph's arena
+} effect_node_t;
+
+typedef struct {
+    unsigned char *arena;            // One aligned allocation holding everything below
+    size_t arena_size;
+    size_t arena_used;
+    
+    float sample_rate;
+    unsigned int channels;
+    size_t max_frames;               // Frames per processing chunk
+    
+    effect_node_t nodes[EFFECT_GRAPH_MAX_NODES];  // Build order
+    unsigned int node_count;
+    
+    // Set by effect_graph_compile
+    effect_node_t *schedule;         // node_count entries, in the arena
+    float *scratch;                  // max_frames * channels samples, in the arena
+    bool compiled;
+    
+    effect_chain_t *chain;           // First chain node, or NULL
+    size_t latency;                  // Frames the output lags the input, padding included
+    
+    // Set by effect_graph_set_latency
+    float *pad;                      // pad_frames * channels samples of delay line, or NULL
+    size_t pad_frames;               // Frames of delay after the last node
+    size_t pad_pos;                  // Next frame of the delay line to swap out
+} effect_graph_t;
+
+/**
+ * Create an empty graph whose arena holds arena_size bytes of node state
+ * (0 = room for EFFECT_GRAPH_MAX_NODES built-in nodes) plus the schedule and
+ * scratch buffer. max_frames 0 picks effect_chain_chunk_frames. channels
+ * must be between 1 and EFFECT_MAX_CHANNELS. Returns NULL on failure.
+ */
+effect_graph_t* effect_graph_create(float sample_rate, unsigned int channels,
+                                    size_t max_frames, size_t arena_size);
+
+/**
+ * Destroy the graph, its nodes and its arena.
+ */
+void effect_graph_free(effect_graph_t *graph);
+
+/**
+ * Carve size bytes from the arena, aligned to EFFECT_GRAPH_ALIGN and zeroed.
+ * Returns NULL when the arena is exhausted.
+ */
+void* effect_graph_alloc(effect_graph_t *graph, size_t size);
+
+/**
+ * Append a node with state_size bytes of zeroed arena state, which the
+ * caller initializes through the returned pointer. Returns NULL if the graph
+ * is compiled, full, or out of arena.
+ */
+void* effect_graph_add_node(effect_graph_t *graph, effect_node_process_t process,
+                            size_t state_size);
+
+/**
+ * As effect_graph_add_node, with a destroy callback for the state.
+ */
+void* effect_graph_add_node_ex(effect_graph_t *graph, effect_node_process_t process,
+                               effect_node_destroy_t destroy, size_t state_size);
+
+/**
+ * Give the node whose state is state a reset callback. Returns 0, or -1 if
+ * no node has that state.
+ */
+int effect_graph_set_reset(effect_graph_t *graph, const void *state, effect_node_reset_t reset);
+
+/**
+ * Built-in nodes. Return 0 on success, -1 on failure (see add_node, or an
+ * invalid filter design). add_chain returns the chain, or NULL. All but
+ * the convolver, whose tail may be in flight on its worker, can be reset.
+ */
+int effect_graph_add_gain(effect_graph_t *graph, float gain_db);
+int effect_graph_add_lowpass(effect_graph_t *graph, float cutoff_freq, unsigned int order);
+int effect_graph_add_highpass(effect_graph_t *graph, float cutoff_freq, unsigned int order);
+int effect_graph_add_compressor(effect_graph_t *graph, float threshold_db, float ratio,
+                                float attack_ms, float release_ms);
+effect_chain_t* effect_graph_add_chain(effect_graph_t *graph, const effect_chain_config_t *config);
+
+/**
+ * Convolution with ir (see convolver.h), mixed in at mix. An IR recorded at
+ * another rate is resampled to the graph's first, keeping its gain; rates
+ * more than RESAMPLER_MAX_RATIO apart fail. The convolver and its worker
+ * thread live until the graph is freed.
+ */
+int effect_graph_add_convolver(effect_graph_t *graph, const struct convolver_ir *ir, float mix,
+                               bool realtime);
+
+/**
+ * Lookahead brickwall limiter (see limiter.h). Adds its lookahead to the
+ * graph's latency.
+ */
+int effect_graph_add_limiter(effect_graph_t *graph, float ceiling_db, float lookahead_ms,
+                             float release_ms);
+
+/**
+ * Frames the graph delays its audio by; the processing modes drop that
+ * much from the start of the output (file modes) or count it towards the
+ * latency target (live mode).
+ */
+size_t effect_graph_latency(const effect_graph_t *graph);
+
+/**
+ * Delay the graph's output after its last node so its latency comes to
+ * latency frames, e.g. to match another graph it will be crossfaded with.
+ * Allocates the delay line, so call it off the audio thread; replaces any
+ * earlier padding. Returns -1, touching nothing, if the nodes alone lag
+ * more than latency or the allocation fails.
+ */
+int effect_graph_set_latency(effect_graph_t *graph, size_t latency);
+
+/**
+ * Reset every node, so the graph renders a new stream exactly as a freshly
+ * built one would, without reallocating. Returns -1, touching nothing, if
+ * any node can't be reset; build a new graph then.
+ */
+int effect_graph_reset(effect_graph_t *graph);
+
+/**
+ * Freeze the graph into its execution schedule and allocate the scratch
+ * buffer. No nodes can be added afterwards. Returns 0 on success, -1 if the
+ * arena is exhausted.
+ */
+int effect_graph_compile(effect_graph_t *graph);
+
+/**
+ * Build and compile the graph for config: a chain node holding gain, the
+ * low-pass (or high-pass) filter and the compressor, preceded by a high-pass
+ * node when both filters are set and followed by a convolver node when
+ * config has an IR, then a limiter node when config limits. The chain node
+ * is there even when config bypasses everything, so it can be retuned live.
+ * Returns NULL on failure.
+ */
+effect_graph_t* effect_graph_from_config(const effect_chain_config_t *config, float sample_rate,
+                                         unsigned int channels, size_t max_frames);
+
+/**
+ * Process frames interleaved frames in place. The graph must be compiled;
+ * an empty graph passes audio through.
+ */
+void effect_graph_process(effect_graph_t *graph, float *buffer, size_t frames);
+
+/**
+ * Process a region of a float frame ring (frame_ring.h) given as its two
+ * runs of whole frames, e.g. a wrapped span, in place.
+ */
+void effect_graph_process_split(effect_graph_t *graph, const frame_ring_span_t *span);
+
+/**
+ * Hands compiled graphs from a control thread to the audio thread.
+ *
+ * The control thread publishes a new graph; the audio thread picks it up at
+ * the start of its next block, runs it on a copy of its input until it has
+ * put out its latency's worth of audio, crossfades from the old graph over
+ * the block after, and hands the old graph back through the retired slot
+ * for the control thread to free. All three steps are single atomic
+ * exchanges, and the audio thread only takes a new graph once the previous
+ * one has been collected, so it never allocates, frees or waits.
+ *
+ * Every graph runs at the latency of the one the runner starts with:
+ * publish pads a faster graph up to it, so both sides of a crossfade are
+ * aligned and the stream's delay never jumps. Start with a graph padded
+ * (effect_graph_set_latency) to the slowest one that may be published.
+ */
+typedef struct {
+    _Atomic(effect_graph_t*) pending;  // Published, not yet running
+    _Atomic(effect_graph_t*) retired;  // Replaced, waiting to be freed
+    effect_graph_t *current;           // Audio thread only
+    effect_graph_t *next;              // Audio thread only: taken from pending, warming up
+    size_t primed;                     // Audio thread only: frames next has run
+    unsigned int channels;             // Control thread only; 0 until a graph is set
+    size_t latency;                    // Control thread only: every graph's latency
+} effect_graph_runner_t;
+
+/**
+ * Start with graph running (may be NULL for passthrough, at latency 0).
+ */
+void effect_graph_runner_init(effect_graph_runner_t *runner, effect_graph_t *graph);
+
+/**
+ * Control side. publish pads graph to the runner's latency and returns -1 if
+ * the previous graph hasn't been picked up yet (retry after collect), or if
+ * graph's channel count doesn't match or it lags more than the runner's
+ * latency. collect returns a retired graph to free, or NULL.
+ */
+int effect_graph_runner_publish(effect_graph_runner_t *runner, effect_graph_t *graph);
+effect_graph_t* effect_graph_runner_collect(effect_graph_runner_t *runner);
+
+/**
+ * Audio side: process as effect_graph_process_split, warming up or
+ * crossfading to a published graph if there is one.
+ */
+void effect_graph_runner_process_split(effect_graph_runner_t *runner,
+                                       const frame_ring_span_t *span);
+
+/**
+ * Audio side: the running graph's chain node (for param_queue_apply), or NULL.
+ */
+effect_chain_t* effect_graph_runner_chain(effect_graph_runner_t *runner);
+
+/**
+ * Audio side, or before the audio thread starts: the running graph's
+ * latency in frames (0 with no graph).
+ */
+size_t effect_graph_runner_latency(const effect_graph_runner_t *runner);
+
+/**
+ * Free every graph the runner holds. Only once the audio thread has stopped.
+ */
+void effect_graph_runner_destroy(effect_graph_runner_t *runner);
+
+#endif // EFFECT_GRAPH_H
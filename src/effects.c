@@ -4,20 +4,219 @@
 #define M_PI 3.14159265358979323846
 #endif
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 // ============================================================================
 // GAIN EFFECT
 // ============================================================================
 
+/**
+ * Gain kernels. apply multiplies by a constant; ramp multiplies sample i by
+ * start + step * (i + 1). All variants evaluate exactly that expression in
+ * single precision without FMA, so they agree bit for bit with the scalar
+ * code and with each other.
+ */
+typedef struct {
+    const char *name;
+    void (*apply)(float *buffer, size_t samples, float gain);
+    void (*ramp)(float *buffer, size_t samples, float start, float step);
+} gain_kernel_t;
+
+static void gain_apply_scalar(float *buffer, size_t samples, float gain) {
+    for (size_t i = 0; i < samples; i++) {
+        buffer[i] *= gain;
+    }
+}
+
+static void gain_ramp_scalar(float *buffer, size_t samples, float start, float step) {
+    for (size_t i = 0; i < samples; i++) {
+        buffer[i] *= start + step * (float)(i + 1);
+    }
+}
+
+#if defined(__SSE2__)
+static void gain_apply_sse2(float *buffer, size_t samples, float gain) {
+    __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_loadu_ps(&buffer[i]);
+        __m128 b = _mm_loadu_ps(&buffer[i + 4]);
+        _mm_storeu_ps(&buffer[i], _mm_mul_ps(a, g));
+        _mm_storeu_ps(&buffer[i + 4], _mm_mul_ps(b, g));
+    }
+    gain_apply_scalar(&buffer[i], samples - i, gain);
+}
+
+static void gain_ramp_sse2(float *buffer, size_t samples, float start, float step) {
+    __m128 base = _mm_set1_ps(start);
+    __m128 delta = _mm_set1_ps(step);
+    __m128 index = _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f);
+    __m128 four = _mm_set1_ps(4.0f);
+    size_t i = 0;
+    
+    for (; i + 4 <= samples; i += 4) {
+        __m128 g = _mm_add_ps(base, _mm_mul_ps(delta, index));
+        _mm_storeu_ps(&buffer[i], _mm_mul_ps(_mm_loadu_ps(&buffer[i]), g));
+        index = _mm_add_ps(index, four);
+    }
+    for (; i < samples; i++) {
+        buffer[i] *= start + step * (float)(i + 1);
+    }
+}
+
+// AVX2 is not baseline: build these for it and only call them after cpuid says so
+__attribute__((target("avx2")))
+static void gain_apply_avx2(float *buffer, size_t samples, float gain) {
+    __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    
+    for (; i + 16 <= samples; i += 16) {
+        __m256 a = _mm256_loadu_ps(&buffer[i]);
+        __m256 b = _mm256_loadu_ps(&buffer[i + 8]);
+        _mm256_storeu_ps(&buffer[i], _mm256_mul_ps(a, g));
+        _mm256_storeu_ps(&buffer[i + 8], _mm256_mul_ps(b, g));
+    }
+    gain_apply_scalar(&buffer[i], samples - i, gain);
+}
+
+__attribute__((target("avx2")))
+static void gain_ramp_avx2(float *buffer, size_t samples, float start, float step) {
+    __m256 base = _mm256_set1_ps(start);
+    __m256 delta = _mm256_set1_ps(step);
+    __m256 index = _mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+    __m256 eight = _mm256_set1_ps(8.0f);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        __m256 g = _mm256_add_ps(base, _mm256_mul_ps(delta, index));
+        _mm256_storeu_ps(&buffer[i], _mm256_mul_ps(_mm256_loadu_ps(&buffer[i]), g));
+        index = _mm256_add_ps(index, eight);
+    }
+    for (; i < samples; i++) {
+        buffer[i] *= start + step * (float)(i + 1);
+    }
+}
+#endif // __SSE2__
+
+#if defined(__ARM_NEON)
+static void gain_apply_neon(float *buffer, size_t samples, float gain) {
+    float32x4_t g = vdupq_n_f32(gain);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        float32x4_t a = vld1q_f32(&buffer[i]);
+        float32x4_t b = vld1q_f32(&buffer[i + 4]);
+        vst1q_f32(&buffer[i], vmulq_f32(a, g));
+        vst1q_f32(&buffer[i + 4], vmulq_f32(b, g));
+    }
+    gain_apply_scalar(&buffer[i], samples - i, gain);
+}
+
+static void gain_ramp_neon(float *buffer, size_t samples, float start, float step) {
+    static const float first[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    float32x4_t base = vdupq_n_f32(start);
+    float32x4_t delta = vdupq_n_f32(step);
+    float32x4_t index = vld1q_f32(first);
+    float32x4_t four = vdupq_n_f32(4.0f);
+    size_t i = 0;
+    
+    // vmulq + vaddq rather than vmlaq, which may fuse and change rounding
+    for (; i + 4 <= samples; i += 4) {
+        float32x4_t g = vaddq_f32(base, vmulq_f32(delta, index));
+        vst1q_f32(&buffer[i], vmulq_f32(vld1q_f32(&buffer[i]), g));
+        index = vaddq_f32(index, four);
+    }
+    for (; i < samples; i++) {
+        buffer[i] *= start + step * (float)(i + 1);
+    }
+}
+#endif // __ARM_NEON
+
+static const gain_kernel_t gain_kernels[] = {
+#if defined(__SSE2__)
+    { "avx2", gain_apply_avx2, gain_ramp_avx2 },
+    { "sse2", gain_apply_sse2, gain_ramp_sse2 },
+#endif
+#if defined(__ARM_NEON)
+    { "neon", gain_apply_neon, gain_ramp_neon },
+#endif
+    { "scalar", gain_apply_scalar, gain_ramp_scalar },
+};
+
+#define GAIN_KERNEL_COUNT (sizeof(gain_kernels) / sizeof(gain_kernels[0]))
+
+// Resolved on first use; every thread that races here picks the same entry
+static _Atomic(const gain_kernel_t *) gain_kernel = NULL;
+
+static bool gain_kernel_supported(const gain_kernel_t *kernel) {
+#if defined(__SSE2__)
+    if (strcmp(kernel->name, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    (void)kernel;
+    return true;
+}
+
+int gain_select_kernel(const char *name) {
+    for (size_t i = 0; i < GAIN_KERNEL_COUNT; i++) {
+        // Table is in order of preference, so the first usable one is best
+        if ((name == NULL || strcmp(gain_kernels[i].name, name) == 0) &&
+            gain_kernel_supported(&gain_kernels[i])) {
+            atomic_store_explicit(&gain_kernel, &gain_kernels[i], memory_order_release);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const gain_kernel_t* gain_get_kernel(void) {
+    const gain_kernel_t *kernel = atomic_load_explicit(&gain_kernel, memory_order_acquire);
+    if (!kernel) {
+        gain_select_kernel(NULL);
+        kernel = atomic_load_explicit(&gain_kernel, memory_order_acquire);
+    }
+    return kernel;
+}
+
+const char* gain_kernel_name(void) {
+    return gain_get_kernel()->name;
+}
+
 void gain_init(gain_effect_t *effect, float gain_db) {
     // Convert dB to linear gain: gain = 10^(dB/20)
     effect->gain = powf(10.0f, gain_db / 20.0f);
+    effect->target = effect->gain;
+    
+    // Resolve the kernel here, at setup, rather than on the first audio block
+    gain_get_kernel();
 }
 
-void gain_process(gain_effect_t *effect, float *buffer, size_t frames) {
-    for (size_t i = 0; i < frames; i++) {
-        buffer[i] *= effect->gain;
+void gain_set_target(gain_effect_t *effect, float gain_db) {
+    effect->target = powf(10.0f, gain_db / 20.0f);
+}
+
+void gain_process(gain_effect_t *effect, float *buffer, size_t samples) {
+    // Gain goes by value, so stores through buffer never force it to reload
+    gain_get_kernel()->apply(buffer, samples, effect->gain);
+}
+
+void gain_process_smooth(gain_effect_t *effect, float *buffer, size_t samples) {
+    if (samples == 0) {
+        return;
     }
+    
+    float step = (effect->target - effect->gain) / (float)samples;
+    gain_get_kernel()->ramp(buffer, samples, effect->gain, step);
+    effect->gain = effect->target;
 }
 
 // ============================================================================
@@ -82,6 +281,239 @@ void biquad_reset(biquad_t *filter) {
     filter->y1 = filter->y2 = 0.0f;
 }
 
+// ============================================================================
+// BIQUAD CASCADE
+// ============================================================================
+
+int biquad_cascade_init(biquad_cascade_t *cascade, const biquad_t *sections,
+                        unsigned int count, unsigned int channels) {
+    if (count == 0 || count > BIQUAD_MAX_SECTIONS ||
+        channels == 0 || channels > EFFECT_MAX_CHANNELS) {
+        return -1;
+    }
+    
+    cascade->sections = count;
+    cascade->channels = channels;
+    for (unsigned int s = 0; s < BIQUAD_MAX_SECTIONS; s++) {
+        // Identity padding lets the mono path always run full-width vectors
+        bool used = s < count;
+        cascade->b0[s] = used ? sections[s].b0 : 1.0f;
+        cascade->b1[s] = used ? sections[s].b1 : 0.0f;
+        cascade->b2[s] = used ? sections[s].b2 : 0.0f;
+        cascade->a1[s] = used ? sections[s].a1 : 0.0f;
+        cascade->a2[s] = used ? sections[s].a2 : 0.0f;
+    }
+    
+    biquad_cascade_reset(cascade);
+    return 0;
+}
+
+/**
+ * Butterworth sections: order / 2 biquads whose Qs spread the poles evenly
+ * around the unit circle.
+ */
+static int biquad_cascade_butterworth(biquad_cascade_t *cascade, bool highpass,
+                                      float sample_rate, float cutoff_freq,
+                                      unsigned int order, unsigned int channels) {
+    if (order == 0 || order % 2 != 0 || order / 2 > BIQUAD_MAX_SECTIONS) {
+        return -1;
+    }
+    
+    biquad_t sections[BIQUAD_MAX_SECTIONS];
+    unsigned int count = order / 2;
+    for (unsigned int k = 0; k < count; k++) {
+        float q = 1.0f / (2.0f * cosf((float)M_PI * (2 * k + 1) / (2.0f * order)));
+        if (highpass) {
+            biquad_highpass_init(&sections[k], sample_rate, cutoff_freq, q);
+        } else {
+            biquad_lowpass_init(&sections[k], sample_rate, cutoff_freq, q);
+        }
+    }
+    
+    return biquad_cascade_init(cascade, sections, count, channels);
+}
+
+int biquad_cascade_lowpass(biquad_cascade_t *cascade, float sample_rate, float cutoff_freq,
+                           unsigned int order, unsigned int channels) {
+    return biquad_cascade_butterworth(cascade, false, sample_rate, cutoff_freq, order, channels);
+}
+
+int biquad_cascade_highpass(biquad_cascade_t *cascade, float sample_rate, float cutoff_freq,
+                            unsigned int order, unsigned int channels) {
+    return biquad_cascade_butterworth(cascade, true, sample_rate, cutoff_freq, order, channels);
+}
+
+/**
+ * Multichannel kernel: channels are the lanes. Inlined with constant
+ * channel and section counts the state lives in registers and the inner
+ * loop becomes one vector operation per term.
+ *
+ * Every kernel evaluates y = b0*x + z1, z1 = (b1*x + z2) - a1*y,
+ * z2 = b2*x - a2*y in that order, which keeps the loop-carried chain to
+ * one add, one multiply and one subtract.
+ */
+static inline void biquad_cascade_multi_kernel(biquad_cascade_t *cascade, float *buffer,
+                                               size_t frames, unsigned int channels,
+                                               unsigned int sections) {
+    float z1[BIQUAD_MAX_SECTIONS][EFFECT_MAX_CHANNELS];
+    float z2[BIQUAD_MAX_SECTIONS][EFFECT_MAX_CHANNELS];
+    memcpy(z1, cascade->z1, sizeof(z1));
+    memcpy(z2, cascade->z2, sizeof(z2));
+    
+    for (size_t i = 0; i < frames; i++) {
+        float *frame = &buffer[i * channels];
+        for (unsigned int s = 0; s < sections; s++) {
+            float b0 = cascade->b0[s], b1 = cascade->b1[s], b2 = cascade->b2[s];
+            float a1 = cascade->a1[s], a2 = cascade->a2[s];
+            for (unsigned int c = 0; c < channels; c++) {
+                float x = frame[c];
+                float y = b0 * x + z1[s][c];
+                z1[s][c] = b1 * x + z2[s][c] - a1 * y;
+                z2[s][c] = b2 * x - a2 * y;
+                frame[c] = y;
+            }
+        }
+    }
+    
+    memcpy(cascade->z1, z1, sizeof(z1));
+    memcpy(cascade->z2, z2, sizeof(z2));
+}
+
+/**
+ * One TDF-II step of a single mono section, for the pipeline fill/drain.
+ */
+static inline float biquad_cascade_mono_step(const biquad_cascade_t *cascade, unsigned int s,
+                                             float *z1, float *z2, float x) {
+    float y = cascade->b0[s] * x + z1[s];
+    z1[s] = cascade->b1[s] * x + z2[s] - cascade->a1[s] * y;
+    z2[s] = cascade->b2[s] * x - cascade->a2[s] * y;
+    return y;
+}
+
+/**
+ * Mono kernel: sections are the lanes. Section s works on sample t - s
+ * while section 0 takes sample t, so every lane has input and one vector
+ * step advances the whole cascade. The first and last sections - 1 steps
+ * of a block (pipeline fill and drain) run lane by lane, which keeps the
+ * carried state identical to running the sections one after another.
+ */
+static void biquad_cascade_mono_kernel(biquad_cascade_t *cascade, float *buffer, size_t frames) {
+    unsigned int sections = cascade->sections;
+    size_t skew = sections - 1;
+    float z1[BIQUAD_MAX_SECTIONS], z2[BIQUAD_MAX_SECTIONS];
+    float v[BIQUAD_MAX_SECTIONS] = { 0 };  // Input waiting for each lane
+    
+    for (unsigned int s = 0; s < BIQUAD_MAX_SECTIONS; s++) {
+        z1[s] = cascade->z1[s][0];
+        z2[s] = cascade->z2[s][0];
+    }
+    
+    if (frames <= skew) {
+        // Too short to fill the pipeline: plain section-after-section
+        for (size_t i = 0; i < frames; i++) {
+            float x = buffer[i];
+            for (unsigned int s = 0; s < sections; s++) {
+                x = biquad_cascade_mono_step(cascade, s, z1, z2, x);
+            }
+            buffer[i] = x;
+        }
+    } else {
+        // Fill: at step t only lanes 0..t have input yet (high to low again)
+        for (size_t t = 0; t < skew; t++) {
+            v[0] = buffer[t];
+            for (size_t s = t + 1; s-- > 0;) {
+                v[s + 1] = biquad_cascade_mono_step(cascade, (unsigned int)s, z1, z2, v[s]);
+            }
+        }
+        
+        size_t t = skew;
+#if defined(__SSE2__)
+        __m128 b0 = _mm_loadu_ps(cascade->b0), b1 = _mm_loadu_ps(cascade->b1);
+        __m128 b2 = _mm_loadu_ps(cascade->b2), a1 = _mm_loadu_ps(cascade->a1);
+        __m128 a2 = _mm_loadu_ps(cascade->a2);
+        __m128 vz1 = _mm_loadu_ps(z1), vz2 = _mm_loadu_ps(z2);
+        __m128 vin = _mm_loadu_ps(v);
+        float y[BIQUAD_MAX_SECTIONS];
+        
+        for (; t < frames; t++) {
+            vin = _mm_move_ss(vin, _mm_set_ss(buffer[t]));
+            __m128 vy = _mm_add_ps(_mm_mul_ps(b0, vin), vz1);
+            vz1 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(b1, vin), vz2), _mm_mul_ps(a1, vy));
+            vz2 = _mm_sub_ps(_mm_mul_ps(b2, vin), _mm_mul_ps(a2, vy));
+            
+            _mm_storeu_ps(y, vy);
+            buffer[t - skew] = y[skew];
+            
+            // Each section's output feeds the next section's lane
+            vin = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(vy), 4));
+        }
+        
+        _mm_storeu_ps(z1, vz1);
+        _mm_storeu_ps(z2, vz2);
+        _mm_storeu_ps(v, vin);
+#else
+        for (; t < frames; t++) {
+            float y[BIQUAD_MAX_SECTIONS];
+            v[0] = buffer[t];
+            for (unsigned int s = 0; s < BIQUAD_MAX_SECTIONS; s++) {
+                y[s] = cascade->b0[s] * v[s] + z1[s];
+                z1[s] = cascade->b1[s] * v[s] + z2[s] - cascade->a1[s] * y[s];
+                z2[s] = cascade->b2[s] * v[s] - cascade->a2[s] * y[s];
+            }
+            buffer[t - skew] = y[skew];
+            for (unsigned int s = BIQUAD_MAX_SECTIONS - 1; s > 0; s--) {
+                v[s] = y[s - 1];
+            }
+        }
+#endif
+        
+        // Drain: lanes d+1..last finish the samples still in flight. Lanes go
+        // high to low so each one reads its input before the lane below
+        // overwrites it
+        for (size_t d = 0; d < skew; d++) {
+            buffer[frames - skew + d] =
+                biquad_cascade_mono_step(cascade, (unsigned int)skew, z1, z2, v[skew]);
+            for (size_t s = skew - 1; s > d; s--) {
+                v[s + 1] = biquad_cascade_mono_step(cascade, (unsigned int)s, z1, z2, v[s]);
+            }
+        }
+    }
+    
+    for (unsigned int s = 0; s < sections; s++) {
+        cascade->z1[s][0] = z1[s];
+        cascade->z2[s][0] = z2[s];
+    }
+}
+
+void biquad_cascade_process(biquad_cascade_t *cascade, float *buffer, size_t frames) {
+    unsigned int channels = cascade->channels;
+    unsigned int sections = cascade->sections;
+    
+    if (channels == 1 && sections > 1) {
+        biquad_cascade_mono_kernel(cascade, buffer, frames);
+        return;
+    }
+    
+    // Constant-count copies for the common layouts, generic loop for the rest
+    if (sections == 1) {
+        switch (channels) {
+            case 1:  biquad_cascade_multi_kernel(cascade, buffer, frames, 1, 1); return;
+            case 2:  biquad_cascade_multi_kernel(cascade, buffer, frames, 2, 1); return;
+            case 6:  biquad_cascade_multi_kernel(cascade, buffer, frames, 6, 1); return;
+            default: break;
+        }
+    } else if (channels == 2) {
+        biquad_cascade_multi_kernel(cascade, buffer, frames, 2, sections);
+        return;
+    }
+    biquad_cascade_multi_kernel(cascade, buffer, frames, channels, sections);
+}
+
+void biquad_cascade_reset(biquad_cascade_t *cascade) {
+    memset(cascade->z1, 0, sizeof(cascade->z1));
+    memset(cascade->z2, 0, sizeof(cascade->z2));
+}
+
 // ============================================================================
 // COMPRESSOR
 // ============================================================================
@@ -95,56 +527,496 @@ void compressor_init(compressor_t *comp, float threshold_db, float ratio,
     comp->envelope = 0.0f;
 }
 
+// Envelope scratch per pass: the serial follower fills it, then the gain
+// computer runs over it without a loop-carried dependency
+#define COMPRESSOR_CHUNK_SAMPLES 256
+
+// Fused chain chunk in compressor chunks: 4 KB of samples, well inside L1
+#define EFFECT_CHAIN_CHUNK_PASSES 4
+
+/**
+ * log2 for positive x: exponent bits plus a degree-5 fit of log2(1 + t) over
+ * the mantissa. Absolute error below 2.1e-6 plus float rounding. Zero maps
+ * to -127, which the gain computer treats as below threshold.
+ */
+static inline float fast_log2f(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float)((int32_t)(bits >> 23) - 127);
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    float t;
+    memcpy(&t, &bits, sizeof(t));
+    t -= 1.0f;
+    return exponent + t * (1.44255302f + t * (-0.718280212f + t * (0.458262992f +
+           t * (-0.279522452f + t * (0.123437166f + t * -0.0264525825f)))));
+}
+
+/**
+ * 2^-y for y >= 0: integer part into the exponent bits, degree-4 fit of
+ * 2^-f over the fraction. Relative error below 6e-8 plus float rounding;
+ * y = 0 gives exactly 1. Results below 2^-126 flush to zero.
+ */
+static inline float fast_exp2_neg(float y) {
+    y = y < 126.0f ? y : 126.0f;
+    int32_t whole = (int32_t)y;
+    float f = y - (float)whole;
+    float mantissa = 1.0f + f * (-0.693144422f + f * (0.240186703f + f * (-0.0553166688f +
+                     f * (0.0092283507f + f * -0.000954022759f))));
+    uint32_t bits = (uint32_t)(127 - whole) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return mantissa * scale;
+}
+
+/**
+ * Gain computer in the log domain: (envelope / threshold)^(1/ratio - 1)
+ * becomes 2^(-slope * log2 overshoot), clamped to unity below threshold.
+ * Multiplies buffer[i] by the gain for envelope[i]. The SSE2 path performs
+ * the same float operations in the same order, so both are bit-exact.
+ */
+static void compressor_apply_gain(float *buffer, const float *envelope, size_t samples,
+                                  float threshold_log2, float slope) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i mantissa_mask = _mm_set1_epi32(0x007fffff);
+    const __m128i one_bits = _mm_set1_epi32(0x3f800000);
+    const __m128i bias = _mm_set1_epi32(127);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 floor_exp = _mm_set1_ps(126.0f);
+    const __m128 thr = _mm_set1_ps(threshold_log2);
+    const __m128 k = _mm_set1_ps(slope);
+    
+    for (; i + 4 <= samples; i += 4) {
+        // log2(envelope)
+        __m128i bits = _mm_castps_si128(_mm_loadu_ps(&envelope[i]));
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+        __m128 t = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissa_mask), one_bits));
+        t = _mm_sub_ps(t, one);
+        __m128 p = _mm_mul_ps(t, _mm_set1_ps(-0.0264525825f));
+        p = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(0.123437166f), p));
+        p = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(-0.279522452f), p));
+        p = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(0.458262992f), p));
+        p = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(-0.718280212f), p));
+        p = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(1.44255302f), p));
+        __m128 over = _mm_max_ps(_mm_sub_ps(_mm_add_ps(exponent, p), thr), zero);
+        
+        // 2^-(slope * over)
+        __m128 y = _mm_min_ps(_mm_mul_ps(k, over), floor_exp);
+        __m128i whole = _mm_cvttps_epi32(y);
+        __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(whole));
+        __m128 m = _mm_mul_ps(f, _mm_set1_ps(-0.000954022759f));
+        m = _mm_mul_ps(f, _mm_add_ps(_mm_set1_ps(0.0092283507f), m));
+        m = _mm_mul_ps(f, _mm_add_ps(_mm_set1_ps(-0.0553166688f), m));
+        m = _mm_mul_ps(f, _mm_add_ps(_mm_set1_ps(0.240186703f), m));
+        m = _mm_mul_ps(f, _mm_add_ps(_mm_set1_ps(-0.693144422f), m));
+        m = _mm_add_ps(one, m);
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(bias, whole), 23));
+        
+        __m128 x = _mm_loadu_ps(&buffer[i]);
+        _mm_storeu_ps(&buffer[i], _mm_mul_ps(x, _mm_mul_ps(m, scale)));
+    }
+#endif
+    
+    for (; i < samples; i++) {
+        float over = fast_log2f(envelope[i]) - threshold_log2;
+        over = over > 0.0f ? over : 0.0f;
+        buffer[i] *= fast_exp2_neg(slope * over);
+    }
+}
+
 void compressor_process(compressor_t *comp, float *buffer, size_t frames) {
-    for (size_t i = 0; i < frames; i++) {
-        float input = fabsf(buffer[i]);
+    float threshold_log2 = fast_log2f(comp->threshold);
+    float slope = 1.0f - 1.0f / comp->ratio;  // Negated exponent
+    float attack = comp->attack_coef;
+    float release = comp->release_coef;
+    float envelope = comp->envelope;
+    float scratch[COMPRESSOR_CHUNK_SAMPLES];
+    
+    for (size_t pos = 0; pos < frames; pos += COMPRESSOR_CHUNK_SAMPLES) {
+        size_t count = frames - pos;
+        if (count > COMPRESSOR_CHUNK_SAMPLES) count = COMPRESSOR_CHUNK_SAMPLES;
         
         // Envelope follower
-        if (input > comp->envelope) {
-            comp->envelope = comp->attack_coef * comp->envelope + 
-                            (1.0f - comp->attack_coef) * input;
-        } else {
-            comp->envelope = comp->release_coef * comp->envelope + 
-                            (1.0f - comp->release_coef) * input;
+        float peak = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            float input = fabsf(buffer[pos + i]);
+            if (input > envelope) {
+                envelope = attack * envelope + (1.0f - attack) * input;
+            } else {
+                envelope = release * envelope + (1.0f - release) * input;
+            }
+            scratch[i] = envelope;
+            peak = envelope > peak ? envelope : peak;
+        }
+        
+        // Compute gain reduction (unity for chunks that stay below threshold)
+        if (peak > comp->threshold) {
+            compressor_apply_gain(&buffer[pos], scratch, count, threshold_log2, slope);
+        }
+    }
+    comp->envelope = envelope;
+}
+
+void compressor_multi_init(compressor_multi_t *comp, const compressor_t *design,
+                           unsigned int channels) {
+    comp->threshold = design->threshold;
+    comp->ratio = design->ratio;
+    comp->attack_coef = design->attack_coef;
+    comp->release_coef = design->release_coef;
+    comp->channels = channels;
+    memset(comp->envelope, 0, sizeof(comp->envelope));
+}
+
+/**
+ * Envelope followers for one chunk of interleaved frames, recording every
+ * envelope value into scratch. Returns the chunk's peak envelope. Inlined
+ * with a constant channel count.
+ */
+static inline float compressor_multi_follow(float *envelope, const float *block, float *scratch,
+                                            size_t frames, unsigned int channels,
+                                            float attack, float release) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            float input = fabsf(block[i * channels + c]);
+            if (input > envelope[c]) {
+                envelope[c] = attack * envelope[c] + (1.0f - attack) * input;
+            } else {
+                envelope[c] = release * envelope[c] + (1.0f - release) * input;
+            }
+            scratch[i * channels + c] = envelope[c];
+            peak = envelope[c] > peak ? envelope[c] : peak;
         }
+    }
+    return peak;
+}
+
+void compressor_multi_process(compressor_multi_t *comp, float *buffer, size_t frames) {
+    unsigned int channels = comp->channels;
+    float threshold_log2 = fast_log2f(comp->threshold);
+    float attack = comp->attack_coef;
+    float release = comp->release_coef;
+    float slope = 1.0f - 1.0f / comp->ratio;
+    float envelope[EFFECT_MAX_CHANNELS];
+    float scratch[COMPRESSOR_CHUNK_SAMPLES];
+    size_t chunk = COMPRESSOR_CHUNK_SAMPLES / channels;
+    
+    memcpy(envelope, comp->envelope, sizeof(envelope));
+    
+    for (size_t pos = 0; pos < frames; pos += chunk) {
+        size_t count = frames - pos;
+        if (count > chunk) count = chunk;
+        float *block = &buffer[pos * channels];
         
-        // Compute gain reduction
-        float gain = 1.0f;
-        if (comp->envelope > comp->threshold) {
-            float overshoot = comp->envelope / comp->threshold;
-            gain = powf(overshoot, (1.0f / comp->ratio) - 1.0f);
+        float peak;
+        switch (channels) {
+            case 1:
+                peak = compressor_multi_follow(envelope, block, scratch, count, 1, attack, release);
+                break;
+            case 2:
+                peak = compressor_multi_follow(envelope, block, scratch, count, 2, attack, release);
+                break;
+            default:
+                peak = compressor_multi_follow(envelope, block, scratch, count, channels,
+                                               attack, release);
+                break;
         }
         
-        buffer[i] *= gain;
+        // Compute gain reduction (unity for chunks that stay below threshold)
+        if (peak > comp->threshold) {
+            compressor_apply_gain(block, scratch, count * channels, threshold_log2, slope);
+        }
     }
+    memcpy(comp->envelope, envelope, sizeof(envelope));
 }
 
 // ============================================================================
 // EFFECT CHAIN
 // ============================================================================
 
-void effect_chain_init(effect_chain_t *chain, float sample_rate) {
+void effect_chain_init(effect_chain_t *chain, float sample_rate, unsigned int channels) {
+    compressor_t compressor;
+    
     // Initialize with default settings
     gain_init(&chain->gain, 0.0f);  // 0 dB (unity gain)
-    biquad_lowpass_init(&chain->filter, sample_rate, 2000.0f, 0.707f);  // 2kHz lowpass
-    compressor_init(&chain->compressor, -20.0f, 4.0f, 10.0f, 100.0f, sample_rate);
+    biquad_cascade_lowpass(&chain->filter, sample_rate, 2000.0f, 2, channels);  // 2kHz lowpass
+    compressor_init(&compressor, -20.0f, 4.0f, 10.0f, 100.0f, sample_rate);
+    compressor_multi_init(&chain->compressor, &compressor, channels);
+    chain->channels = channels;
     
     // All disabled by default
     chain->gain_enabled = false;
     chain->filter_enabled = false;
     chain->compressor_enabled = false;
+    chain->filter_ramp = 0;
+    chain->filter_ramp_off = false;
+    effect_chain_update(chain);
 }
 
-void effect_chain_process(effect_chain_t *chain, float *buffer, size_t frames) {
+void effect_chain_configure(effect_chain_t *chain, const effect_chain_config_t *config,
+                            float sample_rate, unsigned int channels) {
+    effect_chain_init(chain, sample_rate, channels);
+    
+    if (!config->enabled) {
+        return;
+    }
+    
+    if (config->gain_db != 0.0f) {
+        chain->gain_enabled = true;
+        gain_init(&chain->gain, config->gain_db);
+    }
+    
+    unsigned int order = config->filter_order ? config->filter_order : 2;
+    if (config->lowpass_freq > 0) {
+        chain->filter_enabled =
+            biquad_cascade_lowpass(&chain->filter, sample_rate, config->lowpass_freq,
+                                   order, channels) == 0;
+    } else if (config->highpass_freq > 0) {
+        chain->filter_enabled =
+            biquad_cascade_highpass(&chain->filter, sample_rate, config->highpass_freq,
+                                    order, channels) == 0;
+    }
+    
+    chain->compressor_enabled = config->compress;
+    effect_chain_update(chain);
+}
+
+// Frames after the glide before sections the target doesn't use are
+// dropped: identity sections flush their state to zero in two samples
+#define BIQUAD_RAMP_SETTLE 2
+
+/**
+ * Run frames through the filter while it retunes, one frame at a time with
+ * every coefficient moved by an equal share of the remaining distance
+ * first. Lands exactly on the target, then after BIQUAD_RAMP_SETTLE frames
+ * trims the cascade (or disables the filter). Returns the frames consumed,
+ * fewer than frames if the ramp finished early.
+ */
+static size_t effect_chain_filter_ramp(effect_chain_t *chain, float *buffer, size_t frames) {
+    biquad_cascade_t *filter = &chain->filter;
+    const biquad_cascade_t *target = &chain->filter_target;
+    unsigned int channels = filter->channels;
+    unsigned int sections = filter->sections;
+    size_t done = 0;
+    
+    for (; done < frames && chain->filter_ramp > 0; done++) {
+        unsigned int left = chain->filter_ramp--;
+        
+        if (left == BIQUAD_RAMP_SETTLE + 1) {
+            memcpy(filter->b0, target->b0, sizeof(filter->b0));
+            memcpy(filter->b1, target->b1, sizeof(filter->b1));
+            memcpy(filter->b2, target->b2, sizeof(filter->b2));
+            memcpy(filter->a1, target->a1, sizeof(filter->a1));
+            memcpy(filter->a2, target->a2, sizeof(filter->a2));
+        } else if (left > BIQUAD_RAMP_SETTLE) {
+            float share = 1.0f / (float)(left - BIQUAD_RAMP_SETTLE);
+            for (unsigned int s = 0; s < sections; s++) {
+                filter->b0[s] += (target->b0[s] - filter->b0[s]) * share;
+                filter->b1[s] += (target->b1[s] - filter->b1[s]) * share;
+                filter->b2[s] += (target->b2[s] - filter->b2[s]) * share;
+                filter->a1[s] += (target->a1[s] - filter->a1[s]) * share;
+                filter->a2[s] += (target->a2[s] - filter->a2[s]) * share;
+            }
+        }
+        
+        float *frame = &buffer[done * channels];
+        for (unsigned int s = 0; s < sections; s++) {
+            for (unsigned int c = 0; c < channels; c++) {
+                float x = frame[c];
+                float y = filter->b0[s] * x + filter->z1[s][c];
+                filter->z1[s][c] = filter->b1[s] * x + filter->z2[s][c] - filter->a1[s] * y;
+                filter->z2[s][c] = filter->b2[s] * x - filter->a2[s] * y;
+                frame[c] = y;
+            }
+        }
+    }
+    
+    if (chain->filter_ramp == 0) {
+        filter->sections = target->sections;
+        if (chain->filter_ramp_off) {
+            chain->filter_enabled = false;
+            effect_chain_update(chain);
+        }
+    }
+    return done;
+}
+
+/**
+ * Stage by stage over the whole block. Used while the gain is ramping, since
+ * the ramp spans the whole call rather than one chunk, and while the filter
+ * is retuning.
+ */
+static void effect_chain_process_staged(effect_chain_t *chain, float *buffer, size_t frames) {
+    unsigned int channels = chain->channels;
+    
     if (chain->gain_enabled) {
-        gain_process(&chain->gain, buffer, frames);
+        // Per-sample, so channels don't matter
+        if (chain->gain.gain != chain->gain.target) {
+            gain_process_smooth(&chain->gain, buffer, frames * channels);
+        } else {
+            gain_process(&chain->gain, buffer, frames * channels);
+        }
     }
     
-    if (chain->filter_enabled) {
-        biquad_process(&chain->filter, buffer, frames);
+    size_t done = 0;
+    if (chain->filter_ramp > 0) {
+        done = effect_chain_filter_ramp(chain, buffer, frames);
+    }
+    if (chain->filter_enabled && done < frames) {
+        biquad_cascade_process(&chain->filter, &buffer[done * channels], frames - done);
     }
     
     if (chain->compressor_enabled) {
-        compressor_process(&chain->compressor, buffer, frames);
+        compressor_multi_process(&chain->compressor, buffer, frames);
+    }
+}
+
+/**
+ * Fused body: every enabled stage runs over one chunk while it is still in
+ * L1. Chunks are a whole number of compressor chunks, so the output is
+ * bit-identical to the staged path. Inlined with constant flags, disabled
+ * stages compile away.
+ */
+static inline void effect_chain_fused(effect_chain_t *chain, float *buffer, size_t frames,
+                                      bool gain, bool filter, bool compress) {
+    unsigned int channels = chain->channels;
+    size_t chunk = EFFECT_CHAIN_CHUNK_PASSES * (COMPRESSOR_CHUNK_SAMPLES / channels);
+    
+    if (gain && chain->gain.gain != chain->gain.target) {
+        effect_chain_process_staged(chain, buffer, frames);
+        return;
+    }
+    
+    for (size_t pos = 0; pos < frames; pos += chunk) {
+        size_t count = frames - pos;
+        if (count > chunk) count = chunk;
+        float *block = &buffer[pos * channels];
+        
+        if (gain) gain_process(&chain->gain, block, count * channels);
+        if (filter) biquad_cascade_process(&chain->filter, block, count);
+        if (compress) compressor_multi_process(&chain->compressor, block, count);
+    }
+}
+
+#define EFFECT_CHAIN_KERNEL(name, gain, filter, compress) \
+    static void effect_chain_kernel_##name(effect_chain_t *chain, float *buffer, size_t frames) { \
+        effect_chain_fused(chain, buffer, frames, gain, filter, compress); \
+    }
+
+EFFECT_CHAIN_KERNEL(bypass, false, false, false)
+EFFECT_CHAIN_KERNEL(g, true, false, false)
+EFFECT_CHAIN_KERNEL(f, false, true, false)
+EFFECT_CHAIN_KERNEL(gf, true, true, false)
+EFFECT_CHAIN_KERNEL(c, false, false, true)
+EFFECT_CHAIN_KERNEL(gc, true, false, true)
+EFFECT_CHAIN_KERNEL(fc, false, true, true)
+EFFECT_CHAIN_KERNEL(gfc, true, true, true)
+
+// Indexed by gain | filter << 1 | compressor << 2
+static const effect_chain_kernel_t effect_chain_kernels[8] = {
+    effect_chain_kernel_bypass, effect_chain_kernel_g,
+    effect_chain_kernel_f,      effect_chain_kernel_gf,
+    effect_chain_kernel_c,      effect_chain_kernel_gc,
+    effect_chain_kernel_fc,     effect_chain_kernel_gfc,
+};
+
+void effect_chain_update(effect_chain_t *chain) {
+    unsigned int index = (chain->gain_enabled ? 1u : 0u) |
+                         (chain->filter_enabled ? 2u : 0u) |
+                         (chain->compressor_enabled ? 4u : 0u);
+    chain->kernel = effect_chain_kernels[index];
+}
+
+static void biquad_cascade_passthrough(biquad_cascade_t *cascade, unsigned int s) {
+    cascade->b0[s] = 1.0f;
+    cascade->b1[s] = cascade->b2[s] = cascade->a1[s] = cascade->a2[s] = 0.0f;
+}
+
+void effect_chain_set_gain(effect_chain_t *chain, float gain) {
+    if (!chain->gain_enabled) {
+        chain->gain.gain = 1.0f;  // Glide in from unity
+        chain->gain_enabled = true;
+        effect_chain_update(chain);
+    }
+    chain->gain.target = gain;
+}
+
+int effect_chain_set_filter(effect_chain_t *chain, const biquad_cascade_t *design) {
+    biquad_cascade_t *filter = &chain->filter;
+    biquad_cascade_t *target = &chain->filter_target;
+    
+    if (design && design->channels != chain->channels) {
+        return -1;
+    }
+    if (!chain->filter_enabled && !design) {
+        return 0;
+    }
+    
+    if (!chain->filter_enabled) {
+        // Start from a transparent cascade so switching on doesn't step
+        for (unsigned int s = 0; s < BIQUAD_MAX_SECTIONS; s++) {
+            biquad_cascade_passthrough(filter, s);
+        }
+        filter->sections = 1;
+        biquad_cascade_reset(filter);
+        chain->filter_enabled = true;
+        effect_chain_update(chain);
+    }
+    
+    if (design) {
+        memcpy(target->b0, design->b0, sizeof(target->b0));
+        memcpy(target->b1, design->b1, sizeof(target->b1));
+        memcpy(target->b2, design->b2, sizeof(target->b2));
+        memcpy(target->a1, design->a1, sizeof(target->a1));
+        memcpy(target->a2, design->a2, sizeof(target->a2));
+        target->sections = design->sections;
+    } else {
+        for (unsigned int s = 0; s < BIQUAD_MAX_SECTIONS; s++) {
+            biquad_cascade_passthrough(target, s);
+        }
+        target->sections = filter->sections;
+    }
+    target->channels = chain->channels;
+    chain->filter_ramp_off = design == NULL;
+    
+    // Newly used sections join as identity sections with clean state
+    for (unsigned int s = filter->sections; s < target->sections; s++) {
+        biquad_cascade_passthrough(filter, s);
+        memset(filter->z1[s], 0, sizeof(filter->z1[s]));
+        memset(filter->z2[s], 0, sizeof(filter->z2[s]));
+    }
+    if (target->sections > filter->sections) {
+        filter->sections = target->sections;
+    }
+    
+    chain->filter_ramp = BIQUAD_RAMP_FRAMES + BIQUAD_RAMP_SETTLE;
+    return 0;
+}
+
+void effect_chain_set_compressor(effect_chain_t *chain, bool enabled) {
+    if (enabled && !chain->compressor_enabled) {
+        memset(chain->compressor.envelope, 0, sizeof(chain->compressor.envelope));
+    }
+    chain->compressor_enabled = enabled;
+    effect_chain_update(chain);
+}
+
+void effect_chain_reset(effect_chain_t *chain) {
+    chain->gain.gain = chain->gain.target;
+    biquad_cascade_reset(&chain->filter);
+    memset(chain->compressor.envelope, 0, sizeof(chain->compressor.envelope));
+}
+
+void effect_chain_process(effect_chain_t *chain, float *buffer, size_t frames) {
+    if (chain->filter_ramp > 0) {
+        effect_chain_process_staged(chain, buffer, frames);
+        return;
     }
+    chain->kernel(chain, buffer, frames);
+}
+
+size_t effect_chain_chunk_frames(unsigned int channels) {
+    return EFFECT_CHAIN_CHUNK_PASSES * (COMPRESSOR_CHUNK_SAMPLES / channels);
 }
\ No newline at end of file
@@ -4,15 +4,56 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+/**
+ * Most channels an effect chain handles (7.1). Multichannel buffers are
+ * interleaved: frame i, channel c lives at buffer[i * channels + c].
+ */
+#define EFFECT_MAX_CHANNELS 8
+
 /**
  * Simple gain/volume control effect.
+ *
+ * gain_process applies a constant gain; gain_process_smooth ramps linearly
+ * from the current gain to the target across the block so a gain change
+ * never lands as a step. Both run a SIMD kernel picked once at runtime
+ * (AVX2 or SSE2 on x86, NEON on ARM, scalar elsewhere); every kernel gives
+ * bit-identical results.
  */
 typedef struct {
-    float gain;  // Linear gain (1.0 = unity, 2.0 = double, 0.5 = half)
+    float gain;    // Linear gain (1.0 = unity, 2.0 = double, 0.5 = half)
+    float target;  // Linear gain gain_process_smooth ramps towards
 } gain_effect_t;
 
 void gain_init(gain_effect_t *effect, float gain_db);
-void gain_process(gain_effect_t *effect, float *buffer, size_t frames);
+
+/**
+ * Set the gain the next gain_process_smooth block ramps to.
+ */
+void gain_set_target(gain_effect_t *effect, float gain_db);
+
+/**
+ * Gain is per sample, so interleaved buffers pass frames * channels.
+ */
+void gain_process(gain_effect_t *effect, float *buffer, size_t samples);
+
+/**
+ * Ramp sample i by gain + (target - gain) * (i + 1) / samples, then leave
+ * gain at target. On interleaved buffers the channels of one frame differ
+ * by under one step, far below audibility.
+ */
+void gain_process_smooth(gain_effect_t *effect, float *buffer, size_t samples);
+
+/**
+ * Name of the kernel in use ("avx2", "sse2", "neon" or "scalar").
+ */
+const char* gain_kernel_name(void);
+
+/**
+ * Force a kernel by name, or pick the best available with NULL. For tests
+ * and benchmarks; call before any audio thread starts. Returns 0 on
+ * success, -1 if the kernel isn't built in or the CPU lacks it.
+ */
+int gain_select_kernel(const char *name);
 
 /**
  * Biquad filter (low-pass, high-pass, etc.)
@@ -33,9 +74,60 @@ float biquad_process_sample(biquad_t *filter, float input);
 void biquad_process(biquad_t *filter, float *buffer, size_t frames);
 void biquad_reset(biquad_t *filter);
 
+/**
+ * Cascade of up to BIQUAD_MAX_SECTIONS biquads (8th order) in transposed
+ * Direct Form II, over interleaved frames with independent state per
+ * channel.
+ *
+ * Coefficients and state are structure-of-arrays so SIMD lanes line up with
+ * channels (multichannel) or with sections (mono: each section runs one
+ * sample behind the previous, so all sections advance in one vector step).
+ * A block keeps the whole state in registers and writes it back once.
+ */
+#define BIQUAD_MAX_SECTIONS 4
+
+typedef struct {
+    unsigned int sections;
+    unsigned int channels;
+    
+    // Per-section coefficients; unused sections are identity (b0 = 1)
+    float b0[BIQUAD_MAX_SECTIONS], b1[BIQUAD_MAX_SECTIONS], b2[BIQUAD_MAX_SECTIONS];
+    float a1[BIQUAD_MAX_SECTIONS], a2[BIQUAD_MAX_SECTIONS];
+    
+    // TDF-II state, [section][channel]
+    float z1[BIQUAD_MAX_SECTIONS][EFFECT_MAX_CHANNELS];
+    float z2[BIQUAD_MAX_SECTIONS][EFFECT_MAX_CHANNELS];
+} biquad_cascade_t;
+
+/**
+ * Build a cascade from initialized single-section designs (1 to
+ * BIQUAD_MAX_SECTIONS of them). Returns 0 on success, -1 on bad counts.
+ */
+int biquad_cascade_init(biquad_cascade_t *cascade, const biquad_t *sections,
+                        unsigned int count, unsigned int channels);
+
+/**
+ * Butterworth low-/high-pass of the given order (2, 4, 6 or 8).
+ * Returns 0 on success, -1 on an unsupported order.
+ */
+int biquad_cascade_lowpass(biquad_cascade_t *cascade, float sample_rate, float cutoff_freq,
+                           unsigned int order, unsigned int channels);
+int biquad_cascade_highpass(biquad_cascade_t *cascade, float sample_rate, float cutoff_freq,
+                            unsigned int order, unsigned int channels);
+
+void biquad_cascade_process(biquad_cascade_t *cascade, float *buffer, size_t frames);
+void biquad_cascade_reset(biquad_cascade_t *cascade);
+
 /**
  * Simple compressor (reduces dynamic range)
+ *
+ * Above threshold the gain is (envelope / threshold)^(1/ratio - 1). It is
+ * evaluated with polynomial log2/exp2 approximations rather than powf and
+ * stays within COMPRESSOR_GAIN_TOLERANCE_DB of the exact curve down to
+ * 126 octaves (~760 dB) of gain reduction.
  */
+#define COMPRESSOR_GAIN_TOLERANCE_DB 0.001f
+
 typedef struct {
     float threshold;     // Level above which compression starts (linear)
     float ratio;         // Compression ratio (4.0 = 4:1)
@@ -49,19 +141,124 @@ void compressor_init(compressor_t *comp, float threshold_db, float ratio,
 void compressor_process(compressor_t *comp, float *buffer, size_t frames);
 
 /**
- * Effect chain - combines multiple effects
+ * Compressor over interleaved frames with an envelope per channel.
  */
 typedef struct {
+    float threshold;
+    float ratio;
+    float attack_coef;
+    float release_coef;
+    unsigned int channels;
+    float envelope[EFFECT_MAX_CHANNELS];
+} compressor_multi_t;
+
+void compressor_multi_init(compressor_multi_t *comp, const compressor_t *design,
+                           unsigned int channels);
+void compressor_multi_process(compressor_multi_t *comp, float *buffer, size_t frames);
+
+/**
+ * Filter retuning: coefficients glide linearly to the new design over
+ * BIQUAD_RAMP_FRAMES frames (~11 ms at 48 kHz), one small step per frame,
+ * keeping the filter state. Stepping per block would click: in the
+ * transposed form a change in b0 reaches the output a sample before the
+ * matching b1/b2 terms do.
+ */
+#define BIQUAD_RAMP_FRAMES 512
+
+/**
+ * Effect chain - combines multiple effects
+ *
+ * Processing goes through a kernel specialized for the enabled stages,
+ * which runs every stage over one cache-sized chunk before moving to the
+ * next, so a large block crosses memory once instead of once per stage.
+ * Call effect_chain_update() after changing the enabled flags directly.
+ */
+typedef struct effect_chain effect_chain_t;
+
+typedef void (*effect_chain_kernel_t)(effect_chain_t *chain, float *buffer, size_t frames);
+
+struct effect_chain {
     bool gain_enabled;
     bool filter_enabled;
     bool compressor_enabled;
+    unsigned int channels;
     
     gain_effect_t gain;
-    biquad_t filter;
-    compressor_t compressor;
-} effect_chain_t;
+    biquad_cascade_t filter;
+    compressor_multi_t compressor;
+    
+    effect_chain_kernel_t kernel;  // Fused kernel for the enabled flags
+    
+    // Filter retuning in progress (see effect_chain_set_filter)
+    biquad_cascade_t filter_target;
+    unsigned int filter_ramp;      // Frames left, 0 = idle
+    bool filter_ramp_off;          // Disable the filter once the ramp ends
+};
+
+struct convolver_ir;
+
+/**
+ * User-facing effect settings, shared by every processing mode.
+ */
+typedef struct {
+    bool enabled;           // false = bypass all effects
+    float gain_db;          // 0 dB = gain stage off
+    float lowpass_freq;     // Hz, 0 = off
+    float highpass_freq;    // Hz, 0 = off (in a chain, ignored when lowpass is set)
+    unsigned int filter_order;  // Butterworth order: 2, 4, 6 or 8 (0 = 2)
+    bool compress;          // 4:1, -20 dB threshold
+    const struct convolver_ir *ir;  // Impulse response to convolve with after the chain, or NULL
+    float ir_mix;           // Wet level of the convolution, 0-1
+    bool ir_realtime;       // Drop a late convolution tail instead of waiting for it
+    bool limit;             // Lookahead brickwall limiter, last in the graph
+    float limit_ceiling_db; // Highest level the limiter lets out, dBFS
+    float limit_lookahead_ms;  // The limiter's delay, and how soon it sees a peak coming
+} effect_chain_config_t;
 
-void effect_chain_init(effect_chain_t *chain, float sample_rate);
+/**
+ * channels must be between 1 and EFFECT_MAX_CHANNELS.
+ */
+void effect_chain_init(effect_chain_t *chain, float sample_rate, unsigned int channels);
+void effect_chain_configure(effect_chain_t *chain, const effect_chain_config_t *config,
+                            float sample_rate, unsigned int channels);
+
+/**
+ * Select the kernel for the current enabled flags. init and configure
+ * already do this.
+ */
+void effect_chain_update(effect_chain_t *chain);
+
+/**
+ * Realtime parameter changes for the audio thread, taking effect at the next
+ * block without resetting any state. No allocation and no libm calls; the
+ * designs are computed by the caller (see param_queue.h).
+ *
+ * set_gain glides from the current gain to gain (linear) over the next block.
+ * set_filter ramps the coefficients to design, which must have the chain's
+ * channel count (returns -1 otherwise); NULL ramps to a transparent filter
+ * and then disables it. set_compressor switches the compressor, starting
+ * from a released envelope.
+ */
+void effect_chain_set_gain(effect_chain_t *chain, float gain);
+int effect_chain_set_filter(effect_chain_t *chain, const biquad_cascade_t *design);
+void effect_chain_set_compressor(effect_chain_t *chain, bool enabled);
+
+/**
+ * Clear the filter state and compressor envelopes and finish any gain
+ * glide, keeping the settings, so the next block starts a new stream. A
+ * filter retune in progress carries on.
+ */
+void effect_chain_reset(effect_chain_t *chain);
+
+/**
+ * Process frames interleaved frames in place.
+ */
 void effect_chain_process(effect_chain_t *chain, float *buffer, size_t frames);
 
+/**
+ * Frames the fused kernels run per chunk. Splitting a block on multiples of
+ * this leaves the output unchanged, except while the gain glides.
+ */
+size_t effect_chain_chunk_frames(unsigned int channels);
+
 #endif // EFFECTS_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "fft.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FFT_ALIGN 64
+
+static bool is_power_of_2(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+static float* fft_alloc_floats(size_t count) {
+    size_t bytes = (count * sizeof(float) + FFT_ALIGN - 1) / FFT_ALIGN * FFT_ALIGN;
+    float *p = aligned_alloc(FFT_ALIGN, bytes);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+fft_t* fft_create(size_t n) {
+    if (!is_power_of_2(n) || n < FFT_MIN_SIZE) {
+        return NULL;
+    }
+    
+    fft_t *fft = calloc(1, sizeof(fft_t));
+    if (!fft) {
+        return NULL;
+    }
+    
+    size_t half = n / 2;
+    fft->size = n;
+    fft->half = half;
+    fft->bitrev = malloc(half * sizeof(unsigned int));
+    fft->twiddle_re = fft_alloc_floats(half / 2);
+    fft->twiddle_im = fft_alloc_floats(half / 2);
+    fft->split_re = fft_alloc_floats(half + 1);
+    fft->split_im = fft_alloc_floats(half + 1);
+    fft->work_re = fft_alloc_floats(half);
+    fft->work_im = fft_alloc_floats(half);
+    
+    if (!fft->bitrev || !fft->twiddle_re || !fft->twiddle_im || !fft->split_re ||
+        !fft->split_im || !fft->work_re || !fft->work_im) {
+        fft_free(fft);
+        return NULL;
+    }
+    
+    unsigned int bits = 0;
+    while ((1u << bits) < half) {
+        bits++;
+    }
+    for (size_t i = 0; i < half; i++) {
+        unsigned int r = 0;
+        for (unsigned int b = 0; b < bits; b++) {
+            r |= (unsigned int)((i >> b) & 1u) << (bits - 1 - b);
+        }
+        fft->bitrev[i] = r;
+    }
+    
+    // Twiddles in double, so large sizes don't accumulate rounding
+    for (size_t k = 0; k < half / 2; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)half;
+        fft->twiddle_re[k] = (float)cos(angle);
+        fft->twiddle_im[k] = (float)sin(angle);
+    }
+    for (size_t k = 0; k <= half; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)n;
+        fft->split_re[k] = (float)cos(angle);
+        fft->split_im[k] = (float)sin(angle);
+    }
+    
+    return fft;
+}
+
+void fft_free(fft_t *fft) {
+    if (fft) {
+        free(fft->bitrev);
+        free(fft->twiddle_re);
+        free(fft->twiddle_im);
+        free(fft->split_re);
+        free(fft->split_im);
+        free(fft->work_re);
+        free(fft->work_im);
+        free(fft);
+    }
+}
+
+/**
+ * In-place radix-2 decimation-in-time butterflies over fft->work, whose
+ * input is already in bit-reversed order.
+ */
+static void fft_complex(fft_t *fft) {
+    float *re = fft->work_re;
+    float *im = fft->work_im;
+    size_t half = fft->half;
+    
+    for (size_t len = 2; len <= half; len <<= 1) {
+        size_t span = len / 2;
+        size_t step = half / len;
+        
+        for (size_t i = 0; i < half; i += len) {
+            for (size_t j = 0; j < span; j++) {
+                float wr = fft->twiddle_re[j * step];
+                float wi = fft->twiddle_im[j * step];
+                size_t a = i + j;
+                size_t b = a + span;
+                
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void fft_forward(fft_t *fft, const float *in, float *re, float *im) {
+    size_t half = fft->half;
+    float *zr = fft->work_re;
+    float *zi = fft->work_im;
+    
+    // Even samples as the real part, odd as the imaginary part
+    for (size_t n = 0; n < half; n++) {
+        unsigned int r = fft->bitrev[n];
+        zr[r] = in[2 * n];
+        zi[r] = in[2 * n + 1];
+    }
+    fft_complex(fft);
+    
+    // Untangle: X[k] = E[k] + W^k O[k], with E and O the spectra of the
+    // even and odd samples recovered from Z[k] and conj(Z[half - k])
+    for (size_t k = 0; k <= half; k++) {
+        size_t ka = k < half ? k : 0;
+        size_t kb = k > 0 ? half - k : 0;
+        float ar = zr[ka], ai = zi[ka];
+        float br = zr[kb], bi = -zi[kb];
+        
+        float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+        float dr = 0.5f * (ar - br), di = 0.5f * (ai - bi);
+        float c = fft->split_re[k], s = fft->split_im[k];
+        
+        re[k] = er + c * di + s * dr;
+        im[k] = ei + s * di - c * dr;
+    }
+    
+    // Real by symmetry; don't leave twiddle rounding in them
+    im[0] = 0.0f;
+    im[half] = 0.0f;
+}
+
+void fft_inverse(fft_t *fft, const float *re, const float *im, float *out) {
+    size_t half = fft->half;
+    float *zr = fft->work_re;
+    float *zi = fft->work_im;
+    
+    // Rebuild Z[k] = 2 (E[k] + i O[k]), conjugated so the forward
+    // butterflies compute the inverse
+    for (size_t k = 0; k < half; k++) {
+        float ar = re[k], ai = im[k];
+        float br = re[half - k], bi = -im[half - k];
+        
+        float er = ar + br, ei = ai + bi;
+        float dr = ar - br, di = ai - bi;
+        float c = fft->split_re[k], s = fft->split_im[k];
+        float or_ = dr * c + di * s;
+        float oi = di * c - dr * s;
+        
+        unsigned int r = fft->bitrev[k];
+        zr[r] = er - oi;
+        zi[r] = -(ei + or_);
+    }
+    fft_complex(fft);
+    
+    for (size_t n = 0; n < half; n++) {
+        out[2 * n] = zr[n];
+        out[2 * n + 1] = -zi[n];
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stddef.h>
+
+/**
+ * Real-input FFT of a fixed power-of-2 size.
+ *
+ * A size n transform packs the n real samples into n/2 complex points, runs
+ * an iterative radix-2 FFT on those and splits the result into the n/2 + 1
+ * non-redundant bins. Spectra are split arrays (re[], im[]) so loops over
+ * bins vectorize. Twiddles and the bit-reversal table are computed by
+ * fft_create; the transforms themselves never allocate, but use scratch in
+ * the plan, so one plan serves one thread.
+ */
+
+#define FFT_MIN_SIZE 4
+
+typedef struct {
+    size_t size;              // n real points
+    size_t half;              // n/2 complex points
+    unsigned int *bitrev;     // half entries
+    float *twiddle_re;        // e^(-2 pi i k / half), k < half / 2
+    float *twiddle_im;
+    float *split_re;          // e^(-2 pi i k / n), k <= half
+    float *split_im;
+    float *work_re;           // half entries of scratch
+    float *work_im;
+} fft_t;
+
+/**
+ * Plan a transform of n real points (power of 2, at least FFT_MIN_SIZE).
+ * Returns NULL on failure.
+ */
+fft_t* fft_create(size_t n);
+void fft_free(fft_t *fft);
+
+/**
+ * in: n samples. re, im: n/2 + 1 bins, DC first.
+ */
+void fft_forward(fft_t *fft, const float *in, float *re, float *im);
+
+/**
+ * Inverse of fft_forward, unscaled: out is n times the original signal.
+ * re and im are left untouched.
+ */
+void fft_inverse(fft_t *fft, const float *re, const float *im, float *out);
+
+#endif // FFT_H
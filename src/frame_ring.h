@@ -0,0 +1,135 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ring_buffer.h"
+
+/**
+ * Lock-free SPSC ring of fixed-size frames.
+ *
+ * This is the ring under ring_buffer_t (power-of-2 capacity, cache-line
+ * separated indices with cached peer views, the same storage options and
+ * waits); frame_ring_t is declared in ring_buffer.h. The unit is a frame of
+ * any element type rather than a float sample: one interleaved
+ * multichannel frame of float, int16 or int32 I/O data, or a metadata
+ * record. Every count, index and span is in whole frames, so a read can
+ * never stop between two channels of the same frame and callers never
+ * have to trim counts back to a frame boundary.
+ *
+ * A frame takes stride bytes in the ring. The stride defaults to
+ * element_size * elements and may be padded beyond that, e.g. three float
+ * channels on a 16-byte stride so each frame is one SIMD vector. Frame i
+ * starts at buffer + i * stride, so when the stride is a power of 2 no
+ * larger than the storage alignment every frame starts on a stride boundary.
+ *
+ * Copies (frame_ring_write/read) move data laid out at the ring's stride.
+ */
+
+/**
+ * Up to two runs of whole frames in the ring's storage; frames2 is 0 when
+ * the region does not wrap, which is always the case for a mirrored ring.
+ */
+typedef struct {
+    void *data1;
+    size_t frames1;
+    void *data2;
+    size_t frames2;
+} frame_ring_span_t;
+
+/**
+ * Create a ring of capacity_frames frames (power of 2) holding elements
+ * elements of element_size bytes each. stride is the bytes per frame, 0 for
+ * packed frames; it must be at least element_size * elements. options as
+ * for ring_buffer_create_ex (NULL = defaults); mirroring needs
+ * capacity_frames * stride to be a multiple of the page size.
+ * Returns NULL on failure.
+ */
+frame_ring_t* frame_ring_create(size_t capacity_frames, size_t element_size,
+                                unsigned int elements, size_t stride,
+                                const ring_buffer_options_t *options);
+
+/**
+ * Destroy the ring and free its storage.
+ */
+void frame_ring_free(frame_ring_t *ring);
+
+/**
+ * Copy up to count frames in (producer) / out (consumer).
+ * Returns the number of frames moved.
+ */
+size_t frame_ring_write(frame_ring_t *ring, const void *frames, size_t count);
+size_t frame_ring_read(frame_ring_t *ring, void *frames, size_t count);
+
+/**
+ * Zero-copy access, as ring_buffer_write_acquire/commit and
+ * ring_buffer_read_acquire/release but in frames.
+ */
+size_t frame_ring_write_acquire(frame_ring_t *ring, size_t count, frame_ring_span_t *span);
+void frame_ring_write_commit(frame_ring_t *ring, size_t count);
+size_t frame_ring_read_acquire(frame_ring_t *ring, size_t count, frame_ring_span_t *span);
+void frame_ring_read_release(frame_ring_t *ring, size_t count);
+
+/**
+ * Frames available to read (consumer side) / to write (producer side).
+ * Always load the peer's index, like their ring_buffer_t counterparts.
+ */
+size_t frame_ring_read_available(const frame_ring_t *ring);
+size_t frame_ring_write_available(const frame_ring_t *ring);
+
+/**
+ * Blocking waits and shutdown in frames, as ring_buffer_wait_readable,
+ * ring_buffer_wait_writable and ring_buffer_close.
+ */
+size_t frame_ring_wait_readable(frame_ring_t *ring, size_t min, uint64_t timeout_ns);
+size_t frame_ring_wait_writable(frame_ring_t *ring, size_t min, uint64_t timeout_ns);
+void frame_ring_close(frame_ring_t *ring);
+
+/**
+ * Fill level and consumer-side peak in frames; safe from any thread.
+ */
+size_t frame_ring_fill_level(const frame_ring_t *ring);
+size_t frame_ring_high_water(const frame_ring_t *ring);
+
+/**
+ * Reset the ring (NOT thread-safe, call only when no I/O is happening).
+ */
+void frame_ring_reset(frame_ring_t *ring);
+
+/**
+ * Drop the first count frames of stride bytes from span (all of it if
+ * count is larger), leaving the rest in data1/frames1 when data1 runs out.
+ */
+void frame_ring_span_skip(frame_ring_span_t *span, size_t count, size_t stride);
+
+/**
+ * Typed front ends for packed rings of one element type. FRAME_RING_TYPED
+ * declares prefix_create(capacity_frames, channels, options) and
+ * prefix_write/read taking type pointers, plus prefix_data1/data2 to view
+ * a span as type*. Instantiated below for the formats the I/O paths use.
+ */
+#define FRAME_RING_TYPED(prefix, type)                                                  \
+    static inline frame_ring_t* prefix##_create(size_t capacity_frames,                 \
+                                                unsigned int channels,                  \
+                                                const ring_buffer_options_t *options) { \
+        return frame_ring_create(capacity_frames, sizeof(type), channels, 0, options);  \
+    }                                                                                   \
+    static inline size_t prefix##_write(frame_ring_t *ring, const type *frames,         \
+                                        size_t count) {                                 \
+        return frame_ring_write(ring, frames, count);                                   \
+    }                                                                                   \
+    static inline size_t prefix##_read(frame_ring_t *ring, type *frames, size_t count) { \
+        return frame_ring_read(ring, frames, count);                                    \
+    }                                                                                   \
+    static inline type* prefix##_data1(const frame_ring_span_t *span) {                 \
+        return (type*)span->data1;                                                      \
+    }                                                                                   \
+    static inline type* prefix##_data2(const frame_ring_span_t *span) {                 \
+        return (type*)span->data2;                                                      \
+    }
+
+FRAME_RING_TYPED(frame_ring_f32, float)
+FRAME_RING_TYPED(frame_ring_s16, int16_t)
+FRAME_RING_TYPED(frame_ring_s32, int32_t)
+
+#endif // FRAME_RING_H
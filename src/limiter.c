@@ -0,0 +1,206 @@
+#include "limiter.h"
+#include "effects.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * The delay line back to lookahead frames of silence.
+ */
+static void limiter_prefill(limiter_t *lim) {
+    frame_ring_reset(lim->delay);
+
+    frame_ring_span_t span;
+    size_t got = frame_ring_write_acquire(lim->delay, lim->lookahead, &span);
+    memset(span.data1, 0, span.frames1 * lim->delay->stride);
+    if (span.frames2 > 0) {
+        memset(span.data2, 0, span.frames2 * lim->delay->stride);
+    }
+    frame_ring_write_commit(lim->delay, got);
+}
+
+limiter_t* limiter_create(unsigned int channels, float sample_rate, float ceiling_db,
+                          float lookahead_ms, float release_ms) {
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS || !(sample_rate > 0.0f) ||
+        !isfinite(ceiling_db) || !(lookahead_ms >= 0.0f) || !(release_ms >= 0.0f)) {
+        return NULL;
+    }
+
+    limiter_t *lim = calloc(1, sizeof(limiter_t));
+    if (!lim) {
+        return NULL;
+    }
+
+    lim->channels = channels;
+    lim->ceiling = powf(10.0f, ceiling_db / 20.0f);
+    lim->release_coef = release_ms > 0.0f ? expf(-1000.0f / (release_ms * sample_rate)) : 0.0f;
+    lim->lookahead = limiter_lookahead_frames(sample_rate, lookahead_ms);
+    lim->window = lim->lookahead + 1;
+
+    size_t deque_size = next_power_of_2(lim->window);
+    lim->deque_mask = deque_size - 1;
+    lim->delay = frame_ring_f32_create(next_power_of_2(lim->lookahead + LIMITER_BLOCK), channels,
+                                       NULL);
+    lim->gains = malloc(LIMITER_BLOCK * sizeof(float));
+    lim->deque_peak = malloc(deque_size * sizeof(float));
+    lim->deque_frame = malloc(deque_size * sizeof(uint64_t));
+    lim->history = malloc(lim->window * sizeof(float));
+    if (!lim->delay || !lim->gains || !lim->deque_peak || !lim->deque_frame || !lim->history) {
+        limiter_free(lim);
+        return NULL;
+    }
+
+    limiter_reset(lim);
+    return lim;
+}
+
+void limiter_free(limiter_t *lim) {
+    if (lim) {
+        frame_ring_free(lim->delay);
+        free(lim->gains);
+        free(lim->deque_peak);
+        free(lim->deque_frame);
+        free(lim->history);
+        free(lim);
+    }
+}
+
+void limiter_reset(limiter_t *lim) {
+    limiter_prefill(lim);
+
+    lim->deque_head = 0;
+    lim->deque_tail = 0;
+    lim->frame = 0;
+    lim->gain = 1.0f;
+    for (size_t i = 0; i < lim->window; i++) {
+        lim->history[i] = 1.0f;
+    }
+    lim->history_pos = 0;
+    lim->history_sum = (double)lim->window;
+    lim->min_gain = 1.0f;
+}
+
+/**
+ * Gain for each of frames input frames, into lim->gains (steps 1-3 above).
+ */
+static void limiter_gains(limiter_t *lim, const float *in, size_t frames) {
+    unsigned int channels = lim->channels;
+    float *deque_peak = lim->deque_peak;
+    uint64_t *deque_frame = lim->deque_frame;
+    size_t mask = lim->deque_mask;
+    size_t head = lim->deque_head;
+    size_t tail = lim->deque_tail;
+    uint64_t frame = lim->frame;
+    size_t window = lim->window;
+    float ceiling = lim->ceiling;
+    float release = lim->release_coef;
+    float gain = lim->gain;
+    float min_gain = lim->min_gain;
+
+    for (size_t i = 0; i < frames; i++) {
+        float peak = 0.0f;
+        for (unsigned int c = 0; c < channels; c++) {
+            float a = fabsf(in[i * channels + c]);
+            if (a > peak) peak = a;
+        }
+
+        // Frames arrive one at a time, so at most the oldest has expired.
+        // Dropping it before the push keeps at most window candidates live,
+        // which is all the ring has room for when window is a power of 2
+        if (tail != head && deque_frame[head & mask] + window <= frame) {
+            head++;
+        }
+
+        // A candidate no larger than this frame can never be the maximum
+        // again: this one is at least as big and stays in the window longer
+        while (tail != head && deque_peak[(tail - 1) & mask] <= peak) {
+            tail--;
+        }
+        deque_peak[tail & mask] = peak;
+        deque_frame[tail & mask] = frame;
+        tail++;
+        frame++;
+
+        float max = deque_peak[head & mask];
+        float allowed = max > ceiling ? ceiling / max : 1.0f;
+        gain = allowed < gain ? allowed : allowed + (gain - allowed) * release;
+
+        size_t pos = lim->history_pos;
+        lim->history_sum += (double)gain - lim->history[pos];
+        lim->history[pos] = gain;
+        if (++pos == window) {
+            // Start the sum afresh once per window so rounding can't pile up
+            double sum = 0.0;
+            for (size_t k = 0; k < window; k++) {
+                sum += lim->history[k];
+            }
+            lim->history_sum = sum;
+            pos = 0;
+        }
+        lim->history_pos = pos;
+
+        float smoothed = (float)(lim->history_sum / (double)window);
+        if (smoothed < min_gain) min_gain = smoothed;
+        lim->gains[i] = smoothed;
+    }
+
+    lim->deque_head = head;
+    lim->deque_tail = tail;
+    lim->frame = frame;
+    lim->gain = gain;
+    lim->min_gain = min_gain;
+}
+
+/**
+ * out = frames frames of delayed audio at src times the frame gains.
+ */
+static void limiter_apply(float *out, const float *src, const float *gains,
+                          size_t frames, unsigned int channels) {
+    for (size_t i = 0; i < frames; i++) {
+        float g = gains[i];
+        for (unsigned int c = 0; c < channels; c++) {
+            out[i * channels + c] = src[i * channels + c] * g;
+        }
+    }
+}
+
+void limiter_process(limiter_t *lim, float *buffer, size_t frames) {
+    unsigned int channels = lim->channels;
+
+    for (size_t pos = 0; pos < frames; pos += LIMITER_BLOCK) {
+        size_t n = frames - pos < LIMITER_BLOCK ? frames - pos : LIMITER_BLOCK;
+        float *block = &buffer[pos * channels];
+
+        limiter_gains(lim, block, n);
+
+        // The ring has room for a block past the lookahead, so both always
+        // fit; a wrapped span splits between whole frames
+        frame_ring_f32_write(lim->delay, block, n);
+        frame_ring_span_t span;
+        frame_ring_read_acquire(lim->delay, n, &span);
+        limiter_apply(block, span.data1, lim->gains, span.frames1, channels);
+        limiter_apply(&block[span.frames1 * channels], span.data2, &lim->gains[span.frames1],
+                      span.frames2, channels);
+        frame_ring_read_release(lim->delay, n);
+    }
+}
+
+size_t limiter_latency(const limiter_t *lim) {
+    return lim->lookahead;
+}
+
+size_t limiter_lookahead_frames(float sample_rate, float lookahead_ms) {
+    return (size_t)(lookahead_ms * sample_rate / 1000.0f + 0.5f);
+}
+
+float limiter_max_reduction_db(const limiter_t *lim) {
+    return 20.0f * log10f(lim->min_gain);
+}
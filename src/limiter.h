@@ -0,0 +1,108 @@
+#ifndef LIMITER_H
+#define LIMITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_ring.h"
+
+/**
+ * Lookahead brickwall limiter over interleaved frames, one gain for all
+ * channels so the stereo image doesn't shift.
+ *
+ * The audio goes through a delay line of lookahead frames, so the gain can
+ * start coming down before a peak arrives and reach what the peak needs
+ * exactly when it does: no sample leaves above the ceiling (to float
+ * rounding). Per frame:
+ *
+ *   1. The frame's peak (largest |sample|) enters a sliding maximum over
+ *      the last window = lookahead + 1 frames. A monotonic deque keeps the
+ *      candidates in decreasing order, so every frame is pushed and popped
+ *      at most once: O(1) amortized, however long the window.
+ *   2. The gain that maximum allows, min(1, ceiling / max), is taken at
+ *      once when it is lower than the current gain and released towards
+ *      with a one-pole release otherwise.
+ *   3. A running mean of that gain over the window turns each drop into a
+ *      ramp window frames long. Every term of the mean that lands on a
+ *      peak already allows for it, so the ramp ends at or below its gain.
+ *
+ * The output lags the input by limiter_latency() frames; callers that need
+ * the audio aligned (file output, live latency) account for it.
+ * Everything is allocated by limiter_create; processing never allocates.
+ */
+
+#define LIMITER_CEILING_DB -1.0f     // Defaults for the chain's limiter stage
+#define LIMITER_LOOKAHEAD_MS 5.0f
+#define LIMITER_RELEASE_MS 50.0f
+#define LIMITER_BLOCK 256            // Frames through the delay line at a time
+
+typedef struct {
+    unsigned int channels;
+    float ceiling;              // Linear
+    float release_coef;         // One-pole coefficient per frame
+    size_t lookahead;           // Frames of delay
+    size_t window;              // lookahead + 1
+
+    frame_ring_t *delay;        // lookahead frames of audio in flight
+    float *gains;               // Scratch: gain per frame of one block
+
+    // Sliding maximum: a ring of candidates, peaks decreasing from head
+    float *deque_peak;
+    uint64_t *deque_frame;
+    size_t deque_mask;
+    size_t deque_head;
+    size_t deque_tail;
+    uint64_t frame;             // Frames seen
+
+    float gain;                 // Released gain, before smoothing
+
+    // Running mean of the released gain over the window
+    float *history;             // window entries, a ring
+    size_t history_pos;
+    double history_sum;
+
+    float min_gain;             // Lowest smoothed gain applied since reset
+} limiter_t;
+
+/**
+ * Build a limiter for channels interleaved channels (1 to
+ * EFFECT_MAX_CHANNELS); no sample leaves above ceiling_db. With
+ * lookahead_ms 0 there is no delay, and the gain drops in one step at each
+ * peak. Returns NULL on failure or bad parameters.
+ */
+limiter_t* limiter_create(unsigned int channels, float sample_rate, float ceiling_db,
+                          float lookahead_ms, float release_ms);
+
+/**
+ * Free the limiter.
+ */
+void limiter_free(limiter_t *lim);
+
+/**
+ * Empty the delay line (back to lookahead frames of silence) and release
+ * the gain to unity.
+ */
+void limiter_reset(limiter_t *lim);
+
+/**
+ * Limit frames interleaved frames in place. The output is the input from
+ * limiter_latency() frames earlier.
+ */
+void limiter_process(limiter_t *lim, float *buffer, size_t frames);
+
+/**
+ * Frames the output lags the input.
+ */
+size_t limiter_latency(const limiter_t *lim);
+
+/**
+ * The latency a limiter created with lookahead_ms at sample_rate will have,
+ * without creating one.
+ */
+size_t limiter_lookahead_frames(float sample_rate, float lookahead_ms);
+
+/**
+ * Deepest gain reduction since create or reset, in dB (0 or negative).
+ */
+float limiter_max_reduction_db(const limiter_t *lim);
+
+#endif // LIMITER_H
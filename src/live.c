@@ -0,0 +1,1116 @@
+#include "live.h"
+#include "audio_io.h"
+#include "frame_ring.h"
+#include "resampler.h"
+#include "utils.h"
+#include "rt_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define LIVE_MIN_RING_FRAMES 1024
+#define LIVE_REPORT_INTERVAL_NS 1000000000ull
+#define LIVE_POLL_INTERVAL_NS 10000000ull
+
+// Auto-tune: start small, double the period whenever glitches show up
+#define LIVE_AUTOTUNE_MIN_PERIOD 32
+#define LIVE_AUTOTUNE_MAX_PERIOD 4096
+#define LIVE_AUTOTUNE_SETTLE_NS 500000000ull
+
+// Drift correction: a PI loop on the smoothed ring fill steers the playback
+// resampler, within +/- LIVE_DRIFT_MAX of the nominal ratio
+#define LIVE_DRIFT_SMOOTHING 0.02    // Per DSP block
+#define LIVE_DRIFT_KP 1.5e-5         // Per frame of fill error
+#define LIVE_DRIFT_KI 6e-6           // Per frame of fill error, per second
+#define LIVE_DRIFT_MAX 0.001
+#define LIVE_DRIFT_SETTLE_NS 1000000000ull  // Fill to hold is taken after this long
+
+static atomic_bool live_stop_requested = false;
+
+typedef struct {
+    const live_config_t *config;
+    size_t capture_period;           // Negotiated frames per capture period
+    size_t playback_period;          // Negotiated frames per playback period
+    
+    audio_device_t *capture;
+    audio_device_t *playback;
+    frame_ring_t *captured;          // Capture -> DSP
+    frame_ring_t *processed;         // DSP -> playback
+    effect_graph_runner_t own_graphs;  // Built from config->effects
+    effect_graph_runner_t *graphs;   // own_graphs, or config->graphs
+    block_timing_t dsp_timing;       // Written by the DSP thread only
+    
+    float *capture_scratch;          // Landing area for dropped/wrapped periods
+    float *playback_scratch;         // Landing area for wrapped/padded periods
+    
+    // Rate conversion, owned by the DSP thread. The effects run at
+    // config->sample_rate whatever the devices negotiated
+    resampler_t *in_resampler;       // Capture rate -> DSP rate, NULL when they match
+    resampler_t *out_resampler;      // DSP rate -> playback rate, NULL when they match
+                                     // and drift correction is off
+    wav_writer_t *recorder;          // Fed by the DSP thread; NULL when not recording
+    meter_t *meter;                  // Tapped by the DSP thread; NULL when not metering
+    net_receiver_t *receiver;        // Stands in for the capture device with receive_from
+    net_sender_t *sender;            // Fed by the capture thread with send_to
+    float *dsp_scratch;              // One converted capture period at the DSP rate
+    size_t dsp_scratch_frames;
+    double drift_fill;               // Smoothed ring fill, in playback frames
+    double drift_target;             // Fill to hold: drift_fill once settled
+    double drift_floor;              // Lowest target that stays clear of underruns
+    double drift_integral;
+    double drift_seconds;            // DSP block length, for the integral
+    uint64_t drift_blocks;           // Blocks seen; the loop starts after settling
+    uint64_t drift_settle_blocks;
+    
+    atomic_bool running;
+    atomic_bool failed;
+    
+    // Published counters (one writer each, read by the reporting thread)
+    atomic_size_t capture_delay;     // Frames, last value seen by capture thread
+    atomic_size_t latency_frames;    // Last measured input-to-output latency
+    atomic_size_t graph_latency;     // The running graph's delay, at the DSP rate
+    atomic_uint_least64_t frames_captured;
+    atomic_uint_least64_t frames_played;
+    atomic_uint_least64_t frames_dropped;
+    atomic_uint_least64_t underruns;
+    atomic_uint_least64_t capture_time;   // utils_now_ns() after the last capture period
+    atomic_uint_least64_t playback_time;  // utils_now_ns() after the last playback period
+    
+    double drift_correction;         // Playback ratio trim of the last finished session
+    unsigned int capture_rate;       // Negotiated rates of the last finished session
+    unsigned int playback_rate;
+    bool rates_reported;
+    bool formats_reported;
+    
+    pthread_t threads[3];
+    int started;                     // Threads running in the current session
+    unsigned int rt_flags;           // RT_THREAD_* flags every thread of the session got
+    bool memory_locked;
+    uint64_t xruns;                  // Device xruns from finished sessions
+    uint64_t suspends;               // Device suspends from finished sessions
+    size_t captured_high_water;      // Ring peaks of the last finished session
+    size_t processed_high_water;
+    
+    // Latency summary, owned by the playback thread
+    size_t latency_min;
+    size_t latency_max;
+    double latency_sum;
+    uint64_t latency_count;
+} live_t;
+
+static size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static double frames_to_ms(size_t frames, unsigned int sample_rate) {
+    return frames * 1000.0 / sample_rate;
+}
+
+/**
+ * The rate ring A is filled at: the capture device's, or the DSP rate when
+ * the input comes from the network.
+ */
+static unsigned int capture_rate_of(const live_t *l) {
+    return l->capture ? l->capture->sample_rate : l->config->sample_rate;
+}
+
+/**
+ * Store a captured period in ring A, or drop it if DSP is too far behind.
+ */
+static void capture_store(live_t *l, const float *frames_in, size_t frames) {
+    frame_ring_span_t span;
+    if (frame_ring_write_acquire(l->captured, frames, &span) < frames) {
+        // DSP is behind: drop this period rather than stall the device
+        stats_counter_add(&l->frames_dropped, frames);
+        return;
+    }
+    
+    size_t stride = l->captured->stride;
+    memcpy(span.data1, frames_in, span.frames1 * stride);
+    memcpy(span.data2, (const unsigned char*)frames_in + span.frames1 * stride,
+           span.frames2 * stride);
+    frame_ring_write_commit(l->captured, frames);
+}
+
+/**
+ * Read/write access (or mmap access converting from an integer format):
+ * read the period straight into the ring when it doesn't wrap.
+ */
+static ssize_t capture_period_rw(live_t *l) {
+    size_t period = l->capture_period;
+    
+    frame_ring_span_t span;
+    size_t space = frame_ring_write_acquire(l->captured, period, &span);
+    bool direct = space == period && span.frames2 == 0;
+    
+    ssize_t frames = audio_capture_read(l->capture,
+                                        direct ? frame_ring_f32_data1(&span) : l->capture_scratch,
+                                        period);
+    if (frames > 0) {
+        if (direct) {
+            frame_ring_write_commit(l->captured, (size_t)frames);
+        } else {
+            capture_store(l, l->capture_scratch, (size_t)frames);
+        }
+    }
+    return frames;
+}
+
+/**
+ * Mmap access: copy straight out of the DMA area into the ring.
+ */
+static ssize_t capture_period_mmap(live_t *l) {
+    float *area;
+    ssize_t frames = audio_device_mmap_begin(l->capture, &area, l->capture_period);
+    if (frames <= 0) {
+        return frames;
+    }
+    
+    capture_store(l, area, (size_t)frames);
+    
+    int err = audio_device_mmap_commit(l->capture, (size_t)frames);
+    return err < 0 ? err : frames;
+}
+
+static void* capture_thread(void *arg) {
+    live_t *l = (live_t*)arg;
+    
+    while (atomic_load_explicit(&l->running, memory_order_relaxed)) {
+        ssize_t frames = audio_device_zero_copy(l->capture) ? capture_period_mmap(l)
+                                                            : capture_period_rw(l);
+        if (frames < 0) {
+            fprintf(stderr, "✗ Error: Capture failed\n");
+            atomic_store(&l->failed, true);
+            atomic_store(&l->running, false);
+            break;
+        }
+        if (frames == 0) {
+            continue;  // Recovered from an xrun, try again
+        }
+        
+        stats_counter_add(&l->frames_captured, (uint64_t)frames);
+        atomic_store_explicit(&l->capture_time, utils_now_ns(), memory_order_relaxed);
+        atomic_store_explicit(&l->capture_delay, audio_device_delay(l->capture),
+                              memory_order_relaxed);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Capture from the network: a period out of the jitter buffer into ring A
+ * every period of the local clock. The jitter buffer's depth stands in for
+ * the capture device's delay.
+ */
+static void* network_capture_thread(void *arg) {
+    live_t *l = (live_t*)arg;
+    size_t period = l->capture_period;
+    double ns_per_frame = 1e9 / l->config->sample_rate;
+    uint64_t start = utils_now_ns();
+    uint64_t frames = 0;
+    
+    while (atomic_load_explicit(&l->running, memory_order_relaxed)) {
+        uint64_t now = utils_now_ns();
+        uint64_t due = start + (uint64_t)((frames + period) * ns_per_frame);
+        if (due > now) {
+            utils_sleep_ns(due - now);
+        } else if (now - due > 4 * period * ns_per_frame) {
+            // Descheduled for a while: carry on from now rather than catch up
+            start = now - (uint64_t)((frames + period) * ns_per_frame);
+        }
+        
+        net_receiver_read(l->receiver, l->capture_scratch, period);
+        capture_store(l, l->capture_scratch, period);
+        frames += period;
+        
+        stats_counter_add(&l->frames_captured, period);
+        atomic_store_explicit(&l->capture_time, utils_now_ns(), memory_order_relaxed);
+        atomic_store_explicit(&l->capture_delay,
+                              atomic_load_explicit(&l->receiver->delay_frames,
+                                                   memory_order_relaxed),
+                              memory_order_relaxed);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Capture and send (send_to): every period goes straight out to the
+ * network, from the DMA area where the device allows.
+ */
+static void* send_thread(void *arg) {
+    live_t *l = (live_t*)arg;
+    
+    while (atomic_load_explicit(&l->running, memory_order_relaxed)) {
+        ssize_t frames;
+        if (audio_device_zero_copy(l->capture)) {
+            float *area;
+            frames = audio_device_mmap_begin(l->capture, &area, l->capture_period);
+            if (frames > 0) {
+                net_sender_send(l->sender, area, (size_t)frames);
+                int err = audio_device_mmap_commit(l->capture, (size_t)frames);
+                frames = err < 0 ? err : frames;
+            }
+        } else {
+            frames = audio_capture_read(l->capture, l->capture_scratch, l->capture_period);
+            if (frames > 0) {
+                net_sender_send(l->sender, l->capture_scratch, (size_t)frames);
+            }
+        }
+        if (frames < 0) {
+            fprintf(stderr, "✗ Error: Capture failed\n");
+            atomic_store(&l->failed, true);
+            atomic_store(&l->running, false);
+            break;
+        }
+        stats_counter_add(&l->frames_captured, (uint64_t)frames);
+    }
+    
+    return NULL;
+}
+
+/**
+ * Upper bound on the playback frames count capture frames turn into.
+ */
+static size_t dsp_output_bound(live_t *l, size_t count) {
+    if (l->in_resampler) {
+        count = resampler_max_output(l->in_resampler, count);
+    }
+    if (l->out_resampler) {
+        count = resampler_max_output(l->out_resampler, count);
+    }
+    return count;
+}
+
+/**
+ * How many capture frames the DSP thread can take when space frames are
+ * free in ring B: everything they turn into must fit, so a block never has
+ * to be cut short.
+ */
+static size_t dsp_input_limit(live_t *l, size_t space) {
+    size_t count = l->capture_period;
+    if (!l->in_resampler && !l->out_resampler) {
+        return space < count ? space : count;
+    }
+    
+    while (count > 0 && (dsp_output_bound(l, count) > space ||
+                         (l->in_resampler &&
+                          resampler_max_output(l->in_resampler, count) > l->dsp_scratch_frames))) {
+        count -= count / 8 + 1;
+    }
+    return count;
+}
+
+/**
+ * Write a DSP block into ring B, through the playback resampler if any.
+ * dsp_input_limit() made sure there is room for all of it.
+ */
+static void dsp_emit(live_t *l, const float *block, size_t frames) {
+    if (!l->out_resampler) {
+        frame_ring_f32_write(l->processed, block, frames);
+        return;
+    }
+    
+    frame_ring_span_t span;
+    size_t space = frame_ring_write_acquire(l->processed, frame_ring_write_available(l->processed),
+                                            &span);
+    size_t used;
+    size_t produced = resampler_process(l->out_resampler, block, frames, &used,
+                                        frame_ring_f32_data1(&span), span.frames1);
+    if (used < frames && produced == span.frames1) {
+        size_t more;
+        produced += resampler_process(l->out_resampler, &block[used * l->config->channels],
+                                      frames - used, &more, frame_ring_f32_data2(&span),
+                                      space - span.frames1);
+    }
+    frame_ring_write_commit(l->processed, produced);
+}
+
+/**
+ * Seconds since a device thread last moved a period, at most one period:
+ * how far the device has got into the next one.
+ */
+static double since_period(atomic_uint_least64_t *when, uint64_t now, size_t period,
+                           unsigned int rate) {
+    uint64_t then = atomic_load_explicit(when, memory_order_relaxed);
+    double seconds = then && now > then ? (now - then) / 1e9 : 0.0;
+    double limit = (double)period / rate;
+    return seconds < limit ? seconds : limit;
+}
+
+/**
+ * Steer the playback resampler so the ring fill holds where it settled:
+ * when the playback clock runs slow relative to capture the rings fill up,
+ * and the step grows until playback takes frames as fast as capture
+ * delivers them (and the other way round).
+ *
+ * The rings alone jump by a period whenever a device thread moves one, and
+ * where in those jumps DSP happens to look drifts as slowly as the clocks
+ * do, so it would read as drift itself. Counting the frames each device
+ * has moved since its last period (from the time passed) makes the fill
+ * continuous.
+ */
+static void dsp_correct_drift(live_t *l) {
+    unsigned int capture_rate = capture_rate_of(l);
+    unsigned int playback_rate = l->playback->sample_rate;
+    uint64_t now = utils_now_ns();
+    
+    double captured = frame_ring_read_available(l->captured) +
+                      since_period(&l->capture_time, now, l->capture_period, capture_rate) *
+                      capture_rate;
+    double processed = frame_ring_read_available(l->processed) -
+                       since_period(&l->playback_time, now, l->playback_period, playback_rate) *
+                       playback_rate;
+    double fill = captured * playback_rate / capture_rate + processed;
+    
+    if (l->drift_blocks++ == 0) {
+        l->drift_fill = fill;
+    }
+    l->drift_fill += (fill - l->drift_fill) * LIVE_DRIFT_SMOOTHING;
+    if (l->drift_blocks <= l->drift_settle_blocks) {
+        l->drift_target = l->drift_fill > l->drift_floor ? l->drift_fill : l->drift_floor;
+        return;
+    }
+    
+    double error = l->drift_fill - l->drift_target;
+    
+    l->drift_integral += error * LIVE_DRIFT_KI * l->drift_seconds;
+    if (l->drift_integral > LIVE_DRIFT_MAX) l->drift_integral = LIVE_DRIFT_MAX;
+    if (l->drift_integral < -LIVE_DRIFT_MAX) l->drift_integral = -LIVE_DRIFT_MAX;
+    
+    double trim = error * LIVE_DRIFT_KP + l->drift_integral;
+    if (trim > LIVE_DRIFT_MAX) trim = LIVE_DRIFT_MAX;
+    if (trim < -LIVE_DRIFT_MAX) trim = -LIVE_DRIFT_MAX;
+    resampler_set_correction(l->out_resampler, 1.0 + trim);
+}
+
+static void* dsp_thread(void *arg) {
+    live_t *l = (live_t*)arg;
+    unsigned int spins = 0;
+    
+    unsigned int channels = l->config->channels;
+    
+    while (atomic_load_explicit(&l->running, memory_order_relaxed)) {
+        size_t limit = dsp_input_limit(l, frame_ring_write_available(l->processed));
+        
+        frame_ring_span_t span;
+        size_t count = limit ? frame_ring_read_acquire(l->captured, limit, &span) : 0;
+        if (count == 0) {
+            utils_backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        
+        uint64_t t0 = utils_now_ns();
+        effect_chain_t *chain = effect_graph_runner_chain(l->graphs);
+        if (l->config->params && chain) {
+            param_queue_apply(l->config->params, chain);
+        }
+        float *data1 = frame_ring_f32_data1(&span);
+        float *data2 = frame_ring_f32_data2(&span);
+        
+        if (l->in_resampler) {
+            // Convert to the DSP rate first, then process the block there
+            float *block = l->dsp_scratch;
+            size_t frames = resampler_process(l->in_resampler, data1, span.frames1, NULL,
+                                              block, l->dsp_scratch_frames);
+            frames += resampler_process(l->in_resampler, data2, span.frames2, NULL,
+                                        &block[frames * channels], l->dsp_scratch_frames - frames);
+            frame_ring_span_t converted = { block, frames, NULL, 0 };
+            effect_graph_runner_process_split(l->graphs, &converted);
+            dsp_emit(l, block, frames);
+            if (l->recorder) {
+                wav_writer_write(l->recorder, block, frames);
+            }
+            if (l->meter) {
+                meter_tap(l->meter, block, frames);
+            }
+        } else {
+            effect_graph_runner_process_split(l->graphs, &span);
+            dsp_emit(l, data1, span.frames1);
+            if (span.frames2 > 0) {
+                dsp_emit(l, data2, span.frames2);
+            }
+            if (l->recorder) {
+                wav_writer_write(l->recorder, data1, span.frames1);
+                wav_writer_write(l->recorder, data2, span.frames2);
+            }
+            if (l->meter) {
+                meter_tap(l->meter, data1, span.frames1);
+                meter_tap(l->meter, data2, span.frames2);
+            }
+        }
+        atomic_store_explicit(&l->graph_latency, effect_graph_runner_latency(l->graphs),
+                              memory_order_relaxed);
+        block_timing_record(&l->dsp_timing, utils_now_ns() - t0);
+        frame_ring_read_release(l->captured, count);
+        
+        if (l->config->drift_correction) {
+            dsp_correct_drift(l);
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * Everything queued between the ADC and the DAC, plus what the effects
+ * hold back, in frames at the DSP rate.
+ */
+static size_t measure_latency(live_t *l) {
+    size_t capture_side = atomic_load_explicit(&l->capture_delay, memory_order_relaxed) +
+                          frame_ring_read_available(l->captured);
+    size_t playback_side = frame_ring_read_available(l->processed) +
+                           audio_device_delay(l->playback);
+    
+    double dsp_rate = l->config->sample_rate;
+    return (size_t)(capture_side * dsp_rate / capture_rate_of(l) +
+                    playback_side * dsp_rate / l->playback->sample_rate) +
+           atomic_load_explicit(&l->graph_latency, memory_order_relaxed);
+}
+
+/**
+ * Copy frames of ring B into dst, or silence when ring B doesn't hold that
+ * many yet. A short ring is left as it is, so after an underrun it keeps
+ * the slack it was missing; that matters when DSP blocks and playback
+ * periods differ in size, as they do when resampling.
+ * Returns the number of frames taken from the ring (caller releases them).
+ */
+static size_t playback_fill(live_t *l, float *dst, size_t frames) {
+    size_t stride = l->processed->stride;
+    unsigned char *out = (unsigned char*)dst;
+    
+    frame_ring_span_t span;
+    size_t count = frame_ring_read_acquire(l->processed, frames, &span);
+    if (count < frames) {
+        memset(out, 0, frames * stride);
+        stats_counter_add(&l->underruns, 1);
+        return 0;
+    }
+    
+    memcpy(out, span.data1, span.frames1 * stride);
+    memcpy(out + span.frames1 * stride, span.data2, span.frames2 * stride);
+    return count;
+}
+
+/**
+ * Read/write access (or mmap access converting to an integer format):
+ * write straight from the ring when the period doesn't wrap.
+ */
+static ssize_t playback_period_rw(live_t *l) {
+    size_t period = l->playback_period;
+    
+    frame_ring_span_t span;
+    size_t count = frame_ring_read_acquire(l->processed, period, &span);
+    const float *src = frame_ring_f32_data1(&span);
+    
+    if (count < period || span.frames2 > 0) {
+        count = playback_fill(l, l->playback_scratch, period);
+        src = l->playback_scratch;
+    }
+    
+    // Hand back only what the device took; after an xrun or a short write
+    // the rest stays queued for the next period instead of vanishing
+    ssize_t frames = audio_playback_write(l->playback, src, period);
+    if (frames > 0 && count > 0) {
+        frame_ring_read_release(l->processed, (size_t)frames < count ? (size_t)frames : count);
+    }
+    return frames;
+}
+
+/**
+ * Mmap access: copy the ring straight into the DMA area.
+ */
+static ssize_t playback_period_mmap(live_t *l) {
+    float *area;
+    ssize_t frames = audio_device_mmap_begin(l->playback, &area, l->playback_period);
+    if (frames <= 0) {
+        return frames;
+    }
+    
+    size_t count = playback_fill(l, area, (size_t)frames);
+    int err = audio_device_mmap_commit(l->playback, (size_t)frames);
+    frame_ring_read_release(l->processed, count);
+    return err < 0 ? err : frames;
+}
+
+static void* playback_thread(void *arg) {
+    live_t *l = (live_t*)arg;
+    uint64_t period_ns = (uint64_t)l->playback_period * 1000000000ull / l->playback->sample_rate;
+    
+    while (atomic_load_explicit(&l->running, memory_order_relaxed)) {
+        // Give DSP up to half a period to deliver before padding with silence
+        uint64_t deadline = utils_now_ns() + period_ns / 2;
+        unsigned int spins = 0;
+        while (frame_ring_read_available(l->processed) < l->playback_period &&
+               utils_now_ns() < deadline) {
+            utils_backoff(&spins);
+        }
+        
+        ssize_t frames = audio_device_zero_copy(l->playback) ? playback_period_mmap(l)
+                                                              : playback_period_rw(l);
+        if (frames < 0) {
+            fprintf(stderr, "✗ Error: Playback failed\n");
+            atomic_store(&l->failed, true);
+            atomic_store(&l->running, false);
+            break;
+        }
+        stats_counter_add(&l->frames_played, (uint64_t)frames);
+        atomic_store_explicit(&l->playback_time, utils_now_ns(), memory_order_relaxed);
+        
+        size_t latency = measure_latency(l);
+        atomic_store_explicit(&l->latency_frames, latency, memory_order_relaxed);
+        if (l->latency_count == 0 || latency < l->latency_min) l->latency_min = latency;
+        if (latency > l->latency_max) l->latency_max = latency;
+        l->latency_sum += latency;
+        l->latency_count++;
+    }
+    
+    return NULL;
+}
+
+void live_request_stop(void) {
+    atomic_store(&live_stop_requested, true);
+}
+
+static void live_cleanup(live_t *l) {
+    audio_device_close(l->capture);
+    audio_device_close(l->playback);
+    frame_ring_free(l->captured);
+    frame_ring_free(l->processed);
+    free(l->capture_scratch);
+    free(l->playback_scratch);
+    resampler_free(l->in_resampler);
+    resampler_free(l->out_resampler);
+    free(l->dsp_scratch);
+    l->capture = l->playback = NULL;
+    l->captured = l->processed = NULL;
+    l->capture_scratch = l->playback_scratch = NULL;
+    l->in_resampler = l->out_resampler = NULL;
+    l->dsp_scratch = NULL;
+}
+
+/**
+ * Open both devices at the requested period size, size the rings for what
+ * was negotiated, prefill towards the latency target and start the threads.
+ */
+static int live_session_start(live_t *l, size_t period) {
+    const live_config_t *config = l->config;
+    
+    audio_device_config_t device;
+    audio_device_config_init(&device, config->capture_device, config->sample_rate,
+                             config->channels, period);
+    device.period_count = config->period_count;
+    device.use_mmap = config->use_mmap;
+    device.format = config->device_format;
+    if (!l->receiver) {
+        l->capture = audio_device_open(&device, SND_PCM_STREAM_CAPTURE);
+    }
+    
+    device.device_name = config->playback_device;
+    l->playback = audio_device_open(&device, SND_PCM_STREAM_PLAYBACK);
+    
+    if ((!l->capture && !l->receiver) || !l->playback) {
+        fprintf(stderr, "✗ Error: Failed to open audio devices\n");
+        live_cleanup(l);
+        return 1;
+    }
+    
+    l->capture_period = l->capture ? l->capture->period_size : period;
+    l->playback_period = l->playback->period_size;
+    if (!l->formats_reported) {
+        printf("  Formats:    capture %s, playback %s\n",
+               l->capture ? sample_format_name(l->capture->format) : "network",
+               sample_format_name(l->playback->format));
+        l->formats_reported = true;
+    }
+    
+    size_t largest = l->capture_period > l->playback_period ? l->capture_period : l->playback_period;
+    size_t target_frames = (size_t)(config->latency_ms * config->sample_rate / 1000.0f);
+    size_t ring_frames = next_power_of_2(target_frames + 4 * largest);
+    if (ring_frames < LIVE_MIN_RING_FRAMES) ring_frames = LIVE_MIN_RING_FRAMES;
+    
+    // Frame rings, so DSP always sees whole frames; mirrored where the
+    // size allows, so spans are contiguous too
+    ring_buffer_options_t rings;
+    ring_buffer_options_init(&rings);
+    rings.mirrored = true;
+    rings.lock = config->rt.lock_memory;
+    l->captured = frame_ring_f32_create(ring_frames, config->channels, &rings);
+    l->processed = frame_ring_f32_create(ring_frames, config->channels, &rings);
+    l->capture_scratch = malloc(l->capture_period * config->channels * sizeof(float));
+    l->playback_scratch = calloc(l->playback_period * config->channels, sizeof(float));
+    
+    // The devices may have settled on other rates than asked for: convert to
+    // and from the DSP rate rather than run the effects at the wrong one
+    unsigned int capture_rate = capture_rate_of(l);
+    unsigned int playback_rate = l->playback->sample_rate;
+    bool convert_in = capture_rate != config->sample_rate;
+    bool convert_out = playback_rate != config->sample_rate || config->drift_correction;
+    if (convert_in) {
+        l->in_resampler = resampler_create(config->channels, capture_rate, config->sample_rate);
+        l->dsp_scratch_frames = (size_t)((l->capture_period + RESAMPLER_TAPS) *
+                                         (double)config->sample_rate / capture_rate) + 8;
+        l->dsp_scratch = malloc(l->dsp_scratch_frames * config->channels * sizeof(float));
+    }
+    if (convert_out) {
+        l->out_resampler = resampler_create(config->channels, config->sample_rate, playback_rate);
+    }
+    
+    if (!l->captured || !l->processed || !l->capture_scratch || !l->playback_scratch ||
+        (convert_in && (!l->in_resampler || !l->dsp_scratch)) ||
+        (convert_out && !l->out_resampler)) {
+        fprintf(stderr, "✗ Error: Failed to set up live audio\n");
+        live_cleanup(l);
+        return 1;
+    }
+    if ((convert_in || playback_rate != config->sample_rate) && !l->rates_reported) {
+        printf("  Resampling: capture %u Hz -> DSP %u Hz -> playback %u Hz\n",
+               capture_rate, config->sample_rate, playback_rate);
+        l->rates_reported = true;
+    }
+    
+    l->drift_blocks = 0;
+    l->drift_integral = 0.0;
+    l->drift_seconds = (double)l->capture_period / capture_rate;
+    l->drift_settle_blocks = (uint64_t)(LIVE_DRIFT_SETTLE_NS / 1e9 / l->drift_seconds);
+    
+    // Up to a capture period of the fill can be waiting in ring A just as
+    // playback wants a period from ring B: with the clocks apart, the two
+    // devices' wakeups slide past each other, so sooner or later they line
+    // up. An underrun's silence would read as surplus fill and push the
+    // loop the wrong way
+    l->drift_floor = (double)l->capture_period * playback_rate / capture_rate +
+                     (double)l->playback_period;
+    
+    // One period sits in the capture device and one in the playback device,
+    // and the effects may delay the audio too (a limiter's lookahead); make
+    // up the rest of the latency target with silence in ring B
+    size_t graph_latency = effect_graph_runner_latency(l->graphs);
+    atomic_store(&l->graph_latency, graph_latency);
+    size_t in_devices = l->capture_period + l->playback_period +
+                        (size_t)((double)graph_latency * playback_rate / config->sample_rate);
+    size_t prefill = target_frames > in_devices ? target_frames - in_devices : 0;
+    while (prefill > 0) {
+        size_t n = prefill < l->playback_period ? prefill : l->playback_period;
+        frame_ring_f32_write(l->processed, l->playback_scratch, n);
+        prefill -= n;
+    }
+    
+    // Deadline: DSP has one capture period to turn each block around
+    block_timing_init(&l->dsp_timing,
+                      (uint64_t)l->capture_period * 1000000000ull / capture_rate);
+    
+    atomic_store(&l->running, true);
+    atomic_store(&l->capture_delay, 0);
+    l->started = 0;
+    
+    void *(*entry[3])(void *) = { playback_thread, dsp_thread,
+                                  l->receiver ? network_capture_thread : capture_thread };
+    l->rt_flags = ~0u;
+    for (; l->started < 3; l->started++) {
+        unsigned int applied;
+        if (rt_thread_create(&l->threads[l->started], &config->rt, (unsigned int)l->started,
+                             entry[l->started], l, &applied) != 0) {
+            fprintf(stderr, "✗ Error: Failed to start live thread\n");
+            atomic_store(&l->failed, true);
+            atomic_store(&l->running, false);
+            return 1;
+        }
+        l->rt_flags &= applied;
+    }
+    
+    return 0;
+}
+
+/**
+ * Stop and join the threads, fold device counters into the totals, close.
+ */
+static void live_session_stop(live_t *l) {
+    atomic_store(&l->running, false);
+    for (int i = 0; i < l->started; i++) {
+        pthread_join(l->threads[i], NULL);
+    }
+    l->started = 0;
+    
+    if (l->capture) {
+        l->xruns += atomic_load(&l->capture->xruns);
+        l->suspends += atomic_load(&l->capture->suspends);
+    }
+    if (l->playback) {
+        l->xruns += atomic_load(&l->playback->xruns);
+        l->suspends += atomic_load(&l->playback->suspends);
+    }
+    if (l->captured && l->processed) {
+        l->captured_high_water = frame_ring_high_water(l->captured);
+        l->processed_high_water = frame_ring_high_water(l->processed);
+    }
+    if ((l->capture || l->receiver) && l->playback) {
+        l->capture_rate = capture_rate_of(l);
+        l->playback_rate = l->playback->sample_rate;
+    }
+    l->drift_correction = l->out_resampler ? l->out_resampler->correction : 1.0;
+    live_cleanup(l);
+}
+
+/**
+ * Anything audible: device xruns, dropped capture periods, padded playback periods.
+ * Not the network's underruns: a longer period wouldn't help those.
+ */
+static uint64_t live_glitches(live_t *l) {
+    return (l->capture ? atomic_load(&l->capture->xruns) : 0) +
+           atomic_load(&l->playback->xruns) + atomic_load(&l->frames_dropped) +
+           atomic_load(&l->underruns);
+}
+
+static void live_reset_latency(live_t *l) {
+    l->latency_min = 0;
+    l->latency_max = 0;
+    l->latency_sum = 0.0;
+    l->latency_count = 0;
+}
+
+/**
+ * The sending end (send_to): open only the capture device and run one
+ * thread that captures and sends, until the duration elapses or a stop is
+ * requested.
+ */
+static int live_send(live_t *l, live_stats_t *stats) {
+    const live_config_t *config = l->config;
+    
+    audio_device_config_t device;
+    audio_device_config_init(&device, config->capture_device, config->sample_rate,
+                             config->channels, config->period_frames);
+    device.period_count = config->period_count;
+    device.use_mmap = config->use_mmap;
+    device.format = config->device_format;
+    l->capture = audio_device_open(&device, SND_PCM_STREAM_CAPTURE);
+    if (!l->capture) {
+        fprintf(stderr, "✗ Error: Failed to open audio devices\n");
+        return 1;
+    }
+    // The receiver expects the configured rate; there's no DSP here to convert
+    if (l->capture->sample_rate != config->sample_rate) {
+        fprintf(stderr, "✗ Error: Capture runs at %u Hz, not %u Hz\n",
+                l->capture->sample_rate, config->sample_rate);
+        audio_device_close(l->capture);
+        return 1;
+    }
+    l->capture_period = l->capture->period_size;
+    l->capture_scratch = malloc(l->capture_period * config->channels * sizeof(float));
+    l->sender = net_sender_open(config->send_to, config->channels, config->sample_rate,
+                                config->net_config);
+    if (!l->capture_scratch || !l->sender) {
+        fprintf(stderr, "✗ Error: Can't send to '%s'\n", config->send_to);
+        audio_device_close(l->capture);
+        free(l->capture_scratch);
+        net_sender_close(l->sender);
+        return 1;
+    }
+    printf("  Sending:    %s, %zu frames per packet, capture %s\n", config->send_to,
+           l->sender->packet_frames, sample_format_name(l->capture->format));
+    
+    if (config->rt.lock_memory) {
+        l->memory_locked = rt_lock_memory() == 0;
+        if (!l->memory_locked) {
+            fprintf(stderr, "Warning: Could not lock memory (raise the memlock limit)\n");
+        }
+    }
+    
+    // Same slot as the capture thread of a full-duplex run
+    atomic_store(&l->running, true);
+    if (rt_thread_create(&l->threads[0], &config->rt, 2, send_thread, l, &l->rt_flags) != 0) {
+        fprintf(stderr, "✗ Error: Failed to start live thread\n");
+        atomic_store(&l->failed, true);
+        atomic_store(&l->running, false);
+    } else {
+        l->started = 1;
+    }
+    
+    uint64_t start = utils_now_ns();
+    uint64_t stop_at = config->duration_s > 0 ? start + (uint64_t)(config->duration_s * 1e9) : 0;
+    uint64_t next_report = start + LIVE_REPORT_INTERVAL_NS;
+    while (atomic_load(&l->running) && !atomic_load(&live_stop_requested)) {
+        uint64_t now = utils_now_ns();
+        if (stop_at && now >= stop_at) {
+            break;
+        }
+        if (now >= next_report) {
+            printf("\r  period %zu | sent %llu packets | unsent %llu | xruns %llu   ",
+                   l->capture_period, (unsigned long long)atomic_load(&l->sender->packets_sent),
+                   (unsigned long long)atomic_load(&l->sender->packets_dropped),
+                   (unsigned long long)atomic_load(&l->capture->xruns));
+            fflush(stdout);
+            next_report += LIVE_REPORT_INTERVAL_NS;
+        }
+        utils_sleep_ns(LIVE_POLL_INTERVAL_NS);
+    }
+    printf("\n");
+    
+    atomic_store(&l->running, false);
+    if (l->started) {
+        pthread_join(l->threads[0], NULL);
+    }
+    if (l->memory_locked) {
+        rt_unlock_memory();
+    }
+    
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->frames_captured = atomic_load(&l->frames_captured);
+        stats->xruns = atomic_load(&l->capture->xruns);
+        stats->suspends = atomic_load(&l->capture->suspends);
+        stats->period_frames = l->capture_period;
+        stats->rt_flags = l->rt_flags;
+        stats->memory_locked = l->memory_locked;
+        stats->capture_rate = l->capture->sample_rate;
+        stats->packets_sent = atomic_load(&l->sender->packets_sent);
+        stats->packets_unsent = atomic_load(&l->sender->packets_dropped);
+    }
+    audio_device_close(l->capture);
+    free(l->capture_scratch);
+    net_sender_close(l->sender);
+    return atomic_load(&l->failed) ? 1 : 0;
+}
+
+int live_run(const live_config_t *config, live_stats_t *stats) {
+    live_t l;
+    memset(&l, 0, sizeof(l));
+    l.config = config;
+    atomic_init(&l.running, false);
+    atomic_init(&l.failed, false);
+    atomic_init(&l.capture_delay, 0);
+    atomic_init(&l.latency_frames, 0);
+    atomic_init(&l.graph_latency, 0);
+    atomic_init(&l.frames_captured, 0);
+    atomic_init(&l.frames_played, 0);
+    atomic_init(&l.capture_time, 0);
+    atomic_init(&l.playback_time, 0);
+    atomic_init(&l.frames_dropped, 0);
+    atomic_init(&l.underruns, 0);
+    atomic_store(&live_stop_requested, false);
+    
+    if (config->channels == 0 || config->channels > EFFECT_MAX_CHANNELS) {
+        fprintf(stderr, "✗ Error: %u channels not supported (1-%d)\n",
+                config->channels, EFFECT_MAX_CHANNELS);
+        return 1;
+    }
+    if (config->send_to) {
+        return live_send(&l, stats);
+    }
+    
+    l.graphs = config->graphs;
+    if (!l.graphs) {
+        // Live audio can't wait for a convolution tail that's running late
+        effect_chain_config_t effects = config->effects;
+        effects.ir_realtime = true;
+        effect_graph_t *graph = effect_graph_from_config(&effects, config->sample_rate,
+                                                         config->channels, 0);
+        if (!graph) {
+            fprintf(stderr, "✗ Error: Failed to create effect graph\n");
+            return 1;
+        }
+        effect_graph_runner_init(&l.own_graphs, graph);
+        l.graphs = &l.own_graphs;
+    }
+    
+    // Before locking memory, so the writer's queue and chunks are locked too
+    if (config->record_file) {
+        l.recorder = wav_writer_open(config->record_file, config->channels, config->sample_rate,
+                                     config->record_config);
+        if (!l.recorder) {
+            fprintf(stderr, "✗ Error: Failed to create '%s'\n", config->record_file);
+            if (l.graphs == &l.own_graphs) {
+                effect_graph_runner_destroy(&l.own_graphs);
+            }
+            return 1;
+        }
+    }
+    if (config->meter) {
+        l.meter = meter_create(config->channels, config->sample_rate, 0);
+        if (!l.meter) {
+            fprintf(stderr, "✗ Error: Failed to start the meter\n");
+            if (l.recorder) {
+                wav_writer_close(l.recorder, NULL);
+            }
+            if (l.graphs == &l.own_graphs) {
+                effect_graph_runner_destroy(&l.own_graphs);
+            }
+            return 1;
+        }
+    }
+    if (config->receive_from) {
+        l.receiver = net_receiver_open(config->receive_from, config->channels,
+                                       config->sample_rate, config->net_config);
+        if (!l.receiver) {
+            fprintf(stderr, "✗ Error: Can't receive on '%s'\n", config->receive_from);
+            if (l.recorder) {
+                wav_writer_close(l.recorder, NULL);
+            }
+            meter_free(l.meter);
+            if (l.graphs == &l.own_graphs) {
+                effect_graph_runner_destroy(&l.own_graphs);
+            }
+            return 1;
+        }
+        printf("  Receiving:  UDP port %u\n", net_receiver_port(l.receiver));
+    }
+    
+    if (config->rt.lock_memory) {
+        l.memory_locked = rt_lock_memory() == 0;
+        if (!l.memory_locked) {
+            fprintf(stderr, "Warning: Could not lock memory (raise the memlock limit)\n");
+        }
+    }
+    
+    size_t period = config->auto_tune ? LIVE_AUTOTUNE_MIN_PERIOD : config->period_frames;
+    unsigned int restarts = 0;
+    
+    uint64_t start = utils_now_ns();
+    uint64_t stop_at = config->duration_s > 0
+        ? start + (uint64_t)(config->duration_s * 1e9) : 0;
+    
+    while (true) {
+        if (live_session_start(&l, period) != 0) {
+            live_session_stop(&l);
+            if (l.recorder) {
+                wav_writer_close(l.recorder, NULL);
+            }
+            meter_free(l.meter);
+            net_receiver_close(l.receiver);
+            if (l.graphs == &l.own_graphs) {
+                effect_graph_runner_destroy(&l.own_graphs);
+            }
+            if (l.memory_locked) {
+                rt_unlock_memory();
+            }
+            return 1;
+        }
+        
+        // Glitches while the devices and rings settle don't count against the period
+        uint64_t session_start = utils_now_ns();
+        uint64_t settle_at = session_start + LIVE_AUTOTUNE_SETTLE_NS;
+        uint64_t next_report = session_start + LIVE_REPORT_INTERVAL_NS;
+        uint64_t glitch_base = 0;
+        bool settled = false;
+        bool back_off = false;
+        
+        while (atomic_load(&l.running) && !atomic_load(&live_stop_requested)) {
+            uint64_t now = utils_now_ns();
+            if (stop_at && now >= stop_at) {
+                break;
+            }
+            if (config->auto_tune && now >= settle_at) {
+                uint64_t glitches = live_glitches(&l);
+                if (!settled) {
+                    glitch_base = glitches;
+                    settled = true;
+                } else if (glitches > glitch_base && period < LIVE_AUTOTUNE_MAX_PERIOD) {
+                    back_off = true;
+                    break;
+                }
+            }
+            if (now >= next_report) {
+                block_timing_summary_t dsp;
+                block_timing_summarize(&l.dsp_timing, &dsp);
+                printf("\r  period %zu | latency %6.2f ms | dsp p99 %5.1f%% max %5.1f%% | "
+                       "dropped %llu frames | underruns %llu   ",
+                       l.capture_period,
+                       frames_to_ms(atomic_load(&l.latency_frames), config->sample_rate),
+                       dsp.p99_ns * 100.0 / dsp.deadline_ns, dsp.max_ns * 100.0 / dsp.deadline_ns,
+                       (unsigned long long)atomic_load(&l.frames_dropped),
+                       (unsigned long long)atomic_load(&l.underruns));
+                if (l.meter) {
+                    meter_reading_t reading;
+                    meter_read(l.meter, &reading);
+                    printf("| M %5.1f S %5.1f LUFS, TP %5.1f dB   ", reading.momentary_lufs,
+                           reading.short_term_lufs, reading.true_peak_db);
+                }
+                if (l.receiver) {
+                    net_receiver_stats_t net;
+                    net_receiver_stats(l.receiver, &net);
+                    printf("| net jitter %4.1f ms, buffer %5.1f ms, lost %llu   ", net.jitter_ms,
+                           net.latency_ms, (unsigned long long)net.packets_lost);
+                }
+                fflush(stdout);
+                next_report += LIVE_REPORT_INTERVAL_NS;
+            }
+            utils_sleep_ns(LIVE_POLL_INTERVAL_NS);
+        }
+        
+        size_t granted = l.capture_period;
+        live_session_stop(&l);
+        
+        if (!back_off || atomic_load(&l.failed)) {
+            l.capture_period = granted;
+            break;
+        }
+        
+        // This box can't sustain the period: double it and go again
+        period = granted * 2;
+        restarts++;
+        live_reset_latency(&l);
+        printf("\n  Glitches at %zu frames/period, backing off to %zu\n", granted, period);
+    }
+    printf("\n");
+    
+    wav_writer_stats_t recorded = { 0 };
+    if (l.recorder && wav_writer_close(l.recorder, &recorded) != 0 && recorded.failed) {
+        fprintf(stderr, "✗ Error: Failed to write '%s'\n", config->record_file);
+    }
+    meter_reading_t loudness = { 0 };
+    if (l.meter) {
+        meter_stop(l.meter);
+        meter_read(l.meter, &loudness);
+        meter_free(l.meter);
+    }
+    net_receiver_stats_t network = { 0 };
+    if (l.receiver) {
+        net_receiver_stats(l.receiver, &network);
+        net_receiver_close(l.receiver);
+    }
+    if (l.graphs == &l.own_graphs) {
+        effect_graph_runner_destroy(&l.own_graphs);
+    }
+    if (l.memory_locked) {
+        rt_unlock_memory();
+    }
+    
+    if (stats) {
+        stats->frames_captured = atomic_load(&l.frames_captured);
+        stats->frames_played = atomic_load(&l.frames_played);
+        stats->frames_dropped = atomic_load(&l.frames_dropped);
+        stats->underruns = atomic_load(&l.underruns);
+        stats->xruns = l.xruns;
+        stats->suspends = l.suspends;
+        stats->period_frames = l.capture_period;
+        stats->restarts = restarts;
+        stats->latency_ms_min = frames_to_ms(l.latency_min, config->sample_rate);
+        stats->latency_ms_max = frames_to_ms(l.latency_max, config->sample_rate);
+        stats->latency_ms_avg = l.latency_count
+            ? l.latency_sum / l.latency_count * 1000.0 / config->sample_rate : 0.0;
+        block_timing_summarize(&l.dsp_timing, &stats->dsp_blocks);
+        stats->captured_high_water = l.captured_high_water;
+        stats->processed_high_water = l.processed_high_water;
+        stats->rt_flags = l.rt_flags;
+        stats->memory_locked = l.memory_locked;
+        stats->capture_rate = l.capture_rate;
+        stats->playback_rate = l.playback_rate;
+        stats->drift_ppm = (l.drift_correction - 1.0) * 1e6;
+        stats->frames_recorded = recorded.frames_written;
+        stats->record_dropped = recorded.frames_dropped;
+        stats->loudness = loudness;
+        stats->packets_sent = 0;
+        stats->packets_unsent = 0;
+        stats->network = network;
+    }
+    
+    return atomic_load(&l.failed) ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "effects.h"
+#include "effect_graph.h"
+#include "param_queue.h"
+#include "rt_thread.h"
+#include "stats.h"
+#include "sample_format.h"
+#include "wav_writer.h"
+#include "meter.h"
+#include "net_audio.h"
+
+/**
+ * Full-duplex live processing through ALSA:
+ *
+ *   capture thread --[ring A]--> DSP thread --[ring B]--> playback thread
+ *
+ * The capture thread never blocks on the ring: if DSP falls behind, the
+ * captured period is dropped and counted rather than letting the capture
+ * device overrun. Ring B is prefilled with silence so the total buffering
+ * matches the requested latency target.
+ *
+ * With use_mmap, capture copies straight from the capture DMA area into
+ * ring A and playback copies ring B straight into the playback DMA area
+ * (padding with silence in place), so no intermediate period buffer or
+ * alsa-lib copy is involved. Devices without mmap fall back to read/write.
+ *
+ * Both devices run in device_format, by default the best one each has
+ * natively (audio_io.h); integer formats are converted to and from float
+ * as periods cross the device boundary. The mmap copy is only direct for
+ * float devices; for the others the conversion reads or writes the DMA
+ * area itself.
+ *
+ * With auto_tune, the run starts at a small period. Whenever a glitch (device
+ * xrun, dropped or padded period) shows up after the devices have settled,
+ * both devices are reopened with twice the period, so each machine ends up
+ * at the lowest latency it can sustain. Latency figures are for the final
+ * period only.
+ *
+ * With params set, the DSP thread applies queued parameter updates before
+ * each block, so another thread can retune the effects while audio runs.
+ * With graphs set, the DSP thread runs whatever graph is published there
+ * (and params retunes its chain node) instead of building one from effects;
+ * the caller publishes, collects and destroys the graphs.
+ *
+ * The effects always run at sample_rate. A device that negotiates another
+ * rate is converted on the DSP thread: capture to sample_rate before the
+ * effects, sample_rate to playback after them. With drift_correction the
+ * playback conversion is always on, and its ratio is trimmed (a few hundred
+ * ppm at most) so the ring fill holds steady: two devices on separate
+ * clocks then run full-duplex without the rings slowly filling or
+ * draining into periodic xruns.
+ *
+ * Effects that delay the audio (the limiter's lookahead) count towards the
+ * latency target: ring B starts out that much emptier, and the measured
+ * latency includes the delay.
+ *
+ * With record_file, the DSP thread also queues every processed block (at
+ * sample_rate, before any playback conversion) to a wav_writer, whose own
+ * thread writes the file. The queue never blocks: if the disk can't keep
+ * up, recorded frames are dropped and counted while playback carries on.
+ *
+ * With meter, the DSP thread taps every processed block into a meter
+ * (meter.h) the same way, and the status line shows its loudness. A meter
+ * that falls behind gets summaries or nothing; the DSP thread never waits.
+ *
+ * With receive_from, the input comes over the network (net_audio.h)
+ * instead of from a capture device: a thread paced by the local clock
+ * reads a period at a time out of the jitter buffer into ring A, and
+ * everything after that runs as above. The jitter buffer counts towards
+ * the measured latency as the capture device's delay would. Its clock
+ * isn't the playback device's, so drift_correction is worth turning on.
+ * With send_to, live_run is the other end: it captures and sends, with
+ * no DSP and no playback, so effects run on the receiving host.
+ *
+ * The capture, DSP and playback threads start through rt_thread_create
+ * with rt: playback on rt.cpu, DSP on the next core, capture on the one
+ * after. Memory is locked for the whole run when rt.lock_memory is set.
+ */
+
+typedef struct {
+    const char *capture_device;
+    const char *playback_device;
+    unsigned int sample_rate;
+    unsigned int channels;
+    size_t period_frames;        // ALSA period size requested from both devices
+    unsigned int period_count;   // Periods per device buffer
+    bool auto_tune;              // Start at a small period, double it on glitches
+    float latency_ms;            // Target input-to-output latency
+    float duration_s;            // Stop after this long; 0 = until live_request_stop()
+    bool use_mmap;               // Move periods straight through the DMA areas
+    int device_format;           // A sample_format_t, or SAMPLE_FORMAT_AUTO
+    bool drift_correction;       // Resample playback to track the capture clock
+    const char *record_file;     // Also write the processed audio here (may be NULL)
+    const wav_writer_config_t *record_config;  // Writer options; NULL for the defaults
+    bool meter;                  // Measure the processed audio's level and loudness
+    const char *receive_from;    // Take the input from the network at "[host:]port" (may be NULL)
+    const char *send_to;         // Only capture, and send it to "host:port" (may be NULL)
+    const net_audio_config_t *net_config;  // Packets and jitter buffer; NULL for the defaults
+    effect_chain_config_t effects;
+    param_queue_t *params;       // Optional updates for the running chain (may be NULL)
+    effect_graph_runner_t *graphs;  // Optional graphs to run instead of effects (may be NULL)
+    rt_config_t rt;              // Priority, pinning and memory locking for the three threads
+} live_config_t;
+
+typedef struct {
+    uint64_t frames_captured;
+    uint64_t frames_played;
+    uint64_t frames_dropped;     // Captured periods discarded because ring A was full
+    uint64_t underruns;          // Playback periods of silence (ring B short of a period)
+    uint64_t xruns;              // Device overruns/underruns (both devices)
+    uint64_t suspends;           // Device suspend/resume cycles (both devices)
+    size_t period_frames;        // Final negotiated capture period
+    unsigned int restarts;       // Auto-tune back-offs
+    
+    // Measured input-to-output latency: capture delay + ring fill + playback
+    // delay + effect delay
+    double latency_ms_min;
+    double latency_ms_avg;
+    double latency_ms_max;
+    
+    // Final session only: DSP time per block against one capture period,
+    // and peak ring fills in frames
+    block_timing_summary_t dsp_blocks;
+    size_t captured_high_water;
+    size_t processed_high_water;
+    unsigned int rt_flags;       // RT_THREAD_* flags every thread got
+    bool memory_locked;
+    
+    // Final session only: negotiated device rates and the playback trim
+    // drift correction settled on (parts per million, + = playback slow)
+    unsigned int capture_rate;
+    unsigned int playback_rate;
+    double drift_ppm;
+    
+    // Recording, over all sessions
+    uint64_t frames_recorded;
+    uint64_t record_dropped;     // Frames the writer's queue had no room for
+    
+    // Metering, over all sessions (with meter)
+    meter_reading_t loudness;
+    
+    // Network, over the whole run: what the sender got out (with send_to),
+    // and what arrived and how late (with receive_from)
+    uint64_t packets_sent;
+    uint64_t packets_unsent;     // Refused by the socket
+    net_receiver_stats_t network;
+} live_stats_t;
+
+/**
+ * Open both devices (or one and the network) and run until the duration
+ * elapses or a stop is requested.
+ * Prints a latency and DSP timing line about once per second. Fills stats (may be NULL).
+ * Returns 0 on success, non-zero on error.
+ */
+int live_run(const live_config_t *config, live_stats_t *stats);
+
+/**
+ * Ask a running live_run() to stop. Async-signal-safe.
+ */
+void live_request_stop(void);
+
+#endif // LIVE_H
@@ -3,205 +3,391 @@
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
-#include "ring_buffer.h"
+#include <math.h>
+#include <signal.h>
+#include <pthread.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "frame_ring.h"
 #include "effects.h"
+#include "effect_graph.h"
+#include "convolver.h"
+#include "limiter.h"
+#include "pipeline.h"
+#include "live.h"
+#include "rt_thread.h"
+#include "param_queue.h"
+#include "stats.h"
+#include "utils.h"
+#include "wav_io.h"
+#include "wav_writer.h"
+#include "resampler.h"
+#include "batch.h"
+#include "split.h"
+#include "stream.h"
 
 #define DR_WAV_IMPLEMENTATION
 #include "dr_wav.h"
 
-#define RING_BUFFER_SIZE 8192
+#define RING_BUFFER_FRAMES 4096
 #define PROCESS_CHUNK_SIZE 256
+#define CONTROL_QUEUE_SIZE 64
+#define CONTROL_POLL_MS 100     // How soon the control thread notices a stop
+#define CONTROL_SWAP_POLL_NS 1000000  // How often it looks for a swapped-out graph
 
 void print_usage(const char *prog_name) {
+    net_audio_config_t net_defaults;
+    net_audio_config_init(&net_defaults);
+    
     printf("Usage: %s [input.wav] [output.wav] [OPTIONS]\n", prog_name);
     printf("\nOptions:\n");
     printf("  --gain <dB>          Apply gain in decibels (default: 0.0)\n");
     printf("  --lowpass <Hz>       Apply low-pass filter at frequency (default: off)\n");
     printf("  --highpass <Hz>      Apply high-pass filter at frequency (default: off)\n");
+    printf("  --order <n>          Butterworth filter order: 2, 4, 6 or 8 (default: 2)\n");
     printf("  --compress           Enable compressor (default: off)\n");
+    printf("  --ir <file.wav>      Convolve with an impulse response (reverb, cabinet);\n");
+    printf("                       mono, or one channel per input channel\n");
+    printf("  --ir-mix <0-1>       Wet level of the convolution (default: 1.0)\n");
+    printf("  --limit <dBFS>       Lookahead brickwall limiter at this ceiling, last\n");
+    printf("  --lookahead <ms>     How far ahead the limiter looks; also its delay,\n");
+    printf("                       compensated in every mode (default: %.0f)\n",
+           LIMITER_LOOKAHEAD_MS);
     printf("  --no-effects         Bypass all effects (passthrough)\n");
+    printf("  --stream             Stream the file in chunks (constant memory)\n");
+    printf("  --pipeline           Stream on three threads (decode -> DSP -> encode)\n");
+    printf("  --rate <Hz>          Convert the file to this rate (default: keep its own)\n");
+    printf("  --no-mmap            Decode float input with dr_wav instead of mapping it\n");
+    printf("\nBatch mode (many files, one process):\n");
+    printf("  --batch <dir|list>   Render every *.wav in dir, or each path listed in a file\n");
+    printf("  --out-dir <dir>      Where the outputs go, under their input's name\n");
+    printf("  --workers <n>        Worker threads, also for --split (default: one per core)\n");
+    printf("\nSplit mode (one long file, one segment per core):\n");
+    printf("  --split              Render segments of the file in parallel, each after a\n");
+    printf("                       warm-up run over the audio before it\n");
+    printf("  --preroll <ms>       Warm-up per segment (default: enough for --split-error)\n");
+    printf("  --split-error <dB>   Bound on what the warm-up leaves, below full scale\n");
+    printf("                       (default: %.0f); gain-only chains are always exact\n",
+           SPLIT_ERROR_DB);
+    printf("\nWriting files (--stream and --record):\n");
+    printf("  --direct-io          Write with O_DIRECT, past the page cache\n");
+    printf("  --io-uring           Submit the writes through io_uring (falls back to pwrite)\n");
+    printf("  --fsync              Flush to disk every few MB, not just at the end\n");
+    printf("\nRealtime threads (pipeline and live):\n");
+    printf("  --rt-priority <n>    Run the audio threads SCHED_FIFO at priority 1-99\n");
+    printf("                       (needs CAP_SYS_NICE or an rtprio limit; default: off)\n");
+    printf("  --cpu <n>            Pin the audio threads to consecutive cores from n\n");
+    printf("  --mlock              Lock all memory in RAM while running\n");
+    printf("\nLive mode (ALSA capture -> DSP -> playback):\n");
+    printf("  --live               Process the capture device into the playback device\n");
+    printf("  --capture <dev>      ALSA capture device (default: default)\n");
+    printf("  --playback <dev>     ALSA playback device (default: default)\n");
+    printf("  --rate <Hz>          DSP sample rate; devices that run at another rate\n");
+    printf("                       are resampled (default: 48000)\n");
+    printf("  --channels <n>       Channels, 1-%d (default: 1)\n", EFFECT_MAX_CHANNELS);
+    printf("  --period <frames>    ALSA period size (default: 128)\n");
+    printf("  --periods <n>        Periods per device buffer (default: 4)\n");
+    printf("  --auto-latency       Start at 32 frames/period, back off only on xruns\n");
+    printf("  --latency <ms>       Target input-to-output latency (default: 10)\n");
+    printf("  --duration <s>       Stop after this many seconds (default: until Ctrl-C)\n");
+    printf("  --mmap               Use ALSA mmap access (falls back to read/write)\n");
+    printf("  --format <fmt>       Device sample format: float | s32 | s24 | s16\n");
+    printf("                       (default: the best each device has natively)\n");
+    printf("  --drift-correct      Lock the playback clock to the capture clock by\n");
+    printf("                       resampling (separate sound cards)\n");
+    printf("  --record <file.wav>  Also write the processed audio to a file; a slow disk\n");
+    printf("                       drops recorded frames, never live ones\n");
+    printf("  --meter              Show peak, true-peak and EBU R128 loudness, measured\n");
+    printf("                       off the audio thread\n");
+    printf("  --send <host:port>   Only capture, and send it over UDP to a --receive host\n");
+    printf("  --receive <[host:]port>\n");
+    printf("                       Take the input from a --send host instead of a capture\n");
+    printf("                       device; add --drift-correct\n");
+    printf("  --net-delay <ms>     Least jitter buffering for --receive (default: %.0f;\n",
+           net_defaults.min_delay_ms);
+    printf("                       grows with the network's jitter up to %.0f)\n",
+           net_defaults.max_delay_ms);
+    printf("  --control            Read effect changes from stdin while running:\n");
+    printf("                       gain <dB> | lowpass <Hz> [order] | highpass <Hz> [order]\n");
+    printf("                       | filter off | compress on|off | limit <dB>|off\n");
+    printf("                       (the live delay always makes room for the limiter)\n");
     printf("\nExamples:\n");
     printf("  %s input.wav output/result.wav --gain 6.0\n", prog_name);
     printf("  %s test_audio/input.wav output/filtered.wav --lowpass 3000 --gain 3.0\n", prog_name);
     printf("  %s test_audio/input.wav output/compressed.wav --compress --lowpass 5000\n", prog_name);
+    printf("  %s broadcast.wav output/broadcast.wav --stream --compress\n", prog_name);
+    printf("  %s broadcast.wav output/broadcast.wav --pipeline --lowpass 8000\n", prog_name);
+    printf("  %s dry.wav output/hall.wav --ir hall.wav --ir-mix 0.3\n", prog_name);
+    printf("  %s cd_track.wav output/track_48k.wav --rate 48000\n", prog_name);
+    printf("  %s master.wav output/master.wav --gain 6 --limit -1\n", prog_name);
+    printf("  %s audiobook.wav output/audiobook.wav --split --highpass 80 --compress\n",
+           prog_name);
+    printf("  %s --batch stems/ --out-dir output/stems --highpass 40 --limit -1\n", prog_name);
+    printf("  %s --live --period 64 --latency 5 --highpass 80\n", prog_name);
+    printf("  %s --live --channels 2 --record output/take1.wav --io-uring\n", prog_name);
+    printf("  %s --send dsp-server:%d --channels 2\n", prog_name, NET_AUDIO_PORT);
+    printf("  %s --receive %d --channels 2 --drift-correct --compress\n", prog_name,
+           NET_AUDIO_PORT);
     printf("\n");
 }
 
-int main(int argc, char *argv[]) {
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void print_audio_info(drwav_uint64 total_frames, unsigned int sample_rate,
+                             unsigned int channels) {
+    printf("Audio Info:\n");
+    printf("  Frames:      %llu\n", (unsigned long long)total_frames);
+    printf("  Sample Rate: %u Hz\n", sample_rate);
+    printf("  Channels:    %u\n", channels);
+    printf("  Duration:    %.2f seconds\n", (float)total_frames / sample_rate);
     printf("\n");
-    printf("╔═══════════════════════════════════════════════════════╗\n");
-    printf("║      REAL-TIME AUDIO PROCESSOR v1.0                  ║\n");
-    printf("║      Lock-Free Ring Buffer + DSP Effects             ║\n");
-    printf("╚═══════════════════════════════════════════════════════╝\n");
+}
+
+/**
+ * Announce a mapped input; quiet when dr_wav decodes it.
+ */
+static void print_input(bool mapped) {
+    if (mapped) {
+        printf("Reading float samples straight from the mapped file\n\n");
+    }
+}
+
+/**
+ * Announce a --rate conversion; quiet at the file's own rate.
+ */
+static void print_conversion(unsigned int from, unsigned int to, drwav_uint64 frames) {
+    if (from != to) {
+        printf("Converting %u Hz -> %u Hz (%llu frames, polyphase resampler)\n\n",
+               from, to, (unsigned long long)frames);
+    }
+}
+
+static void print_effects(const effect_chain_config_t *config) {
+    printf("Effects Chain:\n");
+    if (!config->enabled) {
+        printf("  [BYPASS] All effects disabled\n");
+        printf("\n");
+        return;
+    }
+    
+    bool any = false;
+    if (config->gain_db != 0.0f) {
+        printf("  ✓ Gain:       %+.1f dB\n", config->gain_db);
+        any = true;
+    }
+    unsigned int order = config->filter_order ? config->filter_order : 2;
+    if (config->lowpass_freq > 0) {
+        printf("  ✓ Low-pass:   %.0f Hz, order %u\n", config->lowpass_freq, order);
+        any = true;
+    }
+    if (config->highpass_freq > 0) {
+        printf("  ✓ High-pass:  %.0f Hz, order %u\n", config->highpass_freq, order);
+        any = true;
+    }
+    if (config->compress) {
+        printf("  ✓ Compressor: 4:1 ratio, -20dB threshold\n");
+        any = true;
+    }
+    if (config->ir) {
+        printf("  ✓ Convolver:  %zu frame IR, %u channel(s), %.0f%% wet\n",
+               config->ir->frames, config->ir->channels, config->ir_mix * 100.0f);
+        any = true;
+    }
+    if (config->limit) {
+        printf("  ✓ Limiter:    %.1f dBFS ceiling, %.1f ms lookahead\n",
+               config->limit_ceiling_db, config->limit_lookahead_ms);
+        any = true;
+    }
+    if (!any) {
+        printf("  (No effects configured - passthrough mode)\n");
+    }
     printf("\n");
+}
+
+static void print_progress(drwav_uint64 processed, drwav_uint64 total, int *last_percent) {
+    if (total == 0) {
+        return;
+    }
     
-    // Default file paths
-    const char *input_file = "test_audio/input.wav";
-    const char *output_file = "output/processed.wav";
+    int percent = (int)((float)processed / total * 100.0f);
+    if (percent == *last_percent) {
+        return;
+    }
     
-    // Effect parameters
-    float gain_db = 0.0f;
-    float lowpass_freq = 0.0f;
-    float highpass_freq = 0.0f;
-    bool compress_enabled = false;
-    bool effects_enabled = true;
-    
-    // Parse command-line arguments
-    // First, collect non-flag arguments (not starting with '-') before any option
-    int file_count = 0;
-    int options_start = 1;
-    for (int i = 1; i < argc; i++) {
-        if (argv[i][0] == '-') {
-            options_start = i;
-            break;
-        }
-        if (file_count == 0) {
-            input_file = argv[i];
-            file_count++;
-        } else if (file_count == 1) {
-            output_file = argv[i];
-            file_count++;
-        }
+    int bar_width = 50;
+    int filled = (percent * bar_width) / 100;
+    printf("\r  [");
+    for (int i = 0; i < bar_width; i++) {
+        if (i < filled) printf("█");
+        else printf("░");
     }
-    // Now parse options
-    for (int i = options_start; i < argc; i++) {
-        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            print_usage(argv[0]);
-            return 0;
-        }
-        else if (strcmp(argv[i], "--gain") == 0 && i + 1 < argc) {
-            gain_db = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--lowpass") == 0 && i + 1 < argc) {
-            lowpass_freq = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--highpass") == 0 && i + 1 < argc) {
-            highpass_freq = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--compress") == 0) {
-            compress_enabled = true;
-        }
-        else if (strcmp(argv[i], "--no-effects") == 0) {
-            effects_enabled = false;
-        }
+    printf("] %3d%%", percent);
+    fflush(stdout);
+    *last_percent = percent;
+}
+
+static void print_performance(drwav_uint64 processed, unsigned int sample_rate,
+                              double elapsed) {
+    printf("\nPerformance:\n");
+    printf("  Processed:   %llu frames\n", (unsigned long long)processed);
+    printf("  Time:        %.3f seconds\n", elapsed);
+    printf("  Speed:       %.2fx realtime\n", (processed / (double)sample_rate) / elapsed);
+    printf("  Latency:     %.2f ms (ring buffer size)\n",
+           (RING_BUFFER_FRAMES / (float)sample_rate) * 1000.0f);
+    printf("\n");
+}
+
+/**
+ * Tail latency of effect_chain_process per block, against the time the
+ * block represents (the budget it would have in a real-time callback).
+ */
+static uint64_t chunk_deadline_ns(unsigned int sample_rate) {
+    return (uint64_t)PROCESS_CHUNK_SIZE * 1000000000ull / sample_rate;
+}
+
+static void print_block_timing(const block_timing_summary_t *timing) {
+    printf("DSP blocks:\n");
+    printf("  p50 / p99:   %.2f / %.2f us\n", timing->p50_ns / 1e3, timing->p99_ns / 1e3);
+    printf("  Max:         %.2f us (deadline %.2f us)\n",
+           timing->max_ns / 1e3, timing->deadline_ns / 1e3);
+    printf("  Late:        %llu of %llu blocks\n",
+           (unsigned long long)timing->over_deadline, (unsigned long long)timing->count);
+    printf("\n");
+}
+
+static bool check_channels(unsigned int channels, const effect_chain_config_t *config) {
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS) {
+        fprintf(stderr, "✗ Error: %u channels not supported (1-%d)\n",
+                channels, EFFECT_MAX_CHANNELS);
+        return false;
     }
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            print_usage(argv[0]);
-            return 0;
-        }
-        else if (strcmp(argv[i], "--gain") == 0 && i + 1 < argc) {
-            gain_db = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--lowpass") == 0 && i + 1 < argc) {
-            lowpass_freq = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--highpass") == 0 && i + 1 < argc) {
-            highpass_freq = atof(argv[++i]);
-        }
-        else if (strcmp(argv[i], "--compress") == 0) {
-            compress_enabled = true;
-        }
-        else if (strcmp(argv[i], "--no-effects") == 0) {
-            effects_enabled = false;
-        }
-        else if (argv[i][0] != '-') {
-            // Non-flag argument - must be input or output file
-            static int file_count = 0;
-            if (file_count == 0) {
-                input_file = argv[i];
-                file_count++;
-            } else if (file_count == 1) {
-                output_file = argv[i];
-                file_count++;
-            }
-        }
+    if (config->ir && config->ir->channels != 1 && config->ir->channels != channels) {
+        fprintf(stderr, "✗ Error: A %u-channel IR doesn't fit %u-channel audio\n",
+                config->ir->channels, channels);
+        return false;
     }
+    return true;
+}
+
+static bool open_output(drwav *wav, const char *output_file,
+                        unsigned int channels, unsigned int sample_rate) {
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = channels;
+    format.sampleRate = sample_rate;
+    format.bitsPerSample = 32;
     
-    printf("Configuration:\n");
-    printf("  Input:  %s\n", input_file);
-    printf("  Output: %s\n", output_file);
-    printf("\n");
+    if (!drwav_init_file_write(wav, output_file, &format, NULL)) {
+        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", output_file);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Convert a whole decoded file to another rate in one go. Returns a malloc'd
+ * buffer of out_frames frames, or NULL.
+ */
+static float* convert_rate(const float *in, drwav_uint64 in_frames, unsigned int channels,
+                           unsigned int from, unsigned int to, drwav_uint64 out_frames) {
+    resampler_t *rs = resampler_create(channels, from, to);
+    float *out = malloc((out_frames ? out_frames : 1) * channels * sizeof(float));
+    if (!rs || !out) {
+        resampler_free(rs);
+        free(out);
+        return NULL;
+    }
     
+    size_t produced = resampler_process(rs, in, in_frames, NULL, out, out_frames);
+    resampler_drain(rs, &out[produced * channels], out_frames - produced);
+    resampler_free(rs);
+    return out;
+}
+
+/**
+ * Whole-file mode: decode everything up front, process, then write.
+ */
+static int process_buffered(const char *input_file, const char *output_file,
+                            const effect_chain_config_t *config, unsigned int rate) {
     // Load input WAV file
     unsigned int channels;
     unsigned int sample_rate;
     drwav_uint64 total_frames;
     
-    float *input_data = drwav_open_file_and_read_pcm_frames_f32(
+    float *decoded = drwav_open_file_and_read_pcm_frames_f32(
         input_file, &channels, &sample_rate, &total_frames, NULL
     );
+    float *input_data = decoded;
+    float *converted = NULL;
     
-    if (!input_data) {
+    if (!decoded) {
         fprintf(stderr, "✗ Error: Failed to open input file '%s'\n", input_file);
         return 1;
     }
     
-    printf("Audio Info:\n");
-    printf("  Frames:      %llu\n", (unsigned long long)total_frames);
-    printf("  Sample Rate: %u Hz\n", sample_rate);
-    printf("  Channels:    %u\n", channels);
-    printf("  Duration:    %.2f seconds\n", (float)total_frames / sample_rate);
-    printf("\n");
+    print_audio_info(total_frames, sample_rate, channels);
     
-    if (channels != 1) {
-        fprintf(stderr, "✗ Error: Only mono (1 channel) audio supported\n");
-        drwav_free(input_data, NULL);
+    if (!check_channels(channels, config)) {
+        drwav_free(decoded, NULL);
         return 1;
     }
     
+    if (rate && rate != sample_rate) {
+        drwav_uint64 frames = resampler_output_frames(total_frames, sample_rate, rate);
+        converted = convert_rate(decoded, total_frames, channels, sample_rate, rate, frames);
+        drwav_free(decoded, NULL);
+        decoded = NULL;
+        if (!converted) {
+            fprintf(stderr, "✗ Error: Can't convert %u Hz to %u Hz\n", sample_rate, rate);
+            return 1;
+        }
+        print_conversion(sample_rate, rate, frames);
+        input_data = converted;
+        total_frames = frames;
+        sample_rate = rate;
+    }
+    
     // Create ring buffer
-    ring_buffer_t *rb = ring_buffer_create(RING_BUFFER_SIZE);
+    frame_ring_t *rb = frame_ring_f32_create(RING_BUFFER_FRAMES, channels, NULL);
     if (!rb) {
         fprintf(stderr, "✗ Error: Failed to create ring buffer\n");
-        drwav_free(input_data, NULL);
+        free(converted);
+        drwav_free(decoded, NULL);
+        return 1;
+    }
+    
+    // Create effect graph
+    effect_graph_t *effects = effect_graph_from_config(config, sample_rate, channels, 0);
+    if (!effects) {
+        fprintf(stderr, "✗ Error: Failed to create effect graph\n");
+        frame_ring_free(rb);
+        free(converted);
+        drwav_free(decoded, NULL);
         return 1;
     }
+    print_effects(config);
     
-    // Allocate output buffer
-    float *output_data = malloc(total_frames * sizeof(float));
+    // Allocate output buffer, with room for what the graph's latency holds
+    // back past the end of the input
+    size_t delay = effect_graph_latency(effects);
+    float *output_data = malloc((total_frames + delay) * channels * sizeof(float));
     if (!output_data) {
         fprintf(stderr, "✗ Error: Failed to allocate output buffer\n");
-        ring_buffer_free(rb);
-        drwav_free(input_data, NULL);
+        effect_graph_free(effects);
+        frame_ring_free(rb);
+        free(converted);
+        drwav_free(decoded, NULL);
         return 1;
     }
     
-    // Create effect chain
-    effect_chain_t effects;
-    effect_chain_init(&effects, sample_rate);
-    
-    printf("Effects Chain:\n");
-    if (!effects_enabled) {
-        printf("  [BYPASS] All effects disabled\n");
-    } else {
-        if (gain_db != 0.0f) {
-            effects.gain_enabled = true;
-            gain_init(&effects.gain, gain_db);
-            printf("  ✓ Gain:       %+.1f dB\n", gain_db);
-        }
-        
-        if (lowpass_freq > 0) {
-            effects.filter_enabled = true;
-            biquad_lowpass_init(&effects.filter, sample_rate, lowpass_freq, 0.707f);
-            printf("  ✓ Low-pass:   %.0f Hz\n", lowpass_freq);
-        }
-        else if (highpass_freq > 0) {
-            effects.filter_enabled = true;
-            biquad_highpass_init(&effects.filter, sample_rate, highpass_freq, 0.707f);
-            printf("  ✓ High-pass:  %.0f Hz\n", highpass_freq);
-        }
-        
-        if (compress_enabled) {
-            effects.compressor_enabled = true;
-            printf("  ✓ Compressor: 4:1 ratio, -20dB threshold\n");
-        }
-        
-        if (!effects.gain_enabled && !effects.filter_enabled && !effects.compressor_enabled) {
-            printf("  (No effects configured - passthrough mode)\n");
-        }
-    }
-    printf("\n");
+    block_timing_t timing;
+    block_timing_init(&timing, chunk_deadline_ns(sample_rate));
+    block_timing_summary_t summary;
     
     printf("Processing...\n");
     
@@ -209,24 +395,14 @@ int main(int argc, char *argv[]) {
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
     
-    // Process audio through ring buffer
+    // Process audio through ring buffer. Positions are in frames
     size_t input_pos = 0;
     size_t output_pos = 0;
-    size_t total_processed = 0;
-    
-    float *process_buffer = malloc(PROCESS_CHUNK_SIZE * sizeof(float));
-    if (!process_buffer) {
-        fprintf(stderr, "✗ Error: Failed to allocate process buffer\n");
-        free(output_data);
-        ring_buffer_free(rb);
-        drwav_free(input_data, NULL);
-        return 1;
-    }
     
     // Prefill ring buffer
     size_t prefill = PROCESS_CHUNK_SIZE * 2;
     if (prefill > total_frames) prefill = total_frames;
-    ring_buffer_write(rb, input_data, prefill);
+    frame_ring_f32_write(rb, input_data, prefill);
     input_pos = prefill;
     
     int last_percent = -1;
@@ -235,53 +411,36 @@ int main(int argc, char *argv[]) {
         size_t to_write = 0;
         size_t to_read = 0;
         
-        // Write more input if available and buffer has space
+        // Write more input if available; short writes when the ring is
+        // full are fine, the rest goes next lap
         if (input_pos < total_frames) {
-            size_t available_space = ring_buffer_write_available(rb);
             to_write = PROCESS_CHUNK_SIZE;
-            
-            if (to_write > available_space) to_write = available_space;
             if (to_write > total_frames - input_pos) to_write = total_frames - input_pos;
-            
-            if (to_write > 0) {
-                ring_buffer_write(rb, &input_data[input_pos], to_write);
-                input_pos += to_write;
-            }
+            to_write = frame_ring_f32_write(rb, &input_data[input_pos * channels], to_write);
+            input_pos += to_write;
         }
         
-        // Read and process output
-        size_t available_data = ring_buffer_read_available(rb);
+        // Read and process output in place, straight out of the ring
         to_read = PROCESS_CHUNK_SIZE;
-        
-        if (to_read > available_data) to_read = available_data;
         if (to_read > total_frames - output_pos) to_read = total_frames - output_pos;
         
+        frame_ring_span_t span;
+        to_read = frame_ring_read_acquire(rb, to_read, &span);
+        
         if (to_read > 0) {
-            ring_buffer_read(rb, process_buffer, to_read);
+            uint64_t t0 = utils_now_ns();
+            effect_graph_process_split(effects, &span);
+            block_timing_record(&timing, utils_now_ns() - t0);
             
-            // Apply effects if enabled
-            if (effects_enabled) {
-                effect_chain_process(&effects, process_buffer, to_read);
+            memcpy(&output_data[output_pos * channels], span.data1, span.frames1 * rb->stride);
+            if (span.frames2 > 0) {
+                memcpy(&output_data[(output_pos + span.frames1) * channels], span.data2,
+                       span.frames2 * rb->stride);
             }
-            
-            memcpy(&output_data[output_pos], process_buffer, to_read * sizeof(float));
+            frame_ring_read_release(rb, to_read);
             output_pos += to_read;
-            total_processed += to_read;
             
-            // Progress bar
-            int percent = (int)((float)total_processed / total_frames * 100.0f);
-            if (percent != last_percent) {
-                int bar_width = 50;
-                int filled = (percent * bar_width) / 100;
-                printf("\r  [");
-                for (int i = 0; i < bar_width; i++) {
-                    if (i < filled) printf("█");
-                    else printf("░");
-                }
-                printf("] %3d%%", percent);
-                fflush(stdout);
-                last_percent = percent;
-            }
+            print_progress(output_pos, total_frames, &last_percent);
         }
         
         // Safety: break if nothing is happening
@@ -290,50 +449,956 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    printf("\n");
+    // Flush the graph with silence; the output starts delay frames in
+    if (delay > 0) {
+        memset(&output_data[total_frames * channels], 0, delay * channels * sizeof(float));
+        effect_graph_process(effects, &output_data[total_frames * channels], delay);
+    }
     
-    free(process_buffer);
+    printf("\n");
     
     // End timing
     clock_gettime(CLOCK_MONOTONIC, &end);
-    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    
-    printf("\nPerformance:\n");
-    printf("  Processed:   %zu frames\n", total_processed);
-    printf("  Time:        %.3f seconds\n", elapsed);
-    printf("  Speed:       %.2fx realtime\n", (total_frames / (double)sample_rate) / elapsed);
-    printf("  Latency:     %.2f ms (ring buffer size)\n", 
-           (RING_BUFFER_SIZE / (float)sample_rate) * 1000.0f);
-    printf("\n");
+    print_performance(output_pos, sample_rate, elapsed_seconds(&start, &end));
+    block_timing_summarize(&timing, &summary);
+    print_block_timing(&summary);
     
     // Write output WAV file
     printf("Writing output...\n");
     drwav wav;
-    drwav_data_format format;
-    format.container = drwav_container_riff;
-    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
-    format.channels = channels;
-    format.sampleRate = sample_rate;
-    format.bitsPerSample = 32;
-    
-    if (!drwav_init_file_write(&wav, output_file, &format, NULL)) {
-        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", output_file);
+    if (!open_output(&wav, output_file, channels, sample_rate)) {
+        effect_graph_free(effects);
         free(output_data);
-        ring_buffer_free(rb);
-        drwav_free(input_data, NULL);
+        frame_ring_free(rb);
+        free(converted);
+        drwav_free(decoded, NULL);
         return 1;
     }
     
-    drwav_uint64 frames_written = drwav_write_pcm_frames(&wav, total_frames, output_data);
+    drwav_uint64 frames_written = drwav_write_pcm_frames(&wav, total_frames,
+                                                         &output_data[delay * channels]);
     drwav_uninit(&wav);
     
     printf("  Wrote %llu frames to '%s'\n", (unsigned long long)frames_written, output_file);
     
     // Cleanup
+    effect_graph_free(effects);
     free(output_data);
-    ring_buffer_free(rb);
-    drwav_free(input_data, NULL);
+    frame_ring_free(rb);
+    free(converted);
+    drwav_free(decoded, NULL);
+    return 0;
+}
+
+static void print_writer(const wav_writer_stats_t *stats) {
+    printf("  Writer:      %s, %s; queue peak %zu frames\n",
+           stats->direct ? "O_DIRECT" : "page cache", stats->io_uring ? "io_uring" : "pwrite",
+           stats->queue_high_water);
+}
+
+static void print_stream_progress(uint64_t processed, uint64_t total, void *ctx) {
+    print_progress(processed, total, (int*)ctx);
+}
+
+/**
+ * Streaming mode: decode, process and encode chunk by chunk through one
+ * ring (see stream.h), with a progress bar.
+ */
+static int process_streaming(const char *input_file, const char *output_file,
+                             const effect_chain_config_t *config, unsigned int rate,
+                             bool map_input, const wav_writer_config_t *writer_config) {
+    int last_percent = -1;
+    stream_config_t stream = {
+        .input_file = input_file,
+        .output_file = output_file,
+        .sample_rate = rate,
+        .map_input = map_input,
+        .effects = *config,
+        .ring_frames = RING_BUFFER_FRAMES,
+        .chunk_frames = PROCESS_CHUNK_SIZE,
+        .writer = *writer_config,
+        .progress = print_stream_progress,
+        .progress_ctx = &last_percent,
+    };
+    stream_stats_t stats;
+    
+    print_effects(config);
+    printf("Processing (streaming)...\n");
+    
+    int result = stream_run(&stream, &stats);
+    printf("\n");
+    if (result != 0) {
+        return result;
+    }
+    
+    print_audio_info(stats.total_frames, stats.sample_rate, stats.channels);
+    print_input(stats.input_mapped);
+    print_conversion(stats.input_rate, stats.sample_rate, stats.total_frames);
+    print_performance(stats.frames_processed, stats.sample_rate,
+                      stats.wall_seconds);
+    print_block_timing(&stats.dsp_blocks);
+    print_writer(&stats.writer);
+    printf("  Wrote %llu frames to '%s'\n", (unsigned long long)stats.writer.frames_written,
+           output_file);
+    return 0;
+}
+
+static void print_stage_stats(const char *name, const pipeline_stage_stats_t *stage,
+                              const pipeline_stats_t *stats) {
+    double audio_seconds = stage->frames / (double)stats->sample_rate;
+    double capacity = stage->busy_seconds > 0 ? audio_seconds / stage->busy_seconds : 0.0;
+    double utilization = stats->wall_seconds > 0 ? stage->busy_seconds / stats->wall_seconds : 0.0;
+    
+    printf("  %-8s %9.2fx realtime  busy %6.3f s (%5.1f%%)  stalled %6.3f s\n",
+           name, capacity, stage->busy_seconds, utilization * 100.0, stage->wait_seconds);
+}
+
+/**
+ * What the realtime setup achieved, next to what was asked for.
+ */
+static void print_realtime(const rt_config_t *rt, unsigned int flags, bool memory_locked) {
+    printf("  Realtime:    ");
+    if (rt->priority > 0 && (flags & RT_THREAD_REALTIME)) {
+        printf("SCHED_FIFO %d", rt->priority);
+    } else if (rt->priority > 0) {
+        printf("normal scheduling (SCHED_FIFO %d refused)", rt->priority);
+    } else {
+        printf("normal scheduling");
+    }
+    if (rt->cpu >= 0) {
+        printf((flags & RT_THREAD_PINNED) ? ", pinned from core %d" : ", pinning to core %d failed",
+               rt->cpu);
+    }
+    if (flags & RT_THREAD_NO_DENORMALS) {
+        printf(", FTZ/DAZ");
+    }
+    if (rt->lock_memory) {
+        printf(memory_locked ? ", memory locked" : ", memory not locked");
+    }
+    printf("\n");
+}
+
+/**
+ * Pipeline mode: decode, DSP and encode on their own threads.
+ */
+static int process_pipeline(const char *input_file, const char *output_file,
+                            const effect_chain_config_t *config, const rt_config_t *rt,
+                            unsigned int rate, bool map_input) {
+    pipeline_config_t pipeline = {
+        .input_file = input_file,
+        .output_file = output_file,
+        .sample_rate = rate,
+        .map_input = map_input,
+        .effects = *config,
+        .ring_frames = RING_BUFFER_FRAMES,
+        .chunk_frames = PROCESS_CHUNK_SIZE,
+        .rt = *rt,
+    };
+    pipeline_stats_t stats;
+    
+    print_effects(config);
+    printf("Processing (pipeline: decode -> DSP -> encode)...\n");
+    
+    int result = pipeline_run(&pipeline, &stats);
+    if (result != 0) {
+        return result;
+    }
+    
+    print_audio_info(stats.total_frames, stats.sample_rate, stats.channels);
+    print_input(stats.input_mapped);
+    print_conversion(stats.input_rate, stats.sample_rate, stats.total_frames);
+    print_performance(stats.encode.frames, stats.sample_rate, stats.wall_seconds);
+    
+    // Per-stage capacity: how fast each stage would run on its own
+    printf("Stages:\n");
+    print_stage_stats("decode", &stats.decode, &stats);
+    print_stage_stats("dsp", &stats.dsp, &stats);
+    print_stage_stats("encode", &stats.encode, &stats);
+    printf("  Ring peaks: %zu / %zu frames (decoded / processed, of %d)\n",
+           stats.decoded_high_water, stats.processed_high_water, RING_BUFFER_FRAMES);
+    print_realtime(&pipeline.rt, stats.rt_flags, stats.memory_locked);
+    printf("\n");
+    print_block_timing(&stats.dsp_blocks);
+    
+    printf("  Wrote %llu frames to '%s'\n", (unsigned long long)stats.encode.frames, output_file);
+    return 0;
+}
+
+/**
+ * Batch mode: every file in a directory or list across a worker pool.
+ */
+static int process_batch(const char *source, const char *output_dir,
+                         const effect_chain_config_t *config, unsigned int rate,
+                         unsigned int workers, bool map_input) {
+    char **inputs;
+    size_t count;
+    if (batch_collect(source, &inputs, &count) != 0) {
+        fprintf(stderr, "✗ Error: Failed to read '%s'\n", source);
+        return 1;
+    }
+    if (count == 0) {
+        fprintf(stderr, "✗ Error: No WAV files in '%s'\n", source);
+        batch_free_paths(inputs, count);
+        return 1;
+    }
+    
+    batch_config_t batch = {
+        .inputs = (const char *const*)inputs,
+        .count = count,
+        .output_dir = output_dir,
+        .effects = *config,
+        .sample_rate = rate,
+        .workers = workers,
+        .map_input = map_input,
+        .chunk_frames = 0,
+    };
+    batch_stats_t stats;
+    
+    print_effects(config);
+    printf("Processing %zu files...\n", count);
+    int result = batch_run(&batch, &stats);
+    batch_free_paths(inputs, count);
+    
+    double wall = stats.wall_seconds > 0 ? stats.wall_seconds : 1e-9;
+    double realtime = stats.audio_seconds / wall;
+    printf("\nBatch:\n");
+    printf("  Files:       %zu rendered, %zu failed\n", stats.files_ok, stats.files_failed);
+    printf("  Workers:     %u (%zu steals, %zu graphs built)\n", stats.workers, stats.steals,
+           stats.graph_builds);
+    printf("  Audio:       %.2f s in %.3f s (%.1f files/s)\n", stats.audio_seconds,
+           stats.wall_seconds, (stats.files_ok + stats.files_failed) / wall);
+    printf("  Throughput:  %.1fx realtime, %.1fx per worker\n", realtime,
+           stats.workers ? realtime / stats.workers : 0.0);
+    printf("  Utilization: %.1f%% of the workers' time\n",
+           stats.workers ? 100.0 * stats.busy_seconds / (wall * stats.workers) : 0.0);
+    return result;
+}
+
+/**
+ * Split mode: one file cut into segments rendered in parallel.
+ */
+static int process_split(split_config_t *split) {
+    split_stats_t stats;
+    
+    print_effects(&split->effects);
+    printf("Processing (split across workers)...\n");
+    int result = split_run(split, &stats);
+    if (result != 0) {
+        return result;
+    }
+    
+    print_audio_info(stats.total_frames, stats.sample_rate, stats.channels);
+    print_input(split->map_input);
+    print_performance(stats.total_frames, stats.sample_rate, stats.wall_seconds);
+    
+    double preroll_ms = stats.preroll_frames * 1000.0 / stats.sample_rate;
+    printf("Split:\n");
+    printf("  Segments:    %u, each after %.1f ms of warm-up (%.1f%% extra work)\n",
+           stats.segments, preroll_ms,
+           stats.total_frames ? 100.0 * stats.warmup_frames / stats.total_frames : 0.0);
+    if (stats.exact) {
+        printf("  Accuracy:    exact (the chain keeps no state)\n");
+    } else if (isinf(stats.error_db)) {
+        printf("  Accuracy:    within float rounding of serial\n");
+    } else if (stats.error_db < 0.0) {
+        printf("  Accuracy:    within %.1f dBFS of serial, plus float rounding\n",
+               stats.error_db);
+    } else {
+        printf("  Accuracy:    no bound (warm-up shorter than the chain's memory)\n");
+    }
+    printf("  Utilization: %.1f%% of the workers' time\n",
+           stats.wall_seconds > 0 ? 100.0 * stats.busy_seconds /
+                                    (stats.wall_seconds * stats.segments) : 0.0);
+    printf("\n  Wrote %llu frames to '%s'\n", (unsigned long long)stats.total_frames,
+           split->output_file);
+    return 0;
+}
+
+typedef struct {
+    param_queue_t *params;
+    effect_graph_runner_t graphs;   // What the DSP thread runs
+    effect_chain_config_t effects;  // The settings so far, for rebuilding the graph
+    float sample_rate;
+    unsigned int channels;
+    unsigned int filter_order;  // Used when a filter command gives none
+    atomic_bool stop;           // Set once the live run is over
+} live_control_t;
+
+/**
+ * Build the graph for control->effects here, off the audio thread, and
+ * publish it. Then wait until the DSP thread has crossfaded to it and
+ * retired the old one, so no later command retunes a graph on its way out.
+ */
+static int control_swap(live_control_t *control) {
+    effect_graph_t *graph = effect_graph_from_config(&control->effects, control->sample_rate,
+                                                     control->channels, 0);
+    if (!graph || effect_graph_runner_publish(&control->graphs, graph) != 0) {
+        effect_graph_free(graph);
+        return -1;
+    }
+    
+    // Left to effect_graph_runner_destroy if the run ends first
+    while (!atomic_load(&control->stop)) {
+        effect_graph_t *retired = effect_graph_runner_collect(&control->graphs);
+        if (retired) {
+            effect_graph_free(retired);
+            break;
+        }
+        utils_sleep_ns(CONTROL_SWAP_POLL_NS);
+    }
+    return 0;
+}
+
+/**
+ * Design one control command and hand it to the DSP thread: a retune through
+ * the parameter queue, or for the limiter, which changes the graph, a new
+ * graph. A rebuilt graph takes every setting so far, with the last filter
+ * command's filter alone.
+ */
+static void control_apply(live_control_t *control, const char *line) {
+    char command[16] = "", value[16] = "";
+    unsigned int order = control->filter_order;
+    int fields = sscanf(line, "%15s %15s %u", command, value, &order);
+    if (fields < 1) {
+        return;
+    }
+    
+    effect_chain_config_t *effects = &control->effects;
+    int result = -1;
+    if (strcmp(command, "gain") == 0 && fields >= 2) {
+        result = param_queue_set_gain(control->params, (float)atof(value));
+        if (result == 0) {
+            effects->gain_db = (float)atof(value);
+        }
+    } else if (strcmp(command, "lowpass") == 0 && fields >= 2 && atof(value) > 0) {
+        result = param_queue_set_filter(control->params, (float)atof(value), 0.0f, order);
+        if (result == 0) {
+            effects->lowpass_freq = (float)atof(value);
+            effects->highpass_freq = 0.0f;
+            effects->filter_order = order;
+        }
+    } else if (strcmp(command, "highpass") == 0 && fields >= 2 && atof(value) > 0) {
+        result = param_queue_set_filter(control->params, 0.0f, (float)atof(value), order);
+        if (result == 0) {
+            effects->lowpass_freq = 0.0f;
+            effects->highpass_freq = (float)atof(value);
+            effects->filter_order = order;
+        }
+    } else if (strcmp(command, "filter") == 0 && strcmp(value, "off") == 0) {
+        result = param_queue_set_filter(control->params, 0.0f, 0.0f, 0);
+        if (result == 0) {
+            effects->lowpass_freq = 0.0f;
+            effects->highpass_freq = 0.0f;
+        }
+    } else if (strcmp(command, "compress") == 0 &&
+               (strcmp(value, "on") == 0 || strcmp(value, "off") == 0)) {
+        result = param_queue_set_compressor(control->params, strcmp(value, "on") == 0);
+        if (result == 0) {
+            effects->compress = strcmp(value, "on") == 0;
+        }
+    } else if (strcmp(command, "limit") == 0 && fields >= 2 && effects->enabled &&
+               (strcmp(value, "off") == 0 || isfinite(atof(value)))) {
+        effect_chain_config_t before = *effects;
+        effects->limit = strcmp(value, "off") != 0;
+        if (effects->limit) {
+            effects->limit_ceiling_db = (float)atof(value);
+        }
+        result = control_swap(control);
+        if (result != 0) {
+            *effects = before;
+        }
+    }
+    
+    if (result != 0) {
+        fprintf(stderr, "\n✗ Error: Ignored control command: %s\n", line);
+    }
+}
+
+/**
+ * Control thread for --control: one command per line on stdin, designed
+ * here and handed to the DSP thread through the parameter queue. Polls
+ * stdin rather than blocking in it, so it sees stop within CONTROL_POLL_MS
+ * and can simply be joined.
+ */
+static void* control_thread(void *arg) {
+    live_control_t *control = (live_control_t*)arg;
+    char line[128];
+    size_t length = 0;
+    
+    while (!atomic_load(&control->stop)) {
+        struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+        int ready = poll(&pfd, 1, CONTROL_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        
+        ssize_t got = read(STDIN_FILENO, &line[length], sizeof(line) - 1 - length);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;  // End of input: keep running without control
+        }
+        length += (size_t)got;
+        line[length] = '\0';
+        
+        // Apply each whole line; a line too long for the buffer is cut
+        char *start = line, *end;
+        while ((end = strchr(start, '\n')) != NULL) {
+            *end = '\0';
+            control_apply(control, start);
+            start = end + 1;
+        }
+        length = strlen(start);
+        if (length == sizeof(line) - 1) {
+            control_apply(control, start);
+            length = 0;
+        }
+        memmove(line, start, length);
+    }
+    return NULL;
+}
+
+static void on_sigint(int sig) {
+    (void)sig;
+    live_request_stop();
+}
+
+/**
+ * Live mode: capture -> DSP -> playback until the duration elapses or Ctrl-C.
+ */
+static int process_live(live_config_t *live, const effect_chain_config_t *config,
+                        bool control) {
+    live->effects = *config;
+    live->params = NULL;
+    
+    printf("Live:\n");
+    if (live->receive_from) {
+        printf("  Capture:  network, UDP %s\n", live->receive_from);
+    } else {
+        printf("  Capture:  %s\n", live->capture_device);
+    }
+    if (live->send_to) {
+        printf("  Send to:  %s (UDP), no DSP or playback here\n", live->send_to);
+    } else {
+        printf("  Playback: %s\n", live->playback_device);
+    }
+    printf("  Rate:     %u Hz, %u channel(s)\n", live->sample_rate, live->channels);
+    if (live->auto_tune) {
+        printf("  Period:   auto-tune (lowest sustainable)\n");
+    } else {
+        printf("  Period:   %zu frames (%.2f ms) x %u\n", live->period_frames,
+               live->period_frames * 1000.0f / live->sample_rate, live->period_count);
+    }
+    printf("  Target:   %.2f ms input-to-output\n", live->latency_ms);
+    printf("  Access:   %s\n", live->use_mmap ? "mmap (if supported)" : "read/write");
+    printf("  Format:   %s\n", live->device_format == SAMPLE_FORMAT_AUTO ? "best native" :
+           sample_format_name((sample_format_t)live->device_format));
+    printf("  Clocks:   %s\n", live->drift_correction ? "drift-corrected" : "assumed locked");
+    if (live->record_file) {
+        printf("  Record:   %s\n", live->record_file);
+    }
+    if (live->meter) {
+        printf("  Meter:    peak, true-peak, R128 loudness\n");
+    }
+    printf("\n");
+    print_effects(config);
+    
+    signal(SIGINT, on_sigint);
+    
+    live_control_t controller = {
+        .effects = *config,
+        .sample_rate = (float)live->sample_rate,
+        .channels = live->channels,
+        .filter_order = config->filter_order,
+    };
+    atomic_init(&controller.stop, false);
+    pthread_t control_tid;
+    if (control) {
+        // Live audio can't wait for a convolution tail that's running late
+        controller.effects.ir_realtime = true;
+        effect_graph_t *graph = effect_graph_from_config(&controller.effects,
+                                                         controller.sample_rate,
+                                                         controller.channels, 0);
+        
+        // Delayed by the limiter's lookahead from the start, so turning it on
+        // or off later doesn't make the audio skip or repeat
+        size_t lookahead = config->enabled ?
+            limiter_lookahead_frames(controller.sample_rate, config->limit_lookahead_ms) : 0;
+        if (graph && effect_graph_set_latency(graph, lookahead) != 0) {
+            effect_graph_free(graph);
+            graph = NULL;
+        }
+        effect_graph_runner_init(&controller.graphs, graph);
+        
+        controller.params = param_queue_create(CONTROL_QUEUE_SIZE, controller.sample_rate,
+                                               controller.channels);
+        if (!graph || !controller.params ||
+            pthread_create(&control_tid, NULL, control_thread, &controller) != 0) {
+            fprintf(stderr, "✗ Error: Failed to start the control thread\n");
+            param_queue_free(controller.params);
+            effect_graph_runner_destroy(&controller.graphs);
+            return 1;
+        }
+        live->params = controller.params;
+        live->graphs = &controller.graphs;
+        printf("Reading effect changes from stdin\n");
+    }
+    
+    printf("Running (Ctrl-C to stop)...\n");
+    live_stats_t stats;
+    int result = live_run(live, &stats);
+    
+    if (control) {
+        atomic_store(&controller.stop, true);
+        pthread_join(control_tid, NULL);
+        live->params = NULL;
+        live->graphs = NULL;
+        param_queue_free(controller.params);
+        effect_graph_runner_destroy(&controller.graphs);
+    }
+    if (result != 0) {
+        return result;
+    }
     
-    printf("\n✓ Done! Play '%s' to hear the result.\n\n", output_file);
+    if (live->send_to) {
+        printf("\nSend Summary:\n");
+        printf("  Captured:    %llu frames\n", (unsigned long long)stats.frames_captured);
+        printf("  Packets:     %llu sent, %llu refused by the socket\n",
+               (unsigned long long)stats.packets_sent, (unsigned long long)stats.packets_unsent);
+        printf("  XRUNs:       %llu (%llu suspends)\n", (unsigned long long)stats.xruns,
+               (unsigned long long)stats.suspends);
+        print_realtime(&live->rt, stats.rt_flags, stats.memory_locked);
+        return 0;
+    }
+    
+    printf("\nLive Summary:\n");
+    printf("  Captured:    %llu frames\n", (unsigned long long)stats.frames_captured);
+    printf("  Played:      %llu frames\n", (unsigned long long)stats.frames_played);
+    printf("  Dropped:     %llu frames\n", (unsigned long long)stats.frames_dropped);
+    printf("  Underruns:   %llu periods\n", (unsigned long long)stats.underruns);
+    printf("  XRUNs:       %llu (%llu suspends)\n", (unsigned long long)stats.xruns,
+           (unsigned long long)stats.suspends);
+    printf("  Period:      %zu frames (%.2f ms), %u back-offs\n", stats.period_frames,
+           stats.period_frames * 1000.0f / live->sample_rate, stats.restarts);
+    printf("  Latency:     %.2f ms avg (min %.2f, max %.2f)\n",
+           stats.latency_ms_avg, stats.latency_ms_min, stats.latency_ms_max);
+    printf("  Rates:       capture %u Hz, playback %u Hz, DSP %u Hz\n",
+           stats.capture_rate, stats.playback_rate, live->sample_rate);
+    if (live->drift_correction) {
+        printf("  Drift:       %+.1f ppm playback trim\n", stats.drift_ppm);
+    }
+    printf("  Ring peaks:  %zu / %zu frames (captured / processed)\n",
+           stats.captured_high_water, stats.processed_high_water);
+    if (live->receive_from) {
+        const net_receiver_stats_t *n = &stats.network;
+        printf("  Network:     %llu packets, %llu lost, %llu late, %llu reordered\n",
+               (unsigned long long)n->packets_received, (unsigned long long)n->packets_lost,
+               (unsigned long long)n->packets_late, (unsigned long long)n->packets_reordered);
+        printf("  Jitter buf:  %.2f ms avg (target %.2f), %.2f ms jitter, %+.1f ppm sender\n",
+               n->latency_ms_avg, n->target_ms, n->jitter_ms, n->drift_ppm);
+        printf("  Concealed:   %llu frames, %llu underruns, %llu frames skipped, %llu resyncs\n",
+               (unsigned long long)n->frames_concealed, (unsigned long long)n->underruns,
+               (unsigned long long)n->frames_skipped, (unsigned long long)n->resyncs);
+    }
+    if (live->record_file) {
+        printf("  Recorded:    %llu frames to '%s' (%llu dropped)\n",
+               (unsigned long long)stats.frames_recorded, live->record_file,
+               (unsigned long long)stats.record_dropped);
+    }
+    if (live->meter) {
+        const meter_reading_t *m = &stats.loudness;
+        printf("  Loudness:    %.1f LUFS integrated, %.1f LUFS over the last 3 s\n",
+               m->integrated_lufs, m->short_term_lufs);
+        printf("  Peaks:       %.1f dBFS sample, %.1f dBTP true\n", m->peak_db, m->true_peak_db);
+        printf("  Metered:     %llu frames (%llu as summaries, %llu dropped)\n",
+               (unsigned long long)(m->frames_metered + m->frames_summarized),
+               (unsigned long long)m->frames_summarized, (unsigned long long)m->frames_dropped);
+    }
+    print_realtime(&live->rt, stats.rt_flags, stats.memory_locked);
+    printf("\n");
+    print_block_timing(&stats.dsp_blocks);
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char *argv[]) {
+    printf("\n");
+    printf("╔═══════════════════════════════════════════════════════╗\n");
+    printf("║      REAL-TIME AUDIO PROCESSOR v1.0                  ║\n");
+    printf("║      Lock-Free Ring Buffer + DSP Effects             ║\n");
+    printf("╚═══════════════════════════════════════════════════════╝\n");
+    printf("\n");
+    
+    // Default file paths
+    const char *input_file = "test_audio/input.wav";
+    const char *output_file = "output/processed.wav";
+    
+    // Effect parameters
+    effect_chain_config_t effects = {
+        .enabled = true,
+        .gain_db = 0.0f,
+        .lowpass_freq = 0.0f,
+        .highpass_freq = 0.0f,
+        .filter_order = 2,
+        .compress = false,
+        .ir = NULL,
+        .ir_mix = 1.0f,
+        .ir_realtime = false,
+        .limit = false,
+        .limit_ceiling_db = LIMITER_CEILING_DB,
+        .limit_lookahead_ms = LIMITER_LOOKAHEAD_MS,
+    };
+    const char *ir_file = NULL;
+    enum {
+        MODE_BUFFERED, MODE_STREAMING, MODE_PIPELINE, MODE_LIVE, MODE_BATCH, MODE_SPLIT
+    } mode = MODE_BUFFERED;
+    static const char *mode_names[] = {
+        "whole file", "streaming", "pipeline", "live", "batch", "split"
+    };
+    const char *batch_source = NULL;
+    const char *out_dir = NULL;
+    unsigned int workers = 0;
+    split_config_t split;
+    split_config_init(&split);
+    
+    live_config_t live = {
+        .capture_device = "default",
+        .playback_device = "default",
+        .sample_rate = 48000,
+        .channels = 1,
+        .period_frames = 128,
+        .period_count = 4,
+        .auto_tune = false,
+        .latency_ms = 10.0f,
+        .duration_s = 0.0f,
+        .use_mmap = false,
+        .device_format = SAMPLE_FORMAT_AUTO,
+        .drift_correction = false,
+        .record_file = NULL,
+        .record_config = NULL,
+        .meter = false,
+        .receive_from = NULL,
+        .send_to = NULL,
+        .net_config = NULL,
+    };
+    net_audio_config_t net;
+    net_audio_config_init(&net);
+    wav_writer_config_t writer;
+    wav_writer_config_init(&writer);
+    
+    bool control = false;
+    bool rate_set = false;      // File modes keep the file's rate unless asked
+    bool map_input = true;
+    rt_config_t rt;
+    rt_config_init(&rt);
+    
+    // Parse command-line arguments; the first two non-flag arguments are
+    // the input and output files, wherever they appear
+    int file_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--gain") == 0 && i + 1 < argc) {
+            effects.gain_db = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--lowpass") == 0 && i + 1 < argc) {
+            effects.lowpass_freq = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--highpass") == 0 && i + 1 < argc) {
+            effects.highpass_freq = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--order") == 0 && i + 1 < argc) {
+            effects.filter_order = (unsigned int)atoi(argv[++i]);
+            if (effects.filter_order < 2 || effects.filter_order > 2 * BIQUAD_MAX_SECTIONS ||
+                effects.filter_order % 2 != 0) {
+                fprintf(stderr, "✗ Error: --order must be 2, 4, 6 or 8\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--compress") == 0) {
+            effects.compress = true;
+        }
+        else if (strcmp(argv[i], "--ir") == 0 && i + 1 < argc) {
+            ir_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--ir-mix") == 0 && i + 1 < argc) {
+            effects.ir_mix = atof(argv[++i]);
+            if (effects.ir_mix < 0.0f || effects.ir_mix > 1.0f) {
+                fprintf(stderr, "✗ Error: --ir-mix must be between 0 and 1\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            effects.limit = true;
+            effects.limit_ceiling_db = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--lookahead") == 0 && i + 1 < argc) {
+            effects.limit_lookahead_ms = atof(argv[++i]);
+            if (effects.limit_lookahead_ms < 0.0f) {
+                fprintf(stderr, "✗ Error: --lookahead can't be negative\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--no-effects") == 0) {
+            effects.enabled = false;
+        }
+        else if (strcmp(argv[i], "--stream") == 0) {
+            mode = MODE_STREAMING;
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0) {
+            mode = MODE_PIPELINE;
+        }
+        else if (strcmp(argv[i], "--no-mmap") == 0) {
+            map_input = false;
+        }
+        else if (strcmp(argv[i], "--live") == 0) {
+            mode = MODE_LIVE;
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            mode = MODE_BATCH;
+            batch_source = argv[++i];
+        }
+        else if (strcmp(argv[i], "--split") == 0) {
+            mode = MODE_SPLIT;
+        }
+        else if (strcmp(argv[i], "--preroll") == 0 && i + 1 < argc) {
+            split.preroll_ms = atof(argv[++i]);
+            if (split.preroll_ms < 0.0) {
+                fprintf(stderr, "✗ Error: --preroll can't be negative\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--split-error") == 0 && i + 1 < argc) {
+            split.error_db = atof(argv[++i]);
+            if (split.error_db >= 0.0) {
+                fprintf(stderr, "✗ Error: --split-error must be below 0 dB\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            int n = atoi(argv[++i]);
+            if (n < 1) {
+                fprintf(stderr, "✗ Error: --workers must be at least 1\n");
+                return 1;
+            }
+            workers = (unsigned int)n;
+        }
+        else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            live.capture_device = argv[++i];
+        }
+        else if (strcmp(argv[i], "--playback") == 0 && i + 1 < argc) {
+            live.playback_device = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            live.sample_rate = (unsigned int)atoi(argv[++i]);
+            rate_set = true;
+        }
+        else if (strcmp(argv[i], "--channels") == 0 && i + 1 < argc) {
+            live.channels = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            live.period_frames = (size_t)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--periods") == 0 && i + 1 < argc) {
+            live.period_count = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--auto-latency") == 0) {
+            live.auto_tune = true;
+        }
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            live.latency_ms = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            live.duration_s = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--mmap") == 0) {
+            live.use_mmap = true;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            sample_format_t format;
+            if (sample_format_parse(argv[++i], &format) != 0) {
+                fprintf(stderr, "✗ Error: --format must be float, s32, s24 or s16\n");
+                return 1;
+            }
+            live.device_format = (int)format;
+        }
+        else if (strcmp(argv[i], "--drift-correct") == 0) {
+            live.drift_correction = true;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            live.record_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--meter") == 0) {
+            live.meter = true;
+        }
+        else if (strcmp(argv[i], "--send") == 0 && i + 1 < argc) {
+            live.send_to = argv[++i];
+            mode = MODE_LIVE;
+        }
+        else if (strcmp(argv[i], "--receive") == 0 && i + 1 < argc) {
+            live.receive_from = argv[++i];
+            mode = MODE_LIVE;
+        }
+        else if (strcmp(argv[i], "--net-delay") == 0 && i + 1 < argc) {
+            net.min_delay_ms = atof(argv[++i]);
+            if (net.min_delay_ms < 0.0) {
+                fprintf(stderr, "✗ Error: --net-delay must not be negative\n");
+                return 1;
+            }
+            if (net.max_delay_ms < net.min_delay_ms) {
+                net.max_delay_ms = net.min_delay_ms;
+            }
+        }
+        else if (strcmp(argv[i], "--direct-io") == 0) {
+            writer.direct = true;
+        }
+        else if (strcmp(argv[i], "--io-uring") == 0) {
+            writer.io_uring = true;
+        }
+        else if (strcmp(argv[i], "--fsync") == 0) {
+            writer.sync = WAV_WRITER_SYNC_PERIODIC;
+        }
+        else if (strcmp(argv[i], "--rt-priority") == 0 && i + 1 < argc) {
+            rt.priority = atoi(argv[++i]);
+            if (rt.priority < 1 || rt.priority > 99) {
+                fprintf(stderr, "✗ Error: --rt-priority must be between 1 and 99\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            rt.cpu = atoi(argv[++i]);
+            if (rt.cpu < 0) {
+                fprintf(stderr, "✗ Error: --cpu must be a core number\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--mlock") == 0) {
+            rt.lock_memory = true;
+        }
+        else if (strcmp(argv[i], "--control") == 0) {
+            control = true;
+        }
+        else if (argv[i][0] != '-') {
+            if (file_count == 0) {
+                input_file = argv[i];
+            } else if (file_count == 1) {
+                output_file = argv[i];
+            }
+            file_count++;
+        }
+    }
+    
+    // Loaded up front; every mode convolves with the same IR
+    float *ir_samples = NULL;
+    convolver_ir_t ir;
+    if (ir_file) {
+        unsigned int ir_channels, ir_rate;
+        drwav_uint64 ir_frames;
+        ir_samples = drwav_open_file_and_read_pcm_frames_f32(ir_file, &ir_channels, &ir_rate,
+                                                             &ir_frames, NULL);
+        if (!ir_samples || ir_frames == 0) {
+            fprintf(stderr, "✗ Error: Failed to open impulse response '%s'\n", ir_file);
+            drwav_free(ir_samples, NULL);
+            return 1;
+        }
+        ir.samples = ir_samples;
+        ir.frames = (size_t)ir_frames;
+        ir.channels = ir_channels;
+        ir.sample_rate = ir_rate;   // Resampled to the processing rate if it differs
+        effects.ir = &ir;
+    }
+    
+    if (mode == MODE_LIVE) {
+        int result = 1;
+        if (live.sample_rate == 0 || live.period_frames == 0 || live.period_count < 2) {
+            fprintf(stderr, "✗ Error: --rate and --period must be positive, --periods at least 2\n");
+        } else if (live.send_to && live.receive_from) {
+            fprintf(stderr, "✗ Error: --send and --receive are the two ends; pick one\n");
+        } else if (check_channels(live.channels, &effects)) {
+            live.rt = rt;
+            live.record_config = &writer;
+            live.net_config = &net;
+            result = process_live(&live, &effects, control);
+        }
+        drwav_free(ir_samples, NULL);
+        return result;
+    }
+    
+    if (rate_set && live.sample_rate == 0) {
+        fprintf(stderr, "✗ Error: --rate must be positive\n");
+        drwav_free(ir_samples, NULL);
+        return 1;
+    }
+    unsigned int file_rate = rate_set ? live.sample_rate : 0;
+    
+    // The pipeline's threads flush denormals; do the same here so every
+    // file mode renders the same bits
+    rt_flush_denormals();
+    
+    if (mode == MODE_BATCH) {
+        int result = 1;
+        if (!out_dir) {
+            fprintf(stderr, "✗ Error: --batch needs --out-dir\n");
+        } else {
+            printf("Configuration:\n");
+            printf("  Inputs:  %s\n", batch_source);
+            printf("  Outputs: %s\n", out_dir);
+            printf("  Mode:    %s\n", mode_names[mode]);
+            printf("\n");
+            result = process_batch(batch_source, out_dir, &effects, file_rate, workers, map_input);
+        }
+        drwav_free(ir_samples, NULL);
+        if (result == 0) {
+            printf("\n✓ Done! Outputs are in '%s'.\n\n", out_dir);
+        }
+        return result;
+    }
+    
+    if (mode == MODE_SPLIT && rate_set) {
+        fprintf(stderr, "✗ Error: --split renders at the file's own rate; drop --rate\n");
+        drwav_free(ir_samples, NULL);
+        return 1;
+    }
+    
+    printf("Configuration:\n");
+    printf("  Input:  %s\n", input_file);
+    printf("  Output: %s\n", output_file);
+    printf("  Mode:   %s\n", mode_names[mode]);
+    printf("\n");
+    
+    int result;
+    switch (mode) {
+    case MODE_STREAMING:
+        result = process_streaming(input_file, output_file, &effects, file_rate, map_input,
+                                   &writer);
+        break;
+    case MODE_SPLIT:
+        split.input_file = input_file;
+        split.output_file = output_file;
+        split.effects = effects;
+        split.workers = workers;
+        split.map_input = map_input;
+        result = process_split(&split);
+        break;
+    case MODE_PIPELINE:
+        result = process_pipeline(input_file, output_file, &effects, &rt, file_rate, map_input);
+        break;
+    default:
+        result = process_buffered(input_file, output_file, &effects, file_rate);
+        break;
+    }
+    
+    drwav_free(ir_samples, NULL);
+    if (result == 0) {
+        printf("\n✓ Done! Play '%s' to hear the result.\n\n", output_file);
+    }
+    return result;
+}
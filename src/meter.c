@@ -0,0 +1,456 @@
+#include "meter.h"
+#include "stats.h"
+#include "rt_thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define METER_HEADER 2                     // Floats in front of every record: kind, frames
+#define METER_RECORD_RAW 0.0f
+#define METER_RECORD_SUMMARY 1.0f
+#define METER_MAX_RECORD_FRAMES 65536      // Longer taps are split (frames travel as a float)
+#define METER_IDLE_NS 20000000ull          // Longest the meter sleeps on an empty ring
+#define METER_MOMENTARY_BLOCKS 4
+#define METER_ABSOLUTE_GATE -70.0
+#define METER_RELATIVE_GATE -10.0
+
+// The 4x true-peak interpolator: a Hann-windowed sinc centred on a tap,
+// so phase 0 is the input itself and phase 2 falls halfway between samples
+static float true_peak_phases[4][METER_TRUE_PEAK_TAPS];
+static pthread_once_t true_peak_once = PTHREAD_ONCE_INIT;
+
+static void true_peak_design(void) {
+    const int length = 4 * METER_TRUE_PEAK_TAPS;
+    for (int p = 0; p < 4; p++) {
+        double sum = 0.0;
+        double taps[METER_TRUE_PEAK_TAPS];
+        for (int j = 0; j < METER_TRUE_PEAK_TAPS; j++) {
+            int k = p + 4 * j;
+            double x = (k - length / 2) / 4.0;
+            double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double window = 0.5 - 0.5 * cos(2.0 * M_PI * k / length);
+            taps[j] = sinc * window;
+            sum += taps[j];
+        }
+        // Unity gain at DC for every phase
+        for (int j = 0; j < METER_TRUE_PEAK_TAPS; j++) {
+            true_peak_phases[p][j] = (float)(taps[j] / sum);
+        }
+    }
+}
+
+static size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+/**
+ * The two BS.1770-4 K-weighting stages, designed for any rate from the
+ * analogue prototypes behind the standard's 48 kHz coefficients.
+ */
+static void meter_design_k_weighting(meter_t *m) {
+    double rate = m->sample_rate;
+    
+    double f0 = 1681.974450955533;
+    double gain_db = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain_db / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    m->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    m->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    m->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->shelf.a2 = (1.0 - k / q + k * k) / a0;
+    
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    m->highpass.b0 = 1.0;
+    m->highpass.b1 = -2.0;
+    m->highpass.b2 = 1.0;
+    m->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->highpass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+static inline double biquad_step(meter_biquad_t *f, unsigned int c, double x) {
+    double y = f->b0 * x + f->z1[c];
+    f->z1[c] = f->b1 * x - f->a1 * y + f->z2[c];
+    f->z2[c] = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+static float level_db(double linear) {
+    return linear > 0.0 ? (float)(20.0 * log10(linear)) : METER_SILENCE_DB;
+}
+
+static double mean_square_lufs(double z) {
+    return z > 0.0 ? -0.691 + 10.0 * log10(z) : METER_SILENCE_DB;
+}
+
+/**
+ * Gated integrated loudness from the histogram: the absolute gate was
+ * applied on the way in, the relative one is applied here to within a bin.
+ */
+static double meter_integrated(const meter_t *m) {
+    double energy = 0.0;
+    uint64_t count = 0;
+    for (int b = 0; b < METER_HISTOGRAM_BINS; b++) {
+        energy += m->histogram_energy[b];
+        count += m->histogram_count[b];
+    }
+    if (count == 0) {
+        return METER_SILENCE_DB;
+    }
+    
+    double gate = mean_square_lufs(energy / count) + METER_RELATIVE_GATE;
+    int first = (int)floor((gate - METER_ABSOLUTE_GATE) * 10.0);
+    energy = 0.0;
+    count = 0;
+    for (int b = first < 0 ? 0 : first; b < METER_HISTOGRAM_BINS; b++) {
+        energy += m->histogram_energy[b];
+        count += m->histogram_count[b];
+    }
+    return count ? mean_square_lufs(energy / count) : METER_SILENCE_DB;
+}
+
+static void meter_publish(meter_t *m) {
+    // Until a window has filled, it covers what there is
+    size_t have = m->blocks < METER_WINDOW_BLOCKS ? (size_t)m->blocks : METER_WINDOW_BLOCKS;
+    double momentary = 0.0, short_term = 0.0;
+    for (size_t i = 0; i < have; i++) {
+        double z = m->loudness[(m->blocks - 1 - i) % METER_WINDOW_BLOCKS];
+        if (i < METER_MOMENTARY_BLOCKS) {
+            momentary += z;
+        }
+        short_term += z;
+    }
+    size_t recent = have < METER_MOMENTARY_BLOCKS ? have : METER_MOMENTARY_BLOCKS;
+    
+    double loudest = 0.0;
+    for (unsigned int c = 0; c < m->channels; c++) {
+        double sum = 0.0;
+        for (size_t i = 0; i < recent; i++) {
+            sum += m->squares[(m->blocks - 1 - i) % METER_MOMENTARY_BLOCKS][c];
+        }
+        loudest = fmax(loudest, recent ? sum / recent : 0.0);
+    }
+    
+    atomic_store_explicit(&m->peak_db, level_db(m->peak), memory_order_relaxed);
+    atomic_store_explicit(&m->true_peak_db, level_db(m->true_peak), memory_order_relaxed);
+    atomic_store_explicit(&m->rms_db, level_db(sqrt(loudest)), memory_order_relaxed);
+    atomic_store_explicit(&m->momentary_lufs,
+                          (float)(recent ? mean_square_lufs(momentary / recent) : METER_SILENCE_DB),
+                          memory_order_relaxed);
+    atomic_store_explicit(&m->short_term_lufs,
+                          (float)(have ? mean_square_lufs(short_term / have) : METER_SILENCE_DB),
+                          memory_order_relaxed);
+    atomic_store_explicit(&m->integrated_lufs, (float)meter_integrated(m), memory_order_relaxed);
+}
+
+/**
+ * Close the current 100 ms sub-block: it joins the windows, and the
+ * 400 ms gating block ending with it (75% overlap) joins the histogram.
+ */
+static void meter_end_block(meter_t *m) {
+    unsigned int channels = m->channels;
+    m->loudness[m->blocks % METER_WINDOW_BLOCKS] = m->block_loudness / m->block_frames;
+    for (unsigned int c = 0; c < channels; c++) {
+        m->squares[m->blocks % METER_MOMENTARY_BLOCKS][c] = m->block_squares[c] / m->block_frames;
+        m->block_squares[c] = 0.0;
+    }
+    m->blocks++;
+    m->block_loudness = 0.0;
+    m->block_fill = 0;
+    
+    if (m->blocks >= METER_MOMENTARY_BLOCKS) {
+        double z = 0.0;
+        for (size_t i = 0; i < METER_MOMENTARY_BLOCKS; i++) {
+            z += m->loudness[(m->blocks - 1 - i) % METER_WINDOW_BLOCKS];
+        }
+        z /= METER_MOMENTARY_BLOCKS;
+        double lufs = mean_square_lufs(z);
+        if (lufs >= METER_ABSOLUTE_GATE) {
+            int bin = (int)((lufs - METER_ABSOLUTE_GATE) * 10.0);
+            if (bin >= METER_HISTOGRAM_BINS) {
+                bin = METER_HISTOGRAM_BINS - 1;
+            }
+            m->histogram_count[bin]++;
+            m->histogram_energy[bin] += z;
+        }
+    }
+    meter_publish(m);
+}
+
+/**
+ * Measure a raw record in full.
+ */
+static void meter_measure(meter_t *m, const float *frames, size_t count) {
+    unsigned int channels = m->channels;
+    
+    for (size_t i = 0; i < count; i++) {
+        const float *frame = &frames[i * channels];
+        for (unsigned int c = 0; c < channels; c++) {
+            float x = frame[c];
+            double ax = fabs(x);
+            m->peak = fmax(m->peak, ax);
+            
+            // Slide the input into the interpolator's history (newest last)
+            float *history = m->history[c];
+            memmove(history, &history[1], (METER_TRUE_PEAK_TAPS - 1) * sizeof(float));
+            history[METER_TRUE_PEAK_TAPS - 1] = x;
+            double tp = ax;
+            for (int p = 1; p < 4; p++) {
+                const float *taps = true_peak_phases[p];
+                double y = 0.0;
+                for (int j = 0; j < METER_TRUE_PEAK_TAPS; j++) {
+                    y += taps[j] * history[METER_TRUE_PEAK_TAPS - 1 - j];
+                }
+                tp = fmax(tp, fabs(y));
+            }
+            m->true_peak = fmax(m->true_peak, tp);
+            
+            double k = biquad_step(&m->highpass, c, biquad_step(&m->shelf, c, x));
+            m->block_loudness += m->weight[c] * k * k;
+            m->block_squares[c] += (double)x * x;
+        }
+        if (++m->block_fill == m->block_frames) {
+            meter_end_block(m);
+        }
+    }
+}
+
+/**
+ * Account for count frames known only by their summary, spreading their
+ * energy evenly over the sub-blocks they span.
+ */
+static void meter_summarize(meter_t *m, const float *summary, size_t count) {
+    unsigned int channels = m->channels;
+    const float *peak = summary;
+    const float *squares = &summary[channels];
+    
+    for (unsigned int c = 0; c < channels; c++) {
+        m->peak = fmax(m->peak, peak[c]);
+        m->true_peak = fmax(m->true_peak, peak[c]);
+    }
+    size_t total = count;
+    while (count > 0) {
+        size_t n = m->block_frames - m->block_fill;
+        if (n > count) {
+            n = count;
+        }
+        for (unsigned int c = 0; c < channels; c++) {
+            double energy = (double)squares[c] * n / total;
+            m->block_squares[c] += energy;
+            m->block_loudness += m->weight[c] * energy;
+        }
+        count -= n;
+        m->block_fill += n;
+        if (m->block_fill == m->block_frames) {
+            meter_end_block(m);
+        }
+    }
+}
+
+static void meter_consume(meter_t *m) {
+    unsigned int channels = m->channels;
+    float header[METER_HEADER];
+    ring_buffer_read(m->ring, header, METER_HEADER);
+    size_t frames = (size_t)header[1];
+    
+    // The tap commits a record whole, so the rest of it is there already
+    if (header[0] == METER_RECORD_RAW) {
+        ring_buffer_read(m->ring, m->scratch, frames * channels);
+        meter_measure(m, m->scratch, frames);
+        stats_counter_add(&m->frames_metered, frames);
+    } else {
+        ring_buffer_read(m->ring, m->scratch, 2 * channels);
+        meter_summarize(m, m->scratch, frames);
+        stats_counter_add(&m->frames_summarized, frames);
+    }
+}
+
+static void* meter_thread(void *arg) {
+    meter_t *m = (meter_t*)arg;
+    
+    // Silence decaying through the K-weighting filters would go denormal
+    rt_flush_denormals();
+    
+    // Parked for a publish interval's worth of audio, the timeout aside, so
+    // the tap's commits seldom have anyone to wake
+    size_t wake = m->block_frames * m->channels + METER_HEADER;
+    if (wake > m->ring->capacity / 2) {
+        wake = m->ring->capacity / 2;
+    }
+    
+    while (true) {
+        // stopping first: everything tapped before it was set is visible below
+        bool stopping = atomic_load_explicit(&m->stopping, memory_order_acquire);
+        if (ring_buffer_read_available(m->ring) == 0) {
+            if (stopping) {
+                break;
+            }
+            ring_buffer_wait_readable(m->ring, wake, METER_IDLE_NS);
+            continue;
+        }
+        meter_consume(m);
+    }
+    meter_publish(m);
+    return NULL;
+}
+
+meter_t* meter_create(unsigned int channels, unsigned int sample_rate, size_t ring_frames) {
+    if (channels == 0 || channels > METER_MAX_CHANNELS || sample_rate < 10) {
+        return NULL;
+    }
+    pthread_once(&true_peak_once, true_peak_design);
+    
+    meter_t *m = calloc(1, sizeof(meter_t));
+    if (!m) {
+        return NULL;
+    }
+    m->channels = channels;
+    m->sample_rate = sample_rate;
+    m->block_frames = (sample_rate + 5) / 10;
+    atomic_init(&m->stopping, false);
+    atomic_init(&m->frames_dropped, 0);
+    atomic_init(&m->frames_metered, 0);
+    atomic_init(&m->frames_summarized, 0);
+    meter_design_k_weighting(m);
+    
+    // BS.1770 weights; the LFE (fourth of 5.1 and 7.1) isn't counted and
+    // the surrounds count 1.41 times
+    for (unsigned int c = 0; c < channels; c++) {
+        bool surround = (channels == 6 || channels == 8) && c >= 3;
+        m->weight[c] = surround ? (c == 3 ? 0.0 : 1.41) : 1.0;
+    }
+    meter_publish(m);
+    
+    // Waitable, so the idle meter sleeps on a futex rather than polling
+    if (ring_frames == 0) {
+        ring_frames = (size_t)sample_rate * METER_RING_MS / 1000;
+    }
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.prefault = true;
+    options.waitable = true;
+    size_t capacity = next_power_of_2(ring_frames * channels + METER_HEADER);
+    m->ring = ring_buffer_create_ex(capacity, &options);
+    size_t largest = (size_t)METER_MAX_RECORD_FRAMES * channels;
+    m->scratch = malloc((capacity < largest ? capacity : largest) * sizeof(float));
+    if (!m->ring || !m->scratch) {
+        meter_free(m);
+        return NULL;
+    }
+    
+    if (pthread_create(&m->thread, NULL, meter_thread, m) != 0) {
+        meter_free(m);
+        return NULL;
+    }
+    m->running = true;
+    return m;
+}
+
+/**
+ * Copy n floats to position at of a write span, across its wrap.
+ */
+static void span_store(const ring_buffer_span_t *span, size_t at, const float *src, size_t n) {
+    if (at < span->size1) {
+        size_t first = span->size1 - at < n ? span->size1 - at : n;
+        memcpy(&span->data1[at], src, first * sizeof(float));
+        src += first;
+        n -= first;
+        at = span->size1;
+    }
+    if (n > 0) {
+        memcpy(&span->data2[at - span->size1], src, n * sizeof(float));
+    }
+}
+
+static void meter_tap_record(meter_t *m, const float *frames, size_t count) {
+    unsigned int channels = m->channels;
+    size_t raw = METER_HEADER + count * channels;
+    size_t summary = METER_HEADER + 2 * channels;
+    
+    ring_buffer_span_t span;
+    size_t room = ring_buffer_write_acquire(m->ring, raw, &span);
+    if (room >= raw) {
+        float header[METER_HEADER] = { METER_RECORD_RAW, (float)count };
+        span_store(&span, 0, header, METER_HEADER);
+        span_store(&span, METER_HEADER, frames, count * channels);
+        ring_buffer_write_commit(m->ring, raw);
+        return;
+    }
+    if (room < summary) {
+        stats_counter_add(&m->frames_dropped, count);
+        return;
+    }
+    
+    // No room for the block: its peak and energy per channel will do
+    double peak[METER_MAX_CHANNELS] = { 0.0 };
+    double squares[METER_MAX_CHANNELS] = { 0.0 };
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            double x = frames[i * channels + c];
+            peak[c] = fmax(peak[c], fabs(x));
+            squares[c] += x * x;
+        }
+    }
+    float record[METER_HEADER + 2 * METER_MAX_CHANNELS] = { METER_RECORD_SUMMARY, (float)count };
+    for (unsigned int c = 0; c < channels; c++) {
+        record[METER_HEADER + c] = (float)peak[c];
+        record[METER_HEADER + channels + c] = (float)squares[c];
+    }
+    span_store(&span, 0, record, summary);
+    ring_buffer_write_commit(m->ring, summary);
+}
+
+void meter_tap(meter_t *m, const float *frames, size_t count) {
+    while (count > 0) {
+        size_t n = count < METER_MAX_RECORD_FRAMES ? count : METER_MAX_RECORD_FRAMES;
+        meter_tap_record(m, frames, n);
+        frames += n * m->channels;
+        count -= n;
+    }
+}
+
+void meter_read(const meter_t *m, meter_reading_t *reading) {
+    reading->peak_db = atomic_load_explicit(&m->peak_db, memory_order_relaxed);
+    reading->true_peak_db = atomic_load_explicit(&m->true_peak_db, memory_order_relaxed);
+    reading->rms_db = atomic_load_explicit(&m->rms_db, memory_order_relaxed);
+    reading->momentary_lufs = atomic_load_explicit(&m->momentary_lufs, memory_order_relaxed);
+    reading->short_term_lufs = atomic_load_explicit(&m->short_term_lufs, memory_order_relaxed);
+    reading->integrated_lufs = atomic_load_explicit(&m->integrated_lufs, memory_order_relaxed);
+    reading->frames_metered = atomic_load_explicit(&m->frames_metered, memory_order_relaxed);
+    reading->frames_summarized = atomic_load_explicit(&m->frames_summarized,
+                                                      memory_order_relaxed);
+    reading->frames_dropped = atomic_load_explicit(&m->frames_dropped, memory_order_relaxed);
+}
+
+void meter_stop(meter_t *m) {
+    if (!m->running) {
+        return;
+    }
+    atomic_store_explicit(&m->stopping, true, memory_order_release);
+    pthread_join(m->thread, NULL);
+    m->running = false;
+}
+
+void meter_free(meter_t *m) {
+    if (!m) {
+        return;
+    }
+    meter_stop(m);
+    ring_buffer_free(m->ring);
+    free(m->scratch);
+    free(m);
+}
@@ -0,0 +1,133 @@
+#ifndef METER_H
+#define METER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "ring_buffer.h"
+
+/**
+ * Level and loudness metering off the audio thread.
+ *
+ *   DSP thread --meter_tap--> [side ring] --> meter thread --> atomics
+ *
+ * The tap copies each processed block into a side ring as a raw record
+ * when there is room for it; when there isn't, it writes a summary
+ * record instead (per-channel peak and sum of squares, two floats per
+ * channel whatever the block length); when not even that fits, it drops
+ * the block and counts it. It never waits and takes no locks, so a meter
+ * that falls behind costs the DSP thread nothing but its readings. The
+ * ring is waitable, which puts a fence in each commit; the meter thread
+ * parks for a publish interval's worth of audio and wakes on its timeout
+ * before that arrives, so the tap hardly ever has to wake it.
+ *
+ * The meter thread measures raw records in full: sample peak, true peak
+ * (4x oversampled, BS.1770-4 Annex 2), RMS over 400 ms, and EBU R128
+ * momentary (400 ms), short-term (3 s) and gated integrated loudness
+ * through the K-weighting filter; until a window has filled it covers
+ * what there is. A summary updates the sample peak and RMS exactly and
+ * bounds the true peak by its sample peak, but its energy enters the
+ * loudness unweighted, and the K-weighting filters hold their state
+ * across it; a dropped block is left out of every measurement. Readings
+ * are published through atomics every 100 ms and when the meter stops.
+ */
+
+#define METER_MAX_CHANNELS 8
+#define METER_RING_MS 500             // Default side ring, in audio
+#define METER_SILENCE_DB -200.0f      // Published for nothing measured yet
+
+typedef struct {
+    float peak_db;              // Highest sample so far, dBFS
+    float true_peak_db;         // Highest inter-sample peak so far, dBTP
+    float rms_db;               // Loudest channel over the last 400 ms, dBFS
+    float momentary_lufs;       // Last 400 ms
+    float short_term_lufs;      // Last 3 s
+    float integrated_lufs;      // Everything so far, gated
+    uint64_t frames_metered;    // Frames measured from raw records
+    uint64_t frames_summarized; // Frames that only got through as summaries
+    uint64_t frames_dropped;    // Frames the tap found no room for
+} meter_reading_t;
+
+/**
+ * A K-weighting stage (direct form II transposed), per channel.
+ */
+typedef struct {
+    double b0, b1, b2, a1, a2;
+    double z1[METER_MAX_CHANNELS];
+    double z2[METER_MAX_CHANNELS];
+} meter_biquad_t;
+
+#define METER_WINDOW_BLOCKS 30        // 100 ms sub-blocks in the short-term window
+#define METER_HISTOGRAM_BINS 1000     // 0.1 LU bins from -70 LUFS up
+#define METER_TRUE_PEAK_TAPS 12       // Per phase of the 4x interpolator
+
+typedef struct {
+    unsigned int channels;
+    unsigned int sample_rate;
+    ring_buffer_t *ring;
+    pthread_t thread;
+    bool running;
+    atomic_bool stopping;       // Tap is done; drain and stop
+    atomic_uint_least64_t frames_dropped;   // Tap side
+    
+    // Published by the meter thread
+    _Atomic float peak_db;
+    _Atomic float true_peak_db;
+    _Atomic float rms_db;
+    _Atomic float momentary_lufs;
+    _Atomic float short_term_lufs;
+    _Atomic float integrated_lufs;
+    atomic_uint_least64_t frames_metered;
+    atomic_uint_least64_t frames_summarized;
+    
+    // Meter thread only
+    float *scratch;             // One record, copied out of the ring
+    meter_biquad_t shelf;
+    meter_biquad_t highpass;
+    double weight[METER_MAX_CHANNELS];
+    float history[METER_MAX_CHANNELS][METER_TRUE_PEAK_TAPS];
+    double peak;
+    double true_peak;
+    size_t block_frames;        // Frames per 100 ms sub-block
+    size_t block_fill;          // Frames in the current sub-block
+    double block_loudness;      // Weighted K-filtered energy of the current sub-block
+    double block_squares[METER_MAX_CHANNELS];
+    double loudness[METER_WINDOW_BLOCKS];   // Mean square per finished sub-block
+    double squares[4][METER_MAX_CHANNELS];  // Unweighted, for the RMS window
+    uint64_t blocks;            // Sub-blocks finished
+    uint64_t histogram_count[METER_HISTOGRAM_BINS];
+    double histogram_energy[METER_HISTOGRAM_BINS];
+} meter_t;
+
+/**
+ * Create a meter for channels at sample_rate and start its thread.
+ * ring_frames sizes the side ring (0 = METER_RING_MS worth); it is
+ * rounded up to a power of 2 samples. Returns NULL on failure.
+ */
+meter_t* meter_create(unsigned int channels, unsigned int sample_rate, size_t ring_frames);
+
+/**
+ * Tap side (realtime safe): hand count interleaved frames to the meter,
+ * raw if they fit, else as a summary, else dropped.
+ */
+void meter_tap(meter_t *meter, const float *frames, size_t count);
+
+/**
+ * Snapshot the published readings. Safe from any thread.
+ */
+void meter_read(const meter_t *meter, meter_reading_t *reading);
+
+/**
+ * Tap side, once it has stopped tapping: measure what is queued, publish
+ * the final readings and stop the thread. Idempotent.
+ */
+void meter_stop(meter_t *meter);
+
+/**
+ * Stop the meter if it's still running and free it.
+ */
+void meter_free(meter_t *meter);
+
+#endif // METER_H
@@ -0,0 +1,826 @@
+#define _GNU_SOURCE
+#include "net_audio.h"
+#include "stats.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define NET_AUDIO_PACKET_MS 2.5
+#define NET_AUDIO_MIN_DELAY_MS 5.0
+#define NET_AUDIO_MAX_DELAY_MS 80.0
+#define NET_AUDIO_JITTER_FACTOR 4.0
+#define NET_AUDIO_REORDER 3
+#define NET_AUDIO_SOCKET_BYTES (1 << 20)     // Receive buffer asked for: bursts wait here
+#define NET_AUDIO_IDLE_NS 20000000ull        // Longest the receiver blocks in recvmmsg
+#define NET_AUDIO_RESYNC_SECONDS 1           // A jump this far ahead starts the stream over
+#define NET_AUDIO_SCRATCH_FRAMES 1024        // Reader's input chunk
+
+// Drift and target tracking: the fill error in seconds drives the ratio
+#define NET_AUDIO_FILL_SMOOTHING_S 2.0       // Time constant of the fill average
+#define NET_AUDIO_DRIFT_KP 0.2               // Ratio trim per second of error
+#define NET_AUDIO_DRIFT_KI 0.02              // Per second of error, per second
+#define NET_AUDIO_DRIFT_MAX 0.002            // Clock drift the integral may hold
+#define NET_AUDIO_TRIM_MAX 0.005             // Total trim: drift plus moving the target
+
+static size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+void net_audio_config_init(net_audio_config_t *config) {
+    config->packet_ms = NET_AUDIO_PACKET_MS;
+    config->min_delay_ms = NET_AUDIO_MIN_DELAY_MS;
+    config->max_delay_ms = NET_AUDIO_MAX_DELAY_MS;
+    config->jitter_factor = NET_AUDIO_JITTER_FACTOR;
+    config->reorder_packets = NET_AUDIO_REORDER;
+}
+
+size_t net_audio_packet_frames(const net_audio_config_t *config, unsigned int sample_rate,
+                               unsigned int channels) {
+    size_t most = NET_AUDIO_MAX_PAYLOAD / (channels * sizeof(float));
+    size_t frames = (size_t)llround(config->packet_ms * sample_rate / 1000.0);
+    if (frames < 1) {
+        frames = 1;
+    }
+    return frames < most ? frames : most;
+}
+
+static uint32_t load_be32(const unsigned char *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static void store_be32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+size_t net_audio_pack(unsigned char *packet, const net_audio_header_t *header,
+                      const float *frames, size_t count, unsigned int channels) {
+    packet[0] = 0x80;   // Version 2, no padding, extension or CSRCs
+    packet[1] = (unsigned char)((header->marker ? 0x80 : 0) | NET_AUDIO_PAYLOAD_TYPE);
+    packet[2] = (unsigned char)(header->sequence >> 8);
+    packet[3] = (unsigned char)header->sequence;
+    store_be32(&packet[4], header->timestamp);
+    store_be32(&packet[8], header->ssrc);
+    
+    unsigned char *payload = &packet[NET_AUDIO_HEADER_BYTES];
+    size_t samples = count * channels;
+    for (size_t i = 0; i < samples; i++) {
+        uint32_t bits;
+        memcpy(&bits, &frames[i], sizeof(bits));
+        store_be32(&payload[i * 4], bits);
+    }
+    return NET_AUDIO_HEADER_BYTES + samples * 4;
+}
+
+long net_audio_unpack(const unsigned char *packet, size_t bytes, unsigned int channels,
+                      net_audio_header_t *header, float *frames) {
+    size_t frame_bytes = channels * sizeof(float);
+    if (bytes < NET_AUDIO_HEADER_BYTES || (packet[0] & 0xC0) != 0x80 ||
+        (packet[1] & 0x7F) != NET_AUDIO_PAYLOAD_TYPE) {
+        return -1;
+    }
+    // Skip CSRCs and an extension, should a relay have added them
+    size_t offset = NET_AUDIO_HEADER_BYTES + 4 * (size_t)(packet[0] & 0x0F);
+    if ((packet[0] & 0x10) && offset + 4 <= bytes) {
+        offset += 4 + 4 * (size_t)((packet[offset + 2] << 8) | packet[offset + 3]);
+    }
+    if (offset > bytes) {
+        return -1;
+    }
+    size_t payload = bytes - offset;
+    if ((packet[0] & 0x20) && payload > 0) {
+        size_t padding = packet[bytes - 1];
+        payload = padding <= payload ? payload - padding : 0;
+    }
+    if (payload == 0 || payload % frame_bytes != 0 || payload > NET_AUDIO_MAX_PAYLOAD) {
+        return -1;
+    }
+    
+    header->marker = (packet[1] & 0x80) != 0;
+    header->sequence = (uint16_t)((packet[2] << 8) | packet[3]);
+    header->timestamp = load_be32(&packet[4]);
+    header->ssrc = load_be32(&packet[8]);
+    size_t samples = payload / sizeof(float);
+    for (size_t i = 0; i < samples; i++) {
+        uint32_t bits = load_be32(&packet[offset + i * 4]);
+        memcpy(&frames[i], &bits, sizeof(bits));
+    }
+    return (long)(payload / frame_bytes);
+}
+
+/**
+ * Resolve "host:port", "[v6]:port", ":port" or "port" (passive: no host
+ * means any address). Returns 0 on success.
+ */
+static int net_audio_resolve(const char *text, bool passive, struct sockaddr_storage *addr,
+                             socklen_t *len) {
+    char host[256] = "";
+    const char *port = text;
+    const char *colon = strrchr(text, ':');
+    if (colon) {
+        const char *begin = text;
+        const char *end = colon;
+        if (*begin == '[' && end > begin && end[-1] == ']') {
+            begin++;
+            end--;
+        }
+        size_t n = (size_t)(end - begin);
+        if (n >= sizeof(host)) {
+            return -1;
+        }
+        memcpy(host, begin, n);
+        host[n] = '\0';
+        port = colon + 1;
+    }
+    if (*port == '\0' || (!passive && host[0] == '\0')) {
+        return -1;
+    }
+    
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = (passive ? AI_PASSIVE : 0) | AI_NUMERICSERV;
+    if (getaddrinfo(host[0] ? host : NULL, port, &hints, &result) != 0) {
+        return -1;
+    }
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return 0;
+}
+
+static uint32_t net_audio_random_ssrc(void) {
+    uint64_t x = utils_now_ns() ^ ((uint64_t)getpid() << 32);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return (uint32_t)x;
+}
+
+net_sender_t* net_sender_open(const char *destination, unsigned int channels,
+                              unsigned int sample_rate, const net_audio_config_t *config) {
+    net_audio_config_t defaults;
+    if (!config) {
+        net_audio_config_init(&defaults);
+        config = &defaults;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (channels == 0 || channels > NET_AUDIO_MAX_CHANNELS || sample_rate == 0 ||
+        net_audio_resolve(destination, false, &addr, &addr_len) != 0) {
+        return NULL;
+    }
+    
+    net_sender_t *s = calloc(1, sizeof(net_sender_t));
+    if (!s) {
+        return NULL;
+    }
+    s->channels = channels;
+    s->sample_rate = sample_rate;
+    s->packet_frames = net_audio_packet_frames(config, sample_rate, channels);
+    s->packet_bytes = NET_AUDIO_HEADER_BYTES + s->packet_frames * channels * sizeof(float);
+    s->next.ssrc = net_audio_random_ssrc();
+    s->next.sequence = (uint16_t)s->next.ssrc;
+    s->next.timestamp = s->next.ssrc * 2654435761u;   // Random start, as RFC 3550 asks
+    s->next.marker = true;
+    atomic_init(&s->packets_sent, 0);
+    atomic_init(&s->packets_dropped, 0);
+    
+    s->fd = socket(addr.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    s->staging = malloc(s->packet_frames * channels * sizeof(float));
+    s->packets = malloc(NET_AUDIO_BATCH * s->packet_bytes);
+    s->messages = calloc(NET_AUDIO_BATCH, sizeof(struct mmsghdr));
+    s->vectors = calloc(NET_AUDIO_BATCH, sizeof(struct iovec));
+    if (s->fd < 0 || !s->staging || !s->packets || !s->messages || !s->vectors ||
+        connect(s->fd, (struct sockaddr*)&addr, addr_len) != 0) {
+        net_sender_close(s);
+        return NULL;
+    }
+    for (size_t i = 0; i < NET_AUDIO_BATCH; i++) {
+        s->vectors[i].iov_base = &s->packets[i * s->packet_bytes];
+        s->vectors[i].iov_len = s->packet_bytes;
+        s->messages[i].msg_hdr.msg_iov = &s->vectors[i];
+        s->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    return s;
+}
+
+/**
+ * Send the queued packets in as few sendmmsg calls as the socket takes;
+ * whatever it refuses is dropped.
+ */
+static size_t net_sender_flush(net_sender_t *s) {
+    size_t sent = 0;
+    while (sent < s->queued) {
+        int n = sendmmsg(s->fd, &s->messages[sent], (unsigned int)(s->queued - sent),
+                         MSG_DONTWAIT);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            // Full socket buffer, or an ICMP error from an earlier send
+            // (nobody listening yet): this batch is lost either way
+            break;
+        }
+        sent += (size_t)n;
+    }
+    stats_counter_add(&s->packets_sent, sent);
+    stats_counter_add(&s->packets_dropped, s->queued - sent);
+    s->queued = 0;
+    return sent;
+}
+
+size_t net_sender_send(net_sender_t *s, const float *frames, size_t count) {
+    unsigned int channels = s->channels;
+    size_t sent = 0;
+    
+    while (count > 0) {
+        size_t n = s->packet_frames - s->fill;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(&s->staging[s->fill * channels], frames, n * channels * sizeof(float));
+        s->fill += n;
+        frames += n * channels;
+        count -= n;
+        if (s->fill < s->packet_frames) {
+            break;
+        }
+        
+        net_audio_pack(&s->packets[s->queued * s->packet_bytes], &s->next, s->staging,
+                       s->packet_frames, channels);
+        s->queued++;
+        s->fill = 0;
+        s->next.sequence++;
+        s->next.timestamp += (uint32_t)s->packet_frames;
+        s->next.marker = false;
+        if (s->queued == NET_AUDIO_BATCH) {
+            sent += net_sender_flush(s);
+        }
+    }
+    if (s->queued > 0) {
+        sent += net_sender_flush(s);
+    }
+    return sent;
+}
+
+void net_sender_close(net_sender_t *s) {
+    if (!s) {
+        return;
+    }
+    if (s->fd >= 0) close(s->fd);
+    free(s->staging);
+    free(s->packets);
+    free(s->messages);
+    free(s->vectors);
+    free(s);
+}
+
+/**
+ * Put frames at the end of the ring, or count them if the reader has
+ * stopped taking them. Either way they have had their turn.
+ */
+static void rx_write(net_receiver_t *r, const float *frames, size_t count) {
+    if (frame_ring_write_available(r->ring) < count) {
+        stats_counter_add(&r->frames_overflowed, count);
+    } else {
+        frame_ring_f32_write(r->ring, frames, count);
+    }
+    r->next_timestamp += (uint32_t)count;
+}
+
+static void rx_deliver(net_receiver_t *r, float *frames, size_t count) {
+    unsigned int channels = r->channels;
+    
+    // Back from concealment: fade in rather than step from silence
+    if (r->fade_in) {
+        size_t ramp = count < r->fade_frames ? count : r->fade_frames;
+        for (size_t i = 0; i < ramp; i++) {
+            float gain = (float)(i + 1) / (float)(ramp + 1);
+            for (unsigned int c = 0; c < channels; c++) {
+                frames[i * channels + c] *= gain;
+            }
+        }
+        r->fade_in = false;
+    }
+    rx_write(r, frames, count);
+    memcpy(r->last, frames, count * channels * sizeof(float));
+    r->last_frames = count;
+    r->conceal_pos = 0;
+}
+
+/**
+ * Fill the gap up to timestamp: the last packet over and over, fading out
+ * across NET_AUDIO_FADE_MS of the gap (continuing where an earlier gap
+ * left off), then silence.
+ */
+static void rx_conceal(net_receiver_t *r, uint32_t timestamp) {
+    unsigned int channels = r->channels;
+    size_t gap = (uint32_t)(timestamp - r->next_timestamp);
+    stats_counter_add(&r->frames_lost_concealed, gap);
+    
+    while (gap > 0) {
+        size_t n = gap < r->max_packet_frames ? gap : r->max_packet_frames;
+        for (size_t i = 0; i < n; i++) {
+            size_t pos = r->conceal_pos + i;
+            float gain = pos < r->fade_frames
+                ? 1.0f - (float)(pos + 1) / (float)r->fade_frames : 0.0f;
+            for (unsigned int c = 0; c < channels; c++) {
+                float x = r->last_frames ? r->last[(pos % r->last_frames) * channels + c] : 0.0f;
+                r->decoded[i * channels + c] = x * gain;
+            }
+        }
+        rx_write(r, r->decoded, n);
+        r->conceal_pos += n;
+        gap -= n;
+    }
+    r->fade_in = true;
+}
+
+/**
+ * Write out stashed packets for as long as the next one is there.
+ */
+static void rx_drain(net_receiver_t *r) {
+    unsigned int depth = r->config.reorder_packets + 1;
+    bool found = true;
+    while (found) {
+        found = false;
+        for (unsigned int i = 0; i < depth; i++) {
+            net_audio_slot_t *slot = &r->slots[i];
+            if (slot->used && slot->timestamp == r->next_timestamp) {
+                rx_deliver(r, slot->samples, slot->frames);
+                slot->used = false;
+                found = true;
+            }
+        }
+    }
+}
+
+static void rx_resync(net_receiver_t *r, const net_audio_header_t *header) {
+    if (r->synced) {
+        stats_counter_add(&r->resyncs, 1);
+        r->fade_in = true;
+    }
+    r->synced = true;
+    r->ssrc = header->ssrc;
+    r->next_timestamp = header->timestamp;
+    r->highest_timestamp = header->timestamp;
+    r->have_arrival = false;
+    for (unsigned int i = 0; i <= r->config.reorder_packets; i++) {
+        r->slots[i].used = false;
+    }
+}
+
+/**
+ * RFC 3550 interarrival jitter, and the buffer target it calls for.
+ */
+static void rx_track_jitter(net_receiver_t *r, uint32_t timestamp, size_t frames,
+                            uint64_t arrival_ns) {
+    if (r->have_arrival) {
+        double elapsed = (double)(int64_t)(arrival_ns - r->last_arrival_ns) * 1e-9 *
+                         r->sample_rate;
+        double d = elapsed - (double)(int32_t)(timestamp - r->last_timestamp);
+        r->jitter += (fabs(d) - r->jitter) / 16.0;
+    }
+    r->have_arrival = true;
+    r->last_arrival_ns = arrival_ns;
+    r->last_timestamp = timestamp;
+    
+    double rate = r->sample_rate / 1000.0;
+    double target = r->config.jitter_factor * r->jitter + (double)frames;
+    target = fmax(target, r->config.min_delay_ms * rate);
+    target = fmin(target, r->config.max_delay_ms * rate);
+    atomic_store_explicit(&r->target_frames, (size_t)target, memory_order_relaxed);
+    atomic_store_explicit(&r->jitter_ms, (float)(r->jitter / rate), memory_order_relaxed);
+}
+
+static void rx_packet(net_receiver_t *r, const net_audio_header_t *header, size_t frames,
+                      uint64_t arrival_ns) {
+    stats_counter_add(&r->packets_received, 1);
+    if (!r->synced || header->ssrc != r->ssrc) {
+        rx_resync(r, header);
+    }
+    int32_t ahead = (int32_t)(header->timestamp - r->next_timestamp);
+    if (ahead < 0) {
+        stats_counter_add(&r->packets_late, 1);
+        return;
+    }
+    if (ahead > (int32_t)(r->sample_rate * NET_AUDIO_RESYNC_SECONDS)) {
+        rx_resync(r, header);
+        ahead = 0;
+    }
+    rx_track_jitter(r, header->timestamp, frames, arrival_ns);
+    
+    uint32_t end = header->timestamp + (uint32_t)frames;
+    if ((int32_t)(end - r->highest_timestamp) < 0) {
+        stats_counter_add(&r->packets_reordered, 1);
+    } else {
+        r->highest_timestamp = end;
+    }
+    
+    if (ahead == 0) {
+        rx_deliver(r, r->decoded, frames);
+        rx_drain(r);
+        return;
+    }
+    
+    // Ahead of a gap: stash it until the gap fills or is given up on
+    unsigned int depth = r->config.reorder_packets + 1;
+    net_audio_slot_t *free_slot = NULL;
+    unsigned int stashed = 1;
+    for (unsigned int i = 0; i < depth; i++) {
+        net_audio_slot_t *slot = &r->slots[i];
+        if (!slot->used) {
+            free_slot = free_slot ? free_slot : slot;
+        } else if (slot->timestamp == header->timestamp) {
+            stats_counter_add(&r->packets_late, 1);   // A duplicate
+            return;
+        } else {
+            stashed++;
+        }
+    }
+    free_slot->timestamp = header->timestamp;
+    free_slot->frames = frames;
+    free_slot->used = true;
+    memcpy(free_slot->samples, r->decoded, frames * r->channels * sizeof(float));
+    
+    while (stashed > r->config.reorder_packets) {
+        // Enough has overtaken the gap: it's lost. Conceal up to the
+        // earliest stashed packet and carry on from there
+        net_audio_slot_t *earliest = NULL;
+        for (unsigned int i = 0; i < depth; i++) {
+            net_audio_slot_t *slot = &r->slots[i];
+            if (slot->used && (!earliest ||
+                               (int32_t)(slot->timestamp - earliest->timestamp) < 0)) {
+                earliest = slot;
+            }
+        }
+        size_t gap = (uint32_t)(earliest->timestamp - r->next_timestamp);
+        size_t typical = r->last_frames ? r->last_frames : earliest->frames;
+        stats_counter_add(&r->packets_lost, (gap + typical - 1) / typical);
+        rx_conceal(r, earliest->timestamp);
+        rx_drain(r);
+        
+        stashed = 0;
+        for (unsigned int i = 0; i < depth; i++) {
+            stashed += r->slots[i].used;
+        }
+    }
+}
+
+/**
+ * When the kernel received the message (SO_TIMESTAMPNS), else now.
+ */
+static uint64_t rx_arrival_ns(struct msghdr *msg) {
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        }
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+#define NET_AUDIO_PACKET_BYTES 2048          // Receive buffer per packet
+#define NET_AUDIO_CONTROL_BYTES 64           // Room for one timestamp cmsg
+
+static void* net_receiver_thread(void *arg) {
+    net_receiver_t *r = (net_receiver_t*)arg;
+    
+    while (atomic_load_explicit(&r->running, memory_order_relaxed)) {
+        for (size_t i = 0; i < NET_AUDIO_BATCH; i++) {
+            r->messages[i].msg_hdr.msg_controllen = NET_AUDIO_CONTROL_BYTES;
+            r->messages[i].msg_len = 0;
+        }
+        // Blocks (up to SO_RCVTIMEO) for the first, then takes what's queued
+        int n = recvmmsg(r->fd, r->messages, NET_AUDIO_BATCH, MSG_WAITFORONE, NULL);
+        if (n <= 0) {
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            net_audio_header_t header;
+            long frames = net_audio_unpack(&r->packets[i * NET_AUDIO_PACKET_BYTES],
+                                           r->messages[i].msg_len, r->channels, &header,
+                                           r->decoded);
+            if (frames > 0) {
+                rx_packet(r, &header, (size_t)frames, rx_arrival_ns(&r->messages[i].msg_hdr));
+            }
+        }
+    }
+    return NULL;
+}
+
+net_receiver_t* net_receiver_open(const char *address, unsigned int channels,
+                                  unsigned int sample_rate, const net_audio_config_t *config) {
+    net_audio_config_t defaults;
+    if (!config) {
+        net_audio_config_init(&defaults);
+        config = &defaults;
+    }
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (channels == 0 || channels > NET_AUDIO_MAX_CHANNELS || sample_rate == 0 ||
+        config->min_delay_ms > config->max_delay_ms ||
+        net_audio_resolve(address, true, &addr, &addr_len) != 0) {
+        return NULL;
+    }
+    
+    net_receiver_t *r = calloc(1, sizeof(net_receiver_t));
+    if (!r) {
+        return NULL;
+    }
+    r->channels = channels;
+    r->sample_rate = sample_rate;
+    r->config = *config;
+    r->max_packet_frames = NET_AUDIO_MAX_PAYLOAD / (channels * sizeof(float));
+    r->fade_frames = (size_t)(NET_AUDIO_FADE_MS * sample_rate / 1000.0);
+    if (r->fade_frames < 1) {
+        r->fade_frames = 1;
+    }
+    atomic_init(&r->running, false);
+    atomic_init(&r->packets_received, 0);
+    atomic_init(&r->packets_lost, 0);
+    atomic_init(&r->packets_late, 0);
+    atomic_init(&r->packets_reordered, 0);
+    atomic_init(&r->frames_lost_concealed, 0);
+    atomic_init(&r->frames_overflowed, 0);
+    atomic_init(&r->resyncs, 0);
+    atomic_init(&r->target_frames,
+                (size_t)(config->min_delay_ms * sample_rate / 1000.0));
+    atomic_init(&r->jitter_ms, 0.0f);
+    atomic_init(&r->underruns, 0);
+    atomic_init(&r->frames_underrun_concealed, 0);
+    atomic_init(&r->frames_skipped, 0);
+    atomic_init(&r->delay_frames, 0);
+    atomic_init(&r->delay_sum, 0);
+    atomic_init(&r->delay_reads, 0);
+    atomic_init(&r->drift_ppm, 0.0f);
+    
+    // Room for the longest buffer, a burst of packets on top and the
+    // reader's chunk
+    size_t max_delay = (size_t)(config->max_delay_ms * sample_rate / 1000.0);
+    size_t ring_frames = max_delay + NET_AUDIO_BATCH * r->max_packet_frames +
+                         NET_AUDIO_SCRATCH_FRAMES;
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.prefault = true;
+    r->ring = frame_ring_f32_create(next_power_of_2(ring_frames), channels, &options);
+    
+    unsigned int depth = config->reorder_packets + 1;
+    size_t packet_samples = r->max_packet_frames * channels;
+    r->slots = calloc(depth, sizeof(net_audio_slot_t));
+    float *slot_samples = malloc(depth * packet_samples * sizeof(float));
+    r->decoded = malloc(packet_samples * sizeof(float));
+    r->last = malloc(packet_samples * sizeof(float));
+    r->packets = malloc(NET_AUDIO_BATCH * NET_AUDIO_PACKET_BYTES);
+    r->control = calloc(NET_AUDIO_BATCH, NET_AUDIO_CONTROL_BYTES);
+    r->messages = calloc(NET_AUDIO_BATCH, sizeof(struct mmsghdr));
+    r->vectors = calloc(NET_AUDIO_BATCH, sizeof(struct iovec));
+    r->resampler = resampler_create(channels, sample_rate, sample_rate);
+    r->scratch_frames = NET_AUDIO_SCRATCH_FRAMES;
+    r->scratch = malloc(r->scratch_frames * channels * sizeof(float));
+    r->fd = socket(addr.ss_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (r->slots) {
+        for (unsigned int i = 0; i < depth; i++) {
+            r->slots[i].samples = slot_samples ? &slot_samples[i * packet_samples] : NULL;
+        }
+    } else {
+        free(slot_samples);
+    }
+    if (!r->ring || !r->slots || !slot_samples || !r->decoded || !r->last || !r->packets ||
+        !r->control || !r->messages || !r->vectors || !r->resampler || !r->scratch ||
+        r->fd < 0) {
+        net_receiver_close(r);
+        return NULL;
+    }
+    
+    // Best effort: a deep socket buffer rides out bursts, kernel receive
+    // times keep scheduling delay out of the jitter estimate
+    int bytes = NET_AUDIO_SOCKET_BYTES, on = 1;
+    setsockopt(r->fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+    setsockopt(r->fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    setsockopt(r->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct timeval idle = { 0, (suseconds_t)(NET_AUDIO_IDLE_NS / 1000) };
+    setsockopt(r->fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+    if (bind(r->fd, (struct sockaddr*)&addr, addr_len) != 0) {
+        net_receiver_close(r);
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < NET_AUDIO_BATCH; i++) {
+        r->vectors[i].iov_base = &r->packets[i * NET_AUDIO_PACKET_BYTES];
+        r->vectors[i].iov_len = NET_AUDIO_PACKET_BYTES;
+        r->messages[i].msg_hdr.msg_iov = &r->vectors[i];
+        r->messages[i].msg_hdr.msg_iovlen = 1;
+        r->messages[i].msg_hdr.msg_control = &r->control[i * NET_AUDIO_CONTROL_BYTES];
+    }
+    
+    atomic_store(&r->running, true);
+    if (pthread_create(&r->thread, NULL, net_receiver_thread, r) != 0) {
+        net_receiver_close(r);
+        return NULL;
+    }
+    r->started = true;
+    return r;
+}
+
+unsigned int net_receiver_port(const net_receiver_t *r) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(r->fd, (struct sockaddr*)&addr, &len) != 0) {
+        return 0;
+    }
+    if (addr.ss_family == AF_INET6) {
+        return ntohs(((struct sockaddr_in6*)&addr)->sin6_port);
+    }
+    return ntohs(((struct sockaddr_in*)&addr)->sin_port);
+}
+
+/**
+ * Frames waiting for the reader: in the ring, taken out but not yet
+ * resampled, and in the resampler's history but not yet played.
+ */
+static size_t rx_fill(net_receiver_t *r) {
+    double history = (double)r->resampler->filled - r->resampler->pos;
+    return frame_ring_read_available(r->ring) + r->pending +
+           (history > 0.0 ? (size_t)history : 0);
+}
+
+/**
+ * Throw away the oldest frames, pending ones first.
+ */
+static void rx_skip(net_receiver_t *r, size_t frames) {
+    stats_counter_add(&r->frames_skipped, frames);
+    size_t n = frames < r->pending ? frames : r->pending;
+    r->pending_offset += n;
+    r->pending -= n;
+    frames -= n;
+    if (frames > 0) {
+        frame_ring_span_t span;
+        frame_ring_read_release(r->ring, frame_ring_read_acquire(r->ring, frames, &span));
+    }
+}
+
+/**
+ * Steer the resampler so the fill settles on the target: above it, each
+ * output frame takes a little more input and the buffer drains; below
+ * it, a little less. The integral ends up holding the clocks' drift.
+ */
+static void rx_steer(net_receiver_t *r, size_t fill, size_t target, size_t count) {
+    double alpha = (double)count / (r->sample_rate * NET_AUDIO_FILL_SMOOTHING_S);
+    r->fill_avg += ((double)fill - r->fill_avg) * (alpha < 1.0 ? alpha : 1.0);
+    
+    double error = (r->fill_avg - (double)target) / r->sample_rate;
+    double seconds = (double)count / r->sample_rate;
+    r->integral += error * NET_AUDIO_DRIFT_KI * seconds;
+    r->integral = fmax(-NET_AUDIO_DRIFT_MAX, fmin(NET_AUDIO_DRIFT_MAX, r->integral));
+    double trim = error * NET_AUDIO_DRIFT_KP + r->integral;
+    trim = fmax(-NET_AUDIO_TRIM_MAX, fmin(NET_AUDIO_TRIM_MAX, trim));
+    resampler_set_correction(r->resampler, 1.0 + trim);
+    atomic_store_explicit(&r->drift_ppm, (float)(r->integral * 1e6), memory_order_relaxed);
+}
+
+size_t net_receiver_read(net_receiver_t *r, float *out, size_t count) {
+    unsigned int channels = r->channels;
+    size_t target = atomic_load_explicit(&r->target_frames, memory_order_relaxed);
+    size_t fill = rx_fill(r);
+    size_t max_delay = (size_t)(r->config.max_delay_ms * r->sample_rate / 1000.0);
+    
+    if (!r->playing) {
+        if (fill < target) {
+            memset(out, 0, count * channels * sizeof(float));
+            return count;
+        }
+        // Start from the target, not from however much piled up meanwhile
+        if (fill > target) {
+            rx_skip(r, fill - target);
+            fill = target;
+        }
+        r->playing = true;
+        r->fill_avg = (double)fill;
+    } else if (fill > max_delay + r->max_packet_frames) {
+        rx_skip(r, fill - target);
+        fill = target;
+        r->fill_avg = (double)fill;
+    }
+    rx_steer(r, fill, target, count);
+    
+    size_t done = 0;
+    while (done < count) {
+        if (r->pending == 0) {
+            size_t n = frame_ring_f32_read(r->ring, r->scratch, r->scratch_frames);
+            if (n == 0) {
+                break;
+            }
+            r->pending_offset = 0;
+            r->pending = n;
+        }
+        size_t used;
+        done += resampler_process(r->resampler, &r->scratch[r->pending_offset * channels],
+                                  r->pending, &used, &out[done * channels], count - done);
+        r->pending_offset += used;
+        r->pending -= used;
+    }
+    
+    if (r->resume_fade) {
+        size_t ramp = done < r->fade_frames ? done : r->fade_frames;
+        for (size_t i = 0; i < ramp; i++) {
+            float gain = (float)(i + 1) / (float)(ramp + 1);
+            for (unsigned int c = 0; c < channels; c++) {
+                out[i * channels + c] *= gain;
+            }
+        }
+        r->resume_fade = false;
+    }
+    if (done > 0) {
+        memcpy(r->held, &out[(done - 1) * channels], channels * sizeof(float));
+    }
+    if (done < count) {
+        // Ran dry: fade the last frame out, then buffer up again
+        for (size_t i = done; i < count; i++) {
+            size_t pos = i - done;
+            float gain = pos < r->fade_frames
+                ? 1.0f - (float)(pos + 1) / (float)r->fade_frames : 0.0f;
+            for (unsigned int c = 0; c < channels; c++) {
+                out[i * channels + c] = r->held[c] * gain;
+            }
+        }
+        stats_counter_add(&r->underruns, 1);
+        stats_counter_add(&r->frames_underrun_concealed, count - done);
+        memset(r->held, 0, sizeof(r->held));
+        r->playing = false;
+        r->resume_fade = true;
+    }
+    
+    size_t delay = rx_fill(r) + net_audio_packet_frames(&r->config, r->sample_rate, channels);
+    atomic_store_explicit(&r->delay_frames, delay, memory_order_relaxed);
+    stats_counter_add(&r->delay_sum, delay);
+    stats_counter_add(&r->delay_reads, 1);
+    return count;
+}
+
+void net_receiver_stats(const net_receiver_t *r, net_receiver_stats_t *stats) {
+    double rate = r->sample_rate / 1000.0;
+    stats->packets_received = atomic_load_explicit(&r->packets_received, memory_order_relaxed);
+    stats->packets_lost = atomic_load_explicit(&r->packets_lost, memory_order_relaxed);
+    stats->packets_late = atomic_load_explicit(&r->packets_late, memory_order_relaxed);
+    stats->packets_reordered = atomic_load_explicit(&r->packets_reordered, memory_order_relaxed);
+    stats->frames_concealed =
+        atomic_load_explicit(&r->frames_lost_concealed, memory_order_relaxed) +
+        atomic_load_explicit(&r->frames_underrun_concealed, memory_order_relaxed);
+    stats->frames_overflowed = atomic_load_explicit(&r->frames_overflowed, memory_order_relaxed);
+    stats->frames_skipped = atomic_load_explicit(&r->frames_skipped, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&r->underruns, memory_order_relaxed);
+    stats->resyncs = atomic_load_explicit(&r->resyncs, memory_order_relaxed);
+    stats->jitter_ms = atomic_load_explicit(&r->jitter_ms, memory_order_relaxed);
+    stats->target_ms = atomic_load_explicit(&r->target_frames, memory_order_relaxed) / rate;
+    stats->latency_ms = atomic_load_explicit(&r->delay_frames, memory_order_relaxed) / rate;
+    uint64_t reads = atomic_load_explicit(&r->delay_reads, memory_order_relaxed);
+    stats->latency_ms_avg = reads
+        ? atomic_load_explicit(&r->delay_sum, memory_order_relaxed) / (double)reads / rate
+        : 0.0;
+    stats->drift_ppm = atomic_load_explicit(&r->drift_ppm, memory_order_relaxed);
+}
+
+void net_receiver_close(net_receiver_t *r) {
+    if (!r) {
+        return;
+    }
+    if (r->started) {
+        atomic_store(&r->running, false);
+        pthread_join(r->thread, NULL);
+    }
+    if (r->fd >= 0) close(r->fd);
+    frame_ring_free(r->ring);
+    if (r->slots) {
+        free(r->slots[0].samples);
+    }
+    free(r->slots);
+    free(r->decoded);
+    free(r->last);
+    free(r->packets);
+    free(r->control);
+    free(r->messages);
+    free(r->vectors);
+    resampler_free(r->resampler);
+    free(r->scratch);
+    free(r);
+}
@@ -0,0 +1,261 @@
+#ifndef NET_AUDIO_H
+#define NET_AUDIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "frame_ring.h"
+#include "resampler.h"
+
+/**
+ * Audio over UDP between hosts: capture on an edge box, process on a
+ * server.
+ *
+ *   sender --[UDP, sendmmsg]--> receiver thread --[jitter ring]--> reader
+ *
+ * Packets are RTP-shaped: the 12-byte fixed header (version 2, dynamic
+ * payload type NET_AUDIO_PAYLOAD_TYPE, sequence number, a timestamp
+ * counting frames, SSRC) followed by interleaved big-endian 32-bit float
+ * samples. The rate and channel count aren't carried; both ends are
+ * configured alike.
+ *
+ * The sender packs each block it is handed into packets of packet_frames
+ * and sends all the whole ones with a single sendmmsg; a partial packet
+ * waits for the next block. Sends never block: what the socket refuses is
+ * dropped and counted.
+ *
+ * The receiver thread takes packets up to NET_AUDIO_BATCH at a time with
+ * recvmmsg, in kernel arrival time order (SO_TIMESTAMPNS), and writes
+ * them into a frame ring in stream order. A packet that arrives ahead
+ * of a gap waits in a small reorder stash; once reorder_packets later ones
+ * have arrived the gap is taken as lost and concealed: the last packet is
+ * repeated, fading out over NET_AUDIO_FADE_MS, and the packet after it
+ * fades back in. A packet behind what has already been written is late
+ * and dropped. A new SSRC (the sender restarted) or a jump of more than
+ * a second starts the stream over.
+ *
+ * The reader (the consumer's clock, e.g. a capture thread paced by the
+ * local clock) pulls frames through a resampler. The ring's fill is the
+ * jitter buffer: the reader waits until it reaches the target before it
+ * starts, then steers the resampler's ratio so the fill holds the target.
+ * That follows the sender's clock wherever it drifts, and moves the
+ * buffer to a new target smoothly. The target adapts to the network:
+ * jitter_factor times the RFC 3550 interarrival jitter plus a packet,
+ * within [min_delay_ms, max_delay_ms]. If the ring runs dry, the reader
+ * fades out, counts an underrun and buffers up to the target again.
+ * Reading never blocks, allocates or makes a syscall.
+ */
+
+#define NET_AUDIO_PORT 5004
+#define NET_AUDIO_HEADER_BYTES 12     // RTP fixed header
+#define NET_AUDIO_MAX_PAYLOAD 1400    // Bytes of samples per packet: fits a 1500-byte MTU
+#define NET_AUDIO_PAYLOAD_TYPE 96     // Dynamic: there is no static type for float samples
+#define NET_AUDIO_BATCH 32            // Packets per sendmmsg/recvmmsg
+#define NET_AUDIO_FADE_MS 5.0         // Concealment fade-out and fade-in
+#define NET_AUDIO_MAX_CHANNELS 8
+
+struct mmsghdr;
+struct iovec;
+
+typedef struct {
+    double packet_ms;           // Audio per packet (capped to fit NET_AUDIO_MAX_PAYLOAD)
+    double min_delay_ms;        // Jitter buffer target bounds
+    double max_delay_ms;
+    double jitter_factor;       // Target = factor * jitter + one packet
+    unsigned int reorder_packets;   // Later packets that must arrive before a gap is lost
+} net_audio_config_t;
+
+typedef struct {
+    uint16_t sequence;
+    uint32_t timestamp;         // Frame index of the first frame
+    uint32_t ssrc;
+    bool marker;                // First packet of a stream
+} net_audio_header_t;
+
+typedef struct {
+    int fd;
+    unsigned int channels;
+    unsigned int sample_rate;
+    size_t packet_frames;
+    size_t packet_bytes;
+    
+    net_audio_header_t next;    // Header of the packet being filled
+    float *staging;             // The packet being filled, host order
+    size_t fill;                // Frames in it
+    unsigned char *packets;     // NET_AUDIO_BATCH packed packets awaiting sendmmsg
+    size_t queued;
+    struct mmsghdr *messages;   // NET_AUDIO_BATCH of each
+    struct iovec *vectors;
+    
+    atomic_uint_least64_t packets_sent;
+    atomic_uint_least64_t packets_dropped;  // Refused by the socket
+} net_sender_t;
+
+typedef struct {
+    uint64_t packets_received;
+    uint64_t packets_lost;      // Never arrived in time: concealed
+    uint64_t packets_late;      // Arrived after their place was written (or twice)
+    uint64_t packets_reordered; // Arrived out of order, still in time
+    uint64_t frames_concealed;  // Loss and underrun concealment together
+    uint64_t frames_overflowed; // Dropped on a full ring (reader stalled)
+    uint64_t frames_skipped;    // Dropped by the reader to get back under max_delay_ms
+    uint64_t underruns;         // Ring ran dry: concealed, then rebuffered
+    uint64_t resyncs;           // Streams started over
+    double jitter_ms;           // RFC 3550 interarrival jitter
+    double target_ms;           // Jitter buffer target
+    double latency_ms;          // Buffered plus one packet: what the network adds
+    double latency_ms_avg;      // Average of latency_ms over every read while playing
+    double drift_ppm;           // Sender clock against the reader's (+ = sender fast)
+} net_receiver_stats_t;
+
+typedef struct {
+    uint32_t timestamp;
+    size_t frames;
+    bool used;
+    float *samples;
+} net_audio_slot_t;
+
+typedef struct {
+    int fd;
+    unsigned int channels;
+    unsigned int sample_rate;
+    net_audio_config_t config;
+    size_t max_packet_frames;   // What a packet can hold
+    size_t fade_frames;
+    frame_ring_t *ring;         // Receiver thread -> reader, in stream order
+    pthread_t thread;
+    bool started;
+    atomic_bool running;
+    
+    // Receiver thread only
+    unsigned char *packets;     // NET_AUDIO_BATCH receive buffers
+    unsigned char *control;     // Their timestamp cmsgs
+    struct mmsghdr *messages;
+    struct iovec *vectors;
+    float *decoded;             // One packet, host order
+    net_audio_slot_t *slots;    // Reorder stash, reorder_packets + 1 deep
+    bool synced;
+    uint32_t ssrc;
+    uint32_t next_timestamp;    // First frame not yet written to the ring
+    uint32_t highest_timestamp; // End of the furthest packet seen
+    float *last;                // Last packet written, for concealment
+    size_t last_frames;
+    size_t conceal_pos;         // Frames concealed since the last real packet
+    bool fade_in;               // The next real packet follows concealment
+    bool have_arrival;
+    uint64_t last_arrival_ns;   // Kernel receive time of the previous packet (realtime)
+    uint32_t last_timestamp;    // And its timestamp
+    double jitter;              // RFC 3550 estimate, in frames
+    
+    // Published by the receiver thread
+    atomic_uint_least64_t packets_received;
+    atomic_uint_least64_t packets_lost;
+    atomic_uint_least64_t packets_late;
+    atomic_uint_least64_t packets_reordered;
+    atomic_uint_least64_t frames_lost_concealed;
+    atomic_uint_least64_t frames_overflowed;
+    atomic_uint_least64_t resyncs;
+    atomic_size_t target_frames;
+    _Atomic float jitter_ms;
+    
+    // Reader only
+    resampler_t *resampler;
+    float *scratch;             // Input taken from the ring, not yet resampled
+    size_t scratch_frames;
+    size_t pending_offset;
+    size_t pending;
+    bool playing;
+    bool resume_fade;           // Fade the next output in (after an underrun)
+    float held[NET_AUDIO_MAX_CHANNELS];   // Last frame put out, faded on underrun
+    double fill_avg;
+    double integral;
+    
+    // Published by the reader
+    atomic_uint_least64_t underruns;
+    atomic_uint_least64_t frames_underrun_concealed;
+    atomic_uint_least64_t frames_skipped;
+    atomic_size_t delay_frames;
+    atomic_uint_least64_t delay_sum;
+    atomic_uint_least64_t delay_reads;
+    _Atomic float drift_ppm;
+} net_receiver_t;
+
+/**
+ * Defaults: 2.5 ms packets, a 5-80 ms jitter buffer at 4x the jitter,
+ * gaps concealed after 3 later packets.
+ */
+void net_audio_config_init(net_audio_config_t *config);
+
+/**
+ * Frames per packet for config at sample_rate and channels: packet_ms
+ * worth, at least 1, at most what NET_AUDIO_MAX_PAYLOAD holds.
+ */
+size_t net_audio_packet_frames(const net_audio_config_t *config, unsigned int sample_rate,
+                               unsigned int channels);
+
+/**
+ * Write header and count frames into packet (NET_AUDIO_HEADER_BYTES plus
+ * 4 bytes per sample). Returns the packet's length.
+ */
+size_t net_audio_pack(unsigned char *packet, const net_audio_header_t *header,
+                      const float *frames, size_t count, unsigned int channels);
+
+/**
+ * Parse a packet of bytes into header and frames (room for
+ * NET_AUDIO_MAX_PAYLOAD bytes of samples). Returns the frames it holds,
+ * or -1 if it isn't one of ours for channels.
+ */
+long net_audio_unpack(const unsigned char *packet, size_t bytes, unsigned int channels,
+                      net_audio_header_t *header, float *frames);
+
+/**
+ * Connect a sender to destination, "host:port" ("[v6]:port" for IPv6
+ * literals). config may be NULL for the defaults. Returns NULL on failure.
+ */
+net_sender_t* net_sender_open(const char *destination, unsigned int channels,
+                              unsigned int sample_rate, const net_audio_config_t *config);
+
+/**
+ * Queue count interleaved frames and send every whole packet in one
+ * sendmmsg. Never blocks. Returns the packets sent by this call.
+ */
+size_t net_sender_send(net_sender_t *sender, const float *frames, size_t count);
+
+/**
+ * Close the socket and free the sender. A partial packet is dropped.
+ */
+void net_sender_close(net_sender_t *sender);
+
+/**
+ * Bind a receiver to address, "[host:]port" (port 0 picks a free one;
+ * see net_receiver_port), and start its thread. config may be NULL for
+ * the defaults. Returns NULL on failure.
+ */
+net_receiver_t* net_receiver_open(const char *address, unsigned int channels,
+                                  unsigned int sample_rate, const net_audio_config_t *config);
+
+/**
+ * The UDP port the receiver is bound to.
+ */
+unsigned int net_receiver_port(const net_receiver_t *receiver);
+
+/**
+ * Reader side (realtime safe): fill out with count interleaved frames,
+ * silence while buffering and concealment where the ring runs dry.
+ * Always returns count.
+ */
+size_t net_receiver_read(net_receiver_t *receiver, float *out, size_t count);
+
+/**
+ * Snapshot the counters. Safe from any thread.
+ */
+void net_receiver_stats(const net_receiver_t *receiver, net_receiver_stats_t *stats);
+
+/**
+ * Stop the thread, close the socket and free the receiver.
+ */
+void net_receiver_close(net_receiver_t *receiver);
+
+#endif // NET_AUDIO_H
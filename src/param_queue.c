@@ -0,0 +1,98 @@
+#include "param_queue.h"
+#include <stdlib.h>
+#include <math.h>
+
+param_queue_t* param_queue_create(size_t capacity, float sample_rate, unsigned int channels) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        channels == 0 || channels > EFFECT_MAX_CHANNELS) {
+        return NULL;
+    }
+    
+    param_queue_t *queue = malloc(sizeof(param_queue_t));
+    if (!queue) {
+        return NULL;
+    }
+    
+    queue->ring = frame_ring_create(capacity, sizeof(param_update_t), 1, 0, NULL);
+    if (!queue->ring) {
+        free(queue);
+        return NULL;
+    }
+    
+    queue->sample_rate = sample_rate;
+    queue->channels = channels;
+    return queue;
+}
+
+void param_queue_free(param_queue_t *queue) {
+    if (queue) {
+        frame_ring_free(queue->ring);
+        free(queue);
+    }
+}
+
+bool param_queue_push(param_queue_t *queue, const param_update_t *update) {
+    return frame_ring_write(queue->ring, update, 1) == 1;
+}
+
+bool param_queue_pop(param_queue_t *queue, param_update_t *update) {
+    return frame_ring_read(queue->ring, update, 1) == 1;
+}
+
+int param_queue_set_gain(param_queue_t *queue, float gain_db) {
+    param_update_t update = { .type = PARAM_GAIN };
+    update.value.gain = powf(10.0f, gain_db / 20.0f);
+    return param_queue_push(queue, &update) ? 0 : -1;
+}
+
+int param_queue_set_filter(param_queue_t *queue, float lowpass_freq, float highpass_freq,
+                           unsigned int order) {
+    param_update_t update = { .type = PARAM_FILTER };
+    int result;
+    
+    if (lowpass_freq > 0) {
+        result = biquad_cascade_lowpass(&update.value.filter, queue->sample_rate,
+                                        lowpass_freq, order, queue->channels);
+    } else if (highpass_freq > 0) {
+        result = biquad_cascade_highpass(&update.value.filter, queue->sample_rate,
+                                         highpass_freq, order, queue->channels);
+    } else {
+        update.type = PARAM_FILTER_OFF;
+        result = 0;
+    }
+    
+    if (result != 0) {
+        return -1;
+    }
+    return param_queue_push(queue, &update) ? 0 : -1;
+}
+
+int param_queue_set_compressor(param_queue_t *queue, bool enabled) {
+    param_update_t update = { .type = PARAM_COMPRESSOR };
+    update.value.enabled = enabled;
+    return param_queue_push(queue, &update) ? 0 : -1;
+}
+
+size_t param_queue_apply(param_queue_t *queue, effect_chain_t *chain) {
+    param_update_t update;
+    size_t applied = 0;
+    
+    while (param_queue_pop(queue, &update)) {
+        switch (update.type) {
+            case PARAM_GAIN:
+                effect_chain_set_gain(chain, update.value.gain);
+                break;
+            case PARAM_FILTER:
+                effect_chain_set_filter(chain, &update.value.filter);
+                break;
+            case PARAM_FILTER_OFF:
+                effect_chain_set_filter(chain, NULL);
+                break;
+            case PARAM_COMPRESSOR:
+                effect_chain_set_compressor(chain, update.value.enabled);
+                break;
+        }
+        applied++;
+    }
+    return applied;
+}
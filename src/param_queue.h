@@ -0,0 +1,85 @@
+#ifndef PARAM_QUEUE_H
+#define PARAM_QUEUE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "effects.h"
+#include "frame_ring.h"
+
+/**
+ * Lock-free SPSC queue of effect parameter updates, from a control thread
+ * (UI, stdin, network) to the audio thread.
+ *
+ * The control side does the expensive work: dB conversion and filter
+ * design (cosf/sinf/powf) happen in param_queue_set_*, and only finished
+ * coefficients travel through the queue. The audio side drains the queue
+ * at a block boundary with param_queue_apply, which copies them into the
+ * chain through the effect_chain_set_* calls: no allocation, no locks and
+ * no libm on the audio path. Filter changes then ramp over a few
+ * milliseconds instead of resetting state, so retuning doesn't click.
+ *
+ * The queue is a frame ring (frame_ring.h) whose frames are whole
+ * param_update_t records, so it shares the audio rings' index logic.
+ */
+
+typedef enum {
+    PARAM_GAIN,            // value.gain: linear target
+    PARAM_FILTER,          // value.filter: new cascade design
+    PARAM_FILTER_OFF,      // Ramp the filter out and disable it
+    PARAM_COMPRESSOR,      // value.enabled
+} param_type_t;
+
+typedef struct {
+    param_type_t type;
+    union {
+        float gain;
+        biquad_cascade_t filter;
+        bool enabled;
+    } value;
+} param_update_t;
+
+typedef struct {
+    frame_ring_t *ring;         // One param_update_t per frame
+    float sample_rate;          // For designs built on the control side
+    unsigned int channels;
+} param_queue_t;
+
+/**
+ * Create a queue for a chain running at sample_rate with channels channels.
+ * capacity must be a power of 2. Returns NULL on failure.
+ */
+param_queue_t* param_queue_create(size_t capacity, float sample_rate, unsigned int channels);
+
+/**
+ * Destroy the queue and free memory.
+ */
+void param_queue_free(param_queue_t *queue);
+
+/**
+ * Enqueue an update (producer side). Returns false if the queue is full.
+ */
+bool param_queue_push(param_queue_t *queue, const param_update_t *update);
+
+/**
+ * Dequeue the oldest update (consumer side). Returns false if empty.
+ */
+bool param_queue_pop(param_queue_t *queue, param_update_t *update);
+
+/**
+ * Control-side helpers: compute the update and enqueue it. Gain in dB;
+ * filter with a lowpass or highpass cutoff (the other 0) and Butterworth
+ * order, both 0 to switch the filter off. Return 0 on success, -1 if the
+ * design is invalid or the queue is full.
+ */
+int param_queue_set_gain(param_queue_t *queue, float gain_db);
+int param_queue_set_filter(param_queue_t *queue, float lowpass_freq, float highpass_freq,
+                           unsigned int order);
+int param_queue_set_compressor(param_queue_t *queue, bool enabled);
+
+/**
+ * Apply every pending update to chain (consumer side, audio thread). Call
+ * between blocks. Returns the number of updates applied.
+ */
+size_t param_queue_apply(param_queue_t *queue, effect_chain_t *chain);
+
+#endif // PARAM_QUEUE_H
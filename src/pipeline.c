@@ -0,0 +1,332 @@
+#include "pipeline.h"
+#include "frame_ring.h"
+#include "utils.h"
+#include "wav_io.h"
+#include "effect_graph.h"
+#include "convolver.h"
+#include "rt_thread.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef struct {
+    const pipeline_config_t *config;
+    pipeline_stats_t stats;
+    unsigned int channels;
+    
+    wav_io_input_t in;
+    wav_io_reader_t reader;      // in, at the render rate
+    drwav out;
+    frame_ring_t *decoded;       // Decode -> DSP
+    frame_ring_t *processed;     // DSP -> encode
+    effect_graph_t *effects;
+    size_t skip;                 // Output frames still to drop: the graph's latency
+    block_timing_t dsp_timing;
+    
+    atomic_bool decode_done;     // Set once the last decoded frame is committed
+    atomic_bool dsp_done;        // Set once the last processed frame is committed
+    atomic_bool failed;          // Any stage hit an error; everyone bails out
+} pipeline_t;
+
+static double ns_to_seconds(uint64_t ns) {
+    return ns / 1e9;
+}
+
+/**
+ * Flag a failure and wake every stage parked on a ring so it sees it.
+ */
+static void pipeline_fail(pipeline_t *p) {
+    atomic_store(&p->failed, true);
+    frame_ring_close(p->decoded);
+    frame_ring_close(p->processed);
+}
+
+/**
+ * Copy count frames of stride bytes between two (possibly wrapped) ring spans.
+ */
+static void span_copy(frame_ring_span_t *dst, const frame_ring_span_t *src, size_t count,
+                      size_t stride) {
+    unsigned char *src_parts[2] = { src->data1, src->data2 };
+    size_t src_sizes[2] = { src->frames1, src->frames2 };
+    unsigned char *dst_parts[2] = { dst->data1, dst->data2 };
+    size_t dst_sizes[2] = { dst->frames1, dst->frames2 };
+    size_t si = 0, so = 0, di = 0, doff = 0;
+    
+    while (count > 0) {
+        size_t n = src_sizes[si] - so;
+        if (n > dst_sizes[di] - doff) n = dst_sizes[di] - doff;
+        if (n > count) n = count;
+        
+        memcpy(&dst_parts[di][doff * stride], &src_parts[si][so * stride], n * stride);
+        so += n;
+        doff += n;
+        count -= n;
+        
+        if (so == src_sizes[si]) { si++; so = 0; }
+        if (doff == dst_sizes[di]) { di++; doff = 0; }
+    }
+}
+
+static void* decode_thread(void *arg) {
+    pipeline_t *p = (pipeline_t*)arg;
+    pipeline_stage_stats_t *st = &p->stats.decode;
+    size_t chunk = p->config->chunk_frames;
+    uint64_t busy = 0, wait = 0;
+    
+    while (!atomic_load_explicit(&p->failed, memory_order_relaxed)) {
+        uint64_t t0 = utils_now_ns();
+        frame_ring_span_t span;
+        size_t space = frame_ring_write_acquire(p->decoded, chunk, &span);
+        
+        if (space == 0) {
+            // Back-pressure: park until DSP has freed a chunk
+            frame_ring_wait_writable(p->decoded, chunk, RING_BUFFER_WAIT_FOREVER);
+            wait += utils_now_ns() - t0;
+            continue;
+        }
+        
+        size_t got = wav_io_reader_read(&p->reader, &span);
+        frame_ring_write_commit(p->decoded, got);
+        
+        st->frames += got;
+        busy += utils_now_ns() - t0;
+        
+        if (got < space) {
+            break;  // End of input
+        }
+    }
+    
+    st->busy_seconds = ns_to_seconds(busy);
+    st->wait_seconds = ns_to_seconds(wait);
+    atomic_store_explicit(&p->decode_done, true, memory_order_release);
+    frame_ring_close(p->decoded);
+    return NULL;
+}
+
+static void* dsp_thread(void *arg) {
+    pipeline_t *p = (pipeline_t*)arg;
+    pipeline_stage_stats_t *st = &p->stats.dsp;
+    size_t chunk = p->config->chunk_frames;
+    uint64_t busy = 0, wait = 0;
+    
+    while (!atomic_load_explicit(&p->failed, memory_order_relaxed)) {
+        uint64_t t0 = utils_now_ns();
+        frame_ring_span_t out_span, in_span;
+        size_t space = frame_ring_write_acquire(p->processed, chunk, &out_span);
+        size_t count = space ? frame_ring_read_acquire(p->decoded, space, &in_span) : 0;
+        
+        if (count == 0) {
+            // The done flag is published after the last commit, so once it is
+            // set an empty ring really means end of stream
+            if (space > 0 &&
+                atomic_load_explicit(&p->decode_done, memory_order_acquire) &&
+                frame_ring_read_available(p->decoded) == 0) {
+                break;
+            }
+            if (space == 0) {
+                frame_ring_wait_writable(p->processed, chunk, RING_BUFFER_WAIT_FOREVER);
+            } else {
+                frame_ring_wait_readable(p->decoded, 1, RING_BUFFER_WAIT_FOREVER);
+            }
+            wait += utils_now_ns() - t0;
+            continue;
+        }
+        
+        uint64_t t1 = utils_now_ns();
+        effect_graph_process_split(p->effects, &in_span);
+        block_timing_record(&p->dsp_timing, utils_now_ns() - t1);
+        span_copy(&out_span, &in_span, count, p->decoded->stride);
+        
+        frame_ring_read_release(p->decoded, count);
+        frame_ring_write_commit(p->processed, count);
+        
+        st->frames += count;
+        busy += utils_now_ns() - t0;
+    }
+    
+    st->busy_seconds = ns_to_seconds(busy);
+    st->wait_seconds = ns_to_seconds(wait);
+    atomic_store_explicit(&p->dsp_done, true, memory_order_release);
+    frame_ring_close(p->processed);
+    return NULL;
+}
+
+static void* encode_thread(void *arg) {
+    pipeline_t *p = (pipeline_t*)arg;
+    pipeline_stage_stats_t *st = &p->stats.encode;
+    uint64_t busy = 0, wait = 0;
+    
+    while (!atomic_load_explicit(&p->failed, memory_order_relaxed)) {
+        uint64_t t0 = utils_now_ns();
+        frame_ring_span_t span;
+        size_t count = frame_ring_read_acquire(p->processed, p->config->chunk_frames, &span);
+        
+        if (count == 0) {
+            if (atomic_load_explicit(&p->dsp_done, memory_order_acquire) &&
+                frame_ring_read_available(p->processed) == 0) {
+                break;
+            }
+            frame_ring_wait_readable(p->processed, 1, RING_BUFFER_WAIT_FOREVER);
+            wait += utils_now_ns() - t0;
+            continue;
+        }
+        
+        size_t dropped = p->skip < count ? p->skip : count;
+        frame_ring_span_t rest = span;
+        frame_ring_span_skip(&rest, dropped, p->processed->stride);
+        p->skip -= dropped;
+        
+        size_t written = wav_io_write_span(&p->out, &rest, count - dropped);
+        frame_ring_read_release(p->processed, count);
+        
+        // drwav retries a short write and stdio buffers the retry, so a full
+        // disk only shows on the stream (drwav_init_file_write's FILE*)
+        if (written != count - dropped || ferror((FILE*)p->out.pUserData)) {
+            fprintf(stderr, "✗ Error: Failed to write output (disk full?)\n");
+            pipeline_fail(p);
+            break;
+        }
+        
+        st->frames += written;
+        busy += utils_now_ns() - t0;
+    }
+    
+    st->busy_seconds = ns_to_seconds(busy);
+    st->wait_seconds = ns_to_seconds(wait);
+    return NULL;
+}
+
+int pipeline_run(const pipeline_config_t *config, pipeline_stats_t *stats) {
+    pipeline_t p;
+    memset(&p, 0, sizeof(p));
+    p.config = config;
+    atomic_init(&p.decode_done, false);
+    atomic_init(&p.dsp_done, false);
+    atomic_init(&p.failed, false);
+    
+    if (wav_io_input_open(&p.in, config->input_file, config->map_input) != 0) {
+        fprintf(stderr, "✗ Error: Failed to open input file '%s'\n", config->input_file);
+        return 1;
+    }
+    
+    p.stats.input_rate = p.in.sample_rate;
+    p.stats.channels = p.in.channels;
+    p.stats.input_mapped = p.in.mapped;
+    
+    if (p.in.channels == 0 || p.in.channels > EFFECT_MAX_CHANNELS) {
+        fprintf(stderr, "✗ Error: %u channels not supported (1-%d)\n",
+                p.in.channels, EFFECT_MAX_CHANNELS);
+        wav_io_input_close(&p.in);
+        return 1;
+    }
+    const convolver_ir_t *ir = config->effects.ir;
+    if (ir && ir->channels != 1 && ir->channels != p.in.channels) {
+        fprintf(stderr, "✗ Error: A %u-channel IR doesn't fit %u-channel audio\n",
+                ir->channels, p.in.channels);
+        wav_io_input_close(&p.in);
+        return 1;
+    }
+    if (wav_io_reader_init(&p.reader, &p.in, config->sample_rate) != 0) {
+        fprintf(stderr, "✗ Error: Can't convert %u Hz to %u Hz\n",
+                p.in.sample_rate, config->sample_rate);
+        wav_io_input_close(&p.in);
+        return 1;
+    }
+    unsigned int sample_rate = p.reader.sample_rate;
+    p.stats.sample_rate = sample_rate;
+    p.stats.total_frames = wav_io_reader_total_frames(&p.reader);
+    p.channels = p.in.channels;
+    
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = p.in.channels;
+    format.sampleRate = sample_rate;
+    format.bitsPerSample = 32;
+    
+    if (!drwav_init_file_write(&p.out, config->output_file, &format, NULL)) {
+        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", config->output_file);
+        wav_io_reader_free(&p.reader);
+        wav_io_input_close(&p.in);
+        return 1;
+    }
+    
+    // Mirrored where the ring's bytes allow it, so spans are contiguous;
+    // waitable, so stalled stages sleep instead of spinning
+    ring_buffer_options_t rings;
+    ring_buffer_options_init(&rings);
+    rings.mirrored = true;
+    rings.waitable = true;
+    rings.lock = config->rt.lock_memory;
+    p.decoded = frame_ring_f32_create(config->ring_frames, p.channels, &rings);
+    p.processed = frame_ring_f32_create(config->ring_frames, p.channels, &rings);
+    p.effects = effect_graph_from_config(&config->effects, sample_rate, p.channels, 0);
+    if (!p.decoded || !p.processed || !p.effects) {
+        fprintf(stderr, "✗ Error: Failed to create ring buffers or effect graph\n");
+        effect_graph_free(p.effects);
+        frame_ring_free(p.decoded);
+        frame_ring_free(p.processed);
+        drwav_uninit(&p.out);
+        wav_io_reader_free(&p.reader);
+        wav_io_input_close(&p.in);
+        return 1;
+    }
+    
+    // Silence after the input flushes the graph's latency out; the encoder
+    // drops as much from the start
+    size_t delay = effect_graph_latency(p.effects);
+    wav_io_reader_pad(&p.reader, delay);
+    p.skip = delay;
+    
+    block_timing_init(&p.dsp_timing,
+                      (uint64_t)config->chunk_frames * 1000000000ull / sample_rate);
+    
+    if (config->rt.lock_memory) {
+        p.stats.memory_locked = rt_lock_memory() == 0;
+        if (!p.stats.memory_locked) {
+            fprintf(stderr, "Warning: Could not lock memory (raise the memlock limit)\n");
+        }
+    }
+    
+    uint64_t start = utils_now_ns();
+    
+    pthread_t threads[3];
+    void *(*entry[3])(void *) = { decode_thread, dsp_thread, encode_thread };
+    int started = 0;
+    p.stats.rt_flags = ~0u;
+    for (; started < 3; started++) {
+        unsigned int applied;
+        if (rt_thread_create(&threads[started], &config->rt, (unsigned int)started,
+                             entry[started], &p, &applied) != 0) {
+            fprintf(stderr, "✗ Error: Failed to start pipeline thread\n");
+            pipeline_fail(&p);
+            break;
+        }
+        p.stats.rt_flags &= applied;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    p.stats.wall_seconds = ns_to_seconds(utils_now_ns() - start);
+    block_timing_summarize(&p.dsp_timing, &p.stats.dsp_blocks);
+    p.stats.decoded_high_water = frame_ring_high_water(p.decoded);
+    p.stats.processed_high_water = frame_ring_high_water(p.processed);
+    
+    drwav_uninit(&p.out);
+    wav_io_reader_free(&p.reader);
+    wav_io_input_close(&p.in);
+    frame_ring_free(p.decoded);
+    frame_ring_free(p.processed);
+    effect_graph_free(p.effects);
+    if (p.stats.memory_locked) {
+        rt_unlock_memory();
+    }
+    
+    if (stats) {
+        *stats = p.stats;
+    }
+    return atomic_load(&p.failed) ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "effects.h"
+#include "stats.h"
+#include "rt_thread.h"
+
+/**
+ * Three-thread offline render pipeline:
+ *
+ *   decode thread --[ring A]--> DSP thread --[ring B]--> encode thread
+ *
+ * Each ring is a lock-free SPSC frame_ring_t of whole frames, so every
+ * ring has exactly one producer and one consumer and no stage ever sees
+ * part of a frame. A full ring stalls its producer
+ * (back-pressure) and an empty ring stalls its consumer. A stalled stage
+ * spins briefly, then sleeps on the ring's futex until its peer commits
+ * or releases enough; stages close the rings at end of stream or on
+ * failure, so nobody stays parked.
+ *
+ * The stage threads start through rt_thread_create with config->rt, on
+ * consecutive cores from rt.cpu in decode, DSP, encode order.
+ */
+
+typedef struct {
+    const char *input_file;
+    const char *output_file;
+    unsigned int sample_rate;  // Render at this rate, converting on decode (0 = the input's)
+    bool map_input;          // Map float input instead of decoding it (wav_io_input_open)
+    effect_chain_config_t effects;
+    size_t ring_frames;      // Frames per ring (power of 2)
+    size_t chunk_frames;     // Max frames moved per stage iteration
+    rt_config_t rt;          // Priority, pinning and memory locking for the stages
+} pipeline_config_t;
+
+typedef struct {
+    uint64_t frames;         // Frames this stage handled
+    double busy_seconds;     // Time spent doing the stage's own work
+    double wait_seconds;     // Time stalled on an empty/full ring
+} pipeline_stage_stats_t;
+
+typedef struct {
+    unsigned int sample_rate;      // Of the output
+    unsigned int input_rate;
+    unsigned int channels;
+    bool input_mapped;       // The decode stage copied straight from the mapped file
+    uint64_t total_frames;   // The input header's count, at the output rate
+    double wall_seconds;
+    
+    pipeline_stage_stats_t decode;
+    pipeline_stage_stats_t dsp;
+    pipeline_stage_stats_t encode;
+    
+    block_timing_summary_t dsp_blocks;  // Per-chunk effect time vs the chunk's duration
+    size_t decoded_high_water;          // Peak ring fills, in frames
+    size_t processed_high_water;
+    unsigned int rt_flags;              // RT_THREAD_* flags every stage thread got
+    bool memory_locked;
+} pipeline_stats_t;
+
+/**
+ * Render config->input_file into config->output_file on three threads.
+ * Fills stats (may be NULL). Returns 0 on success, non-zero on error.
+ */
+int pipeline_run(const pipeline_config_t *config, pipeline_stats_t *stats);
+
+#endif // PIPELINE_H
@@ -0,0 +1,338 @@
+#include "resampler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RESAMPLER_ALIGN 64
+#define RESAMPLER_BLOCK 1024          // History frames per channel beyond one window
+#define RESAMPLER_HALF (RESAMPLER_TAPS / 2)
+#define RESAMPLER_KAISER_BETA 8.0     // About 80 dB stopband at 64 taps
+#define RESAMPLER_CUTOFF 0.9          // Passband edge, as a fraction of the lower Nyquist
+
+// Taps before the output position: tap k sits at k - RESAMPLER_LEAD - frac
+#define RESAMPLER_LEAD (RESAMPLER_HALF - 1)
+
+static float* rs_alloc(size_t count) {
+    size_t bytes = (count * sizeof(float) + RESAMPLER_ALIGN - 1) / RESAMPLER_ALIGN * RESAMPLER_ALIGN;
+    float *p = aligned_alloc(RESAMPLER_ALIGN, bytes);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+}
+
+// ============================================================================
+// FILTER BANK
+// ============================================================================
+
+/**
+ * Zeroth-order modified Bessel function of the first kind (power series).
+ */
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    double q = x * x / 4.0;
+    for (int k = 1; k < 64; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * Windowed sinc at distance d input frames from the output position.
+ */
+static double rs_kernel(double d, double cutoff) {
+    double x = d / RESAMPLER_HALF;
+    if (x <= -1.0 || x >= 1.0) {
+        return 0.0;
+    }
+    double window = bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - x * x)) /
+                    bessel_i0(RESAMPLER_KAISER_BETA);
+    double arg = M_PI * cutoff * d;
+    double sinc = fabs(arg) < 1e-12 ? 1.0 : sin(arg) / arg;
+    return cutoff * sinc * window;
+}
+
+/**
+ * Row p holds the taps for an output p / RESAMPLER_PHASES of a frame past
+ * an input frame. Every row sums to 1, so DC passes at unity gain whatever
+ * the phase.
+ */
+static void rs_build_bank(float *bank, double cutoff) {
+    double taps[RESAMPLER_TAPS];
+    for (int p = 0; p <= RESAMPLER_PHASES; p++) {
+        double frac = (double)p / RESAMPLER_PHASES;
+        double sum = 0.0;
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            taps[k] = rs_kernel(k - RESAMPLER_LEAD - frac, cutoff);
+            sum += taps[k];
+        }
+        for (int k = 0; k < RESAMPLER_TAPS; k++) {
+            bank[p * RESAMPLER_TAPS + k] = (float)(taps[k] / sum);
+        }
+    }
+}
+
+// ============================================================================
+// KERNELS
+// ============================================================================
+
+/**
+ * coef = a + t (b - a), RESAMPLER_TAPS wide.
+ */
+static void rs_lerp(float *coef, const float *a, const float *b, float t) {
+    size_t k = 0;
+#if defined(__SSE2__)
+    __m128 vt = _mm_set1_ps(t);
+    for (; k + 4 <= RESAMPLER_TAPS; k += 4) {
+        __m128 va = _mm_load_ps(&a[k]);
+        __m128 vb = _mm_load_ps(&b[k]);
+        _mm_store_ps(&coef[k], _mm_add_ps(va, _mm_mul_ps(vt, _mm_sub_ps(vb, va))));
+    }
+#elif defined(__ARM_NEON)
+    float32x4_t vt = vdupq_n_f32(t);
+    for (; k + 4 <= RESAMPLER_TAPS; k += 4) {
+        float32x4_t va = vld1q_f32(&a[k]);
+        float32x4_t vb = vld1q_f32(&b[k]);
+        vst1q_f32(&coef[k], vmlaq_f32(va, vt, vsubq_f32(vb, va)));
+    }
+#else
+    for (; k < RESAMPLER_TAPS; k++) {
+        coef[k] = a[k] + t * (b[k] - a[k]);
+    }
+#endif
+}
+
+/**
+ * Inner product of RESAMPLER_TAPS history frames with the aligned coefficients.
+ */
+static float rs_dot(const float *x, const float *coef) {
+    size_t k = 0;
+    float sum = 0.0f;
+#if defined(__SSE2__)
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (; k + 8 <= RESAMPLER_TAPS; k += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&x[k]), _mm_load_ps(&coef[k])));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(&x[k + 4]), _mm_load_ps(&coef[k + 4])));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON)
+    float32x4_t s0 = vdupq_n_f32(0.0f), s1 = vdupq_n_f32(0.0f);
+    for (; k + 8 <= RESAMPLER_TAPS; k += 8) {
+        s0 = vmlaq_f32(s0, vld1q_f32(&x[k]), vld1q_f32(&coef[k]));
+        s1 = vmlaq_f32(s1, vld1q_f32(&x[k + 4]), vld1q_f32(&coef[k + 4]));
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vaddq_f32(s0, s1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    for (; k < RESAMPLER_TAPS; k++) {
+        sum += x[k] * coef[k];
+    }
+#endif
+    return sum;
+}
+
+// ============================================================================
+// CONVERTER
+// ============================================================================
+
+resampler_t* resampler_create(unsigned int channels, double in_rate, double out_rate) {
+    if (channels == 0 || !(in_rate > 0.0) || !(out_rate > 0.0) ||
+        in_rate > out_rate * RESAMPLER_MAX_RATIO || out_rate > in_rate * RESAMPLER_MAX_RATIO) {
+        return NULL;
+    }
+    
+    resampler_t *rs = calloc(1, sizeof(resampler_t));
+    if (!rs) {
+        return NULL;
+    }
+    
+    rs->channels = channels;
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->step = in_rate / out_rate;
+    rs->correction = 1.0;
+    rs->step_now = rs->step;
+    
+    // A step past RESAMPLER_TAPS would skip whole windows between outputs
+    rs->capacity = RESAMPLER_TAPS + RESAMPLER_BLOCK + (size_t)ceil(rs->step);
+    rs->bank = rs_alloc((RESAMPLER_PHASES + 1) * RESAMPLER_TAPS);
+    rs->coef = rs_alloc(RESAMPLER_TAPS);
+    rs->history = rs_alloc(channels * rs->capacity);
+    if (!rs->bank || !rs->coef || !rs->history) {
+        resampler_free(rs);
+        return NULL;
+    }
+    
+    // Downsampling moves the cutoff under the output's Nyquist
+    double cutoff = RESAMPLER_CUTOFF * (out_rate < in_rate ? out_rate / in_rate : 1.0);
+    rs_build_bank(rs->bank, cutoff);
+    
+    resampler_reset(rs);
+    return rs;
+}
+
+void resampler_free(resampler_t *rs) {
+    if (rs) {
+        free(rs->bank);
+        free(rs->coef);
+        free(rs->history);
+        free(rs);
+    }
+}
+
+void resampler_reset(resampler_t *rs) {
+    // Silence before the first frame, so output 0 lands on input 0
+    memset(rs->history, 0, rs->channels * rs->capacity * sizeof(float));
+    rs->filled = RESAMPLER_LEAD;
+    rs->pos = RESAMPLER_LEAD;
+}
+
+void resampler_set_correction(resampler_t *rs, double factor) {
+    if (factor < 1.0 - RESAMPLER_MAX_CORRECTION) factor = 1.0 - RESAMPLER_MAX_CORRECTION;
+    if (factor > 1.0 + RESAMPLER_MAX_CORRECTION) factor = 1.0 + RESAMPLER_MAX_CORRECTION;
+    rs->correction = factor;
+    rs->step_now = rs->step * factor;
+}
+
+/**
+ * Drop history no future output can reach, making room at the end.
+ */
+static void rs_compact(resampler_t *rs) {
+    size_t first = (size_t)rs->pos - RESAMPLER_LEAD;
+    if (first > rs->filled) first = rs->filled;
+    if (first == 0) {
+        return;
+    }
+    
+    size_t keep = rs->filled - first;
+    for (unsigned int c = 0; c < rs->channels; c++) {
+        float *h = &rs->history[c * rs->capacity];
+        memmove(h, &h[first], keep * sizeof(float));
+    }
+    rs->filled = keep;
+    rs->pos -= (double)first;
+}
+
+/**
+ * Deinterleave up to frames of input (NULL: silence) onto the history.
+ * Returns the frames taken.
+ */
+static size_t rs_append(resampler_t *rs, const float *in, size_t frames) {
+    if (rs->filled == rs->capacity) {
+        rs_compact(rs);
+    }
+    size_t n = rs->capacity - rs->filled;
+    if (n > frames) n = frames;
+    
+    unsigned int channels = rs->channels;
+    for (unsigned int c = 0; c < channels; c++) {
+        float *h = &rs->history[c * rs->capacity + rs->filled];
+        if (in) {
+            for (size_t i = 0; i < n; i++) {
+                h[i] = in[i * channels + c];
+            }
+        } else {
+            memset(h, 0, n * sizeof(float));
+        }
+    }
+    rs->filled += n;
+    return n;
+}
+
+/**
+ * Whether the history reaches far enough for the next output.
+ */
+static bool rs_ready(const resampler_t *rs) {
+    return (size_t)rs->pos + RESAMPLER_HALF + 1 <= rs->filled;
+}
+
+/**
+ * Produce every output the history can support, up to frames.
+ */
+static size_t rs_render(resampler_t *rs, float *out, size_t frames) {
+    unsigned int channels = rs->channels;
+    size_t produced = 0;
+    
+    while (produced < frames && rs_ready(rs)) {
+        size_t index = (size_t)rs->pos;
+        double phase = (rs->pos - (double)index) * RESAMPLER_PHASES;
+        size_t row = (size_t)phase;
+        if (row >= RESAMPLER_PHASES) row = RESAMPLER_PHASES - 1;
+        const float *taps = &rs->bank[row * RESAMPLER_TAPS];
+        rs_lerp(rs->coef, taps, taps + RESAMPLER_TAPS, (float)(phase - (double)row));
+        
+        size_t start = index - RESAMPLER_LEAD;
+        for (unsigned int c = 0; c < channels; c++) {
+            out[produced * channels + c] = rs_dot(&rs->history[c * rs->capacity + start], rs->coef);
+        }
+        
+        produced++;
+        rs->pos += rs->step_now;
+    }
+    return produced;
+}
+
+size_t resampler_process(resampler_t *rs, const float *in, size_t in_frames, size_t *in_used,
+                         float *out, size_t out_frames) {
+    size_t produced = 0, used = 0;
+    
+    while (true) {
+        produced += rs_render(rs, &out[produced * rs->channels], out_frames - produced);
+        
+        // Still ready means the output is full; input that would only fill
+        // the history further is left for the next call
+        if (used == in_frames || rs_ready(rs)) {
+            break;
+        }
+        used += rs_append(rs, &in[used * rs->channels], in_frames - used);
+    }
+    
+    if (in_used) {
+        *in_used = used;
+    }
+    return produced;
+}
+
+size_t resampler_drain(resampler_t *rs, float *out, size_t out_frames) {
+    size_t produced = 0;
+    
+    while (true) {
+        produced += rs_render(rs, &out[produced * rs->channels], out_frames - produced);
+        if (produced == out_frames) {
+            break;
+        }
+        rs_append(rs, NULL, rs->capacity);
+    }
+    return produced;
+}
+
+size_t resampler_max_output(const resampler_t *rs, size_t in_frames) {
+    double last = (double)(rs->filled + in_frames) - (RESAMPLER_HALF + 1);
+    if (last < rs->pos) {
+        return 0;
+    }
+    // One spare for rounding in the accumulated position
+    return (size_t)((last - rs->pos) / rs->step_now) + 2;
+}
+
+size_t resampler_output_frames(size_t in_frames, double in_rate, double out_rate) {
+    return (size_t)ceil((double)in_frames * out_rate / in_rate - 1e-9);
+}
@@ -0,0 +1,101 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stddef.h>
+
+/**
+ * Polyphase sample-rate converter for interleaved float audio.
+ *
+ * The filter is a Kaiser-windowed sinc of RESAMPLER_TAPS taps, cut off just
+ * below the lower of the two Nyquist frequencies, precomputed at
+ * RESAMPLER_PHASES fractional offsets (plus one, so the last phase can be
+ * interpolated too). Each output frame interpolates its coefficients
+ * between the two nearest phases once, then takes one SIMD inner product
+ * with the history of every channel.
+ *
+ * The read position is kept in double, so any rate pair works - not just
+ * ratios of small integers - and the step can be nudged while running:
+ * resampler_set_correction() scales it by a factor close to 1, which is how
+ * live mode locks two devices on different clocks together.
+ *
+ * Output is time-aligned with input (output frame 0 is input frame 0), but
+ * each output needs RESAMPLER_TAPS / 2 input frames past it, so that much
+ * input stays buffered; resampler_drain() pads the end of a stream with
+ * silence to get it out.
+ *
+ * Everything is allocated by resampler_create; processing never allocates.
+ */
+
+#define RESAMPLER_TAPS 64                // Per phase; a multiple of 8 for the SIMD kernels
+#define RESAMPLER_PHASES 256
+#define RESAMPLER_MAX_RATIO 8.0          // Either way, between in_rate and out_rate
+#define RESAMPLER_MAX_CORRECTION 0.01    // resampler_set_correction() range: 1 +/- this
+
+typedef struct {
+    unsigned int channels;
+    double in_rate;
+    double out_rate;
+    double step;                // Input frames per output frame, nominal
+    double correction;          // Drift factor applied to step
+    double step_now;            // step * correction
+    
+    float *bank;                // [RESAMPLER_PHASES + 1][RESAMPLER_TAPS]
+    float *coef;                // Scratch: interpolated taps for one output frame
+    float *history;             // [channel][capacity] planar input
+    size_t capacity;            // Frames of history per channel
+    size_t filled;              // Frames of history in use
+    double pos;                 // Next output, in history frames
+} resampler_t;
+
+/**
+ * Build a converter from in_rate to out_rate for channels interleaved
+ * channels. Returns NULL on failure, or when the ratio is beyond
+ * RESAMPLER_MAX_RATIO.
+ */
+resampler_t* resampler_create(unsigned int channels, double in_rate, double out_rate);
+
+/**
+ * Free the converter.
+ */
+void resampler_free(resampler_t *rs);
+
+/**
+ * Forget all buffered input and return to position 0; the correction factor
+ * is kept.
+ */
+void resampler_reset(resampler_t *rs);
+
+/**
+ * Scale the step by factor (clamped to 1 +/- RESAMPLER_MAX_CORRECTION).
+ * Above 1, each output frame consumes more input: fewer frames come out.
+ */
+void resampler_set_correction(resampler_t *rs, double factor);
+
+/**
+ * Convert from in (in_frames interleaved frames) into out (room for
+ * out_frames). Stops when either the input runs out or the output is full;
+ * *in_used (may be NULL) is set to the input frames consumed. Returns the
+ * number of frames written.
+ */
+size_t resampler_process(resampler_t *rs, const float *in, size_t in_frames, size_t *in_used,
+                         float *out, size_t out_frames);
+
+/**
+ * Write out_frames frames, feeding silence as input: the end of a stream.
+ * Returns out_frames.
+ */
+size_t resampler_drain(resampler_t *rs, float *out, size_t out_frames);
+
+/**
+ * At most how many frames resampler_process() can produce from in_frames
+ * more input at the current step.
+ */
+size_t resampler_max_output(const resampler_t *rs, size_t in_frames);
+
+/**
+ * Output length of a whole stream of in_frames frames: the input duration
+ * rounded up at the output rate.
+ */
+size_t resampler_output_frames(size_t in_frames, double in_rate, double out_rate);
+
+#endif // RESAMPLER_H
@@ -1,7 +1,21 @@
+#define _GNU_SOURCE
 #include "ring_buffer.h"
+#include "frame_ring.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define RING_BUFFER_HUGE_PAGE (2u * 1024 * 1024)
 
 /**
  * Check if a number is a power of 2.
@@ -10,117 +24,627 @@ static bool is_power_of_2(size_t n) {
     return n > 0 && (n & (n - 1)) == 0;
 }
 
-ring_buffer_t* ring_buffer_create(size_t capacity_samples) {
-    if (!is_power_of_2(capacity_samples)) {
+static size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+/**
+ * Reserve bytes of address space aligned to align (a multiple of the page
+ * size), without backing. Returns NULL on failure.
+ */
+static unsigned char* ring_buffer_reserve(size_t bytes, size_t align) {
+    size_t len = bytes + align;
+    unsigned char *raw = mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                              -1, 0);
+    if (raw == MAP_FAILED) {
         return NULL;
     }
     
-    ring_buffer_t *rb = malloc(sizeof(ring_buffer_t));
-    if (!rb) {
+    // Trim the slack on both sides
+    unsigned char *base = (unsigned char*)round_up((uintptr_t)raw, align);
+    if (base > raw) {
+        munmap(raw, (size_t)(base - raw));
+    }
+    size_t tail = (size_t)((raw + len) - (base + bytes));
+    if (tail > 0) {
+        munmap(base + bytes, tail);
+    }
+    return base;
+}
+
+/**
+ * Map one memfd of bytes twice in a row. Returns the base, or NULL.
+ */
+static void* ring_buffer_map_mirrored(size_t bytes, bool huge) {
+    size_t page = huge ? RING_BUFFER_HUGE_PAGE : (size_t)sysconf(_SC_PAGESIZE);
+    int fd = memfd_create("ring_buffer", MFD_CLOEXEC | (huge ? MFD_HUGETLB : 0));
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
         return NULL;
     }
     
-    rb->buffer = malloc(capacity_samples * sizeof(float));
-    if (!rb->buffer) {
-        free(rb);
+    // Reserve both halves first so nothing else can land between them
+    unsigned char *base = ring_buffer_reserve(2 * bytes, page);
+    if (!base ||
+        mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        if (base) {
+            munmap(base, 2 * bytes);
+        }
+        close(fd);
         return NULL;
     }
     
-    rb->capacity = capacity_samples;
-    rb->mask = capacity_samples - 1;
+    close(fd);  // The mappings keep the pages alive
+    return base;
+}
+
+/**
+ * Huge-page storage of len bytes (a multiple of the huge page size):
+ * explicit huge pages if the system has any reserved, else a huge-page
+ * aligned mapping with transparent huge pages advised. Sets the storage
+ * flags; returns NULL on failure.
+ */
+static void* ring_buffer_map_huge(size_t len, unsigned int *storage) {
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                   -1, 0);
+    if (p != MAP_FAILED) {
+        *storage |= RING_BUFFER_MAPPED | RING_BUFFER_HUGETLB;
+        return p;
+    }
     
-    atomic_init(&rb->write_index, 0);
-    atomic_init(&rb->read_index, 0);
+    unsigned char *base = ring_buffer_reserve(len, RING_BUFFER_HUGE_PAGE);
+    if (!base || mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+                      -1, 0) == MAP_FAILED) {
+        if (base) {
+            munmap(base, len);
+        }
+        return NULL;
+    }
     
-    // Zero out buffer (good practice for audio)
-    memset(rb->buffer, 0, capacity_samples * sizeof(float));
+    *storage |= RING_BUFFER_MAPPED;
+    if (madvise(base, len, MADV_HUGEPAGE) == 0) {
+        *storage |= RING_BUFFER_THP;
+    }
+    return base;
+}
+
+/**
+ * Tell the core we're in a spin loop (saves power, frees the sibling thread).
+ */
+static inline void ring_buffer_cpu_relax(void) {
+#if defined(__SSE2__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static void futex_wait(atomic_uint *word, unsigned int expected, uint64_t timeout_ns) {
+    struct timespec ts;
+    struct timespec *timeout = NULL;
+    if (timeout_ns != RING_BUFFER_WAIT_FOREVER) {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+        timeout = &ts;
+    }
+    // EAGAIN (word already moved on), EINTR and ETIMEDOUT all just send the
+    // caller back to re-check
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+}
+
+static void futex_wake(atomic_uint *word) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static uint64_t ring_buffer_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Level callbacks for the events: frames readable and writable.
+ */
+typedef size_t (*ring_level_fn_t)(const frame_ring_t *ring);
+
+static void ring_event_init(ring_buffer_event_t *event, bool enabled) {
+    atomic_init(&event->word, 0);
+    atomic_init(&event->need, 0);
+    event->enabled = enabled;
+}
+
+/**
+ * Block until available(ring) >= need, the event is closed or timeout_ns
+ * passes. Returns the last level seen.
+ */
+static size_t ring_event_wait(ring_buffer_event_t *event, ring_level_fn_t available,
+                              const frame_ring_t *ring, size_t need, uint64_t timeout_ns) {
+    size_t level = available(ring);
+    for (unsigned int i = 0; level < need && i < RING_BUFFER_WAIT_SPINS; i++) {
+        if (atomic_load_explicit(&event->word, memory_order_acquire) & RING_BUFFER_EVENT_CLOSED) {
+            return available(ring);
+        }
+        ring_buffer_cpu_relax();
+        level = available(ring);
+    }
+    if (level >= need || timeout_ns == 0) {
+        return level;
+    }
+    
+    uint64_t deadline = 0;
+    if (timeout_ns != RING_BUFFER_WAIT_FOREVER) {
+        deadline = ring_buffer_now_ns() + timeout_ns;
+    }
+    
+    atomic_store_explicit(&event->need, need, memory_order_relaxed);
+    while (true) {
+        // Flag ourselves, then look again: the fences on both sides make sure
+        // either we see the peer's new index or the peer sees the flag
+        unsigned int word = atomic_fetch_or(&event->word, RING_BUFFER_EVENT_PARKED) |
+                            RING_BUFFER_EVENT_PARKED;
+        atomic_thread_fence(memory_order_seq_cst);
+        level = available(ring);
+        if (level >= need || (word & RING_BUFFER_EVENT_CLOSED)) {
+            break;
+        }
+        
+        uint64_t remaining = RING_BUFFER_WAIT_FOREVER;
+        if (deadline) {
+            uint64_t now = ring_buffer_now_ns();
+            if (now >= deadline) {
+                break;
+            }
+            remaining = deadline - now;
+        }
+        if (event->enabled) {
+            futex_wait(&event->word, word, remaining);
+        } else {
+            // Nobody will wake us: poll
+            if (remaining > RING_BUFFER_POLL_NS) remaining = RING_BUFFER_POLL_NS;
+            struct timespec ts = { .tv_sec = 0, .tv_nsec = (long)remaining };
+            nanosleep(&ts, NULL);
+        }
+    }
     
-    return rb;
+    atomic_fetch_and(&event->word, ~RING_BUFFER_EVENT_PARKED);
+    return level;
 }
 
-void ring_buffer_free(ring_buffer_t *rb) {
-    if (rb) {
-        free(rb->buffer);
-        free(rb);
+/**
+ * Called after publishing an index: wake a parked waiter once its level is
+ * reached. Only calls available when a waiter is flagged.
+ */
+static void ring_event_notify(ring_buffer_event_t *event, ring_level_fn_t available,
+                              const frame_ring_t *ring) {
+    // Pairs with the waiter's fence: our index store can't pass the flag load
+    atomic_thread_fence(memory_order_seq_cst);
+    unsigned int word = atomic_load_explicit(&event->word, memory_order_relaxed);
+    
+    while (word & RING_BUFFER_EVENT_PARKED) {
+        if (available(ring) < atomic_load_explicit(&event->need, memory_order_relaxed)) {
+            return;  // Parked for more than is there; a later notify will do
+        }
+        // Drop the flag and bump the wake count in one step
+        unsigned int next = (word & ~RING_BUFFER_EVENT_PARKED) + RING_BUFFER_EVENT_COUNT;
+        if (atomic_compare_exchange_weak(&event->word, &word, next)) {
+            futex_wake(&event->word);
+            return;
+        }
     }
 }
 
-size_t ring_buffer_read_available(const ring_buffer_t *rb) {
-    size_t w = atomic_load_explicit(&rb->write_index, memory_order_relaxed);
-    size_t r = atomic_load_explicit(&rb->read_index, memory_order_relaxed);
-    return w - r;
+static void ring_event_close(ring_buffer_event_t *event) {
+    // Same word the waiter flags itself in, so it either sees closed or is woken
+    unsigned int word = atomic_fetch_or(&event->word, RING_BUFFER_EVENT_CLOSED);
+    if (word & RING_BUFFER_EVENT_PARKED) {
+        futex_wake(&event->word);
+    }
 }
 
-size_t ring_buffer_write_available(const ring_buffer_t *rb) {
-    size_t w = atomic_load_explicit(&rb->write_index, memory_order_relaxed);
-    size_t r = atomic_load_explicit(&rb->read_index, memory_order_relaxed);
-    return rb->capacity - (w - r);
+void ring_buffer_options_init(ring_buffer_options_t *options) {
+    options->alignment = RING_BUFFER_CACHE_LINE;
+    options->huge_pages = false;
+    options->lock = false;
+    options->prefault = true;
+    options->mirrored = false;
+    options->waitable = false;
 }
 
-size_t ring_buffer_write(ring_buffer_t *rb, const float *data, size_t count) {
-    size_t available = ring_buffer_write_available(rb);
-    size_t to_write = (count < available) ? count : available;
+/**
+ * Allocate bytes of ring storage as options asks (NULL = defaults) and
+ * report the RING_BUFFER_* flags granted and the mapping length. A
+ * mirrored mapping needs bytes to be a multiple of the page size.
+ * Returns 0 on success, -1 on failure.
+ */
+static int ring_storage_alloc(size_t bytes, const ring_buffer_options_t *options,
+                              void **buffer, unsigned int *storage, size_t *mapped_bytes) {
+    ring_buffer_options_t defaults;
+    if (!options) {
+        ring_buffer_options_init(&defaults);
+        options = &defaults;
+    }
     
-    if (to_write == 0) {
-        return 0;
+    size_t alignment = options->alignment ? options->alignment : RING_BUFFER_CACHE_LINE;
+    if (bytes == 0 || !is_power_of_2(alignment)) {
+        return -1;
+    }
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
     }
     
-    size_t w = atomic_load_explicit(&rb->write_index, memory_order_relaxed);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    void *data = NULL;
+    unsigned int flags = 0;
+    size_t mapped = 0;
     
-    // Write in up to two chunks (handle wrap-around)
-    size_t write_pos = w & rb->mask;
-    size_t chunk1 = rb->capacity - write_pos;
+    if (options->mirrored) {
+        if (options->huge_pages && bytes % RING_BUFFER_HUGE_PAGE == 0) {
+            data = ring_buffer_map_mirrored(bytes, true);
+            if (data) flags |= RING_BUFFER_HUGETLB;
+        }
+        if (!data && bytes % page == 0) {
+            data = ring_buffer_map_mirrored(bytes, false);
+        }
+        if (data) {
+            flags |= RING_BUFFER_MAPPED | RING_BUFFER_MIRRORED;
+            mapped = 2 * bytes;
+        }
+    }
+    
+    if (!data && options->huge_pages) {
+        size_t len = round_up(bytes, RING_BUFFER_HUGE_PAGE);
+        data = ring_buffer_map_huge(len, &flags);
+        mapped = len;
+    }
     
-    if (chunk1 > to_write) {
-        chunk1 = to_write;
+    if (!data) {
+        data = aligned_alloc(alignment, round_up(bytes, alignment));
+        if (!data) {
+            return -1;
+        }
+        mapped = 0;
     }
     
-    memcpy(&rb->buffer[write_pos], data, chunk1 * sizeof(float));
+    if (options->lock && mlock(data, (flags & RING_BUFFER_MAPPED) ? mapped : bytes) == 0) {
+        flags |= RING_BUFFER_LOCKED;
+    }
     
-    if (to_write > chunk1) {
-        size_t chunk2 = to_write - chunk1;
-        memcpy(&rb->buffer[0], &data[chunk1], chunk2 * sizeof(float));
+    // Heap storage may be recycled and always gets zeroed (good practice
+    // for audio). Fresh mappings are zero already; writing them only
+    // faults the pages in, so that is left to the prefault option
+    if (!(flags & RING_BUFFER_MAPPED) || options->prefault) {
+        memset(data, 0, bytes);
     }
     
-    // Update write index (release semantics ensures data is visible)
-    atomic_store_explicit(&rb->write_index, w + to_write, memory_order_release);
+    *buffer = data;
+    *storage = flags;
+    *mapped_bytes = mapped;
+    return 0;
+}
+
+frame_ring_t* frame_ring_create(size_t capacity_frames, size_t element_size,
+                                unsigned int elements, size_t stride,
+                                const ring_buffer_options_t *options) {
+    size_t packed = element_size * elements;
+    if (stride == 0) {
+        stride = packed;
+    }
+    if (!is_power_of_2(capacity_frames) || packed == 0 || stride < packed ||
+        capacity_frames > SIZE_MAX / stride) {
+        return NULL;
+    }
+    
+    // sizeof(frame_ring_t) is a multiple of the cache line thanks to alignas
+    frame_ring_t *ring = aligned_alloc(RING_BUFFER_CACHE_LINE, sizeof(frame_ring_t));
+    if (!ring) {
+        return NULL;
+    }
+    
+    if (ring_storage_alloc(capacity_frames * stride, options, &ring->buffer,
+                           &ring->storage, &ring->mapped_bytes) != 0) {
+        free(ring);
+        return NULL;
+    }
+    
+    ring->capacity = capacity_frames;
+    ring->mask = capacity_frames - 1;
+    ring->stride = stride;
+    ring->element_size = element_size;
+    ring->elements = elements;
+    ring->mirrored = (ring->storage & RING_BUFFER_MIRRORED) != 0;
+    
+    atomic_init(&ring->write_index, 0);
+    atomic_init(&ring->read_index, 0);
+    ring->cached_read_index = 0;
+    ring->cached_write_index = 0;
+    atomic_init(&ring->high_water, 0);
+    bool waitable = options && options->waitable;
+    ring_event_init(&ring->readable, waitable);
+    ring_event_init(&ring->writable, waitable);
+    
+    return ring;
+}
+
+void frame_ring_free(frame_ring_t *ring) {
+    if (ring) {
+        if (ring->storage & RING_BUFFER_MAPPED) {
+            munmap(ring->buffer, ring->mapped_bytes);
+        } else {
+            free(ring->buffer);
+        }
+        free(ring);
+    }
+}
+
+size_t frame_ring_read_available(const frame_ring_t *ring) {
+    size_t w = atomic_load_explicit(&ring->write_index, memory_order_acquire);
+    size_t r = atomic_load_explicit(&ring->read_index, memory_order_relaxed);
+    return w - r;
+}
+
+size_t frame_ring_write_available(const frame_ring_t *ring) {
+    size_t w = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+    size_t r = atomic_load_explicit(&ring->read_index, memory_order_acquire);
+    return ring->capacity - (w - r);
+}
+
+size_t frame_ring_fill_level(const frame_ring_t *ring) {
+    // Read index first: the producer can only grow the gap in the meantime,
+    // so the result never underflows
+    size_t r = atomic_load_explicit(&ring->read_index, memory_order_acquire);
+    size_t w = atomic_load_explicit(&ring->write_index, memory_order_acquire);
+    return w - r;
+}
+
+size_t frame_ring_high_water(const frame_ring_t *ring) {
+    return atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+}
+
+size_t frame_ring_wait_readable(frame_ring_t *ring, size_t min, uint64_t timeout_ns) {
+    if (min > ring->capacity) min = ring->capacity;
+    return ring_event_wait(&ring->readable, frame_ring_read_available, ring, min, timeout_ns);
+}
+
+size_t frame_ring_wait_writable(frame_ring_t *ring, size_t min, uint64_t timeout_ns) {
+    if (min > ring->capacity) min = ring->capacity;
+    return ring_event_wait(&ring->writable, frame_ring_write_available, ring, min, timeout_ns);
+}
+
+void frame_ring_close(frame_ring_t *ring) {
+    ring_event_close(&ring->readable);
+    ring_event_close(&ring->writable);
+}
+
+/**
+ * Describe count frames starting at absolute index pos as up to two spans.
+ * A mirrored ring always needs one: its second mapping continues the first.
+ */
+static void frame_ring_make_span(const frame_ring_t *ring, size_t pos, size_t count,
+                                 frame_ring_span_t *span) {
+    size_t offset = pos & ring->mask;
+    size_t chunk1 = ring->mirrored ? count : ring->capacity - offset;
     
+    if (chunk1 > count) {
+        chunk1 = count;
+    }
+    
+    span->data1 = (unsigned char*)ring->buffer + offset * ring->stride;
+    span->frames1 = chunk1;
+    span->data2 = ring->buffer;
+    span->frames2 = count - chunk1;
+}
+
+size_t frame_ring_write_acquire(frame_ring_t *ring, size_t count, frame_ring_span_t *span) {
+    size_t w = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
+    size_t available = ring->capacity - (w - ring->cached_read_index);
+    
+    if (available < count) {
+        // Looks too full: refresh our view of the consumer. Acquire pairs
+        // with its release so we never overwrite frames it is still reading
+        ring->cached_read_index = atomic_load_explicit(&ring->read_index, memory_order_acquire);
+        available = ring->capacity - (w - ring->cached_read_index);
+    }
+    size_t to_write = (count < available) ? count : available;
+    
+    frame_ring_make_span(ring, w, to_write, span);
     return to_write;
 }
 
-size_t ring_buffer_read(ring_buffer_t *rb, float *data, size_t count) {
-    size_t available = ring_buffer_read_available(rb);
-    size_t to_read = (count < available) ? count : available;
+void frame_ring_write_commit(frame_ring_t *ring, size_t count) {
+    size_t w = atomic_load_explicit(&ring->write_index, memory_order_relaxed);
     
-    if (to_read == 0) {
-        return 0;
+    // Update write index (release semantics ensures data is visible)
+    atomic_store_explicit(&ring->write_index, w + count, memory_order_release);
+    if (ring->readable.enabled) {
+        ring_event_notify(&ring->readable, frame_ring_read_available, ring);
     }
+}
+
+size_t frame_ring_read_acquire(frame_ring_t *ring, size_t count, frame_ring_span_t *span) {
+    size_t r = atomic_load_explicit(&ring->read_index, memory_order_relaxed);
+    size_t available = ring->cached_write_index - r;
     
-    size_t r = atomic_load_explicit(&rb->read_index, memory_order_acquire);
+    if (available < count) {
+        // Looks too empty: refresh our view of the producer. Acquire pairs
+        // with its release so the frames are visible
+        ring->cached_write_index = atomic_load_explicit(&ring->write_index, memory_order_acquire);
+        available = ring->cached_write_index - r;
+    }
     
-    // Read in up to two chunks (handle wrap-around)
-    size_t read_pos = r & rb->mask;
-    size_t chunk1 = rb->capacity - read_pos;
+    // Consumer-owned line, so the peak costs a compare and a rare plain store
+    if (available > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, available, memory_order_relaxed);
+    }
+    size_t to_read = (count < available) ? count : available;
+    
+    frame_ring_make_span(ring, r, to_read, span);
+    return to_read;
+}
+
+void frame_ring_read_release(frame_ring_t *ring, size_t count) {
+    size_t r = atomic_load_explicit(&ring->read_index, memory_order_relaxed);
+    
+    // Release so the producer only reuses the space after we are done with it
+    atomic_store_explicit(&ring->read_index, r + count, memory_order_release);
+    if (ring->writable.enabled) {
+        ring_event_notify(&ring->writable, frame_ring_write_available, ring);
+    }
+}
+
+size_t frame_ring_write(frame_ring_t *ring, const void *frames, size_t count) {
+    frame_ring_span_t span;
+    size_t to_write = frame_ring_write_acquire(ring, count, &span);
     
-    if (chunk1 > to_read) {
-        chunk1 = to_read;
+    if (to_write == 0) {
+        return 0;
+    }
+    
+    // Write in up to two chunks (handle wrap-around)
+    const unsigned char *src = frames;
+    memcpy(span.data1, src, span.frames1 * ring->stride);
+    if (span.frames2 > 0) {
+        memcpy(span.data2, src + span.frames1 * ring->stride, span.frames2 * ring->stride);
     }
     
-    memcpy(data, &rb->buffer[read_pos], chunk1 * sizeof(float));
+    frame_ring_write_commit(ring, to_write);
+    return to_write;
+}
+
+size_t frame_ring_read(frame_ring_t *ring, void *frames, size_t count) {
+    frame_ring_span_t span;
+    size_t to_read = frame_ring_read_acquire(ring, count, &span);
     
-    if (to_read > chunk1) {
-        size_t chunk2 = to_read - chunk1;
-        memcpy(&data[chunk1], &rb->buffer[0], chunk2 * sizeof(float));
+    if (to_read == 0) {
+        return 0;
     }
     
-    // Update read index
-    atomic_store_explicit(&rb->read_index, r + to_read, memory_order_relaxed);
+    // Read in up to two chunks (handle wrap-around)
+    unsigned char *dst = frames;
+    memcpy(dst, span.data1, span.frames1 * ring->stride);
+    if (span.frames2 > 0) {
+        memcpy(dst + span.frames1 * ring->stride, span.data2, span.frames2 * ring->stride);
+    }
     
+    frame_ring_read_release(ring, to_read);
     return to_read;
 }
 
+void frame_ring_reset(frame_ring_t *ring) {
+    atomic_store(&ring->write_index, 0);
+    atomic_store(&ring->read_index, 0);
+    ring->cached_read_index = 0;
+    ring->cached_write_index = 0;
+    atomic_store(&ring->high_water, 0);
+    ring_event_init(&ring->readable, ring->readable.enabled);
+    ring_event_init(&ring->writable, ring->writable.enabled);
+    memset(ring->buffer, 0, ring->capacity * ring->stride);
+}
+
+void frame_ring_span_skip(frame_ring_span_t *span, size_t count, size_t stride) {
+    if (count < span->frames1) {
+        span->data1 = (unsigned char*)span->data1 + count * stride;
+        span->frames1 -= count;
+        return;
+    }
+    count -= span->frames1;
+    if (span->frames2 > 0) {
+        if (count > span->frames2) {
+            count = span->frames2;
+        }
+        span->data1 = (unsigned char*)span->data2 + count * stride;
+        span->frames1 = span->frames2 - count;
+    } else {
+        span->data1 = (unsigned char*)span->data1 + span->frames1 * stride;
+        span->frames1 = 0;
+    }
+    span->data2 = NULL;
+    span->frames2 = 0;
+}
+
+/*
+ * The sample API: a frame ring of single floats, so frames are samples.
+ */
+
+ring_buffer_t* ring_buffer_create(size_t capacity_samples) {
+    return ring_buffer_create_ex(capacity_samples, NULL);
+}
+
+ring_buffer_t* ring_buffer_create_ex(size_t capacity_samples, const ring_buffer_options_t *options) {
+    return frame_ring_create(capacity_samples, sizeof(float), 1, 0, options);
+}
+
+void ring_buffer_free(ring_buffer_t *rb) {
+    frame_ring_free(rb);
+}
+
+static size_t ring_buffer_span(const frame_ring_span_t *frames, ring_buffer_span_t *span) {
+    span->data1 = frames->data1;
+    span->size1 = frames->frames1;
+    span->data2 = frames->data2;
+    span->size2 = frames->frames2;
+    return span->size1 + span->size2;
+}
+
+size_t ring_buffer_write_acquire(ring_buffer_t *rb, size_t count, ring_buffer_span_t *span) {
+    frame_ring_span_t frames;
+    frame_ring_write_acquire(rb, count, &frames);
+    return ring_buffer_span(&frames, span);
+}
+
+void ring_buffer_write_commit(ring_buffer_t *rb, size_t count) {
+    frame_ring_write_commit(rb, count);
+}
+
+size_t ring_buffer_read_acquire(ring_buffer_t *rb, size_t count, ring_buffer_span_t *span) {
+    frame_ring_span_t frames;
+    frame_ring_read_acquire(rb, count, &frames);
+    return ring_buffer_span(&frames, span);
+}
+
+void ring_buffer_read_release(ring_buffer_t *rb, size_t count) {
+    frame_ring_read_release(rb, count);
+}
+
+size_t ring_buffer_write(ring_buffer_t *rb, const float *data, size_t count) {
+    return frame_ring_write(rb, data, count);
+}
+
+size_t ring_buffer_read(ring_buffer_t *rb, float *data, size_t count) {
+    return frame_ring_read(rb, data, count);
+}
+
+size_t ring_buffer_read_available(const ring_buffer_t *rb) {
+    return frame_ring_read_available(rb);
+}
+
+size_t ring_buffer_write_available(const ring_buffer_t *rb) {
+    return frame_ring_write_available(rb);
+}
+
+size_t ring_buffer_wait_readable(ring_buffer_t *rb, size_t min, uint64_t timeout_ns) {
+    return frame_ring_wait_readable(rb, min, timeout_ns);
+}
+
+size_t ring_buffer_wait_writable(ring_buffer_t *rb, size_t min, uint64_t timeout_ns) {
+    return frame_ring_wait_writable(rb, min, timeout_ns);
+}
+
+void ring_buffer_close(ring_buffer_t *rb) {
+    frame_ring_close(rb);
+}
+
+size_t ring_buffer_fill_level(const ring_buffer_t *rb) {
+    return frame_ring_fill_level(rb);
+}
+
+size_t ring_buffer_high_water(const ring_buffer_t *rb) {
+    return frame_ring_high_water(rb);
+}
+
 void ring_buffer_reset(ring_buffer_t *rb) {
-    atomic_store(&rb->write_index, 0);
-    atomic_store(&rb->read_index, 0);
-    memset(rb->buffer, 0, rb->capacity * sizeof(float));
-}
\ No newline at end of file
+    frame_ring_reset(rb);
+}
@@ -2,11 +2,19 @@
 #define RING_BUFFER_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdatomic.h>
+#include <stdalign.h>
 #include <stdbool.h>
 
 /**
  * Lock-free Single-Producer-Single-Consumer (SPSC) ring buffer.
+ *
+ * The ring holds fixed-size frames (frame_ring.h): one interleaved
+ * multichannel frame, an integer I/O frame or a metadata record. All the
+ * index logic below is that frame ring's; ring_buffer_t is the case of one
+ * float per frame, and its API counts samples. Audio that must never be
+ * split between channels belongs in a frame ring of whole frames.
  * 
  * Thread safety:
  *   - ONE thread writes (producer)
@@ -15,18 +23,121 @@
  * 
  * Design:
  *   - Power-of-2 size for fast modulo (bitmask)
- *   - Atomic read/write indices
- *   - Memory ordering: relaxed for indices (data dependencies provide ordering)
+ *   - Atomic read/write indices, each on its own cache line so the
+ *     producer and consumer cores don't bounce a shared line
+ *   - Each side keeps a cached copy of the peer's index and only reloads
+ *     it when the ring looks full (producer) or empty (consumer)
+ *   - Memory ordering: own index relaxed, peer index acquire, stores release
+ *   - Optional blocking (ring_buffer_options_t.waitable):
+ *     ring_buffer_wait_readable/writable spin briefly, then park on a
+ *     futex. Commits and releases only make a syscall when the peer has
+ *     flagged itself as parked and its level is reached
  */
 
+#define RING_BUFFER_CACHE_LINE 64
+
+// How the storage ended up allocated (ring_buffer_t.storage)
+#define RING_BUFFER_MAPPED    0x1u  // mmap'd rather than from the heap
+#define RING_BUFFER_MIRRORED  0x2u  // Mapped twice back to back
+#define RING_BUFFER_HUGETLB   0x4u  // Explicit huge pages
+#define RING_BUFFER_THP       0x8u  // Transparent huge pages advised
+#define RING_BUFFER_LOCKED    0x10u // mlock'd
+
+// Timeout for ring_buffer_wait_readable/writable that never expires
+#define RING_BUFFER_WAIT_FOREVER UINT64_MAX
+
+// Polls before a waiter parks on the futex
+#define RING_BUFFER_WAIT_SPINS 256
+
+// Sleep between polls when waiting on a ring that isn't waitable
+#define RING_BUFFER_POLL_NS 50000
+
+// ring_buffer_event_t.word layout
+#define RING_BUFFER_EVENT_PARKED 0x1u  // A waiter is parked, or about to be
+#define RING_BUFFER_EVENT_CLOSED 0x2u  // Waits return at once
+#define RING_BUFFER_EVENT_COUNT  0x4u  // Wake count increment (upper bits)
+
+/**
+ * One side's parking spot. Every wake changes word, so a wake between the
+ * waiter's last check and its futex call is never lost. need is the level
+ * the waiter is after.
+ */
 typedef struct {
-    float *buffer;              // Audio samples (heap allocated)
-    size_t capacity;            // Must be power of 2
+    atomic_uint word;
+    atomic_size_t need;
+    bool enabled;               // Peer notifies; else waits poll
+} ring_buffer_event_t;
+
+/**
+ * Storage options for ring_buffer_create_ex. Everything beyond alignment
+ * is best effort; ring_buffer_t.storage says what was granted.
+ *
+ * A mirrored ring maps the same pages twice in a row, so buffer[capacity + i]
+ * is buffer[i] and every span is a single contiguous one (size2 == 0):
+ * wrap-around costs nothing, and callers can hand spans straight to code
+ * that wants one pointer. It needs capacity * sizeof(float) to be a multiple
+ * of the page size (of 2 MiB for huge pages), and falls back to the plain
+ * layout otherwise.
+ *
+ * A waitable ring lets either side block in ring_buffer_wait_*. The price
+ * is a full fence in every commit and release, so rings between realtime
+ * threads that never block should leave it off; waits on them fall back
+ * to polling with short sleeps.
+ */
+typedef struct {
+    size_t alignment;           // Bytes, power of 2 (0 = RING_BUFFER_CACHE_LINE)
+    bool huge_pages;            // MAP_HUGETLB, else madvise(MADV_HUGEPAGE)
+    bool lock;                  // mlock the storage
+    bool prefault;              // Fault every page in at create time
+    bool mirrored;              // Map the storage twice back to back
+    bool waitable;              // Futex wake-ups for ring_buffer_wait_*
+} ring_buffer_options_t;
+
+/**
+ * A ring of capacity frames of stride bytes each (see frame_ring.h).
+ */
+typedef struct frame_ring {
+    void *buffer;               // capacity * stride bytes (see storage)
+    size_t capacity;            // Frames, must be power of 2
     size_t mask;                // capacity - 1 (for fast modulo)
+    size_t stride;              // Bytes per frame
+    size_t element_size;        // Bytes per element
+    unsigned int elements;      // Elements per frame (e.g. channels)
+    bool mirrored;              // Spans never wrap
+    unsigned int storage;       // RING_BUFFER_* allocation flags
+    size_t mapped_bytes;        // Length of the mapping when RING_BUFFER_MAPPED
     
-    atomic_size_t write_index;  // Producer updates this
-    atomic_size_t read_index;   // Consumer updates this
-} ring_buffer_t;
+    // Producer-owned cache line
+    alignas(RING_BUFFER_CACHE_LINE) atomic_size_t write_index;
+    size_t cached_read_index;   // Producer's last view of read_index
+    
+    // Consumer-owned cache line
+    alignas(RING_BUFFER_CACHE_LINE) atomic_size_t read_index;
+    size_t cached_write_index;  // Consumer's last view of write_index
+    atomic_size_t high_water;   // Largest fill the consumer has seen
+    
+    // Waiters; only written when someone parks, so normally read-shared
+    alignas(RING_BUFFER_CACHE_LINE) ring_buffer_event_t readable;  // Consumer waits here
+    ring_buffer_event_t writable;                                   // Producer waits here
+} frame_ring_t;
+
+/**
+ * A frame ring of single floats: capacity, indices and spans in samples.
+ */
+typedef frame_ring_t ring_buffer_t;
+
+/**
+ * A region of the ring buffer's storage handed out by the zero-copy API.
+ * Because the region may wrap past the end of the buffer it is described
+ * as up to two contiguous spans; size2 is 0 when it does not wrap, which
+ * is always the case for a mirrored ring.
+ */
+typedef struct {
+    float *data1;
+    size_t size1;
+    float *data2;
+    size_t size2;
+} ring_buffer_span_t;
 
 /**
  * Create a ring buffer.
@@ -35,6 +146,17 @@ typedef struct {
  */
 ring_buffer_t* ring_buffer_create(size_t capacity_samples);
 
+/**
+ * Default options: cache-line aligned heap storage, prefaulted.
+ */
+void ring_buffer_options_init(ring_buffer_options_t *options);
+
+/**
+ * Create a ring buffer with the given storage options (NULL = defaults).
+ * Returns NULL on failure, or if alignment is not a power of 2.
+ */
+ring_buffer_t* ring_buffer_create_ex(size_t capacity_samples, const ring_buffer_options_t *options);
+
 /**
  * Destroy ring buffer and free memory.
  */
@@ -52,16 +174,84 @@ size_t ring_buffer_write(ring_buffer_t *rb, const float *data, size_t count);
  */
 size_t ring_buffer_read(ring_buffer_t *rb, float *data, size_t count);
 
+/**
+ * Zero-copy write (producer side).
+ * Fills span with up to count samples of free space pointing straight into
+ * the ring's storage. Returns the total number of samples in the span.
+ * Nothing becomes visible to the consumer until ring_buffer_write_commit.
+ */
+size_t ring_buffer_write_acquire(ring_buffer_t *rb, size_t count, ring_buffer_span_t *span);
+
+/**
+ * Publish count samples previously obtained from ring_buffer_write_acquire.
+ * count must not exceed the size of the acquired span.
+ */
+void ring_buffer_write_commit(ring_buffer_t *rb, size_t count);
+
+/**
+ * Zero-copy read (consumer side).
+ * Fills span with up to count readable samples pointing straight into the
+ * ring's storage. The consumer may modify them in place (e.g. run effects)
+ * until it calls ring_buffer_read_release. Returns the total span size.
+ */
+size_t ring_buffer_read_acquire(ring_buffer_t *rb, size_t count, ring_buffer_span_t *span);
+
+/**
+ * Hand count samples previously obtained from ring_buffer_read_acquire back
+ * to the producer. count must not exceed the size of the acquired span.
+ */
+void ring_buffer_read_release(ring_buffer_t *rb, size_t count);
+
 /**
  * Get number of samples available to read (consumer side).
+ * Always loads the producer's index; hot loops should call read/acquire
+ * directly, which only do so when the cached view looks empty.
  */
 size_t ring_buffer_read_available(const ring_buffer_t *rb);
 
 /**
  * Get number of samples available to write (producer side).
+ * Always loads the consumer's index; hot loops should call write/acquire
+ * directly, which only do so when the cached view looks full.
  */
 size_t ring_buffer_write_available(const ring_buffer_t *rb);
 
+/**
+ * Block the consumer until at least min samples are readable (min is capped
+ * at the capacity) or timeout_ns passes (RING_BUFFER_WAIT_FOREVER = never).
+ * Spins RING_BUFFER_WAIT_SPINS polls first, then sleeps on a futex
+ * (waitable rings) or polls every RING_BUFFER_POLL_NS.
+ * Returns the samples available, which is below min only on timeout or
+ * once the ring is closed.
+ */
+size_t ring_buffer_wait_readable(ring_buffer_t *rb, size_t min, uint64_t timeout_ns);
+
+/**
+ * Block the producer until at least min samples of space are free, as
+ * ring_buffer_wait_readable. Returns the space available.
+ */
+size_t ring_buffer_wait_writable(ring_buffer_t *rb, size_t min, uint64_t timeout_ns);
+
+/**
+ * Wake both sides and make every later wait return at once, so a thread
+ * parked on the ring notices an end-of-stream or failure flag published
+ * just before. Safe from any thread; ring_buffer_reset reopens the ring.
+ */
+void ring_buffer_close(ring_buffer_t *rb);
+
+/**
+ * Current fill level in samples. Safe from any thread (e.g. a monitor);
+ * the value may be stale by the time the caller looks at it.
+ */
+size_t ring_buffer_fill_level(const ring_buffer_t *rb);
+
+/**
+ * Highest fill level observed by the consumer since creation or reset.
+ * Sampled whenever the consumer acquires, so it is exact at each sample
+ * point and never larger than the true peak. Safe from any thread.
+ */
+size_t ring_buffer_high_water(const ring_buffer_t *rb);
+
 /**
  * Reset the buffer (NOT thread-safe, call only when no I/O is happening).
  */
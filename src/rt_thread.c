@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include "rt_thread.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// MXCSR flush-to-zero (bit 15) and denormals-are-zero (bit 6)
+#define RT_MXCSR_FTZ_DAZ 0x8040u
+
+// FPCR.FZ on AArch64 covers both inputs and results
+#define RT_FPCR_FZ (1ull << 24)
+
+// Handed to the new thread on the creator's stack; valid until ready is set
+typedef struct {
+    int priority;
+    int cpu;
+    void *(*entry)(void *);
+    void *arg;
+    unsigned int applied;
+    atomic_bool ready;
+} rt_start_t;
+
+void rt_config_init(rt_config_t *config) {
+    config->priority = 0;
+    config->cpu = -1;
+    config->lock_memory = false;
+}
+
+bool rt_flush_denormals(void) {
+#if defined(__SSE__)
+    _mm_setcsr(_mm_getcsr() | RT_MXCSR_FTZ_DAZ);
+    return true;
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    __asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ volatile("msr fpcr, %0" : : "r"(fpcr | RT_FPCR_FZ));
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Write one byte per page of a stack frame RT_THREAD_STACK_PREFAULT deep.
+ * Not inlined, so the frame is really below the caller's.
+ */
+static __attribute__((noinline)) void rt_prefault_stack(void) {
+    volatile unsigned char stack[RT_THREAD_STACK_PREFAULT];
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    
+    for (size_t i = 0; i < sizeof(stack); i += page) {
+        stack[i] = 0;
+    }
+}
+
+static void* rt_thread_start(void *arg) {
+    rt_start_t *start = (rt_start_t*)arg;
+    unsigned int applied = 0;
+    
+    // Pin first, so the prefaulted pages come from the core's own node
+    if (start->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(start->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+            applied |= RT_THREAD_PINNED;
+        }
+    }
+    
+    if (start->priority > 0) {
+        struct sched_param param = { .sched_priority = start->priority };
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+            applied |= RT_THREAD_REALTIME;
+        }
+    }
+    
+    if (rt_flush_denormals()) {
+        applied |= RT_THREAD_NO_DENORMALS;
+    }
+    rt_prefault_stack();
+    
+    void *(*entry)(void *) = start->entry;
+    void *entry_arg = start->arg;
+    start->applied = applied;
+    atomic_store_explicit(&start->ready, true, memory_order_release);
+    
+    return entry(entry_arg);
+}
+
+int rt_thread_create(pthread_t *thread, const rt_config_t *config, unsigned int index,
+                     void *(*entry)(void *), void *arg, unsigned int *applied) {
+    rt_start_t start = {
+        .priority = config->priority,
+        .cpu = -1,
+        .entry = entry,
+        .arg = arg,
+    };
+    atomic_init(&start.ready, false);
+    
+    if (config->cpu >= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (online < 1) online = 1;
+        start.cpu = (int)(((long)config->cpu + index) % online);
+    }
+    
+    if (pthread_create(thread, NULL, rt_thread_start, &start) != 0) {
+        return -1;
+    }
+    
+    // Setup is a few syscalls; wait so start can stay on this stack
+    unsigned int spins = 0;
+    while (!atomic_load_explicit(&start.ready, memory_order_acquire)) {
+        utils_backoff(&spins);
+    }
+    
+    if (applied) {
+        *applied = start.applied;
+    }
+    return 0;
+}
+
+int rt_lock_memory(void) {
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : -1;
+}
+
+void rt_unlock_memory(void) {
+    munlockall();
+}
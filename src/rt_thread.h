@@ -0,0 +1,64 @@
+#ifndef RT_THREAD_H
+#define RT_THREAD_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Realtime setup for audio threads.
+ *
+ * rt_thread_create starts a thread that, before running its entry point,
+ * switches itself to SCHED_FIFO at the configured priority, pins itself to
+ * a core, enables flush-to-zero / denormals-are-zero and touches the first
+ * RT_THREAD_STACK_PREFAULT bytes of its stack, so neither a page fault nor
+ * a denormal slow path lands in the middle of a block. Decaying filter
+ * state and compressor envelopes go denormal during silence otherwise.
+ *
+ * Every step is best effort: without CAP_SYS_NICE (or an rtprio limit) the
+ * thread keeps normal scheduling, and the caller learns from the returned
+ * flags what was applied.
+ */
+
+#define RT_THREAD_STACK_PREFAULT (128 * 1024)
+
+// Flags reported by rt_thread_create
+#define RT_THREAD_REALTIME     0x1u  // SCHED_FIFO at the requested priority
+#define RT_THREAD_PINNED       0x2u  // Affinity set to one core
+#define RT_THREAD_NO_DENORMALS 0x4u  // FTZ/DAZ enabled
+
+typedef struct {
+    int priority;          // SCHED_FIFO priority, 1-99; 0 = normal scheduling
+    int cpu;               // First core to pin to; -1 = no pinning
+    bool lock_memory;      // mlockall() before the threads start
+} rt_config_t;
+
+/**
+ * Normal scheduling, no pinning, no memory locking.
+ */
+void rt_config_init(rt_config_t *config);
+
+/**
+ * Start entry(arg) on a new thread set up from config. Threads that share a
+ * config get consecutive cores: index 0 goes on config->cpu, index 1 on the
+ * next core and so on, wrapping around the online cores. Returns once the
+ * thread has finished its setup; *applied (may be NULL) receives the
+ * RT_THREAD_* flags in effect. Returns 0 on success, -1 if the thread could
+ * not be created.
+ */
+int rt_thread_create(pthread_t *thread, const rt_config_t *config, unsigned int index,
+                     void *(*entry)(void *), void *arg, unsigned int *applied);
+
+/**
+ * Enable FTZ/DAZ on the calling thread. Returns false where the CPU has no
+ * such mode.
+ */
+bool rt_flush_denormals(void);
+
+/**
+ * Lock every current and future page of the process in RAM. Returns 0 on
+ * success, -1 if the memlock limit or permissions don't allow it.
+ */
+int rt_lock_memory(void);
+void rt_unlock_memory(void);
+
+#endif // RT_THREAD_H
@@ -0,0 +1,427 @@
+#include "sample_format.h"
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SAMPLE_FORMAT_NEON 1   // vcvtnq (round to nearest) is AArch64 only
+#endif
+
+#define S24_CHUNK 256           // Samples unpacked or packed through the S32 kernels at a time
+
+#define DITHER_SCALE (1.0f / 16777216.0f)   // 2^-24: a 24-bit draw to [0, 1)
+
+/**
+ * Conversion kernels. to_float multiplies by a power of two after an exact
+ * or correctly rounded int-to-float; from_float computes src * scale +
+ * dither, clamps to [lo, hi] and rounds to nearest even. Every step is a
+ * single IEEE operation with no FMA, so all variants agree bit for bit.
+ * The dither for sample i comes from lane i & 3 and is the difference of
+ * two successive 24-bit draws from it: triangular, +/- 1 LSB.
+ */
+typedef struct {
+    const char *name;
+    void (*s16_to_float)(const int16_t *src, float *dst, size_t samples);
+    void (*s32_to_float)(const int32_t *src, float *dst, size_t samples, float scale);
+    void (*float_to_s16)(const float *src, int16_t *dst, size_t samples, sample_dither_t *dither);
+    void (*float_to_s32)(const float *src, int32_t *dst, size_t samples, float scale,
+                         float lo, float hi, sample_dither_t *dither);
+} sample_kernel_t;
+
+static inline uint32_t xorshift32(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static inline float dither_next(sample_dither_t *dither, size_t i) {
+    uint32_t a = xorshift32(dither->lanes[i & 3]);
+    uint32_t b = xorshift32(a);
+    dither->lanes[i & 3] = b;
+    return (float)(int32_t)(a >> 8) * DITHER_SCALE - (float)(int32_t)(b >> 8) * DITHER_SCALE;
+}
+
+/**
+ * One sample of from_float. The clamp is written as min then max so a NaN
+ * lands on hi, as it does in the SIMD min/max instructions.
+ */
+static inline int32_t quantize(float x, float scale, float lo, float hi, float d) {
+    float v = x * scale + d;
+    v = v < hi ? v : hi;
+    v = v > lo ? v : lo;
+    return (int32_t)lrintf(v);
+}
+
+static void s16_to_float_scalar(const int16_t *src, float *dst, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (float)src[i] * (1.0f / 32768.0f);
+    }
+}
+
+static void s32_to_float_scalar(const int32_t *src, float *dst, size_t samples, float scale) {
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+static void float_to_s16_scalar(const float *src, int16_t *dst, size_t samples,
+                                sample_dither_t *dither) {
+    for (size_t i = 0; i < samples; i++) {
+        float d = dither ? dither_next(dither, i) : 0.0f;
+        dst[i] = (int16_t)quantize(src[i], 32768.0f, -32768.0f, 32767.0f, d);
+    }
+}
+
+static void float_to_s32_scalar(const float *src, int32_t *dst, size_t samples, float scale,
+                                float lo, float hi, sample_dither_t *dither) {
+    for (size_t i = 0; i < samples; i++) {
+        float d = dither ? dither_next(dither, i) : 0.0f;
+        dst[i] = quantize(src[i], scale, lo, hi, d);
+    }
+}
+
+#if defined(__SSE2__)
+static inline __m128i xorshift32_sse2(__m128i x) {
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+/**
+ * Four dither values from four lanes, advancing them.
+ */
+static inline __m128 dither_next_sse2(__m128i *lanes) {
+    __m128i a = xorshift32_sse2(*lanes);
+    __m128i b = xorshift32_sse2(a);
+    *lanes = b;
+    __m128 scale = _mm_set1_ps(DITHER_SCALE);
+    return _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a, 8)), scale),
+                      _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(b, 8)), scale));
+}
+
+static inline __m128i quantize_sse2(__m128 x, __m128 scale, __m128 lo, __m128 hi, __m128 d) {
+    __m128 v = _mm_add_ps(_mm_mul_ps(x, scale), d);
+    return _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(v, hi), lo));
+}
+
+static void s16_to_float_sse2(const int16_t *src, float *dst, size_t samples) {
+    __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)&src[i]);
+        // Interleave with itself and shift back down: sign-extends 16 -> 32
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(&dst[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    s16_to_float_scalar(&src[i], &dst[i], samples - i);
+}
+
+static void s32_to_float_sse2(const int32_t *src, float *dst, size_t samples, float scale) {
+    __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    
+    for (; i + 4 <= samples; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(x), s));
+    }
+    s32_to_float_scalar(&src[i], &dst[i], samples - i, scale);
+}
+
+static void float_to_s16_sse2(const float *src, int16_t *dst, size_t samples,
+                              sample_dither_t *dither) {
+    __m128 scale = _mm_set1_ps(32768.0f);
+    __m128 lo = _mm_set1_ps(-32768.0f);
+    __m128 hi = _mm_set1_ps(32767.0f);
+    __m128i lanes = dither ? _mm_loadu_si128((const __m128i*)dither->lanes) : _mm_setzero_si128();
+    __m128 d0 = _mm_setzero_ps();
+    __m128 d1 = _mm_setzero_ps();
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        if (dither) {
+            d0 = dither_next_sse2(&lanes);
+            d1 = dither_next_sse2(&lanes);
+        }
+        __m128i a = quantize_sse2(_mm_loadu_ps(&src[i]), scale, lo, hi, d0);
+        __m128i b = quantize_sse2(_mm_loadu_ps(&src[i + 4]), scale, lo, hi, d1);
+        // Already in range, so the saturating pack is a plain narrowing
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(a, b));
+    }
+    if (dither) {
+        _mm_storeu_si128((__m128i*)dither->lanes, lanes);
+    }
+    float_to_s16_scalar(&src[i], &dst[i], samples - i, dither);
+}
+
+static void float_to_s32_sse2(const float *src, int32_t *dst, size_t samples, float scale,
+                              float lo, float hi, sample_dither_t *dither) {
+    __m128 s = _mm_set1_ps(scale);
+    __m128 l = _mm_set1_ps(lo);
+    __m128 h = _mm_set1_ps(hi);
+    __m128i lanes = dither ? _mm_loadu_si128((const __m128i*)dither->lanes) : _mm_setzero_si128();
+    __m128 d = _mm_setzero_ps();
+    size_t i = 0;
+    
+    for (; i + 4 <= samples; i += 4) {
+        if (dither) {
+            d = dither_next_sse2(&lanes);
+        }
+        _mm_storeu_si128((__m128i*)&dst[i], quantize_sse2(_mm_loadu_ps(&src[i]), s, l, h, d));
+    }
+    if (dither) {
+        _mm_storeu_si128((__m128i*)dither->lanes, lanes);
+    }
+    float_to_s32_scalar(&src[i], &dst[i], samples - i, scale, lo, hi, dither);
+}
+#endif // __SSE2__
+
+#if defined(SAMPLE_FORMAT_NEON)
+static inline uint32x4_t xorshift32_neon(uint32x4_t x) {
+    x = veorq_u32(x, vshlq_n_u32(x, 13));
+    x = veorq_u32(x, vshrq_n_u32(x, 17));
+    return veorq_u32(x, vshlq_n_u32(x, 5));
+}
+
+static inline float32x4_t dither_next_neon(uint32x4_t *lanes) {
+    uint32x4_t a = xorshift32_neon(*lanes);
+    uint32x4_t b = xorshift32_neon(a);
+    *lanes = b;
+    float32x4_t scale = vdupq_n_f32(DITHER_SCALE);
+    return vsubq_f32(vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(a, 8)), scale),
+                     vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(b, 8)), scale));
+}
+
+// vminq/vmaxq propagate NaN; select instead so NaN lands on hi as in scalar
+static inline int32x4_t quantize_neon(float32x4_t x, float32x4_t scale, float32x4_t lo,
+                                      float32x4_t hi, float32x4_t d) {
+    float32x4_t v = vaddq_f32(vmulq_f32(x, scale), d);
+    v = vbslq_f32(vcltq_f32(v, hi), v, hi);
+    v = vbslq_f32(vcgtq_f32(v, lo), v, lo);
+    return vcvtnq_s32_f32(v);
+}
+
+static void s16_to_float_neon(const int16_t *src, float *dst, size_t samples) {
+    float32x4_t scale = vdupq_n_f32(1.0f / 32768.0f);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        int16x8_t x = vld1q_s16(&src[i]);
+        vst1q_f32(&dst[i], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(&dst[i + 4], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), scale));
+    }
+    s16_to_float_scalar(&src[i], &dst[i], samples - i);
+}
+
+static void s32_to_float_neon(const int32_t *src, float *dst, size_t samples, float scale) {
+    float32x4_t s = vdupq_n_f32(scale);
+    size_t i = 0;
+    
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_f32(&dst[i], vmulq_f32(vcvtq_f32_s32(vld1q_s32(&src[i])), s));
+    }
+    s32_to_float_scalar(&src[i], &dst[i], samples - i, scale);
+}
+
+static void float_to_s16_neon(const float *src, int16_t *dst, size_t samples,
+                              sample_dither_t *dither) {
+    float32x4_t scale = vdupq_n_f32(32768.0f);
+    float32x4_t lo = vdupq_n_f32(-32768.0f);
+    float32x4_t hi = vdupq_n_f32(32767.0f);
+    uint32x4_t lanes = dither ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+    float32x4_t d0 = vdupq_n_f32(0.0f);
+    float32x4_t d1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    
+    for (; i + 8 <= samples; i += 8) {
+        if (dither) {
+            d0 = dither_next_neon(&lanes);
+            d1 = dither_next_neon(&lanes);
+        }
+        int32x4_t a = quantize_neon(vld1q_f32(&src[i]), scale, lo, hi, d0);
+        int32x4_t b = quantize_neon(vld1q_f32(&src[i + 4]), scale, lo, hi, d1);
+        vst1q_s16(&dst[i], vcombine_s16(vmovn_s32(a), vmovn_s32(b)));
+    }
+    if (dither) {
+        vst1q_u32(dither->lanes, lanes);
+    }
+    float_to_s16_scalar(&src[i], &dst[i], samples - i, dither);
+}
+
+static void float_to_s32_neon(const float *src, int32_t *dst, size_t samples, float scale,
+                              float lo, float hi, sample_dither_t *dither) {
+    float32x4_t s = vdupq_n_f32(scale);
+    float32x4_t l = vdupq_n_f32(lo);
+    float32x4_t h = vdupq_n_f32(hi);
+    uint32x4_t lanes = dither ? vld1q_u32(dither->lanes) : vdupq_n_u32(0);
+    float32x4_t d = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    
+    for (; i + 4 <= samples; i += 4) {
+        if (dither) {
+            d = dither_next_neon(&lanes);
+        }
+        vst1q_s32(&dst[i], quantize_neon(vld1q_f32(&src[i]), s, l, h, d));
+    }
+    if (dither) {
+        vst1q_u32(dither->lanes, lanes);
+    }
+    float_to_s32_scalar(&src[i], &dst[i], samples - i, scale, lo, hi, dither);
+}
+#endif // SAMPLE_FORMAT_NEON
+
+static const sample_kernel_t sample_kernels[] = {
+#if defined(__SSE2__)
+    { "sse2", s16_to_float_sse2, s32_to_float_sse2, float_to_s16_sse2, float_to_s32_sse2 },
+#endif
+#if defined(SAMPLE_FORMAT_NEON)
+    { "neon", s16_to_float_neon, s32_to_float_neon, float_to_s16_neon, float_to_s32_neon },
+#endif
+    { "scalar", s16_to_float_scalar, s32_to_float_scalar, float_to_s16_scalar, float_to_s32_scalar },
+};
+
+#define SAMPLE_KERNEL_COUNT (sizeof(sample_kernels) / sizeof(sample_kernels[0]))
+
+// Resolved on first use; every thread that races here picks the same entry
+static _Atomic(const sample_kernel_t *) sample_kernel = NULL;
+
+int sample_format_select_kernel(const char *name) {
+    for (size_t i = 0; i < SAMPLE_KERNEL_COUNT; i++) {
+        // Table is in order of preference, so the first one is best
+        if (name == NULL || strcmp(sample_kernels[i].name, name) == 0) {
+            atomic_store_explicit(&sample_kernel, &sample_kernels[i], memory_order_release);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const sample_kernel_t* sample_get_kernel(void) {
+    const sample_kernel_t *kernel = atomic_load_explicit(&sample_kernel, memory_order_acquire);
+    if (!kernel) {
+        sample_format_select_kernel(NULL);
+        kernel = atomic_load_explicit(&sample_kernel, memory_order_acquire);
+    }
+    return kernel;
+}
+
+const char* sample_format_kernel_name(void) {
+    return sample_get_kernel()->name;
+}
+
+size_t sample_format_bytes(sample_format_t format) {
+    switch (format) {
+        case SAMPLE_FORMAT_S32:   return 4;
+        case SAMPLE_FORMAT_S24_3: return 3;
+        case SAMPLE_FORMAT_S16:   return 2;
+        default:                  return sizeof(float);
+    }
+}
+
+const char* sample_format_name(sample_format_t format) {
+    switch (format) {
+        case SAMPLE_FORMAT_S32:   return "S32_LE";
+        case SAMPLE_FORMAT_S24_3: return "S24_3LE";
+        case SAMPLE_FORMAT_S16:   return "S16_LE";
+        default:                  return "FLOAT_LE";
+    }
+}
+
+int sample_format_parse(const char *name, sample_format_t *format) {
+    static const struct { const char *name; sample_format_t format; } names[] = {
+        { "float", SAMPLE_FORMAT_F32 },
+        { "s32", SAMPLE_FORMAT_S32 },
+        { "s24", SAMPLE_FORMAT_S24_3 },
+        { "s16", SAMPLE_FORMAT_S16 },
+    };
+    
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i].name) == 0) {
+            *format = names[i].format;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void sample_dither_init(sample_dither_t *dither, uint32_t seed) {
+    for (int i = 0; i < 4; i++) {
+        // Spread the seed over the lanes; xorshift must never start at 0
+        uint32_t s = (seed + (uint32_t)i + 1u) * 2654435761u;
+        dither->lanes[i] = s ? s : 0x9e3779b9u;
+    }
+}
+
+void sample_format_to_float(sample_format_t format, const void *src, float *dst, size_t samples) {
+    const sample_kernel_t *kernel = sample_get_kernel();
+    
+    switch (format) {
+        case SAMPLE_FORMAT_S32:
+            kernel->s32_to_float((const int32_t*)src, dst, samples, 1.0f / 2147483648.0f);
+            break;
+        case SAMPLE_FORMAT_S16:
+            kernel->s16_to_float((const int16_t*)src, dst, samples);
+            break;
+        case SAMPLE_FORMAT_S24_3: {
+            // Into the top 24 bits of an S32, then the S32 kernel
+            const uint8_t *bytes = (const uint8_t*)src;
+            int32_t wide[S24_CHUNK];
+            for (size_t pos = 0; pos < samples; pos += S24_CHUNK) {
+                size_t n = samples - pos < S24_CHUNK ? samples - pos : S24_CHUNK;
+                for (size_t i = 0; i < n; i++) {
+                    const uint8_t *b = &bytes[(pos + i) * 3];
+                    wide[i] = (int32_t)((uint32_t)b[0] << 8 | (uint32_t)b[1] << 16 |
+                                        (uint32_t)b[2] << 24);
+                }
+                kernel->s32_to_float(wide, &dst[pos], n, 1.0f / 2147483648.0f);
+            }
+            break;
+        }
+        default:
+            memcpy(dst, src, samples * sizeof(float));
+            break;
+    }
+}
+
+void sample_format_from_float(sample_format_t format, const float *src, void *dst,
+                              size_t samples, sample_dither_t *dither) {
+    const sample_kernel_t *kernel = sample_get_kernel();
+    
+    switch (format) {
+        case SAMPLE_FORMAT_S32:
+            // 2^31 - 128: the largest float below 2^31
+            kernel->float_to_s32(src, (int32_t*)dst, samples, 2147483648.0f,
+                                 -2147483648.0f, 2147483520.0f, NULL);
+            break;
+        case SAMPLE_FORMAT_S16:
+            kernel->float_to_s16(src, (int16_t*)dst, samples, dither);
+            break;
+        case SAMPLE_FORMAT_S24_3: {
+            uint8_t *bytes = (uint8_t*)dst;
+            int32_t wide[S24_CHUNK];
+            for (size_t pos = 0; pos < samples; pos += S24_CHUNK) {
+                size_t n = samples - pos < S24_CHUNK ? samples - pos : S24_CHUNK;
+                kernel->float_to_s32(&src[pos], wide, n, 8388608.0f, -8388608.0f, 8388607.0f,
+                                     dither);
+                for (size_t i = 0; i < n; i++) {
+                    uint8_t *b = &bytes[(pos + i) * 3];
+                    uint32_t v = (uint32_t)wide[i];
+                    b[0] = (uint8_t)v;
+                    b[1] = (uint8_t)(v >> 8);
+                    b[2] = (uint8_t)(v >> 16);
+                }
+            }
+            break;
+        }
+        default:
+            memcpy(dst, src, samples * sizeof(float));
+            break;
+    }
+}
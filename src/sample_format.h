@@ -0,0 +1,83 @@
+#ifndef SAMPLE_FORMAT_H
+#define SAMPLE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Device sample formats and conversion to and from the float the DSP runs
+ * on. All are little-endian, which is also the host order on every target
+ * we build for (x86, ARM).
+ *
+ * Integer to float scales by 2^-(bits - 1), so full scale maps to [-1, 1).
+ * Float to integer scales back, adds TPDF dither of +/- 1 LSB when a
+ * dither state is given (S16 and S24 only: a float has no bits below an
+ * S32 LSB to decorrelate), rounds to nearest and saturates.
+ *
+ * S16 and S32 run a SIMD kernel picked once at runtime (SSE2 on x86, NEON
+ * on ARM, scalar elsewhere); S24_3 packs and unpacks its 3-byte samples in
+ * scalar code around the S32 kernels. The dither generator is four
+ * xorshift lanes, one per sample of each group of four, so every kernel
+ * gives bit-identical results.
+ */
+
+typedef enum {
+    SAMPLE_FORMAT_F32,      // FLOAT_LE
+    SAMPLE_FORMAT_S32,      // S32_LE
+    SAMPLE_FORMAT_S24_3,    // S24_3LE: 24 bits packed in 3 bytes
+    SAMPLE_FORMAT_S16,      // S16_LE
+} sample_format_t;
+
+#define SAMPLE_FORMAT_COUNT 4
+#define SAMPLE_FORMAT_AUTO -1   // Where a format is chosen: the best the device has natively
+
+typedef struct {
+    uint32_t lanes[4];      // xorshift32 states, never 0
+} sample_dither_t;
+
+/**
+ * Bytes per sample.
+ */
+size_t sample_format_bytes(sample_format_t format);
+
+/**
+ * ALSA-style name ("FLOAT_LE", "S32_LE", "S24_3LE", "S16_LE").
+ */
+const char* sample_format_name(sample_format_t format);
+
+/**
+ * Parse "float", "s32", "s24" or "s16" (case matters). Returns 0 on
+ * success, -1 for anything else.
+ */
+int sample_format_parse(const char *name, sample_format_t *format);
+
+/**
+ * Seed a dither generator; any seed works.
+ */
+void sample_dither_init(sample_dither_t *dither, uint32_t seed);
+
+/**
+ * Convert samples samples of format at src to float at dst.
+ */
+void sample_format_to_float(sample_format_t format, const void *src, float *dst, size_t samples);
+
+/**
+ * Convert samples floats at src to format at dst, dithered when dither is
+ * not NULL. src and dst must not overlap.
+ */
+void sample_format_from_float(sample_format_t format, const float *src, void *dst,
+                              size_t samples, sample_dither_t *dither);
+
+/**
+ * Name of the kernel in use ("sse2", "neon" or "scalar").
+ */
+const char* sample_format_kernel_name(void);
+
+/**
+ * Force a kernel by name, or pick the best available with NULL. For tests
+ * and benchmarks; call before any audio thread starts. Returns 0 on
+ * success, -1 if the kernel isn't built in.
+ */
+int sample_format_select_kernel(const char *name);
+
+#endif // SAMPLE_FORMAT_H
@@ -0,0 +1,339 @@
+#define _GNU_SOURCE
+#include "split.h"
+#include "effect_graph.h"
+#include "convolver.h"
+#include "limiter.h"
+#include "wav_io.h"
+#include "wav_writer.h"
+#include "rt_thread.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef struct {
+    const split_config_t *config;
+    unsigned int index;
+    pthread_t thread;
+    int fd;                     // The output, shared: every worker writes its own range
+    unsigned int channels;
+    size_t chunk_frames;
+    uint64_t begin;             // Output frames [begin, end)
+    uint64_t end;
+    uint64_t preroll;
+    
+    int result;
+    uint64_t busy_ns;
+    uint64_t warmup_frames;
+} split_worker_t;
+
+/**
+ * Slowest per-frame decay of a cascade: its largest pole radius.
+ */
+static double cascade_radius(const biquad_cascade_t *cascade) {
+    double radius = 0.0;
+    for (unsigned int s = 0; s < cascade->sections; s++) {
+        double a1 = cascade->a1[s], a2 = cascade->a2[s];
+        double disc = a1 * a1 - 4.0 * a2;
+        double r;
+        if (disc < 0.0) {
+            r = sqrt(a2);   // Complex pair: |p|^2 = a2
+        } else {
+            double root = sqrt(disc);
+            r = fmax(fabs(-a1 + root), fabs(-a1 - root)) / 2.0;
+        }
+        radius = fmax(radius, r);
+    }
+    return radius;
+}
+
+/**
+ * The memory of the graph effect_graph_from_config builds: rho, the
+ * slowest factor per frame by which an old state fades (0 for none), and
+ * finite, the frames after which the rest of it is gone entirely.
+ */
+static void split_memory(const effect_chain_config_t *config, float sample_rate,
+                         double *rho, size_t *finite) {
+    *rho = 0.0;
+    *finite = 0;
+    if (!config->enabled) {
+        return;
+    }
+    
+    // The chain's own stages, designed exactly as the graph designs them
+    effect_chain_t chain;
+    effect_chain_configure(&chain, config, sample_rate, 1);
+    if (chain.filter_enabled) {
+        *rho = fmax(*rho, cascade_radius(&chain.filter));
+    }
+    if (chain.compressor_enabled) {
+        *rho = fmax(*rho, fmax(chain.compressor.attack_coef, chain.compressor.release_coef));
+    }
+    if (config->lowpass_freq > 0 && config->highpass_freq > 0) {
+        biquad_cascade_t highpass;
+        unsigned int order = config->filter_order ? config->filter_order : 2;
+        if (biquad_cascade_highpass(&highpass, sample_rate, config->highpass_freq,
+                                    order, 1) == 0) {
+            *rho = fmax(*rho, cascade_radius(&highpass));
+        }
+    }
+    
+    if (config->ir) {
+        *finite += config->ir->frames;
+    }
+    if (config->limit) {
+        limiter_t *lim = limiter_create(1, sample_rate, config->limit_ceiling_db,
+                                        config->limit_lookahead_ms, LIMITER_RELEASE_MS);
+        if (lim) {
+            *rho = fmax(*rho, lim->release_coef);
+            *finite += lim->window;
+            limiter_free(lim);
+        }
+    }
+}
+
+size_t split_preroll_frames(const effect_chain_config_t *config, float sample_rate,
+                            double error_db) {
+    double rho;
+    size_t finite;
+    split_memory(config, sample_rate, &rho, &finite);
+    if (rho <= 0.0 || error_db >= 0.0) {
+        return finite;
+    }
+    if (rho >= 1.0) {
+        return SIZE_MAX;   // Never settles (a pole on the unit circle)
+    }
+    return finite + (size_t)ceil(error_db / (20.0 * log10(rho)));
+}
+
+double split_error_db(const effect_chain_config_t *config, float sample_rate, size_t preroll) {
+    double rho;
+    size_t finite;
+    split_memory(config, sample_rate, &rho, &finite);
+    if (preroll < finite || rho >= 1.0) {
+        return 0.0;
+    }
+    if (rho <= 0.0) {
+        return -INFINITY;
+    }
+    return (double)(preroll - finite) * 20.0 * log10(rho);
+}
+
+void split_config_init(split_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->map_input = true;
+    config->preroll_ms = -1.0;
+    config->error_db = SPLIT_ERROR_DB;
+    config->chunk_frames = SPLIT_CHUNK_FRAMES;
+}
+
+/**
+ * pwrite all of it, retrying short writes and interrupts.
+ */
+static int write_at(int fd, const void *data, size_t bytes, uint64_t offset) {
+    const unsigned char *p = data;
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, p, bytes, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        bytes -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Render one segment: from preroll frames before it (or the start of the
+ * file), through the graph's latency past it, padding with silence after
+ * the file as --stream does, keeping only [begin, end).
+ */
+static int split_render(split_worker_t *w, float *block) {
+    const split_config_t *config = w->config;
+    unsigned int channels = w->channels;
+    
+    wav_io_input_t input;
+    if (wav_io_input_open(&input, config->input_file, config->map_input) != 0) {
+        return -1;
+    }
+    uint64_t from = w->begin > w->preroll ? w->begin - w->preroll : 0;
+    wav_io_reader_t reader;
+    if (wav_io_input_seek(&input, from) != 0 || wav_io_reader_init(&reader, &input, 0) != 0) {
+        wav_io_input_close(&input);
+        return -1;
+    }
+    effect_graph_t *graph = effect_graph_from_config(&config->effects, input.sample_rate,
+                                                     channels, 0);
+    if (!graph) {
+        wav_io_reader_free(&reader);
+        wav_io_input_close(&input);
+        return -1;
+    }
+    size_t delay = effect_graph_latency(graph);
+    wav_io_reader_pad(&reader, delay);
+    
+    // Output frame t is what the graph gives for input frame t + delay
+    uint64_t skip = w->begin + delay - from;
+    uint64_t left = w->end + delay - from;
+    uint64_t offset = WAV_WRITER_HEADER_BYTES + w->begin * channels * sizeof(float);
+    int result = 0;
+    while (left > 0) {
+        size_t n = left < w->chunk_frames ? (size_t)left : w->chunk_frames;
+        frame_ring_span_t span = { block, n, NULL, 0 };
+        size_t frames = wav_io_reader_read(&reader, &span);
+        if (frames == 0) {
+            result = -1;   // The file is shorter than its header says
+            break;
+        }
+        effect_graph_process(graph, block, frames);
+        left -= frames;
+        
+        size_t dropped = skip < frames ? (size_t)skip : frames;
+        skip -= dropped;
+        size_t bytes = (frames - dropped) * channels * sizeof(float);
+        if (bytes > 0 && write_at(w->fd, &block[dropped * channels], bytes, offset) != 0) {
+            result = -1;
+            break;
+        }
+        offset += bytes;
+    }
+    
+    w->warmup_frames = w->begin - from;
+    effect_graph_free(graph);
+    wav_io_reader_free(&reader);
+    wav_io_input_close(&input);
+    return result;
+}
+
+static void* split_worker(void *arg) {
+    split_worker_t *w = (split_worker_t*)arg;
+    
+    // As every other file mode, so the output comes out the same bits
+    rt_flush_denormals();
+    
+    uint64_t start = utils_now_ns();
+    float *block = malloc(w->chunk_frames * w->channels * sizeof(float));
+    w->result = block ? split_render(w, block) : -1;
+    free(block);
+    w->busy_ns = utils_now_ns() - start;
+    return NULL;
+}
+
+int split_run(const split_config_t *config, split_stats_t *stats) {
+    split_stats_t total;
+    memset(&total, 0, sizeof(total));
+    if (stats) {
+        *stats = total;
+    }
+    
+    // Open once here for the format; each worker opens its own
+    wav_io_input_t input;
+    if (wav_io_input_open(&input, config->input_file, config->map_input) != 0) {
+        fprintf(stderr, "✗ Error: Failed to open input file '%s'\n", config->input_file);
+        return 1;
+    }
+    unsigned int channels = input.channels;
+    unsigned int sample_rate = input.sample_rate;
+    uint64_t frames = input.total_frames;
+    wav_io_input_close(&input);
+    
+    const convolver_ir_t *ir = config->effects.ir;
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS ||
+        (ir && ir->channels != 1 && ir->channels != channels)) {
+        fprintf(stderr, "✗ Error: %u channels don't fit the effects\n", channels);
+        return 1;
+    }
+    
+    size_t preroll;
+    if (config->preroll_ms >= 0.0) {
+        preroll = (size_t)llround(config->preroll_ms * sample_rate / 1000.0);
+    } else {
+        preroll = split_preroll_frames(&config->effects, sample_rate, config->error_db);
+    }
+    
+    // Every segment at least as long as its warm-up, or the warm-up costs
+    // more than the split gains
+    unsigned int workers = config->workers;
+    if (workers == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cores > 0 ? (unsigned int)cores : 1;
+    }
+    uint64_t shortest = preroll > SPLIT_MIN_SEGMENT_FRAMES ? preroll : SPLIT_MIN_SEGMENT_FRAMES;
+    uint64_t most = frames / shortest;
+    unsigned int segments = most < workers ? (unsigned int)most : workers;
+    if (segments == 0) {
+        segments = 1;
+    }
+    
+    int fd = open(config->output_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", config->output_file);
+        return 1;
+    }
+    uint64_t data_bytes = frames * channels * sizeof(float);
+    unsigned char header[WAV_WRITER_HEADER_BYTES];
+    wav_writer_format_header(header, SAMPLE_FORMAT_F32, channels, sample_rate, data_bytes);
+    split_worker_t *workers_state = calloc(segments, sizeof(split_worker_t));
+    if (!workers_state || write_at(fd, header, sizeof(header), 0) != 0 ||
+        ftruncate(fd, (off_t)(sizeof(header) + data_bytes)) != 0) {
+        fprintf(stderr, "✗ Error: Failed to write '%s'\n", config->output_file);
+        free(workers_state);
+        close(fd);
+        return 1;
+    }
+    
+    uint64_t start = utils_now_ns();
+    unsigned int started = 0;
+    for (unsigned int i = 0; i < segments; i++) {
+        split_worker_t *w = &workers_state[i];
+        w->config = config;
+        w->index = i;
+        w->fd = fd;
+        w->channels = channels;
+        w->chunk_frames = config->chunk_frames ? config->chunk_frames : SPLIT_CHUNK_FRAMES;
+        w->begin = frames * i / segments;
+        w->end = frames * (i + 1) / segments;
+        w->preroll = preroll;
+        if (pthread_create(&w->thread, NULL, split_worker, w) != 0) {
+            // A segment has only one place it can be rendered
+            fprintf(stderr, "✗ Error: Failed to start worker %u\n", i);
+            break;
+        }
+        started++;
+    }
+    
+    int result = started == segments ? 0 : 1;
+    for (unsigned int i = 0; i < started; i++) {
+        pthread_join(workers_state[i].thread, NULL);
+        if (workers_state[i].result != 0) {
+            fprintf(stderr, "✗ Error: Segment %u failed\n", i);
+            result = 1;
+        }
+        total.busy_seconds += workers_state[i].busy_ns / 1e9;
+        total.warmup_frames += workers_state[i].warmup_frames;
+    }
+    total.wall_seconds = (utils_now_ns() - start) / 1e9;
+    if (close(fd) != 0) {
+        result = 1;
+    }
+    free(workers_state);
+    
+    total.sample_rate = sample_rate;
+    total.channels = channels;
+    total.total_frames = frames;
+    total.segments = segments;
+    total.preroll_frames = preroll;
+    total.error_db = split_error_db(&config->effects, sample_rate, preroll);
+    total.exact = isinf(split_error_db(&config->effects, sample_rate, 0));
+    if (stats) {
+        *stats = total;
+    }
+    return result;
+}
@@ -0,0 +1,92 @@
+#ifndef SPLIT_H
+#define SPLIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "effects.h"
+
+/**
+ * Split rendering: one long file over several cores.
+ *
+ * The filter and compressor carry state from sample to sample, so a file
+ * can't simply be cut and its pieces processed apart. Here the output is
+ * cut into one contiguous segment per worker, and each worker renders its
+ * segment with a graph of its own that first runs over the preroll frames
+ * before the segment and throws them away, so the filter, envelope and
+ * limiter states have converged on what a serial render would hold by the
+ * time the segment starts. Workers write their segment straight to its
+ * place in the output file (pwrite), so nothing is stitched afterwards.
+ *
+ * What the warm-up leaves behind is bounded from the chain's memory: IIR
+ * filter poles, compressor and limiter release decay by at most their
+ * slowest per-frame factor rho, so after a preroll of P frames (past the
+ * finite memory: limiter window, IR length) the difference from serial is
+ * at most rho^P of full scale, to a small constant factor (Butterworth
+ * states stay near the signal level). Below that the two renders differ
+ * by float rounding, which a filter amplifies by its noise gain: a few
+ * ulps for most settings, but a high-pass within a few tens of Hz of DC
+ * keeps its rounding noise around -65 dBFS, in a serial render as much as
+ * in a split one. A chain with no memory (gain only, or bypassed) needs no
+ * preroll and its output is bit-identical to serial rendering.
+ *
+ * Files are rendered at their own rate; the segments need a seekable input
+ * and a resampler can't start mid-stream on the same phase.
+ */
+
+#define SPLIT_ERROR_DB -120.0         // Default warm-up error bound, dB below full scale
+#define SPLIT_CHUNK_FRAMES 4096       // Frames per read-process-write step
+#define SPLIT_MIN_SEGMENT_FRAMES 65536  // No segment shorter, however many workers
+
+typedef struct {
+    const char *input_file;
+    const char *output_file;    // 32-bit float, as --stream writes
+    effect_chain_config_t effects;
+    unsigned int workers;       // 0 = one per online core
+    bool map_input;             // Map float input (wav_io_input_open)
+    double preroll_ms;          // Warm-up per segment; < 0 = enough for error_db
+    double error_db;            // Bound the derived preroll meets (default SPLIT_ERROR_DB)
+    size_t chunk_frames;        // 0 = SPLIT_CHUNK_FRAMES
+} split_config_t;
+
+typedef struct {
+    unsigned int sample_rate;
+    unsigned int channels;
+    uint64_t total_frames;
+    unsigned int segments;      // Workers actually used
+    size_t preroll_frames;      // Warm-up per segment (the first has none to run)
+    double error_db;            // Bound for that preroll; -INFINITY when only rounding is left
+    bool exact;                 // No memory in the chain: bit-identical to serial
+    double wall_seconds;
+    double busy_seconds;        // Summed over the workers
+    uint64_t warmup_frames;     // Extra frames rendered and thrown away
+} split_stats_t;
+
+/**
+ * Defaults: workers per core, mapped input, preroll from SPLIT_ERROR_DB.
+ */
+void split_config_init(split_config_t *config);
+
+/**
+ * Frames of warm-up the chain needs for its effect on the output to stay
+ * below error_db (dB, negative). 0 when the chain has no memory.
+ */
+size_t split_preroll_frames(const effect_chain_config_t *config, float sample_rate,
+                            double error_db);
+
+/**
+ * The bound split_preroll_frames works to: how far below full scale (dB)
+ * a warm-up of preroll frames leaves the difference from serial. 0 when
+ * preroll is shorter than the chain's finite memory (no bound);
+ * -INFINITY when nothing but float rounding is left (no memory, or
+ * only finite memory within preroll).
+ */
+double split_error_db(const effect_chain_config_t *config, float sample_rate, size_t preroll);
+
+/**
+ * Render input_file into output_file across the workers. Fills stats (may
+ * be NULL). Returns 0 on success.
+ */
+int split_run(const split_config_t *config, split_stats_t *stats);
+
+#endif // SPLIT_H
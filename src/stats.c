@@ -0,0 +1,96 @@
+#include "stats.h"
+
+void block_timing_init(block_timing_t *timing, uint64_t deadline_ns) {
+    timing->deadline_ns = deadline_ns;
+    for (size_t i = 0; i < BLOCK_TIMING_BUCKETS; i++) {
+        atomic_init(&timing->buckets[i], 0);
+    }
+    atomic_init(&timing->count, 0);
+    atomic_init(&timing->max_ns, 0);
+    atomic_init(&timing->over_deadline, 0);
+}
+
+/**
+ * Bucket index: octave from the position of the top bit, sub-bucket from
+ * the next three bits below it.
+ */
+static size_t bucket_index(uint64_t ns) {
+    if (ns < (1ull << BLOCK_TIMING_MIN_SHIFT)) {
+        return 0;
+    }
+    
+    unsigned int top = 63 - (unsigned int)__builtin_clzll(ns);
+    size_t octave = top - BLOCK_TIMING_MIN_SHIFT;
+    if (octave >= BLOCK_TIMING_OCTAVES) {
+        return BLOCK_TIMING_BUCKETS - 1;
+    }
+    
+    size_t sub = (size_t)(ns >> (top - 3)) & (BLOCK_TIMING_SUB_BUCKETS - 1);
+    return octave * BLOCK_TIMING_SUB_BUCKETS + sub;
+}
+
+/**
+ * Upper edge (exclusive) of a bucket, in ns.
+ */
+static uint64_t bucket_upper_ns(size_t index) {
+    if (index >= BLOCK_TIMING_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    
+    size_t octave = index / BLOCK_TIMING_SUB_BUCKETS;
+    size_t sub = index % BLOCK_TIMING_SUB_BUCKETS;
+    unsigned int top = (unsigned int)octave + BLOCK_TIMING_MIN_SHIFT;
+    return (1ull << top) + ((uint64_t)(sub + 1) << (top - 3));
+}
+
+void block_timing_record(block_timing_t *timing, uint64_t ns) {
+    stats_counter_add(&timing->buckets[bucket_index(ns)], 1);
+    stats_counter_add(&timing->count, 1);
+    
+    if (ns > atomic_load_explicit(&timing->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&timing->max_ns, ns, memory_order_relaxed);
+    }
+    if (timing->deadline_ns && ns > timing->deadline_ns) {
+        stats_counter_add(&timing->over_deadline, 1);
+    }
+}
+
+void block_timing_summarize(const block_timing_t *timing, block_timing_summary_t *summary) {
+    uint64_t counts[BLOCK_TIMING_BUCKETS];
+    uint64_t total = 0;
+    
+    // Sum the buckets we actually copied so percentiles stay self-consistent
+    for (size_t i = 0; i < BLOCK_TIMING_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&timing->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    
+    summary->count = total;
+    summary->deadline_ns = timing->deadline_ns;
+    summary->max_ns = atomic_load_explicit(&timing->max_ns, memory_order_relaxed);
+    summary->over_deadline = atomic_load_explicit(&timing->over_deadline, memory_order_relaxed);
+    summary->p50_ns = 0;
+    summary->p99_ns = 0;
+    
+    if (total == 0) {
+        return;
+    }
+    
+    uint64_t p50_rank = (total + 1) / 2;
+    uint64_t p99_rank = total - total / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BLOCK_TIMING_BUCKETS; i++) {
+        seen += counts[i];
+        if (summary->p50_ns == 0 && seen >= p50_rank) {
+            summary->p50_ns = bucket_upper_ns(i);
+        }
+        if (seen >= p99_rank) {
+            summary->p99_ns = bucket_upper_ns(i);
+            break;
+        }
+    }
+    
+    // Bucket edges overestimate; the exact maximum bounds every percentile
+    if (summary->p50_ns > summary->max_ns) summary->p50_ns = summary->max_ns;
+    if (summary->p99_ns > summary->max_ns) summary->p99_ns = summary->max_ns;
+}
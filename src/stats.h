@@ -0,0 +1,64 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/**
+ * Lock-free runtime statistics.
+ *
+ * Every counter has exactly one writer (normally an audio thread) and any
+ * number of readers. Writers use relaxed load/store pairs instead of
+ * atomic read-modify-write, so recording never takes a locked bus cycle
+ * and readers never disturb the writer beyond sharing its cache lines.
+ */
+
+/**
+ * Add n to a single-writer counter.
+ */
+static inline void stats_counter_add(atomic_uint_least64_t *counter, uint64_t n) {
+    uint64_t v = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, v + n, memory_order_relaxed);
+}
+
+/**
+ * Log-linear histogram of per-block processing time: 8 buckets per octave
+ * (about 9% resolution) from 64 ns up to ~4 s, one overflow bucket above.
+ */
+#define BLOCK_TIMING_MIN_SHIFT 6
+#define BLOCK_TIMING_OCTAVES 26
+#define BLOCK_TIMING_SUB_BUCKETS 8
+#define BLOCK_TIMING_BUCKETS (BLOCK_TIMING_OCTAVES * BLOCK_TIMING_SUB_BUCKETS + 1)
+
+typedef struct {
+    uint64_t deadline_ns;       // Budget per block (e.g. one period)
+    atomic_uint_least64_t buckets[BLOCK_TIMING_BUCKETS];
+    atomic_uint_least64_t count;
+    atomic_uint_least64_t max_ns;
+    atomic_uint_least64_t over_deadline;
+} block_timing_t;
+
+typedef struct {
+    uint64_t count;
+    uint64_t deadline_ns;
+    uint64_t p50_ns;            // Upper edge of the bucket holding the median
+    uint64_t p99_ns;
+    uint64_t max_ns;            // Exact
+    uint64_t over_deadline;     // Blocks that took longer than deadline_ns
+} block_timing_summary_t;
+
+void block_timing_init(block_timing_t *timing, uint64_t deadline_ns);
+
+/**
+ * Record one block (single writer, wait-free, no syscalls).
+ */
+void block_timing_record(block_timing_t *timing, uint64_t ns);
+
+/**
+ * Snapshot percentiles from any thread. Concurrent recording may make the
+ * snapshot off by a block or two, never inconsistent enough to matter.
+ */
+void block_timing_summarize(const block_timing_t *timing, block_timing_summary_t *summary);
+
+#endif // STATS_H
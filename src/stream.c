@@ -0,0 +1,174 @@
+#include "stream.h"
+#include "frame_ring.h"
+#include "effect_graph.h"
+#include "convolver.h"
+#include "wav_io.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Decode up to count frames straight into the ring (producer side).
+ * Returns the number of frames committed; 0 means end of input or full ring.
+ */
+static size_t stream_decode_into_ring(wav_io_reader_t *in, frame_ring_t *ring, size_t count) {
+    frame_ring_span_t span;
+    if (frame_ring_write_acquire(ring, count, &span) == 0) {
+        return 0;
+    }
+    
+    size_t decoded = wav_io_reader_read(in, &span);
+    frame_ring_write_commit(ring, decoded);
+    return decoded;
+}
+
+/**
+ * Process and encode up to count frames straight out of the ring (consumer side),
+ * dropping the first *skip frames of output (the graph's latency).
+ * Returns the number of frames consumed.
+ */
+static size_t stream_encode_from_ring(wav_writer_t *out, frame_ring_t *ring,
+                                      effect_graph_t *effects, block_timing_t *timing,
+                                      size_t count, size_t *skip) {
+    frame_ring_span_t span;
+    size_t acquired = frame_ring_read_acquire(ring, count, &span);
+    if (acquired == 0) {
+        return 0;
+    }
+    
+    uint64_t t0 = utils_now_ns();
+    effect_graph_process_split(effects, &span);
+    block_timing_record(timing, utils_now_ns() - t0);
+    
+    size_t dropped = *skip < acquired ? *skip : acquired;
+    frame_ring_span_t rest = span;
+    frame_ring_span_skip(&rest, dropped, ring->stride);
+    wav_writer_write_span(out, &rest, acquired - dropped);
+    *skip -= dropped;
+    
+    frame_ring_read_release(ring, acquired);
+    return acquired;
+}
+
+int stream_run(const stream_config_t *config, stream_stats_t *stats) {
+    stream_stats_t st;
+    memset(&st, 0, sizeof(st));
+    
+    wav_io_input_t input;
+    if (wav_io_input_open(&input, config->input_file, config->map_input) != 0) {
+        fprintf(stderr, "✗ Error: Failed to open input file '%s'\n", config->input_file);
+        return 1;
+    }
+    
+    unsigned int channels = input.channels;
+    st.input_rate = input.sample_rate;
+    st.channels = channels;
+    st.input_mapped = input.mapped;
+    
+    if (channels == 0 || channels > EFFECT_MAX_CHANNELS) {
+        fprintf(stderr, "✗ Error: %u channels not supported (1-%d)\n",
+                channels, EFFECT_MAX_CHANNELS);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    const convolver_ir_t *ir = config->effects.ir;
+    if (ir && ir->channels != 1 && ir->channels != channels) {
+        fprintf(stderr, "✗ Error: A %u-channel IR doesn't fit %u-channel audio\n",
+                ir->channels, channels);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    
+    // Converted on the way into the ring when another rate is asked for
+    wav_io_reader_t in;
+    if (wav_io_reader_init(&in, &input, config->sample_rate) != 0) {
+        fprintf(stderr, "✗ Error: Can't convert %u Hz to %u Hz\n",
+                input.sample_rate, config->sample_rate);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    unsigned int sample_rate = in.sample_rate;
+    st.sample_rate = sample_rate;
+    st.total_frames = wav_io_reader_total_frames(&in);
+    
+    frame_ring_t *ring = frame_ring_f32_create(config->ring_frames, channels, NULL);
+    if (!ring) {
+        fprintf(stderr, "✗ Error: Failed to create ring buffer\n");
+        wav_io_reader_free(&in);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    
+    // Offline: every frame must reach the file, so wait for room instead of dropping
+    wav_writer_config_t writer = config->writer;
+    writer.block = true;
+    wav_writer_t *out = wav_writer_open(config->output_file, channels, sample_rate, &writer);
+    if (!out) {
+        fprintf(stderr, "✗ Error: Failed to create output file '%s'\n", config->output_file);
+        frame_ring_free(ring);
+        wav_io_reader_free(&in);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    
+    effect_graph_t *effects = effect_graph_from_config(&config->effects, sample_rate,
+                                                       channels, 0);
+    if (!effects) {
+        fprintf(stderr, "✗ Error: Failed to create effect graph\n");
+        wav_writer_close(out, NULL);
+        frame_ring_free(ring);
+        wav_io_reader_free(&in);
+        wav_io_input_close(&input);
+        return 1;
+    }
+    
+    // Run the graph's latency worth of silence in after the file and drop
+    // as much from the start, so the output lines up with the input
+    size_t delay = effect_graph_latency(effects);
+    size_t skip = delay;
+    wav_io_reader_pad(&in, delay);
+    
+    size_t chunk = config->chunk_frames;
+    block_timing_t timing;
+    block_timing_init(&timing, (uint64_t)chunk * 1000000000ull / sample_rate);
+    
+    uint64_t start = utils_now_ns();
+    bool input_done = false;
+    
+    while (true) {
+        if (!input_done) {
+            if (frame_ring_write_available(ring) >= chunk &&
+                stream_decode_into_ring(&in, ring, chunk) < chunk) {
+                input_done = true;
+            }
+        }
+        
+        size_t consumed = stream_encode_from_ring(out, ring, effects, &timing, chunk, &skip);
+        st.frames_processed += consumed;
+        if (config->progress) {
+            config->progress(st.frames_processed, st.total_frames + delay,
+                             config->progress_ctx);
+        }
+        
+        if (input_done && consumed == 0) {
+            break;
+        }
+    }
+    
+    st.wall_seconds = (utils_now_ns() - start) / 1e9;
+    block_timing_summarize(&timing, &st.dsp_blocks);
+    
+    int result = wav_writer_close(out, &st.writer) == 0 ? 0 : 1;
+    if (result != 0) {
+        fprintf(stderr, "✗ Error: Failed to write '%s'\n", config->output_file);
+    }
+    
+    effect_graph_free(effects);
+    frame_ring_free(ring);
+    wav_io_reader_free(&in);
+    wav_io_input_close(&input);
+    if (stats) {
+        *stats = st;
+    }
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "effects.h"
+#include "stats.h"
+#include "wav_writer.h"
+
+/**
+ * Single-threaded streaming render: decode, process and encode chunk by
+ * chunk through one ring, so memory use stays at the size of the ring no
+ * matter how long the file is, and output starts before the input has
+ * been fully read. The output is written on the writer's own thread, so
+ * DSP never waits on the disk unless the writer's queue fills.
+ */
+
+typedef struct {
+    const char *input_file;
+    const char *output_file;
+    unsigned int sample_rate;  // Render at this rate, converting on decode (0 = the input's)
+    bool map_input;            // Map float input instead of decoding it (wav_io_input_open)
+    effect_chain_config_t effects;
+    size_t ring_frames;        // Frames in the ring (power of 2)
+    size_t chunk_frames;       // Frames decoded and processed per step
+    wav_writer_config_t writer; // Output format and queue (block is forced on)
+    
+    // Called after every chunk (may be NULL); ctx is progress_ctx
+    void (*progress)(uint64_t processed, uint64_t total, void *ctx);
+    void *progress_ctx;
+} stream_config_t;
+
+typedef struct {
+    unsigned int sample_rate;  // Of the output
+    unsigned int input_rate;
+    unsigned int channels;
+    bool input_mapped;         // Float samples were copied straight from the mapped file
+    uint64_t total_frames;     // The input header's count, at the output rate
+    uint64_t frames_processed; // Through the graph, its latency's flush included
+    double wall_seconds;
+    block_timing_summary_t dsp_blocks;  // Per-chunk effect time vs the chunk's duration
+    wav_writer_stats_t writer;
+} stream_stats_t;
+
+/**
+ * Render config->input_file into config->output_file. Fills stats (may be
+ * NULL). Returns 0 on success, non-zero on error.
+ */
+int stream_run(const stream_config_t *config, stream_stats_t *stats);
+
+#endif // STREAM_H
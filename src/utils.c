@@ -0,0 +1,34 @@
+#define _POSIX_C_SOURCE 200809L
+#include "utils.h"
+#include <time.h>
+#include <sched.h>
+
+#define BACKOFF_SPIN_LIMIT 64
+#define BACKOFF_YIELD_LIMIT 128
+#define BACKOFF_SLEEP_NS 50000
+
+uint64_t utils_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void utils_sleep_ns(uint64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+    nanosleep(&ts, NULL);
+}
+
+void utils_backoff(unsigned int *spins) {
+    unsigned int n = (*spins)++;
+    
+    if (n < BACKOFF_SPIN_LIMIT) {
+        return;
+    }
+    if (n < BACKOFF_YIELD_LIMIT) {
+        sched_yield();
+        return;
+    }
+    utils_sleep_ns(BACKOFF_SLEEP_NS);
+}
@@ -0,0 +1,27 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdint.h>
+
+/**
+ * Small helpers shared by the processing modes.
+ */
+
+/**
+ * Monotonic clock in nanoseconds.
+ */
+uint64_t utils_now_ns(void);
+
+/**
+ * Sleep for roughly ns nanoseconds.
+ */
+void utils_sleep_ns(uint64_t ns);
+
+/**
+ * Back off while waiting on a peer thread: spin first, then yield, then
+ * sleep briefly. *spins counts consecutive calls; reset it to 0 once
+ * progress is made.
+ */
+void utils_backoff(unsigned int *spins);
+
+#endif // UTILS_H
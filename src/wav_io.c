@@ -0,0 +1,217 @@
+#include "wav_io.h"
+#include <string.h>
+#include <stdlib.h>
+
+size_t wav_io_read_span(drwav *wav, const frame_ring_span_t *span) {
+    size_t done = (size_t)drwav_read_pcm_frames_f32(wav, span->frames1, span->data1);
+    if (done < span->frames1 || span->frames2 == 0) {
+        return done;
+    }
+    return done + (size_t)drwav_read_pcm_frames_f32(wav, span->frames2, span->data2);
+}
+
+size_t wav_io_write_span(drwav *wav, const frame_ring_span_t *span, size_t count) {
+    size_t first = count < span->frames1 ? count : span->frames1;
+    size_t done = (size_t)drwav_write_pcm_frames(wav, first, span->data1);
+    if (done < first || count == first) {
+        return done;
+    }
+    return done + (size_t)drwav_write_pcm_frames(wav, count - first, span->data2);
+}
+
+int wav_io_input_open(wav_io_input_t *input, const char *path, bool map) {
+    memset(input, 0, sizeof(*input));
+    
+    if (map && wav_map_open(&input->map, path) == 0) {
+        input->mapped = true;
+        input->channels = input->map.channels;
+        input->sample_rate = input->map.sample_rate;
+        input->total_frames = input->map.total_frames;
+        return 0;
+    }
+    
+    if (!drwav_init_file(&input->wav, path, NULL)) {
+        return -1;
+    }
+    input->channels = input->wav.channels;
+    input->sample_rate = input->wav.sampleRate;
+    input->total_frames = input->wav.totalPCMFrameCount;
+    return 0;
+}
+
+void wav_io_input_close(wav_io_input_t *input) {
+    if (input->mapped) {
+        wav_map_close(&input->map);
+    } else {
+        drwav_uninit(&input->wav);
+    }
+}
+
+int wav_io_input_seek(wav_io_input_t *input, uint64_t frame) {
+    if (input->mapped) {
+        wav_map_seek(&input->map, frame);
+        return 0;
+    }
+    return drwav_seek_to_pcm_frame(&input->wav, frame) ? 0 : -1;
+}
+
+int wav_io_reader_init(wav_io_reader_t *reader, wav_io_input_t *input, unsigned int sample_rate) {
+    memset(reader, 0, sizeof(*reader));
+    reader->input = input;
+    reader->channels = input->channels;
+    reader->sample_rate = sample_rate ? sample_rate : input->sample_rate;
+    reader->frames_left = input->total_frames;
+    
+    if (reader->sample_rate == input->sample_rate) {
+        return 0;
+    }
+    
+    reader->resampler = resampler_create(input->channels, input->sample_rate, reader->sample_rate);
+    if (!input->mapped) {
+        reader->decoded = malloc(WAV_IO_READER_CHUNK * input->channels * sizeof(float));
+    }
+    reader->converted = malloc(WAV_IO_READER_CHUNK * input->channels * sizeof(float));
+    if (!reader->resampler || (!input->mapped && !reader->decoded) || !reader->converted) {
+        wav_io_reader_free(reader);
+        return -1;
+    }
+    reader->frames_left = resampler_output_frames(input->total_frames, input->sample_rate,
+                                                  reader->sample_rate);
+    return 0;
+}
+
+void wav_io_reader_free(wav_io_reader_t *reader) {
+    resampler_free(reader->resampler);
+    free(reader->decoded);
+    free(reader->converted);
+    reader->resampler = NULL;
+    reader->decoded = reader->converted = NULL;
+}
+
+/**
+ * Convert exactly frames frames into reader->converted, decoding as needed
+ * and padding with silence once the file runs out.
+ */
+static void wav_io_reader_convert(wav_io_reader_t *reader, size_t frames) {
+    unsigned int channels = reader->channels;
+    size_t got = 0;
+    
+    while (got < frames) {
+        if (reader->decoded_pos == reader->decoded_frames && !reader->eof) {
+            if (reader->input->mapped) {
+                reader->source = wav_map_read(&reader->input->map, WAV_IO_READER_CHUNK,
+                                              &reader->decoded_frames);
+            } else {
+                reader->decoded_frames = (size_t)drwav_read_pcm_frames_f32(
+                    &reader->input->wav, WAV_IO_READER_CHUNK, reader->decoded);
+                reader->source = reader->decoded;
+            }
+            reader->decoded_pos = 0;
+            reader->eof = reader->decoded_frames < WAV_IO_READER_CHUNK;
+        }
+        
+        float *out = &reader->converted[got * channels];
+        if (reader->decoded_pos < reader->decoded_frames) {
+            size_t used;
+            got += resampler_process(reader->resampler,
+                                     &reader->source[reader->decoded_pos * channels],
+                                     reader->decoded_frames - reader->decoded_pos, &used,
+                                     out, frames - got);
+            reader->decoded_pos += used;
+        } else {
+            got += resampler_drain(reader->resampler, out, frames - got);
+        }
+    }
+}
+
+void wav_io_reader_pad(wav_io_reader_t *reader, size_t frames) {
+    reader->pad_left = frames;
+}
+
+/**
+ * Fill the span from the resampler; returns frames delivered.
+ */
+static size_t wav_io_reader_read_converted(wav_io_reader_t *reader,
+                                           const frame_ring_span_t *span) {
+    unsigned int channels = reader->channels;
+    size_t want = span->frames1 + span->frames2;
+    size_t done = 0;
+    
+    while (done < want && reader->frames_left > 0) {
+        size_t n = want - done;
+        if (n > WAV_IO_READER_CHUNK) n = WAV_IO_READER_CHUNK;
+        if (n > reader->frames_left) n = (size_t)reader->frames_left;
+        wav_io_reader_convert(reader, n);
+        
+        size_t first = done < span->frames1 ? span->frames1 - done : 0;
+        if (first > n) first = n;
+        if (first > 0) {
+            memcpy((float*)span->data1 + done * channels, reader->converted,
+                   first * channels * sizeof(float));
+        }
+        if (first < n) {
+            memcpy((float*)span->data2 + (done + first - span->frames1) * channels,
+                   &reader->converted[first * channels], (n - first) * channels * sizeof(float));
+        }
+        
+        done += n;
+        reader->frames_left -= n;
+    }
+    return done;
+}
+
+/**
+ * Fill the span straight from the mapping, one copy per part.
+ */
+static size_t wav_io_reader_read_mapped(wav_io_reader_t *reader,
+                                        const frame_ring_span_t *span) {
+    size_t got;
+    const float *samples = wav_map_read(&reader->input->map, span->frames1 + span->frames2, &got);
+    size_t frame_bytes = reader->channels * sizeof(float);
+    size_t first = got < span->frames1 ? got : span->frames1;
+    memcpy(span->data1, samples, first * frame_bytes);
+    if (got > first) {
+        memcpy(span->data2, &samples[first * reader->channels], (got - first) * frame_bytes);
+    }
+    return got;
+}
+
+size_t wav_io_reader_read(wav_io_reader_t *reader, const frame_ring_span_t *span) {
+    size_t done;
+    if (reader->resampler) {
+        done = wav_io_reader_read_converted(reader, span);
+    } else if (reader->input->mapped) {
+        done = wav_io_reader_read_mapped(reader, span);
+    } else {
+        done = wav_io_read_span(&reader->input->wav, span);
+    }
+    size_t want = span->frames1 + span->frames2;
+    if (done == want || reader->pad_left == 0) {
+        return done;
+    }
+    
+    // The file has run out: the rest is padding
+    size_t pad = want - done;
+    if (pad > reader->pad_left) {
+        pad = (size_t)reader->pad_left;
+    }
+    size_t frame_bytes = reader->channels * sizeof(float);
+    frame_ring_span_t rest = *span;
+    frame_ring_span_skip(&rest, done, frame_bytes);
+    size_t first = pad < rest.frames1 ? pad : rest.frames1;
+    memset(rest.data1, 0, first * frame_bytes);
+    if (pad > first) {
+        memset(rest.data2, 0, (pad - first) * frame_bytes);
+    }
+    
+    reader->pad_left -= pad;
+    return done + pad;
+}
+
+uint64_t wav_io_reader_total_frames(const wav_io_reader_t *reader) {
+    const wav_io_input_t *input = reader->input;
+    if (!reader->resampler) {
+        return input->total_frames;
+    }
+    return resampler_output_frames(input->total_frames, input->sample_rate, reader->sample_rate);
+}
@@ -0,0 +1,113 @@
+#ifndef WAV_IO_H
+#define WAV_IO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "frame_ring.h"
+#include "resampler.h"
+#include "wav_map.h"
+#include "dr_wav.h"
+
+/**
+ * Move interleaved float WAV frames straight between a file and a span of
+ * a frame ring (frame_ring.h) of one float per channel. Counts are in
+ * frames, and a span only ever wraps between whole frames.
+ */
+
+/**
+ * Decode into the span.
+ * Returns the number of frames decoded (fewer at end of file).
+ */
+size_t wav_io_read_span(drwav *wav, const frame_ring_span_t *span);
+
+/**
+ * Encode count frames from the start of the span.
+ * Returns the number of frames written.
+ */
+size_t wav_io_write_span(drwav *wav, const frame_ring_span_t *span, size_t count);
+
+/**
+ * An input file. 32-bit float files are mapped (wav_map.h) and their
+ * samples copied straight out of the page cache; anything else, or any
+ * file when mapping is off, is decoded by dr_wav.
+ */
+typedef struct {
+    drwav wav;                  // Unless mapped
+    wav_map_t map;              // When mapped
+    bool mapped;
+    unsigned int channels;
+    unsigned int sample_rate;
+    uint64_t total_frames;      // As the header says
+} wav_io_input_t;
+
+/**
+ * Open path, mapping it when map is set and the format allows. Returns 0
+ * on success, -1 if neither way can read it.
+ */
+int wav_io_input_open(wav_io_input_t *input, const char *path, bool map);
+
+/**
+ * Close the file.
+ */
+void wav_io_input_close(wav_io_input_t *input);
+
+/**
+ * Move to frame, so a reader at the file's rate starts there. Returns 0
+ * on success, -1 if the decoder can't seek.
+ */
+int wav_io_input_seek(wav_io_input_t *input, uint64_t frame);
+
+/**
+ * Reads an input file into ring spans at a chosen sample rate. At the
+ * file's own rate it copies from the mapping, or is wav_io_read_span(); at
+ * any other it reads in chunks and runs them through a resampler (from the
+ * mapping itself when mapped), ending with the converted length of the
+ * file (resampler_output_frames()). Optional silence after the end lets a
+ * delaying effect flush what it still holds.
+ */
+
+#define WAV_IO_READER_CHUNK 1024   // Frames decoded or converted at a time
+
+typedef struct {
+    wav_io_input_t *input;
+    unsigned int channels;
+    unsigned int sample_rate;   // Rate the reader delivers
+    resampler_t *resampler;     // NULL at the file's own rate
+    float *decoded;             // WAV_IO_READER_CHUNK frames at the file's rate (dr_wav only)
+    const float *source;        // The current chunk: decoded, or in the mapping
+    size_t decoded_frames;
+    size_t decoded_pos;         // Frames of decoded already converted
+    float *converted;           // WAV_IO_READER_CHUNK frames at sample_rate
+    uint64_t frames_left;       // Converted frames still to deliver
+    bool eof;                   // The file is fully decoded
+    uint64_t pad_left;          // Frames of silence still to deliver after the file
+} wav_io_reader_t;
+
+/**
+ * Read input at sample_rate (0 = the file's rate). Returns 0 on success,
+ * -1 when the conversion isn't possible or out of memory.
+ */
+int wav_io_reader_init(wav_io_reader_t *reader, wav_io_input_t *input, unsigned int sample_rate);
+
+/**
+ * Free the reader's buffers (not the input).
+ */
+void wav_io_reader_free(wav_io_reader_t *reader);
+
+/**
+ * Deliver frames frames of silence once the file has run out.
+ */
+void wav_io_reader_pad(wav_io_reader_t *reader, size_t frames);
+
+/**
+ * Fill the span. Returns the number of frames delivered (fewer at the end).
+ */
+size_t wav_io_reader_read(wav_io_reader_t *reader, const frame_ring_span_t *span);
+
+/**
+ * Frames the reader delivers in total, not counting the padding.
+ */
+uint64_t wav_io_reader_total_frames(const wav_io_reader_t *reader);
+
+#endif // WAV_IO_H
@@ -0,0 +1,157 @@
+#define _GNU_SOURCE
+#include "wav_map.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+static uint16_t get_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)get_u16(p) | (uint32_t)get_u16(p + 2) << 16;
+}
+
+/**
+ * Find fmt and data, and check the samples can be used in place.
+ * Returns 0 if they can.
+ */
+static int wav_map_parse(wav_map_t *map) {
+    const unsigned char *p = map->base;
+    size_t bytes = map->bytes;
+    if (bytes < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) {
+        return -1;  // RF64 and friends included: dr_wav knows them
+    }
+    
+    unsigned int format = 0, bits = 0, block_align = 0;
+    size_t offset = 12;
+    while (offset + 8 <= bytes) {
+        const unsigned char *body = p + offset + 8;
+        size_t size = get_u32(p + offset + 4);
+        size_t room = bytes - offset - 8;
+        
+        if (memcmp(p + offset, "fmt ", 4) == 0 && size >= 16 && size <= room) {
+            format = get_u16(body);
+            map->channels = get_u16(body + 2);
+            map->sample_rate = get_u32(body + 4);
+            block_align = get_u16(body + 12);
+            bits = get_u16(body + 14);
+            if (format == WAV_FORMAT_EXTENSIBLE && size >= 26) {
+                format = get_u16(body + 24);  // First two bytes of the subformat GUID
+            }
+        } else if (memcmp(p + offset, "data", 4) == 0) {
+            if (format == 0) {
+                return -1;  // data before fmt
+            }
+            // Writers that never came back to patch the size leave 0 or ~0
+            if (size == 0 || size > room) {
+                size = room;
+            }
+            if (format != WAV_FORMAT_IEEE_FLOAT || bits != 32 || map->channels == 0 ||
+                map->sample_rate == 0 || block_align != map->channels * sizeof(float) ||
+                (offset + 8) % sizeof(float) != 0) {
+                return -1;
+            }
+            map->data = (const float*)body;
+            map->total_frames = size / block_align;
+            return 0;
+        }
+        
+        offset += 8 + size + (size & 1);
+    }
+    return -1;
+}
+
+/**
+ * Keep the readahead WAV_MAP_WINDOW_BYTES ahead of end and drop the pages
+ * a window or more behind begin.
+ */
+static void wav_map_advise(wav_map_t *map, size_t begin, size_t end) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *base = map->base;
+    
+    if (end + WAV_MAP_WINDOW_BYTES / 2 > map->advised && map->advised < map->bytes) {
+        size_t len = WAV_MAP_WINDOW_BYTES;
+        if (len > map->bytes - map->advised) len = map->bytes - map->advised;
+        madvise(base + map->advised, len, MADV_WILLNEED);
+        map->advised += len;
+    }
+    
+    if (begin >= map->dropped + WAV_MAP_WINDOW_BYTES) {
+        size_t to = begin / page * page;
+        madvise(base + map->dropped, to - map->dropped, MADV_DONTNEED);
+        map->dropped = to;
+    }
+}
+
+int wav_map_open(wav_map_t *map, const char *path) {
+    memset(map, 0, sizeof(*map));
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    map->bytes = (size_t)st.st_size;
+    map->base = mmap(NULL, map->bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file
+    if (map->base == MAP_FAILED) {
+        map->base = NULL;
+        return -1;
+    }
+    
+    if (wav_map_parse(map) != 0) {
+        wav_map_close(map);
+        return -1;
+    }
+    
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = (size_t)((const unsigned char*)map->data - (const unsigned char*)map->base);
+    madvise(map->base, map->bytes, MADV_SEQUENTIAL);
+    map->advised = start / page * page;
+    map->dropped = map->advised;
+    wav_map_advise(map, start, start);
+    return 0;
+}
+
+void wav_map_close(wav_map_t *map) {
+    if (map->base) {
+        munmap(map->base, map->bytes);
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+void wav_map_seek(wav_map_t *map, uint64_t frame) {
+    map->position = frame < map->total_frames ? frame : map->total_frames;
+    
+    // Nothing behind the new position is worth dropping, nor anything
+    // advised before worth counting on
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const float *p = map->data + map->position * map->channels;
+    size_t begin = (size_t)((const unsigned char*)p - (const unsigned char*)map->base);
+    map->advised = begin / page * page;
+    map->dropped = map->advised;
+    wav_map_advise(map, begin, begin);
+}
+
+const float* wav_map_read(wav_map_t *map, size_t frames, size_t *got) {
+    uint64_t left = map->total_frames - map->position;
+    size_t n = frames < left ? frames : (size_t)left;
+    const float *p = map->data + map->position * map->channels;
+    
+    size_t begin = (size_t)((const unsigned char*)p - (const unsigned char*)map->base);
+    wav_map_advise(map, begin, begin + n * map->channels * sizeof(float));
+    
+    map->position += n;
+    *got = n;
+    return p;
+}
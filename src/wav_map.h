@@ -0,0 +1,69 @@
+#ifndef WAV_MAP_H
+#define WAV_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Memory-mapped reader for 32-bit float WAV files.
+ *
+ * The file is mapped read-only and the header parsed in place; reads hand
+ * out pointers straight into the data chunk, so samples go from the page
+ * cache to wherever the caller copies them (a ring span) with no stdio
+ * buffer or decode step in between. The mapping is advised sequential,
+ * a window ahead of the read position is asked for (MADV_WILLNEED) and
+ * pages already read are dropped (MADV_DONTNEED), so resident memory stays
+ * at about two windows however long the file is.
+ *
+ * Only IEEE float 32 (plain or WAVE_FORMAT_EXTENSIBLE) with a 4-byte
+ * aligned data chunk is mapped; anything else is left to dr_wav.
+ * Samples are little-endian, the host order on every target we build for.
+ */
+
+#define WAV_MAP_WINDOW_BYTES (4u << 20)   // Readahead ahead of the read position
+
+typedef struct {
+    void *base;                 // The whole file
+    size_t bytes;
+    const float *data;          // First sample
+    unsigned int channels;
+    unsigned int sample_rate;
+    uint64_t total_frames;
+    uint64_t position;          // Next frame to read
+    size_t advised;             // Byte offset the readahead reaches
+    size_t dropped;             // Byte offset below which pages have been dropped
+} wav_map_t;
+
+/**
+ * Map path. Returns 0 on success; -1 when the file can't be opened or
+ * mapped or isn't float 32 PCM (decode it with dr_wav instead).
+ */
+int wav_map_open(wav_map_t *map, const char *path);
+
+/**
+ * Unmap the file.
+ */
+void wav_map_close(wav_map_t *map);
+
+/**
+ * Up to frames frames from the read position, which moves past them.
+ * Returns a pointer into the mapping and sets *got (0 at the end).
+ * The pointer stays valid until wav_map_close().
+ */
+const float* wav_map_read(wav_map_t *map, size_t frames, size_t *got);
+
+/**
+ * Move the read position to frame (clamped to the end) and restart the
+ * readahead there.
+ */
+void wav_map_seek(wav_map_t *map, uint64_t frame);
+
+/**
+ * Frames left to read.
+ */
+static inline uint64_t wav_map_frames_left(const wav_map_t *map) {
+    return map->total_frames - map->position;
+}
+
+#endif // WAV_MAP_H
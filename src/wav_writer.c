@@ -0,0 +1,503 @@
+#define _GNU_SOURCE
+#include "wav_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#if defined(IORING_OFF_SQ_RING) && defined(__NR_io_uring_setup)
+#define WAV_WRITER_URING 1
+#endif
+
+#define WAV_WRITER_QUEUE_FRAMES 262144
+#define WAV_WRITER_CHUNK_BYTES (1u << 20)
+#define WAV_WRITER_SYNC_BYTES (8u << 20)
+#define WAV_WRITER_BLOCK_FRAMES 1024       // Frames converted per pass over the queue
+#define WAV_WRITER_IDLE_NS 10000000ull     // Longest the writer sleeps on an empty queue
+
+static size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+static void put_u16(unsigned char *p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+void wav_writer_format_header(unsigned char *h, sample_format_t format,
+                              unsigned int channels, unsigned int sample_rate,
+                              uint64_t data_bytes) {
+    // Past 4 GiB the sizes can't be right; saturate as most writers do
+    uint32_t data = data_bytes > 0xffffffffull - 36 ? 0xffffffffu - 36 : (uint32_t)data_bytes;
+    size_t sample_bytes = sample_format_bytes(format);
+    uint16_t block_align = (uint16_t)(channels * sample_bytes);
+    
+    memcpy(h, "RIFF", 4);
+    put_u32(h + 4, 36 + data);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_u32(h + 16, 16);
+    put_u16(h + 20, format == SAMPLE_FORMAT_F32 ? 3 : 1);
+    put_u16(h + 22, (uint16_t)channels);
+    put_u32(h + 24, sample_rate);
+    put_u32(h + 28, sample_rate * block_align);
+    put_u16(h + 32, block_align);
+    put_u16(h + 34, (uint16_t)(sample_bytes * 8));
+    memcpy(h + 36, "data", 4);
+    put_u32(h + 40, data);
+}
+
+/**
+ * pwrite all of it, retrying short writes and interrupts.
+ */
+static int write_all(int fd, const unsigned char *data, size_t bytes, uint64_t offset) {
+    while (bytes > 0) {
+        ssize_t n = pwrite(fd, data, bytes, (off_t)offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        bytes -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+// ============================================================================
+// io_uring, through the raw syscalls (no liburing)
+// ============================================================================
+
+#if defined(WAV_WRITER_URING)
+struct wav_uring {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_map_bytes, cq_map_bytes, sqes_bytes;
+    
+    // Per chunk: what is in flight, to finish a short or refused write by hand
+    size_t len[2];
+    uint64_t offset[2];
+};
+
+static void wav_uring_free(struct wav_uring *u) {
+    if (!u) return;
+    if (u->sqes) munmap(u->sqes, u->sqes_bytes);
+    if (u->cq_map) munmap(u->cq_map, u->cq_map_bytes);
+    if (u->sq_map) munmap(u->sq_map, u->sq_map_bytes);
+    if (u->fd >= 0) close(u->fd);
+    free(u);
+}
+
+static struct wav_uring* wav_uring_create(void) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, 4, &params);
+    if (fd < 0) {
+        return NULL;  // Old kernel, or io_uring disabled (seccomp, sysctl)
+    }
+    
+    struct wav_uring *u = calloc(1, sizeof(struct wav_uring));
+    if (!u) {
+        close(fd);
+        return NULL;
+    }
+    u->fd = fd;
+    u->sq_map_bytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    u->cq_map_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    u->sqes_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    
+    u->sq_map = mmap(NULL, u->sq_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+    u->cq_map = mmap(NULL, u->cq_map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->sqes_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   fd, IORING_OFF_SQES);
+    if (u->sq_map == MAP_FAILED) u->sq_map = NULL;
+    if (u->cq_map == MAP_FAILED) u->cq_map = NULL;
+    if (u->sqes == MAP_FAILED) u->sqes = NULL;
+    if (!u->sq_map || !u->cq_map || !u->sqes) {
+        wav_uring_free(u);
+        return NULL;
+    }
+    
+    unsigned char *sq = u->sq_map;
+    unsigned char *cq = u->cq_map;
+    u->sq_head = (unsigned*)(sq + params.sq_off.head);
+    u->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    u->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    u->sq_array = (unsigned*)(sq + params.sq_off.array);
+    u->cq_head = (unsigned*)(cq + params.cq_off.head);
+    u->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    u->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return u;
+}
+
+/**
+ * Queue a write of chunk and tell the kernel. Returns 0, or -1 if it
+ * couldn't be submitted (the caller writes it by hand).
+ */
+static int wav_uring_submit(struct wav_uring *u, int fd, int chunk, const void *data,
+                            size_t len, uint64_t offset) {
+    unsigned tail = *u->sq_tail;
+    unsigned index = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[index];
+    
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)data;
+    sqe->len = (uint32_t)len;
+    sqe->off = offset;
+    sqe->user_data = (uint64_t)chunk;
+    u->sq_array[index] = index;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    
+    u->len[chunk] = len;
+    u->offset[chunk] = offset;
+    int submitted;
+    do {
+        submitted = (int)syscall(__NR_io_uring_enter, u->fd, 1, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted != 1) {
+        // Take the entry back; nothing else is queued behind it
+        __atomic_store_n(u->sq_tail, tail, __ATOMIC_RELEASE);
+        return -1;
+    }
+    return 0;
+}
+#endif // WAV_WRITER_URING
+
+/**
+ * Block until chunk's write has completed. Completions for the other chunk
+ * are reaped on the way. A write the kernel cut short or refused (a
+ * kernel without IORING_OP_WRITE) is finished with pwrite.
+ */
+static void wav_writer_complete(wav_writer_t *w, int chunk) {
+#if defined(WAV_WRITER_URING)
+    struct wav_uring *u = w->uring;
+    while (w->pending[chunk]) {
+        unsigned head = *u->cq_head;
+        if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+            syscall(__NR_io_uring_enter, u->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+            continue;
+        }
+        
+        struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        int done = (int)cqe->user_data;
+        int res = cqe->res;
+        __atomic_store_n(u->cq_head, head + 1, __ATOMIC_RELEASE);
+        
+        size_t wrote = res > 0 ? (size_t)res : 0;
+        if (wrote < u->len[done] &&
+            write_all(w->fd, w->chunks[done] + wrote, u->len[done] - wrote,
+                      u->offset[done] + wrote) != 0) {
+            atomic_store(&w->failed, true);
+        }
+        w->pending[done] = false;
+    }
+#else
+    (void)w;
+    (void)chunk;
+#endif
+}
+
+/**
+ * Write len bytes of the current chunk at the current offset, then move
+ * on to the other chunk once its own write (if any) is done.
+ */
+static void wav_writer_flush_chunk(wav_writer_t *w, size_t len) {
+    int chunk = w->current;
+    const unsigned char *data = w->chunks[chunk];
+
+#if defined(WAV_WRITER_URING)
+    if (w->uring && wav_uring_submit(w->uring, w->fd, chunk, data, len, w->offset) == 0) {
+        w->pending[chunk] = true;
+    } else
+#endif
+    if (write_all(w->fd, data, len, w->offset) != 0) {
+        fprintf(stderr, "✗ Error: Failed to write output (disk full?)\n");
+        atomic_store(&w->failed, true);
+    }
+    
+    w->offset += len;
+    w->since_sync += len;
+    if (w->config.sync == WAV_WRITER_SYNC_PERIODIC && w->since_sync >= w->config.sync_bytes) {
+        wav_writer_complete(w, chunk);
+        fdatasync(w->fd);
+        w->since_sync = 0;
+    }
+    
+    w->current = chunk ^ 1;
+    wav_writer_complete(w, w->current);
+    w->fill = 0;
+}
+
+/**
+ * Pack bytes into the chunks, writing each one as it fills.
+ */
+static void wav_writer_append(wav_writer_t *w, const unsigned char *bytes, size_t count) {
+    size_t chunk_bytes = w->config.chunk_bytes;
+    
+    while (count > 0) {
+        size_t room = chunk_bytes - w->fill;
+        size_t n = count < room ? count : room;
+        memcpy(w->chunks[w->current] + w->fill, bytes, n);
+        w->fill += n;
+        bytes += n;
+        count -= n;
+        if (w->fill == chunk_bytes) {
+            wav_writer_flush_chunk(w, chunk_bytes);
+        }
+    }
+}
+
+static void wav_writer_convert(wav_writer_t *w, const float *samples, size_t count) {
+    size_t block = WAV_WRITER_BLOCK_FRAMES * w->channels;
+    bool dither = w->config.format == SAMPLE_FORMAT_S16 || w->config.format == SAMPLE_FORMAT_S24_3;
+    
+    while (count > 0) {
+        size_t n = count < block ? count : block;
+        sample_format_from_float(w->config.format, samples, w->staging, n,
+                                 dither ? &w->dither : NULL);
+        wav_writer_append(w, w->staging, n * w->sample_bytes);
+        samples += n;
+        count -= n;
+    }
+}
+
+static void* wav_writer_thread(void *arg) {
+    wav_writer_t *w = (wav_writer_t*)arg;
+    unsigned int channels = w->channels;
+    
+    while (true) {
+        // closing first: everything queued before it was set is visible below
+        bool closing = atomic_load_explicit(&w->closing, memory_order_acquire);
+        frame_ring_span_t span;
+        size_t count = frame_ring_read_acquire(w->queue, WAV_WRITER_BLOCK_FRAMES, &span);
+        if (count == 0) {
+            if (closing) {
+                break;
+            }
+            frame_ring_wait_readable(w->queue, WAV_WRITER_BLOCK_FRAMES, WAV_WRITER_IDLE_NS);
+            continue;
+        }
+        
+        // After a failure keep draining, so a blocking producer never waits forever
+        if (!atomic_load_explicit(&w->failed, memory_order_relaxed)) {
+            wav_writer_convert(w, span.data1, span.frames1 * channels);
+            wav_writer_convert(w, span.data2, span.frames2 * channels);
+            w->frames_written += count;
+        }
+        frame_ring_read_release(w->queue, count);
+    }
+    
+    // The last, partial chunk: O_DIRECT wants whole aligned blocks, so pad
+    // it and let close truncate the file back
+    if (w->fill > 0) {
+        size_t len = w->fill;
+        if (w->direct) {
+            len = (len + WAV_WRITER_ALIGN - 1) / WAV_WRITER_ALIGN * WAV_WRITER_ALIGN;
+            memset(w->chunks[w->current] + w->fill, 0, len - w->fill);
+        }
+        wav_writer_flush_chunk(w, len);
+    }
+    wav_writer_complete(w, 0);
+    wav_writer_complete(w, 1);
+    return NULL;
+}
+
+void wav_writer_config_init(wav_writer_config_t *config) {
+    config->format = SAMPLE_FORMAT_F32;
+    config->queue_frames = WAV_WRITER_QUEUE_FRAMES;
+    config->chunk_bytes = WAV_WRITER_CHUNK_BYTES;
+    config->direct = false;
+    config->io_uring = false;
+    config->block = false;
+    config->sync = WAV_WRITER_SYNC_NONE;
+    config->sync_bytes = WAV_WRITER_SYNC_BYTES;
+}
+
+static void wav_writer_free(wav_writer_t *w) {
+#if defined(WAV_WRITER_URING)
+    wav_uring_free(w->uring);
+#endif
+    frame_ring_free(w->queue);
+    free(w->chunks[0]);
+    free(w->chunks[1]);
+    free(w->staging);
+    if (w->fd >= 0) close(w->fd);
+    free(w);
+}
+
+wav_writer_t* wav_writer_open(const char *path, unsigned int channels, unsigned int sample_rate,
+                              const wav_writer_config_t *config) {
+    wav_writer_config_t defaults;
+    if (!config) {
+        wav_writer_config_init(&defaults);
+        config = &defaults;
+    }
+    if (channels == 0 || channels > WAV_WRITER_MAX_CHANNELS || sample_rate == 0 ||
+        config->queue_frames == 0 || config->chunk_bytes < WAV_WRITER_ALIGN ||
+        config->chunk_bytes % WAV_WRITER_ALIGN != 0) {
+        return NULL;
+    }
+    
+    wav_writer_t *w = calloc(1, sizeof(wav_writer_t));
+    if (!w) {
+        return NULL;
+    }
+    w->fd = -1;
+    w->channels = channels;
+    w->sample_rate = sample_rate;
+    w->config = *config;
+    w->sample_bytes = sample_format_bytes(config->format);
+    atomic_init(&w->closing, false);
+    atomic_init(&w->failed, false);
+    atomic_init(&w->frames_dropped, 0);
+    sample_dither_init(&w->dither, 1);
+    
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (config->direct) {
+        w->fd = open(path, flags | O_DIRECT, 0644);
+        w->direct = w->fd >= 0;
+    }
+    if (w->fd < 0) {
+        w->fd = open(path, flags, 0644);
+    }
+    
+    // Prefaulted, so the producer's first writes don't take page faults;
+    // waitable, so an idle writer (and a blocking producer) sleeps on a
+    // futex instead of polling
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.prefault = true;
+    options.waitable = true;
+    w->queue = frame_ring_f32_create(next_power_of_2(config->queue_frames), channels, &options);
+    if (posix_memalign((void**)&w->chunks[0], WAV_WRITER_ALIGN, config->chunk_bytes) != 0) {
+        w->chunks[0] = NULL;
+    }
+    if (posix_memalign((void**)&w->chunks[1], WAV_WRITER_ALIGN, config->chunk_bytes) != 0) {
+        w->chunks[1] = NULL;
+    }
+    w->staging = malloc(WAV_WRITER_BLOCK_FRAMES * channels * w->sample_bytes);
+    if (w->fd < 0 || !w->queue || !w->chunks[0] || !w->chunks[1] || !w->staging) {
+        wav_writer_free(w);
+        return NULL;
+    }
+
+#if defined(WAV_WRITER_URING)
+    if (config->io_uring) {
+        w->uring = wav_uring_create();
+    }
+#endif
+    
+    // Room for the header at the front of the first chunk; close fills it in
+    memset(w->chunks[0], 0, WAV_WRITER_HEADER_BYTES);
+    w->fill = WAV_WRITER_HEADER_BYTES;
+    
+    if (pthread_create(&w->thread, NULL, wav_writer_thread, w) != 0) {
+        wav_writer_free(w);
+        return NULL;
+    }
+    return w;
+}
+
+size_t wav_writer_write(wav_writer_t *w, const float *frames, size_t count) {
+    size_t done = 0;
+    
+    while (done < count && !atomic_load_explicit(&w->failed, memory_order_relaxed)) {
+        size_t n = frame_ring_f32_write(w->queue, &frames[done * w->channels], count - done);
+        if (n == 0) {
+            if (!w->config.block) {
+                break;
+            }
+            frame_ring_wait_writable(w->queue, 1, RING_BUFFER_WAIT_FOREVER);
+            continue;
+        }
+        done += n;
+    }
+    
+    if (done < count) {
+        atomic_fetch_add_explicit(&w->frames_dropped, count - done, memory_order_relaxed);
+    }
+    return done;
+}
+
+size_t wav_writer_write_span(wav_writer_t *w, const frame_ring_span_t *span, size_t count) {
+    size_t first = count < span->frames1 ? count : span->frames1;
+    size_t done = wav_writer_write(w, span->data1, first);
+    if (done < first || count == first) {
+        return done;
+    }
+    return done + wav_writer_write(w, span->data2, count - first);
+}
+
+bool wav_writer_failed(const wav_writer_t *w) {
+    return atomic_load_explicit(&w->failed, memory_order_relaxed);
+}
+
+int wav_writer_close(wav_writer_t *w, wav_writer_stats_t *stats) {
+    atomic_store_explicit(&w->closing, true, memory_order_release);
+    frame_ring_close(w->queue);
+    pthread_join(w->thread, NULL);
+    
+    // Cut the O_DIRECT padding back off and fill in the header; both are
+    // small unaligned writes, so go back to buffered I/O for them
+    uint64_t data_bytes = w->frames_written * w->channels * w->sample_bytes;
+    uint64_t file_bytes = WAV_WRITER_HEADER_BYTES + data_bytes;
+    if (w->direct) {
+        fcntl(w->fd, F_SETFL, fcntl(w->fd, F_GETFL) & ~O_DIRECT);
+        if (ftruncate(w->fd, (off_t)file_bytes) != 0) {
+            atomic_store(&w->failed, true);
+        }
+    }
+    unsigned char header[WAV_WRITER_HEADER_BYTES];
+    wav_writer_format_header(header, w->config.format, w->channels, w->sample_rate, data_bytes);
+    if (write_all(w->fd, header, sizeof(header), 0) != 0) {
+        atomic_store(&w->failed, true);
+    }
+    if (w->config.sync != WAV_WRITER_SYNC_NONE && fdatasync(w->fd) != 0) {
+        atomic_store(&w->failed, true);
+    }
+    if (close(w->fd) != 0) {
+        atomic_store(&w->failed, true);
+    }
+    w->fd = -1;
+    
+    bool failed = atomic_load(&w->failed);
+    uint64_t dropped = atomic_load(&w->frames_dropped);
+    if (stats) {
+        stats->frames_written = w->frames_written;
+        stats->frames_dropped = dropped;
+        stats->queue_high_water = frame_ring_high_water(w->queue);
+        stats->bytes = file_bytes;
+        stats->direct = w->direct;
+        stats->io_uring = w->uring != NULL;
+        stats->failed = failed;
+    }
+    
+    wav_writer_free(w);
+    return failed || dropped > 0 ? -1 : 0;
+}
@@ -0,0 +1,146 @@
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "frame_ring.h"
+#include "sample_format.h"
+
+/**
+ * Asynchronous WAV file writer.
+ *
+ *   producer --[ring]--> writer thread --[chunk A | chunk B]--> file
+ *
+ * The producer (a DSP or live thread) only copies interleaved float frames
+ * into a bounded ring; it never touches the file. The writer thread drains
+ * the ring, converts to the file's sample format and packs the bytes into
+ * two large, page-aligned chunks: while one is being written the other
+ * fills. With io_uring the write of a full chunk is submitted and the
+ * thread goes straight on to fill the other; without it the thread writes
+ * with pwrite, which blocks only the writer.
+ *
+ * With direct, the file is opened O_DIRECT so chunks skip the page cache:
+ * every write is a whole number of aligned chunks from offset 0, the
+ * header included, and the last partial chunk is padded and the file
+ * truncated back at close. Filesystems that refuse O_DIRECT (tmpfs) get
+ * buffered I/O. io_uring falls back to pwrite where the kernel lacks it
+ * or forbids it.
+ *
+ * When the ring is full, a non-blocking writer drops the frames that
+ * don't fit and counts them, so a slow disk never stalls a realtime
+ * producer; a blocking one waits for room, for offline modes where every
+ * frame matters. The RIFF sizes are patched in at close.
+ */
+
+#define WAV_WRITER_ALIGN 4096             // O_DIRECT alignment: buffers, offsets and lengths
+#define WAV_WRITER_HEADER_BYTES 44
+#define WAV_WRITER_MAX_CHANNELS 8
+
+typedef enum {
+    WAV_WRITER_SYNC_NONE,       // Leave it to the kernel
+    WAV_WRITER_SYNC_CLOSE,      // fdatasync once, at close
+    WAV_WRITER_SYNC_PERIODIC,   // fdatasync every sync_bytes, and at close
+} wav_writer_sync_t;
+
+typedef struct {
+    sample_format_t format;     // Sample format in the file (default F32)
+    size_t queue_frames;        // Ring size; rounded up to a power of 2
+    size_t chunk_bytes;         // Per write, a multiple of WAV_WRITER_ALIGN
+    bool direct;                // O_DIRECT
+    bool io_uring;              // Submit chunk writes through io_uring
+    bool block;                 // Producer waits for room instead of dropping
+    wav_writer_sync_t sync;
+    size_t sync_bytes;          // WAV_WRITER_SYNC_PERIODIC interval
+} wav_writer_config_t;
+
+typedef struct {
+    uint64_t frames_written;    // Frames that reached the file
+    uint64_t frames_dropped;    // Frames the producer dropped on a full ring
+    size_t queue_high_water;    // Peak ring fill, in frames
+    uint64_t bytes;             // File size
+    bool direct;                // O_DIRECT was granted
+    bool io_uring;              // io_uring was set up
+    bool failed;                // A write failed; the file is incomplete
+} wav_writer_stats_t;
+
+struct wav_uring;
+
+typedef struct {
+    int fd;
+    unsigned int channels;
+    unsigned int sample_rate;
+    wav_writer_config_t config;
+    size_t sample_bytes;
+    bool direct;
+    
+    frame_ring_t *queue;
+    pthread_t thread;
+    atomic_bool closing;        // Producer is done; drain and stop
+    atomic_bool failed;
+    atomic_uint_least64_t frames_dropped;   // Producer side
+    
+    // Writer thread only
+    unsigned char *chunks[2];
+    size_t fill;                // Bytes in the current chunk
+    int current;                // Chunk being filled
+    bool pending[2];            // Chunk has a write in flight (io_uring)
+    uint64_t offset;            // File offset of the current chunk
+    uint64_t frames_written;
+    uint64_t since_sync;
+    unsigned char *staging;     // One block converted to the file format
+    sample_dither_t dither;
+    struct wav_uring *uring;    // NULL when writing with pwrite
+} wav_writer_t;
+
+/**
+ * Defaults: F32, 2^18 frames of queue (over 5 s at 48 kHz), 1 MiB chunks,
+ * buffered pwrite, dropping when full, no syncs.
+ */
+void wav_writer_config_init(wav_writer_config_t *config);
+
+/**
+ * Create path and start the writer thread. config may be NULL for the
+ * defaults. Returns NULL on failure.
+ */
+wav_writer_t* wav_writer_open(const char *path, unsigned int channels, unsigned int sample_rate,
+                              const wav_writer_config_t *config);
+
+/**
+ * Producer side: queue count interleaved frames. Returns the frames
+ * queued; fewer only when a non-blocking writer's ring is full (the rest
+ * are dropped and counted) or the writer has failed.
+ */
+size_t wav_writer_write(wav_writer_t *writer, const float *frames, size_t count);
+
+/**
+ * Producer side: queue count frames from the start of a float frame ring
+ * span, as wav_io_write_span. Returns the frames queued.
+ */
+size_t wav_writer_write_span(wav_writer_t *writer, const frame_ring_span_t *span, size_t count);
+
+/**
+ * A write has failed; anything queued from now on is discarded. Safe from
+ * any thread.
+ */
+bool wav_writer_failed(const wav_writer_t *writer);
+
+/**
+ * Producer side, once it has stopped writing: drain the queue, finish the
+ * file and free the writer. Fills stats (may be NULL). Returns 0 if every
+ * queued frame reached the file, -1 otherwise.
+ */
+int wav_writer_close(wav_writer_t *writer, wav_writer_stats_t *stats);
+
+/**
+ * The canonical WAV_WRITER_HEADER_BYTES header wav_writer puts in front of
+ * data_bytes of format samples, for callers that place the samples in the
+ * file themselves.
+ */
+void wav_writer_format_header(unsigned char *header, sample_format_t format,
+                              unsigned int channels, unsigned int sample_rate,
+                              uint64_t data_bytes);
+
+#endif // WAV_WRITER_H
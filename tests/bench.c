@@ -0,0 +1,534 @@
+#include "../src/ring_buffer.h"
+#include "../src/effects.h"
+#include "../src/limiter.h"
+#include "../src/sample_format.h"
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Microbenchmarks. Output is CSV on stdout, one row per case and block size:
+ *
+ *   suite,case,block,ns_per_sample,msamples_per_s
+ *
+ * Each row is the best of BENCH_TRIALS runs of about BENCH_SAMPLES samples,
+ * so the numbers track the code rather than scheduler noise. Compare runs
+ * on the same machine only. Multichannel rows count every channel's sample
+ * and use frames for the block size.
+ */
+
+#define BENCH_SAMPLES (1u << 22)
+#define BENCH_TRIALS 5
+#define BENCH_RING_SIZE 8192
+#define BENCH_MIN_BLOCK 32
+#define BENCH_MAX_BLOCK 4096
+#define BENCH_SAMPLE_RATE 48000.0f
+
+// Results feed into this so the compiler can't drop the work
+static volatile float bench_sink;
+
+static void report(const char *suite, const char *name, size_t block, uint64_t ns,
+                   uint64_t samples) {
+    double ns_per_sample = (double)ns / samples;
+    printf("%s,%s,%zu,%.4f,%.2f\n", suite, name, block, ns_per_sample,
+           1e3 / ns_per_sample);
+    fflush(stdout);
+}
+
+static void fill_noise(float *buffer, size_t count) {
+    uint32_t state = 0x12345678u;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1664525u + 1013904223u;
+        buffer[i] = (float)(state >> 8) / (float)(1u << 23) - 1.0f;
+    }
+}
+
+// ============================================================================
+// Ring buffer
+// ============================================================================
+
+/**
+ * Write then read one block at a time on a single thread: the cost of the
+ * index bookkeeping and copies with no cache-line traffic between cores.
+ */
+static uint64_t bench_ring_single(ring_buffer_t *rb, float *block_data, size_t block) {
+    size_t reps = BENCH_SAMPLES / block;
+    
+    uint64_t start = utils_now_ns();
+    for (size_t i = 0; i < reps; i++) {
+        ring_buffer_write(rb, block_data, block);
+        ring_buffer_read(rb, block_data, block);
+    }
+    uint64_t ns = utils_now_ns() - start;
+    
+    bench_sink = block_data[0];
+    return ns;
+}
+
+typedef struct {
+    ring_buffer_t *rb;
+    size_t block;
+    size_t total;
+} ring_thread_arg_t;
+
+static void* ring_producer(void *arg) {
+    ring_thread_arg_t *a = (ring_thread_arg_t*)arg;
+    float *data = calloc(a->block, sizeof(float));
+    size_t sent = 0;
+    unsigned int spins = 0;
+    
+    while (sent < a->total) {
+        size_t n = a->total - sent < a->block ? a->total - sent : a->block;
+        size_t written = ring_buffer_write(a->rb, data, n);
+        if (written == 0) {
+            utils_backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        sent += written;
+    }
+    
+    free(data);
+    return NULL;
+}
+
+/**
+ * Producer and consumer on separate threads: adds the index handoff between
+ * cores. On a single CPU this measures context switches, not the ring.
+ */
+static uint64_t bench_ring_threaded(ring_buffer_t *rb, float *block_data, size_t block) {
+    ring_thread_arg_t arg = { rb, block, BENCH_SAMPLES };
+    size_t received = 0;
+    unsigned int spins = 0;
+    pthread_t producer;
+    
+    uint64_t start = utils_now_ns();
+    if (pthread_create(&producer, NULL, ring_producer, &arg) != 0) {
+        return 0;
+    }
+    while (received < arg.total) {
+        size_t got = ring_buffer_read(rb, block_data, block);
+        if (got == 0) {
+            utils_backoff(&spins);
+            continue;
+        }
+        spins = 0;
+        received += got;
+    }
+    pthread_join(producer, NULL);
+    uint64_t ns = utils_now_ns() - start;
+    
+    bench_sink = block_data[0];
+    return ns;
+}
+
+static void run_ring_benchmarks(void) {
+    ring_buffer_t *rb = ring_buffer_create(BENCH_RING_SIZE);
+    float *block_data = calloc(BENCH_MAX_BLOCK, sizeof(float));
+    
+    // Same ring with mirrored storage: every copy is a single memcpy
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.mirrored = true;
+    ring_buffer_t *mirrored = ring_buffer_create_ex(BENCH_RING_SIZE, &options);
+    
+    if (!rb || !block_data || !mirrored) {
+        fprintf(stderr, "✗ Error: Failed to allocate ring benchmark\n");
+        exit(1);
+    }
+    
+    for (size_t block = BENCH_MIN_BLOCK; block <= BENCH_MAX_BLOCK; block *= 2) {
+        uint64_t best_single = UINT64_MAX;
+        uint64_t best_threaded = UINT64_MAX;
+        uint64_t best_mirrored = UINT64_MAX;
+        
+        for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+            ring_buffer_reset(rb);
+            uint64_t ns = bench_ring_single(rb, block_data, block);
+            if (ns < best_single) best_single = ns;
+            
+            ring_buffer_reset(rb);
+            ns = bench_ring_threaded(rb, block_data, block);
+            if (ns > 0 && ns < best_threaded) best_threaded = ns;
+            
+            ring_buffer_reset(mirrored);
+            ns = bench_ring_single(mirrored, block_data, block);
+            if (ns < best_mirrored) best_mirrored = ns;
+        }
+        
+        report("ring", "write_read_single", block, best_single,
+               (uint64_t)(BENCH_SAMPLES / block) * block);
+        report("ring", "write_read_threaded", block, best_threaded, BENCH_SAMPLES);
+        report("ring", mirrored->mirrored ? "write_read_mirrored" : "write_read_mirror_fallback",
+               block, best_mirrored, (uint64_t)(BENCH_SAMPLES / block) * block);
+    }
+    
+    free(block_data);
+    ring_buffer_free(rb);
+    ring_buffer_free(mirrored);
+}
+
+// ============================================================================
+// Effects
+// ============================================================================
+
+typedef enum {
+    BENCH_GAIN,
+    BENCH_GAIN_SMOOTH,
+    BENCH_BIQUAD,
+    BENCH_COMPRESSOR,
+    BENCH_LIMITER,
+} effect_kind_t;
+
+/**
+ * Process the same block in place over and over. 0 dB gain, a low-pass and
+ * a compressor all keep the signal well away from denormals, so repeated
+ * passes cost the same as fresh input.
+ */
+static uint64_t bench_effect(effect_kind_t kind, float *buffer, size_t block) {
+    gain_effect_t gain;
+    biquad_t filter;
+    compressor_t comp;
+    gain_init(&gain, 0.0f);
+    biquad_lowpass_init(&filter, BENCH_SAMPLE_RATE, 3000.0f, 0.707f);
+    compressor_init(&comp, -20.0f, 4.0f, 5.0f, 50.0f, BENCH_SAMPLE_RATE);
+    
+    size_t reps = BENCH_SAMPLES / block;
+    uint64_t start = utils_now_ns();
+    for (size_t i = 0; i < reps; i++) {
+        switch (kind) {
+            case BENCH_GAIN:       gain_process(&gain, buffer, block); break;
+            case BENCH_GAIN_SMOOTH:
+                // Alternate between 0 and +1 dB so the level stays bounded
+                gain_set_target(&gain, (i & 1) ? 0.0f : 1.0f);
+                gain_process_smooth(&gain, buffer, block);
+                break;
+            case BENCH_BIQUAD:     biquad_process(&filter, buffer, block); break;
+            case BENCH_COMPRESSOR: compressor_process(&comp, buffer, block); break;
+            default: break;
+        }
+    }
+    uint64_t ns = utils_now_ns() - start;
+    
+    bench_sink = buffer[0];
+    return ns;
+}
+
+/**
+ * Every gain kernel this CPU can run, constant and smoothed.
+ */
+static void run_gain_benchmarks(float *buffer) {
+    static const char *kernels[] = { "avx2", "sse2", "neon", "scalar" };
+    
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (gain_select_kernel(kernels[k]) != 0) {
+            continue;
+        }
+        
+        char name[64];
+        for (int smooth = 0; smooth < 2; smooth++) {
+            snprintf(name, sizeof(name), "%s_%s",
+                     smooth ? "gain_process_smooth" : "gain_process", kernels[k]);
+            
+            for (size_t block = BENCH_MIN_BLOCK; block <= BENCH_MAX_BLOCK; block *= 2) {
+                uint64_t best = UINT64_MAX;
+                
+                for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+                    fill_noise(buffer, block);
+                    uint64_t ns = bench_effect(smooth ? BENCH_GAIN_SMOOTH : BENCH_GAIN,
+                                               buffer, block);
+                    if (ns < best) best = ns;
+                }
+                
+                report("effects", name, block, best, (uint64_t)(BENCH_SAMPLES / block) * block);
+            }
+        }
+    }
+    gain_select_kernel(NULL);
+}
+
+static void run_effect_benchmarks(void) {
+    static const struct {
+        effect_kind_t kind;
+        const char *name;
+    } cases[] = {
+        // The original one-section Direct Form I biquad, which no chain runs
+        // any more; the biquad_cascade_* cases time the filter in use
+        { BENCH_BIQUAD, "biquad_process_df1_legacy" },
+        { BENCH_COMPRESSOR, "compressor_process" },
+    };
+    
+    float *buffer = malloc(BENCH_MAX_BLOCK * sizeof(float));
+    if (!buffer) {
+        fprintf(stderr, "✗ Error: Failed to allocate effect benchmark\n");
+        exit(1);
+    }
+    
+    run_gain_benchmarks(buffer);
+    
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (size_t block = BENCH_MIN_BLOCK; block <= BENCH_MAX_BLOCK; block *= 2) {
+            uint64_t best = UINT64_MAX;
+            
+            for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+                fill_noise(buffer, block);
+                uint64_t ns = bench_effect(cases[c].kind, buffer, block);
+                if (ns < best) best = ns;
+            }
+            
+            report("effects", cases[c].name, block, best,
+                   (uint64_t)(BENCH_SAMPLES / block) * block);
+        }
+    }
+    
+    free(buffer);
+}
+
+/**
+ * Frame-aware kernels on interleaved multichannel blocks, block in frames.
+ * With lanes per channel (or per section for mono cascades), ns/sample
+ * should fall as channels or sections go up. The limiter runs at 96 kHz
+ * with its default 5 ms lookahead, a 481-frame window; its sliding maximum
+ * costs the same whatever the window, so it should track the compressor.
+ */
+static uint64_t bench_effect_multi(effect_kind_t kind, float *buffer, size_t block,
+                                   unsigned int channels, unsigned int order) {
+    compressor_t comp_design;
+    biquad_cascade_t filter;
+    compressor_multi_t comp;
+    biquad_cascade_lowpass(&filter, BENCH_SAMPLE_RATE, 3000.0f, order, channels);
+    compressor_init(&comp_design, -20.0f, 4.0f, 5.0f, 50.0f, BENCH_SAMPLE_RATE);
+    compressor_multi_init(&comp, &comp_design, channels);
+    limiter_t *lim = NULL;
+    if (kind == BENCH_LIMITER) {
+        lim = limiter_create(channels, 96000.0f, LIMITER_CEILING_DB, LIMITER_LOOKAHEAD_MS,
+                             LIMITER_RELEASE_MS);
+        if (!lim) {
+            fprintf(stderr, "✗ Error: Failed to create limiter benchmark\n");
+            exit(1);
+        }
+    }
+    
+    size_t reps = BENCH_SAMPLES / (block * channels);
+    uint64_t start = utils_now_ns();
+    for (size_t i = 0; i < reps; i++) {
+        if (kind == BENCH_BIQUAD) {
+            biquad_cascade_process(&filter, buffer, block);
+        } else if (kind == BENCH_LIMITER) {
+            limiter_process(lim, buffer, block);
+        } else {
+            compressor_multi_process(&comp, buffer, block);
+        }
+    }
+    uint64_t ns = utils_now_ns() - start;
+    
+    limiter_free(lim);
+    bench_sink = buffer[0];
+    return ns;
+}
+
+static void run_multichannel_benchmarks(void) {
+    static const struct {
+        effect_kind_t kind;
+        unsigned int channels;
+        unsigned int order;
+        const char *name;
+    } cases[] = {
+        { BENCH_BIQUAD, 1, 2, "biquad_cascade_o2_1ch" },
+        { BENCH_BIQUAD, 1, 4, "biquad_cascade_o4_1ch" },
+        { BENCH_BIQUAD, 1, 8, "biquad_cascade_o8_1ch" },
+        { BENCH_BIQUAD, 2, 2, "biquad_cascade_o2_2ch" },
+        { BENCH_BIQUAD, 2, 8, "biquad_cascade_o8_2ch" },
+        { BENCH_BIQUAD, 6, 2, "biquad_cascade_o2_6ch" },
+        { BENCH_COMPRESSOR, 1, 0, "compressor_multi_1ch" },
+        { BENCH_COMPRESSOR, 2, 0, "compressor_multi_2ch" },
+        { BENCH_LIMITER, 2, 0, "limiter_96k_2ch" },
+        { BENCH_LIMITER, 8, 0, "limiter_96k_8ch" },
+    };
+    
+    float *buffer = malloc(BENCH_MAX_BLOCK * EFFECT_MAX_CHANNELS * sizeof(float));
+    if (!buffer) {
+        fprintf(stderr, "✗ Error: Failed to allocate multichannel benchmark\n");
+        exit(1);
+    }
+    
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        unsigned int channels = cases[c].channels;
+        for (size_t block = BENCH_MIN_BLOCK; block <= BENCH_MAX_BLOCK; block *= 2) {
+            uint64_t best = UINT64_MAX;
+            
+            for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+                fill_noise(buffer, block * channels);
+                uint64_t ns = bench_effect_multi(cases[c].kind, buffer, block, channels,
+                                                 cases[c].order);
+                if (ns < best) best = ns;
+            }
+            
+            uint64_t frames = (uint64_t)(BENCH_SAMPLES / (block * channels)) * block;
+            report("multichannel", cases[c].name, block, best, frames * channels);
+        }
+    }
+    
+    free(buffer);
+}
+
+/**
+ * Full chain (gain, 4th-order low-pass, compressor) run stage by stage over
+ * the block versus the fused kernel. The gap is the memory traffic saved on
+ * blocks that spill out of L1/L2. The largest blocks get only a few passes,
+ * so the compressor stays busier there than at small blocks.
+ */
+static uint64_t bench_chain(float *buffer, size_t block, unsigned int channels, bool fused) {
+    effect_chain_t chain;
+    effect_chain_init(&chain, BENCH_SAMPLE_RATE, channels);
+    biquad_cascade_lowpass(&chain.filter, BENCH_SAMPLE_RATE, 3000.0f, 4, channels);
+    chain.gain_enabled = true;  // 0 dB, so repeated passes stay bounded
+    chain.filter_enabled = true;
+    chain.compressor_enabled = true;
+    effect_chain_update(&chain);
+    
+    size_t reps = BENCH_SAMPLES / (block * channels);
+    if (reps == 0) reps = 1;
+    uint64_t start = utils_now_ns();
+    for (size_t i = 0; i < reps; i++) {
+        if (fused) {
+            effect_chain_process(&chain, buffer, block);
+        } else {
+            gain_process(&chain.gain, buffer, block * channels);
+            biquad_cascade_process(&chain.filter, buffer, block);
+            compressor_multi_process(&chain.compressor, buffer, block);
+        }
+    }
+    uint64_t ns = utils_now_ns() - start;
+    
+    bench_sink = buffer[0];
+    return ns;
+}
+
+static void run_chain_benchmarks(void) {
+    static const size_t blocks[] = { 256, 4096, 1u << 16, 1u << 20 };
+    const size_t max_block = 1u << 20;
+    
+    float *buffer = malloc(max_block * 2 * sizeof(float));
+    if (!buffer) {
+        fprintf(stderr, "✗ Error: Failed to allocate chain benchmark\n");
+        exit(1);
+    }
+    
+    for (unsigned int channels = 1; channels <= 2; channels++) {
+        for (int fused = 0; fused < 2; fused++) {
+            char name[64];
+            snprintf(name, sizeof(name), "chain_%s_%uch", fused ? "fused" : "staged", channels);
+            
+            for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+                size_t block = blocks[b];
+                uint64_t best = UINT64_MAX;
+                
+                for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+                    fill_noise(buffer, block * channels);
+                    uint64_t ns = bench_chain(buffer, block, channels, fused);
+                    if (ns < best) best = ns;
+                }
+                
+                size_t reps = BENCH_SAMPLES / (block * channels);
+                if (reps == 0) reps = 1;
+                report("chain", name, block, best, (uint64_t)reps * block * channels);
+            }
+        }
+    }
+    
+    free(buffer);
+}
+
+// ============================================================================
+// Device format conversion
+// ============================================================================
+
+#define BENCH_FORMAT_BLOCK 1024   // Samples: a 512-frame stereo period
+
+/**
+ * Every conversion kernel this CPU can run, one period-sized block at a
+ * time each way; float to integer is dithered where the format dithers.
+ */
+static void run_format_benchmarks(void) {
+    static const char *kernels[] = { "sse2", "neon", "scalar" };
+    static const sample_format_t formats[] = {
+        SAMPLE_FORMAT_S16, SAMPLE_FORMAT_S24_3, SAMPLE_FORMAT_S32,
+    };
+    
+    float *buffer = malloc(BENCH_FORMAT_BLOCK * sizeof(float));
+    void *device = calloc(BENCH_FORMAT_BLOCK, sizeof(int32_t));
+    if (!buffer || !device) {
+        fprintf(stderr, "✗ Error: Failed to allocate format benchmark buffers\n");
+        exit(1);
+    }
+    fill_noise(buffer, BENCH_FORMAT_BLOCK);
+    sample_dither_t dither;
+    sample_dither_init(&dither, 1);
+    
+    size_t reps = BENCH_SAMPLES / BENCH_FORMAT_BLOCK;
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (sample_format_select_kernel(kernels[k]) != 0) {
+            continue;
+        }
+        
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            for (int out = 0; out < 2; out++) {
+                uint64_t best = UINT64_MAX;
+                for (int trial = 0; trial < BENCH_TRIALS; trial++) {
+                    uint64_t start = utils_now_ns();
+                    for (size_t i = 0; i < reps; i++) {
+                        if (out) {
+                            sample_format_from_float(formats[f], buffer, device,
+                                                     BENCH_FORMAT_BLOCK, &dither);
+                        } else {
+                            sample_format_to_float(formats[f], device, buffer,
+                                                   BENCH_FORMAT_BLOCK);
+                        }
+                    }
+                    uint64_t ns = utils_now_ns() - start;
+                    if (ns < best) best = ns;
+                }
+                
+                char name[64];
+                snprintf(name, sizeof(name), "%s_%s_%s", out ? "from_float" : "to_float",
+                         sample_format_name(formats[f]), kernels[k]);
+                report("formats", name, BENCH_FORMAT_BLOCK, best,
+                       (uint64_t)reps * BENCH_FORMAT_BLOCK);
+            }
+        }
+    }
+    sample_format_select_kernel(NULL);
+    
+    bench_sink = buffer[0];
+    free(device);
+    free(buffer);
+}
+
+int main(int argc, char *argv[]) {
+    bool ring = true, effects = true;
+    
+    // Optional filter: "ring" or "effects"
+    if (argc > 1) {
+        ring = strcmp(argv[1], "ring") == 0;
+        effects = strcmp(argv[1], "effects") == 0;
+        if (!ring && !effects) {
+            fprintf(stderr, "Usage: %s [ring|effects]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    printf("suite,case,block,ns_per_sample,msamples_per_s\n");
+    if (ring) run_ring_benchmarks();
+    if (effects) {
+        run_effect_benchmarks();
+        run_multichannel_benchmarks();
+        run_chain_benchmarks();
+        run_format_benchmarks();
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+#define _GNU_SOURCE
+#include "../src/batch.h"
+#include "../src/effect_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "../src/dr_wav.h"
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IN_DIR "/tmp/test_batch_in"
+#define OUT_DIR "/tmp/test_batch_out"
+#define RATE 48000
+#define FILES 7
+
+static const effect_chain_config_t effects = {
+    .enabled = true, .gain_db = 9.0f, .lowpass_freq = 5000.0f, .highpass_freq = 60.0f,
+    .filter_order = 4, .compress = true,
+    .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 3.0f,
+};
+
+static char inputs[FILES][64];
+static const char *input_list[FILES];
+
+static size_t file_frames(int i) {
+    return 1000 + (size_t)((i * 7919) % 13) * 3001;   // Uneven lengths
+}
+
+static float* make_signal(size_t frames, unsigned int channels, float freq) {
+    float *samples = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            double phase = 2.0 * M_PI * freq * (c + 1) * (double)i / RATE;
+            samples[i * channels + c] = (float)(0.7 * sin(phase));
+        }
+    }
+    return samples;
+}
+
+/**
+ * Write a stereo file: odd ones as float (mapped), even ones as 16-bit.
+ */
+static void write_input(int i) {
+    size_t frames = file_frames(i);
+    float *samples = make_signal(frames, 2, 110.0f * (i + 1));
+    
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = (i & 1) ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels = 2;
+    format.sampleRate = RATE;
+    format.bitsPerSample = (i & 1) ? 32 : 16;
+    assert(drwav_init_file_write(&wav, inputs[i], &format, NULL));
+    if (i & 1) {
+        drwav_write_pcm_frames(&wav, frames, samples);
+    } else {
+        int16_t *pcm = malloc(frames * 2 * sizeof(int16_t));
+        drwav_f32_to_s16(pcm, samples, frames * 2);
+        drwav_write_pcm_frames(&wav, frames, pcm);
+        free(pcm);
+    }
+    drwav_uninit(&wav);
+    free(samples);
+}
+
+static void setup(void) {
+    mkdir(IN_DIR, 0755);
+    mkdir(OUT_DIR, 0755);
+    for (int i = 0; i < FILES; i++) {
+        snprintf(inputs[i], sizeof(inputs[i]), IN_DIR "/take%d.wav", i);
+        input_list[i] = inputs[i];
+        write_input(i);
+    }
+}
+
+static void teardown(void) {
+    for (int i = 0; i < FILES; i++) {
+        char out[64];
+        snprintf(out, sizeof(out), OUT_DIR "/take%d.wav", i);
+        remove(inputs[i]);
+        remove(out);
+    }
+    remove(IN_DIR "/list.txt");
+    remove(IN_DIR "/again/take0.wav");
+    rmdir(IN_DIR "/again");
+    remove(IN_DIR "/link");
+    rmdir(IN_DIR);
+    rmdir(OUT_DIR);
+}
+
+/**
+ * The file rendered alone and whole by a fresh graph: the input plus its
+ * latency in silence, with that latency dropped from the front.
+ */
+static float* render_alone(const char *path, size_t *frames) {
+    unsigned int channels, rate;
+    drwav_uint64 total;
+    float *in = drwav_open_file_and_read_pcm_frames_f32(path, &channels, &rate, &total, NULL);
+    assert(in && channels == 2 && rate == RATE);
+    
+    effect_graph_t *graph = effect_graph_from_config(&effects, RATE, channels, 0);
+    size_t delay = effect_graph_latency(graph);
+    float *buffer = calloc((total + delay) * channels, sizeof(float));
+    memcpy(buffer, in, total * channels * sizeof(float));
+    effect_graph_process(graph, buffer, total + delay);
+    memmove(buffer, &buffer[delay * channels], total * channels * sizeof(float));
+    effect_graph_free(graph);
+    drwav_free(in, NULL);
+    *frames = (size_t)total;
+    return buffer;
+}
+
+static void check_outputs(void) {
+    for (int i = 0; i < FILES; i++) {
+        char out[64];
+        snprintf(out, sizeof(out), OUT_DIR "/take%d.wav", i);
+        unsigned int channels, rate;
+        drwav_uint64 frames;
+        float *got = drwav_open_file_and_read_pcm_frames_f32(out, &channels, &rate, &frames, NULL);
+        size_t expected_frames;
+        float *expected = render_alone(inputs[i], &expected_frames);
+        assert(got && channels == 2 && rate == RATE && frames == expected_frames);
+        assert(memcmp(got, expected, expected_frames * 2 * sizeof(float)) == 0);
+        drwav_free(got, NULL);
+        free(expected);
+        remove(out);
+    }
+}
+
+// Test 1: Every output is the file rendered on its own, whatever the pool
+TEST(matches_single_file) {
+    unsigned int pools[] = { 1, 3, 16 };
+    for (size_t p = 0; p < sizeof(pools) / sizeof(pools[0]); p++) {
+        batch_config_t config = {
+            .inputs = input_list, .count = FILES, .output_dir = OUT_DIR,
+            .effects = effects, .workers = pools[p], .map_input = true, .chunk_frames = 1000,
+        };
+        batch_stats_t stats;
+        assert(batch_run(&config, &stats) == 0);
+        assert(stats.files_ok == FILES && stats.files_failed == 0);
+        assert(stats.workers == (pools[p] < FILES ? pools[p] : FILES));
+        assert(stats.audio_seconds > 0.0 && stats.wall_seconds > 0.0);
+        check_outputs();
+        
+        // One worker builds its graph once and resets it for the rest
+        if (pools[p] == 1) {
+            assert(stats.graph_builds == 1 && stats.steals == 0);
+        }
+    }
+}
+
+// Test 2: A file that can't be read fails alone; the rest still render
+TEST(missing_file) {
+    const char *list[FILES + 1];
+    memcpy(list, input_list, sizeof(input_list));
+    list[FILES] = IN_DIR "/missing.wav";
+    
+    batch_config_t config = {
+        .inputs = list, .count = FILES + 1, .output_dir = OUT_DIR,
+        .effects = effects, .workers = 2, .map_input = false,
+    };
+    batch_stats_t stats;
+    assert(batch_run(&config, &stats) != 0);
+    assert(stats.files_ok == FILES && stats.files_failed == 1);
+    check_outputs();
+}
+
+// Test 3: Inputs come from a directory's WAV files or a list file
+TEST(collect) {
+    char **paths;
+    size_t count;
+    assert(batch_collect(IN_DIR, &paths, &count) == 0);
+    assert(count == FILES);
+    for (size_t i = 0; i < count; i++) {
+        assert(strcmp(paths[i], inputs[i]) == 0);   // Sorted by name
+    }
+    batch_free_paths(paths, count);
+    
+    FILE *f = fopen(IN_DIR "/list.txt", "w");
+    fprintf(f, "# takes\n%s\n\n%s\r\n", inputs[3], inputs[0]);
+    fclose(f);
+    assert(batch_collect(IN_DIR "/list.txt", &paths, &count) == 0);
+    assert(count == 2 && strcmp(paths[0], inputs[3]) == 0 && strcmp(paths[1], inputs[0]) == 0);
+    batch_free_paths(paths, count);
+    
+    assert(batch_collect(IN_DIR "/nothing", &paths, &count) == -1);
+}
+
+static char* read_bytes(const char *path, size_t *length) {
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    *length = (size_t)ftell(f);
+    rewind(f);
+    char *bytes = malloc(*length);
+    assert(fread(bytes, 1, *length, f) == *length);
+    fclose(f);
+    return bytes;
+}
+
+// Test 4: Outputs that would land on their inputs (the input directory
+// itself, or a link to it) are refused before anything is written
+TEST(output_is_input) {
+    char *before[FILES];
+    size_t lengths[FILES];
+    for (int i = 0; i < FILES; i++) {
+        before[i] = read_bytes(inputs[i], &lengths[i]);
+    }
+    assert(symlink(IN_DIR, IN_DIR "/link") == 0);
+    
+    const char *dirs[] = { IN_DIR, IN_DIR "/link", IN_DIR "/../test_batch_in" };
+    for (size_t d = 0; d < sizeof(dirs) / sizeof(dirs[0]); d++) {
+        batch_config_t config = {
+            .inputs = input_list, .count = FILES, .output_dir = dirs[d],
+            .effects = effects, .workers = 3, .map_input = true,
+        };
+        batch_stats_t stats;
+        assert(batch_run(&config, &stats) != 0);
+        assert(stats.files_ok == 0 && stats.files_failed == FILES);
+        for (int i = 0; i < FILES; i++) {
+            size_t length;
+            char *after = read_bytes(inputs[i], &length);
+            assert(length == lengths[i] && memcmp(after, before[i], length) == 0);
+            free(after);
+        }
+    }
+    remove(IN_DIR "/link");
+    for (int i = 0; i < FILES; i++) {
+        free(before[i]);
+    }
+}
+
+// Test 5: Two inputs of one name would write one output: refused
+TEST(duplicate_names) {
+    mkdir(IN_DIR "/again", 0755);
+    FILE *from = fopen(inputs[0], "rb"), *to = fopen(IN_DIR "/again/take0.wav", "wb");
+    char bytes[4096];
+    size_t n;
+    while ((n = fread(bytes, 1, sizeof(bytes), from)) > 0) {
+        fwrite(bytes, 1, n, to);
+    }
+    fclose(from);
+    fclose(to);
+    
+    const char *list[] = { inputs[0], inputs[1], IN_DIR "/again/take0.wav" };
+    batch_config_t config = {
+        .inputs = list, .count = 3, .output_dir = OUT_DIR,
+        .effects = effects, .workers = 2, .map_input = false,
+    };
+    batch_stats_t stats;
+    assert(batch_run(&config, &stats) != 0);
+    assert(stats.files_ok == 0 && stats.files_failed == 3);
+    assert(access(OUT_DIR "/take0.wav", F_OK) != 0);
+    assert(access(OUT_DIR "/take1.wav", F_OK) != 0);
+}
+
+int main(void) {
+    printf("===== Batch Tests =====\n");
+    
+    setup();
+    RUN_TEST(matches_single_file);
+    RUN_TEST(missing_file);
+    RUN_TEST(collect);
+    RUN_TEST(output_is_input);
+    RUN_TEST(duplicate_names);
+    teardown();
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include "../src/convolver.h"
+#include "../src/fft.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define TOLERANCE 1e-4
+
+static uint32_t rng_state = 12345;
+
+static float noise(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / (float)(1u << 24) - 0.5f;
+}
+
+/**
+ * Exponentially decaying noise, like a room response, peak around 0.5.
+ */
+static float* make_ir(size_t frames, unsigned int channels) {
+    float *ir = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        float decay = expf(-4.0f * (float)i / (float)frames);
+        for (unsigned int c = 0; c < channels; c++) {
+            ir[i * channels + c] = noise() * decay;
+        }
+    }
+    return ir;
+}
+
+static float* make_signal(size_t frames, unsigned int channels) {
+    float *x = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames * channels; i++) {
+        x[i] = noise() * 0.2f;
+    }
+    return x;
+}
+
+/**
+ * Direct convolution in double, truncated to the input length.
+ */
+static void reference(const float *x, size_t frames, unsigned int channels,
+                      const convolver_ir_t *ir, double *y) {
+    for (unsigned int c = 0; c < channels; c++) {
+        unsigned int ic = ir->channels == 1 ? 0 : c;
+        for (size_t n = 0; n < frames; n++) {
+            double sum = 0.0;
+            size_t taps = n + 1 < ir->frames ? n + 1 : ir->frames;
+            for (size_t k = 0; k < taps; k++) {
+                sum += (double)ir->samples[k * ir->channels + ic] * x[(n - k) * channels + c];
+            }
+            y[n * channels + c] = sum;
+        }
+    }
+}
+
+static double max_error(const float *out, const double *ref, size_t count) {
+    double err = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double e = fabs(out[i] - ref[i]);
+        if (e > err) err = e;
+    }
+    return err;
+}
+
+/**
+ * Run x through a fresh convolver in calls of chunk frames and compare with
+ * direct convolution.
+ */
+static double convolve_error(size_t ir_frames, unsigned int ir_channels, unsigned int channels,
+                             size_t frames, size_t chunk, size_t head, size_t tail) {
+    float *h = make_ir(ir_frames, ir_channels);
+    convolver_ir_t ir = { h, ir_frames, ir_channels, 0 };
+    float *x = make_signal(frames, channels);
+    double *ref = malloc(frames * channels * sizeof(double));
+    reference(x, frames, channels, &ir, ref);
+    
+    convolver_t *conv = convolver_create(&ir, channels, head, tail, 1.0f, false);
+    assert(conv != NULL);
+    for (size_t pos = 0; pos < frames; pos += chunk) {
+        size_t n = frames - pos < chunk ? frames - pos : chunk;
+        convolver_process(conv, &x[pos * channels], n);
+    }
+    double err = max_error(x, ref, frames * channels);
+    
+    convolver_free(conv);
+    free(ref);
+    free(x);
+    free(h);
+    return err;
+}
+
+// Test 1: Forward then inverse gives n times the input back
+TEST(fft_roundtrip) {
+    for (size_t n = FFT_MIN_SIZE; n <= 8192; n *= 2) {
+        fft_t *fft = fft_create(n);
+        assert(fft != NULL && fft->size == n);
+        
+        float *x = make_signal(n, 1);
+        float *y = malloc(n * sizeof(float));
+        float *re = malloc((n / 2 + 1) * sizeof(float));
+        float *im = malloc((n / 2 + 1) * sizeof(float));
+        
+        fft_forward(fft, x, re, im);
+        fft_inverse(fft, re, im, y);
+        for (size_t i = 0; i < n; i++) {
+            assert(fabsf(y[i] / (float)n - x[i]) < 1e-5f);
+        }
+        
+        free(im);
+        free(re);
+        free(y);
+        free(x);
+        fft_free(fft);
+    }
+    
+    assert(fft_create(0) == NULL);
+    assert(fft_create(2) == NULL);
+    assert(fft_create(96) == NULL);
+}
+
+// Test 2: Bins match a direct DFT
+TEST(fft_matches_dft) {
+    size_t n = 256;
+    fft_t *fft = fft_create(n);
+    float *x = make_signal(n, 1);
+    float re[129], im[129];
+    
+    fft_forward(fft, x, re, im);
+    for (size_t k = 0; k <= n / 2; k++) {
+        double sr = 0.0, si = 0.0;
+        for (size_t t = 0; t < n; t++) {
+            double angle = -2.0 * 3.14159265358979323846 * (double)(k * t) / (double)n;
+            sr += x[t] * cos(angle);
+            si += x[t] * sin(angle);
+        }
+        assert(fabs(re[k] - sr) < 1e-4 && fabs(im[k] - si) < 1e-4);
+    }
+    assert(im[0] == 0.0f && im[n / 2] == 0.0f);
+    
+    free(x);
+    fft_free(fft);
+}
+
+// Test 3: Bad geometry and IRs that don't fit the stream are refused
+TEST(reject_invalid) {
+    float h[4] = { 1.0f, 0.5f, 0.25f, 0.125f };
+    convolver_ir_t mono = { h, 4, 1, 0 };
+    convolver_ir_t stereo = { h, 2, 2, 0 };
+    convolver_ir_t empty = { h, 0, 1, 0 };
+    
+    assert(convolver_create(NULL, 1, 0, 0, 1.0f, false) == NULL);
+    assert(convolver_create(&empty, 1, 0, 0, 1.0f, false) == NULL);
+    assert(convolver_create(&mono, 0, 0, 0, 1.0f, false) == NULL);
+    assert(convolver_create(&stereo, 3, 0, 0, 1.0f, false) == NULL);
+    assert(convolver_create(&mono, 1, 48, 0, 1.0f, false) == NULL);    // Not a power of 2
+    assert(convolver_create(&mono, 1, 128, 64, 1.0f, false) == NULL);  // Tail below head
+    
+    convolver_t *conv = convolver_create(&stereo, 2, 0, 0, 1.0f, false);
+    assert(conv != NULL);
+    assert(conv->head_block == CONVOLVER_HEAD_BLOCK && conv->tail_block == CONVOLVER_TAIL_BLOCK);
+    assert(!conv->has_head && !conv->has_tail);
+    convolver_free(conv);
+}
+
+// Test 4: A short IR runs on the direct FIR alone, with no latency
+TEST(short_ir) {
+    float h[3] = { 0.0f, 1.0f, -0.5f };
+    convolver_ir_t ir = { h, 3, 1, 0 };
+    convolver_t *conv = convolver_create(&ir, 1, 0, 0, 1.0f, false);
+    
+    float x[8] = { 1.0f, 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f, 0.0f };
+    convolver_process(conv, x, 8);
+    const float expect[8] = { 0.0f, 1.0f, -0.5f, 0.0f, 0.0f, 2.0f, -1.0f, 0.0f };
+    for (int i = 0; i < 8; i++) {
+        assert(fabsf(x[i] - expect[i]) < 1e-6f);
+    }
+    convolver_free(conv);
+    
+    assert(convolve_error(60, 1, 1, 4000, 37, 0, 0) < TOLERANCE);
+}
+
+// Test 5: IRs reaching into the head partitions, any call size
+TEST(head_ir) {
+    assert(convolve_error(65, 1, 1, 4000, 64, 0, 0) < TOLERANCE);
+    assert(convolve_error(1000, 1, 1, 6000, 1, 0, 0) < TOLERANCE);
+    assert(convolve_error(2048, 1, 1, 6000, 100, 0, 0) < TOLERANCE);
+    assert(convolve_error(500, 1, 1, 3000, 512, 32, 128) < TOLERANCE);
+}
+
+// Test 6: Long IRs go through the worker and still match exactly
+TEST(long_ir) {
+    assert(convolve_error(2049, 1, 1, 8000, 64, 0, 0) < TOLERANCE);
+    assert(convolve_error(12000, 1, 1, 20000, 256, 0, 0) < TOLERANCE);
+    assert(convolve_error(12000, 1, 1, 20000, 7, 0, 0) < TOLERANCE);
+    assert(convolve_error(5000, 1, 1, 12000, 5000, 16, 256) < TOLERANCE);
+}
+
+// Test 7: One IR per channel, or one IR shared by every channel
+TEST(multichannel) {
+    assert(convolve_error(6000, 2, 2, 10000, 128, 0, 0) < TOLERANCE);
+    assert(convolve_error(6000, 1, 3, 10000, 100, 32, 512) < TOLERANCE);
+}
+
+// Test 8: mix blends dry and wet linearly
+TEST(mix) {
+    float h[2] = { 0.0f, 1.0f };
+    convolver_ir_t ir = { h, 2, 1, 0 };
+    convolver_t *conv = convolver_create(&ir, 1, 0, 0, 0.25f, false);
+    
+    float x[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    convolver_process(conv, x, 4);
+    assert(fabsf(x[0] - 0.75f) < 1e-6f && fabsf(x[1] - 0.25f) < 1e-6f && x[2] == 0.0f);
+    convolver_free(conv);
+}
+
+// Test 9: Realtime mode never waits. A late tail is silence and input the
+// worker had no room for counts as silence; once it catches up the output
+// is exact again
+static bool wait_for_worker(convolver_t *conv) {
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    // The worker releases its input after sending the output
+    while (frame_ring_read_available(conv->tail_in) >= conv->tail_block) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec - start.tv_sec > 5) {
+            return false;
+        }
+        struct timespec pause = { 0, 100000 };
+        nanosleep(&pause, NULL);
+    }
+    return true;
+}
+
+TEST(realtime) {
+    size_t ir_frames = 4000, frames = 24000, burst = 8192, head = 64, tail = 256;
+    float *h = make_ir(ir_frames, 1);
+    convolver_ir_t ir = { h, ir_frames, 1, 0 };
+    float *x = make_signal(frames, 1);
+    double *ref = malloc(frames * sizeof(double));
+    reference(x, frames, 1, &ir, ref);
+    
+    convolver_t *conv = convolver_create(&ir, 1, head, tail, 1.0f, true);
+    assert(conv != NULL && conv->has_tail);
+    
+    // One call far longer than the rings: the worker can't keep up with it
+    convolver_process(conv, x, burst);
+    uint64_t late = convolver_late_frames(conv);
+    printf(" (%llu late)", (unsigned long long)late);
+    assert(max_error(x, ref, 2 * tail) < TOLERANCE);  // Before the tail starts
+    
+    // Then give it time before every block
+    for (size_t pos = burst; pos < frames; pos += head) {
+        assert(wait_for_worker(conv));
+        convolver_process(conv, &x[pos], head);
+    }
+    
+    // Exact again once what the burst lost has rung out of the IR
+    size_t settled = burst + ir_frames + 4 * tail;
+    assert(max_error(&x[settled], &ref[settled], frames - settled) < TOLERANCE);
+    
+    convolver_free(conv);
+    free(ref);
+    free(x);
+    free(h);
+}
+
+int main(void) {
+    printf("===== Convolver Tests =====\n");
+    
+    RUN_TEST(fft_roundtrip);
+    RUN_TEST(fft_matches_dft);
+    RUN_TEST(reject_invalid);
+    RUN_TEST(short_ir);
+    RUN_TEST(head_ir);
+    RUN_TEST(long_ir);
+    RUN_TEST(multichannel);
+    RUN_TEST(mix);
+    RUN_TEST(realtime);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
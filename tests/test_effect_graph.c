@@ -0,0 +1,526 @@
+#include "../src/effect_graph.h"
+#include "../src/convolver.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define RATE 48000.0f
+
+static void fill_sine(float *buffer, size_t frames, unsigned int channels, float freq) {
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            buffer[i * channels + c] = 0.5f * sinf(2.0f * 3.14159265f * freq * (i + c) / RATE);
+        }
+    }
+}
+
+static float peak(const float *buffer, size_t count) {
+    float p = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        if (fabsf(buffer[i]) > p) p = fabsf(buffer[i]);
+    }
+    return p;
+}
+
+// Test 1: Arena allocations are aligned, zeroed and bounded
+TEST(arena) {
+    assert(effect_graph_create(RATE, 0, 0, 0) == NULL);
+    assert(effect_graph_create(RATE, EFFECT_MAX_CHANNELS + 1, 0, 0) == NULL);
+    
+    effect_graph_t *graph = effect_graph_create(RATE, 2, 64, 256);
+    assert(graph != NULL && graph->max_frames == 64);
+    
+    unsigned char *a = effect_graph_alloc(graph, 10);
+    unsigned char *b = effect_graph_alloc(graph, 100);
+    assert(a && b && b >= a + 10);
+    assert((uintptr_t)a % EFFECT_GRAPH_ALIGN == 0 && (uintptr_t)b % EFFECT_GRAPH_ALIGN == 0);
+    for (int i = 0; i < 100; i++) assert(b[i] == 0);
+    
+    assert(effect_graph_alloc(graph, graph->arena_size) == NULL);
+    
+    // Compile carves the schedule and scratch from the same arena
+    assert(effect_graph_add_gain(graph, 6.0f) == 0);
+    assert(effect_graph_compile(graph) == 0);
+    unsigned char *end = graph->arena + graph->arena_size;
+    assert((unsigned char*)graph->schedule >= graph->arena && (unsigned char*)graph->schedule < end);
+    assert((unsigned char*)graph->scratch >= graph->arena &&
+           (unsigned char*)&graph->scratch[64 * 2] <= end);
+    
+    // Frozen once compiled
+    assert(effect_graph_add_gain(graph, 6.0f) == -1);
+    effect_graph_free(graph);
+}
+
+// Test 2: A config graph with one filter runs exactly as the chain on its own
+TEST(matches_chain) {
+    enum { FRAMES = 3000, CHANNELS = 2 };
+    static float expected[FRAMES * CHANNELS], actual[FRAMES * CHANNELS];
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = 9.0f, .lowpass_freq = 3000.0f, .filter_order = 4, .compress = true,
+    };
+    
+    fill_sine(expected, FRAMES, CHANNELS, 440.0f);
+    memcpy(actual, expected, sizeof(actual));
+    
+    effect_chain_t chain;
+    effect_chain_configure(&chain, &config, RATE, CHANNELS);
+    effect_chain_process(&chain, expected, FRAMES);
+    
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    assert(graph != NULL && graph->node_count == 1 && graph->chain != NULL);
+    effect_graph_process(graph, actual, FRAMES);
+    
+    assert(memcmp(expected, actual, sizeof(actual)) == 0);
+    effect_graph_free(graph);
+}
+
+// Test 3: Low-pass and high-pass together make a band-pass
+TEST(bandpass) {
+    enum { FRAMES = 9600 };
+    static float buffer[FRAMES];
+    effect_chain_config_t config = {
+        .enabled = true, .lowpass_freq = 2000.0f, .highpass_freq = 500.0f, .filter_order = 4,
+    };
+    
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, 1, 0);
+    assert(graph != NULL && graph->node_count == 2);
+    
+    float freqs[] = { 50.0f, 1000.0f, 12000.0f };
+    float gains[3];
+    for (int f = 0; f < 3; f++) {
+        fill_sine(buffer, FRAMES, 1, freqs[f]);
+        effect_graph_process(graph, buffer, FRAMES);
+        gains[f] = peak(&buffer[FRAMES / 2], FRAMES / 2) / 0.5f;
+    }
+    assert(gains[0] < 0.01f);
+    assert(gains[1] > 0.9f && gains[1] < 1.1f);
+    assert(gains[2] < 0.01f);
+    
+    effect_graph_free(graph);
+}
+
+// Test 4: Custom nodes run in order, one chunk at a time
+typedef struct {
+    float scale;
+    float offset;
+    size_t max_seen;
+} affine_node_t;
+
+static void affine_process(void *state, float *buffer, size_t frames, unsigned int channels) {
+    affine_node_t *node = (affine_node_t*)state;
+    if (frames > node->max_seen) node->max_seen = frames;
+    for (size_t i = 0; i < frames * channels; i++) {
+        buffer[i] = buffer[i] * node->scale + node->offset;
+    }
+}
+
+TEST(custom_nodes) {
+    enum { FRAMES = 1000, CHANNELS = 3 };
+    float buffer[FRAMES * CHANNELS];
+    effect_graph_t *graph = effect_graph_create(RATE, CHANNELS, 128, 0);
+    
+    affine_node_t *doubler = effect_graph_add_node(graph, affine_process, sizeof(affine_node_t));
+    affine_node_t *adder = effect_graph_add_node(graph, affine_process, sizeof(affine_node_t));
+    assert(doubler && adder && doubler->max_seen == 0);
+    assert((uintptr_t)doubler % EFFECT_GRAPH_ALIGN == 0 && (uintptr_t)adder % EFFECT_GRAPH_ALIGN == 0);
+    *doubler = (affine_node_t){ .scale = 2.0f };
+    *adder = (affine_node_t){ .scale = 1.0f, .offset = 1.0f };
+    assert(effect_graph_compile(graph) == 0);
+    
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) buffer[i] = (float)(i % 7);
+    effect_graph_process(graph, buffer, FRAMES);
+    
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+        assert(buffer[i] == 2.0f * (float)(i % 7) + 1.0f);
+    }
+    assert(doubler->max_seen == 128 && adder->max_seen == 128);
+    effect_graph_free(graph);
+}
+
+// Test 5: A wrapped span of whole frames matches a contiguous run
+TEST(process_split) {
+    enum { FRAMES = 700, CHANNELS = 6 };
+    static float expected[FRAMES * CHANNELS], split[FRAMES * CHANNELS];
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = -3.0f, .lowpass_freq = 6000.0f, .highpass_freq = 80.0f,
+    };
+    
+    fill_sine(expected, FRAMES, CHANNELS, 300.0f);
+    memcpy(split, expected, sizeof(split));
+    
+    effect_graph_t *a = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    effect_graph_t *b = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    effect_graph_process(a, expected, FRAMES);
+    
+    // Two runs of whole frames, the second first in memory, as a wrapped span
+    size_t frames1 = 333;
+    static float wrapped[FRAMES * CHANNELS];
+    memcpy(&wrapped[(FRAMES - frames1) * CHANNELS], split, frames1 * CHANNELS * sizeof(float));
+    memcpy(wrapped, &split[frames1 * CHANNELS], (FRAMES - frames1) * CHANNELS * sizeof(float));
+    frame_ring_span_t span = { &wrapped[(FRAMES - frames1) * CHANNELS], frames1,
+                               wrapped, FRAMES - frames1 };
+    effect_graph_process_split(b, &span);
+    memcpy(split, span.data1, frames1 * CHANNELS * sizeof(float));
+    memcpy(&split[frames1 * CHANNELS], wrapped, (FRAMES - frames1) * CHANNELS * sizeof(float));
+    
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+        assert(fabsf(expected[i] - split[i]) < 1e-6f);
+    }
+    effect_graph_free(a);
+    effect_graph_free(b);
+}
+
+// Test 6: Publishing crossfades to the new graph and retires the old one
+static effect_graph_t* gain_graph(float gain_db, unsigned int channels) {
+    effect_chain_config_t config = { .enabled = true, .gain_db = gain_db };
+    return effect_graph_from_config(&config, RATE, channels, 0);
+}
+
+TEST(runner_swap) {
+    enum { FRAMES = 512 };
+    float buffer[FRAMES];
+    effect_graph_runner_t runner;
+    effect_graph_t *a = gain_graph(0.0f, 1);
+    effect_graph_t *b = gain_graph(6.0f, 1);
+    effect_graph_t *c = gain_graph(-6.0f, 1);
+    float target = powf(10.0f, 6.0f / 20.0f);
+    
+    effect_graph_runner_init(&runner, a);
+    assert(effect_graph_runner_chain(&runner) == a->chain);
+    
+    effect_graph_t *stereo = gain_graph(0.0f, 2);
+    assert(effect_graph_runner_publish(&runner, stereo) == -1);
+    effect_graph_free(stereo);
+    
+    assert(effect_graph_runner_publish(&runner, b) == 0);
+    assert(effect_graph_runner_publish(&runner, c) == -1);  // b not picked up yet
+    
+    for (size_t i = 0; i < FRAMES; i++) buffer[i] = 1.0f;
+    frame_ring_span_t span = { buffer, 100, &buffer[100], FRAMES - 100 };
+    effect_graph_runner_process_split(&runner, &span);
+    for (size_t i = 1; i < FRAMES; i++) {
+        assert(buffer[i] > buffer[i - 1]);
+    }
+    assert(buffer[0] - 1.0f < 0.01f && fabsf(buffer[FRAMES - 1] - target) < 1e-6f);
+    assert(effect_graph_runner_chain(&runner) == b->chain);
+    
+    // c waits until a has been collected
+    assert(effect_graph_runner_publish(&runner, c) == 0);
+    for (size_t i = 0; i < FRAMES; i++) buffer[i] = 1.0f;
+    span = (frame_ring_span_t){ buffer, FRAMES, NULL, 0 };
+    effect_graph_runner_process_split(&runner, &span);
+    assert(buffer[0] == target && buffer[FRAMES - 1] == target);
+    
+    assert(effect_graph_runner_collect(&runner) == a);
+    assert(effect_graph_runner_collect(&runner) == NULL);
+    effect_graph_free(a);
+    
+    effect_graph_runner_process_split(&runner, &span);
+    assert(effect_graph_runner_chain(&runner) == c->chain);
+    
+    effect_graph_runner_destroy(&runner);  // Frees b (retired) and c
+    assert(runner.current == NULL);
+}
+
+// Test 7: Control thread building and swapping graphs under a running audio thread
+#define THREAD_SWAPS 200
+
+typedef struct {
+    effect_graph_runner_t *runner;
+    atomic_bool done;
+} swap_ctx_t;
+
+static void* control_thread(void *arg) {
+    swap_ctx_t *ctx = (swap_ctx_t*)arg;
+    
+    for (int i = 0; i < THREAD_SWAPS; i++) {
+        effect_graph_t *graph = gain_graph(i % 2 ? 6.0f : -6.0f, 2);
+        assert(graph != NULL);
+        while (effect_graph_runner_publish(ctx->runner, graph) != 0) {
+            effect_graph_free(effect_graph_runner_collect(ctx->runner));
+        }
+    }
+    atomic_store(&ctx->done, true);
+    return NULL;
+}
+
+TEST(threaded) {
+    enum { FRAMES = 64, CHANNELS = 2 };
+    float buffer[FRAMES * CHANNELS];
+    effect_graph_runner_t runner;
+    effect_graph_runner_init(&runner, NULL);
+    
+    swap_ctx_t ctx = { .runner = &runner };
+    atomic_init(&ctx.done, false);
+    pthread_t thread;
+    pthread_create(&thread, NULL, control_thread, &ctx);
+    
+    // Gains stay between -6 and +6 dB whatever graph is running or fading
+    float lo = powf(10.0f, -6.0f / 20.0f) - 1e-6f;
+    float hi = powf(10.0f, 6.0f / 20.0f) + 1e-6f;
+    size_t blocks = 0;
+    while (!atomic_load(&ctx.done) || atomic_load(&runner.pending) != NULL) {
+        for (size_t i = 0; i < FRAMES * CHANNELS; i++) buffer[i] = 1.0f;
+        frame_ring_span_t span = { buffer, FRAMES, NULL, 0 };
+        effect_graph_runner_process_split(&runner, &span);
+        if (runner.current) {
+            for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+                assert(buffer[i] >= lo && buffer[i] <= hi);
+            }
+        }
+        blocks++;
+        if (!atomic_load(&ctx.done) || atomic_load(&runner.retired) == NULL) continue;
+        effect_graph_free(effect_graph_runner_collect(&runner));  // Control thread is gone
+    }
+    pthread_join(thread, NULL);
+    
+    assert(blocks >= THREAD_SWAPS);
+    effect_graph_runner_destroy(&runner);
+}
+
+// Test 8: A config with an IR gets a convolver node after the chain, which
+// the graph tears down with itself
+static int destroyed;
+
+static void count_destroy(void *state) {
+    (void)state;
+    destroyed++;
+}
+
+TEST(convolver_node) {
+    enum { FRAMES = 6000, CHANNELS = 2, DELAY = 3000 };
+    static float impulse[DELAY + 1];
+    impulse[DELAY] = 1.0f;  // Past the head partitions, so the worker renders it
+    convolver_ir_t ir = { impulse, DELAY + 1, 1, 0 };
+    
+    effect_chain_config_t config = { .enabled = true, .gain_db = 6.0f, .ir = &ir, .ir_mix = 1.0f };
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    assert(graph != NULL && graph->node_count == 2);
+    assert(graph->nodes[1].destroy != NULL);
+    
+    static float buffer[FRAMES * CHANNELS];
+    fill_sine(buffer, FRAMES, CHANNELS, 440.0f);
+    static float dry[FRAMES * CHANNELS];
+    memcpy(dry, buffer, sizeof(dry));
+    effect_graph_process(graph, buffer, FRAMES);
+    
+    float gain = powf(10.0f, 6.0f / 20.0f);
+    assert(peak(buffer, DELAY * CHANNELS) < 1e-5f);  // FFT rounding only
+    for (size_t i = DELAY * CHANNELS; i < FRAMES * CHANNELS; i++) {
+        assert(fabsf(buffer[i] - gain * dry[i - DELAY * CHANNELS]) < 1e-4f);
+    }
+    effect_graph_free(graph);
+    
+    // Bypass skips the IR too; an IR that doesn't fit the channels fails the build
+    config.enabled = false;
+    graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    assert(graph != NULL && graph->node_count == 1);
+    effect_graph_free(graph);
+    
+    convolver_ir_t stereo = { impulse, DELAY / 2, 2, 0 };
+    config.enabled = true;
+    config.ir = &stereo;
+    assert(effect_graph_from_config(&config, RATE, 3, 0) == NULL);
+    
+    graph = effect_graph_create(RATE, 1, 0, 0);
+    destroyed = 0;
+    assert(effect_graph_add_node_ex(graph, affine_process, count_destroy, sizeof(affine_node_t)));
+    assert(effect_graph_add_node(graph, affine_process, sizeof(affine_node_t)));
+    effect_graph_free(graph);
+    assert(destroyed == 1);
+}
+
+// Test 9: The limiter node goes last, reports its delay and holds the ceiling
+TEST(limiter_node) {
+    enum { FRAMES = 4000, CHANNELS = 2 };
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = 12.0f,
+        .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 5.0f,
+    };
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    assert(graph != NULL && graph->node_count == 2);
+    assert(graph->nodes[1].destroy != NULL);
+    size_t delay = effect_graph_latency(graph);
+    assert(delay == 240);
+    
+    static float buffer[FRAMES * CHANNELS];
+    fill_sine(buffer, FRAMES, CHANNELS, 440.0f);
+    effect_graph_process(graph, buffer, FRAMES);
+    assert(peak(buffer, delay * CHANNELS) == 0.0f);
+    assert(peak(buffer, FRAMES * CHANNELS) <= powf(10.0f, -1.0f / 20.0f) * 1.0001f);
+    effect_graph_free(graph);
+    
+    // The runner reports the running graph's delay
+    effect_graph_runner_t runner;
+    effect_graph_runner_init(&runner, effect_graph_from_config(&config, RATE, CHANNELS, 0));
+    assert(effect_graph_runner_latency(&runner) == delay);
+    effect_graph_runner_destroy(&runner);
+    
+    config.limit = false;
+    graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    assert(graph != NULL && graph->node_count == 1 && effect_graph_latency(graph) == 0);
+    effect_graph_free(graph);
+}
+
+static void affine_reset(void *state) {
+    ((affine_node_t*)state)->max_seen = 0;
+}
+
+// Test 10: A reset graph renders exactly what a freshly built one does
+TEST(reset) {
+    enum { FRAMES = 3000, CHANNELS = 2 };
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = 6.0f, .lowpass_freq = 2000.0f, .highpass_freq = 100.0f,
+        .filter_order = 4, .compress = true,
+        .limit = true, .limit_ceiling_db = -3.0f, .limit_lookahead_ms = 2.0f,
+    };
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, CHANNELS, 0);
+    static float first[FRAMES * CHANNELS], again[FRAMES * CHANNELS];
+    fill_sine(first, FRAMES, CHANNELS, 440.0f);
+    memcpy(again, first, sizeof(first));
+    effect_graph_process(graph, first, FRAMES);
+    
+    static float other[FRAMES * CHANNELS];
+    fill_sine(other, FRAMES, CHANNELS, 97.0f);
+    effect_graph_process(graph, other, FRAMES);
+    assert(effect_graph_reset(graph) == 0);
+    effect_graph_process(graph, again, FRAMES);
+    assert(memcmp(first, again, sizeof(first)) == 0);
+    effect_graph_free(graph);
+    
+    // A node without a reset callback makes the whole graph refuse
+    graph = effect_graph_create(RATE, 1, 0, 0);
+    affine_node_t *node = effect_graph_add_node(graph, affine_process, sizeof(affine_node_t));
+    node->scale = 1.0f;
+    assert(effect_graph_compile(graph) == 0);
+    effect_graph_process(graph, first, 100);
+    assert(effect_graph_reset(graph) == -1 && node->max_seen == 100);
+    assert(effect_graph_set_reset(graph, first, affine_reset) == -1);
+    assert(effect_graph_set_reset(graph, node, affine_reset) == 0);
+    assert(effect_graph_reset(graph) == 0 && node->max_seen == 0);
+    effect_graph_free(graph);
+}
+
+// Test 11: An IR recorded at another rate is resampled to the graph's: the
+// same delay in seconds, at the same gain
+TEST(convolver_ir_rate) {
+    enum { FRAMES = 6000, IR_FRAMES = 1000, IR_DELAY = 500 };
+    static float impulse[IR_FRAMES];
+    impulse[IR_DELAY] = 1.0f;
+    convolver_ir_t ir = { impulse, IR_FRAMES, 1, (unsigned int)RATE / 2 };
+    
+    effect_chain_config_t config = { .enabled = true, .ir = &ir, .ir_mix = 1.0f };
+    effect_graph_t *graph = effect_graph_from_config(&config, RATE, 1, 0);
+    assert(graph != NULL);
+    
+    static float buffer[FRAMES], dry[FRAMES];
+    fill_sine(buffer, FRAMES, 1, 440.0f);
+    memcpy(dry, buffer, sizeof(dry));
+    effect_graph_process(graph, buffer, FRAMES);
+    
+    // 500 frames at 24 kHz are 1000 at 48 kHz
+    size_t delay = 2 * IR_DELAY;
+    for (size_t i = delay + 100; i < FRAMES; i++) {
+        assert(fabsf(buffer[i] - dry[i - delay]) < 2e-3f);
+    }
+    effect_graph_free(graph);
+    
+    // Too far apart for the resampler
+    ir.sample_rate = (unsigned int)RATE * 16;
+    assert(effect_graph_from_config(&config, RATE, 1, 0) == NULL);
+}
+
+// Test 12: Swapping between graphs of different latencies keeps the stream
+// aligned: the faster one is padded, and the new one primed before the fade
+TEST(runner_latency) {
+    enum { BLOCK = 128, BLOCKS = 16, CHANNELS = 2 };
+    effect_chain_config_t limited = {
+        .enabled = true, .limit = true, .limit_ceiling_db = 0.0f, .limit_lookahead_ms = 5.0f,
+    };
+    effect_graph_t *slow = effect_graph_from_config(&limited, RATE, CHANNELS, 0);
+    size_t delay = effect_graph_latency(slow);
+    assert(delay == 240);
+    
+    // Padding never shortens a graph
+    assert(effect_graph_set_latency(slow, delay - 1) == -1 && slow->latency == delay);
+    effect_graph_t *dry = gain_graph(0.0f, CHANNELS);
+    assert(effect_graph_set_latency(dry, delay) == 0 && effect_graph_latency(dry) == delay);
+    
+    effect_graph_runner_t runner;
+    effect_graph_runner_init(&runner, dry);
+    effect_graph_t *slower = effect_graph_from_config(&limited, RATE * 2.0f, CHANNELS, 0);
+    assert(effect_graph_runner_publish(&runner, slower) == -1);
+    effect_graph_free(slower);
+    
+    // Below the ceiling every graph here is a plain delay, so whatever runs
+    // or fades, the output is the input from delay frames earlier
+    static float input[BLOCK * BLOCKS * CHANNELS];
+    fill_sine(input, BLOCK * BLOCKS, CHANNELS, 440.0f);
+    effect_graph_t *fast = NULL;
+    for (size_t b = 0; b < BLOCKS; b++) {
+        if (b == 1) {
+            assert(effect_graph_runner_publish(&runner, slow) == 0);
+        }
+        if (b == 3) {
+            assert(runner.current == dry);  // Still priming: 2 blocks < delay
+        }
+        if (b == 6) {
+            assert(runner.current == slow);
+            assert(effect_graph_runner_collect(&runner) == dry);
+            effect_graph_free(dry);
+            fast = gain_graph(0.0f, CHANNELS);
+            assert(effect_graph_runner_publish(&runner, fast) == 0);
+            assert(effect_graph_latency(fast) == delay);
+        }
+        
+        float block[BLOCK * CHANNELS];
+        memcpy(block, &input[b * BLOCK * CHANNELS], sizeof(block));
+        frame_ring_span_t span = { block, BLOCK, NULL, 0 };
+        effect_graph_runner_process_split(&runner, &span);
+        assert(effect_graph_runner_latency(&runner) == delay);
+        
+        for (size_t i = 0; i < BLOCK * CHANNELS; i++) {
+            size_t n = b * BLOCK * CHANNELS + i;
+            float expected = n >= delay * CHANNELS ? input[n - delay * CHANNELS] : 0.0f;
+            assert(fabsf(block[i] - expected) < 1e-5f);
+        }
+    }
+    assert(runner.current == fast);
+    
+    effect_graph_runner_destroy(&runner);  // Frees slow (retired) and fast
+}
+
+int main(void) {
+    printf("===== Effect Graph Tests =====\n");
+    
+    RUN_TEST(arena);
+    RUN_TEST(matches_chain);
+    RUN_TEST(bandpass);
+    RUN_TEST(custom_nodes);
+    RUN_TEST(process_split);
+    RUN_TEST(runner_swap);
+    RUN_TEST(threaded);
+    RUN_TEST(convolver_node);
+    RUN_TEST(limiter_node);
+    RUN_TEST(reset);
+    RUN_TEST(convolver_ir_rate);
+    RUN_TEST(runner_latency);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
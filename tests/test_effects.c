@@ -0,0 +1,399 @@
+#include "../src/effects.h"
+#include "../src/frame_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define TEST_SAMPLES 1031  // Odd length: exercises every kernel's scalar tail
+
+static const char *kernel_names[] = { "avx2", "sse2", "neon", "scalar" };
+
+static void fill_test_signal(float *buffer, size_t count) {
+    uint32_t state = 0xdeadbeefu;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1664525u + 1013904223u;
+        buffer[i] = (float)(state >> 8) / (float)(1u << 23) - 1.0f;
+    }
+}
+
+// Test 1: Every available gain kernel matches the scalar multiply exactly
+TEST(gain_kernels_match_scalar) {
+    float input[TEST_SAMPLES + 1];
+    float output[TEST_SAMPLES + 1];
+    fill_test_signal(input, TEST_SAMPLES + 1);
+    
+    gain_effect_t gain;
+    gain_init(&gain, -3.5f);
+    
+    for (size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); k++) {
+        if (gain_select_kernel(kernel_names[k]) != 0) {
+            continue;  // Not built in or not supported by this CPU
+        }
+        
+        // Offset by one sample so the vector loads are unaligned
+        for (size_t offset = 0; offset < 2; offset++) {
+            for (size_t n = 0; n <= TEST_SAMPLES; n += (n < 40 ? 1 : 97)) {
+                memcpy(output, input, sizeof(output));
+                gain_process(&gain, &output[offset], n);
+                
+                for (size_t i = 0; i < TEST_SAMPLES + 1; i++) {
+                    float expected = input[i];
+                    if (i >= offset && i < offset + n) expected *= gain.gain;
+                    assert(output[i] == expected);
+                }
+            }
+        }
+    }
+    assert(gain_select_kernel("no-such-kernel") == -1);
+    assert(gain_select_kernel(NULL) == 0);
+}
+
+// Test 2: The smoothed ramp is identical across kernels and lands on target
+TEST(gain_smooth_ramp) {
+    float input[TEST_SAMPLES];
+    float reference[TEST_SAMPLES];
+    float output[TEST_SAMPLES];
+    fill_test_signal(input, TEST_SAMPLES);
+    
+    assert(gain_select_kernel("scalar") == 0);
+    gain_effect_t gain;
+    gain_init(&gain, 0.0f);
+    gain_set_target(&gain, -12.0f);
+    float target = gain.target;
+    memcpy(reference, input, sizeof(reference));
+    gain_process_smooth(&gain, reference, TEST_SAMPLES);
+    assert(gain.gain == target);
+    
+    // Monotonic ramp from unity down towards the target gain
+    float step = (target - 1.0f) / TEST_SAMPLES;
+    for (size_t i = 0; i < TEST_SAMPLES; i++) {
+        assert(reference[i] == input[i] * (1.0f + step * (float)(i + 1)));
+    }
+    
+    for (size_t k = 0; k < sizeof(kernel_names) / sizeof(kernel_names[0]); k++) {
+        if (gain_select_kernel(kernel_names[k]) != 0) {
+            continue;
+        }
+        
+        gain_init(&gain, 0.0f);
+        gain_set_target(&gain, -12.0f);
+        memcpy(output, input, sizeof(output));
+        gain_process_smooth(&gain, output, TEST_SAMPLES);
+        assert(memcmp(output, reference, sizeof(output)) == 0);
+        
+        // Once at target, the next block is a plain constant gain
+        memcpy(output, input, sizeof(output));
+        gain_process_smooth(&gain, output, TEST_SAMPLES);
+        for (size_t i = 0; i < TEST_SAMPLES; i++) {
+            assert(output[i] == input[i] * target);
+        }
+    }
+    gain_select_kernel(NULL);
+}
+
+/**
+ * Reference cascade: one channel, one sample and one section at a time.
+ */
+static void reference_cascade(const biquad_cascade_t *cascade, float *z1, float *z2,
+                              float *buffer, size_t frames, unsigned int channels,
+                              unsigned int channel) {
+    for (size_t i = 0; i < frames; i++) {
+        float x = buffer[i * channels + channel];
+        for (unsigned int s = 0; s < cascade->sections; s++) {
+            float y = cascade->b0[s] * x + z1[s];
+            z1[s] = cascade->b1[s] * x + z2[s] - cascade->a1[s] * y;
+            z2[s] = cascade->b2[s] * x - cascade->a2[s] * y;
+            x = y;
+        }
+        buffer[i * channels + channel] = x;
+    }
+}
+
+// Test 3: Cascades (channel lanes and mono section lanes) match the reference
+TEST(cascade_matches_reference) {
+    enum { FRAMES = 300, CHANNELS = 6 };
+    static const size_t blocks[] = { 1, 2, 3, 5, 64, 225 };  // Sums to FRAMES
+    float input[FRAMES * CHANNELS];
+    fill_test_signal(input, FRAMES * CHANNELS);
+    
+    for (unsigned int order = 2; order <= 2 * BIQUAD_MAX_SECTIONS; order += 2) {
+        for (unsigned int channels = 1; channels <= CHANNELS; channels++) {
+            float buffer[FRAMES * CHANNELS];
+            float expected[FRAMES * CHANNELS];
+            memcpy(buffer, input, sizeof(buffer));
+            memcpy(expected, input, sizeof(expected));
+            
+            biquad_cascade_t cascade;
+            assert(biquad_cascade_lowpass(&cascade, 48000.0f, 2500.0f, order, channels) == 0);
+            assert(cascade.sections == order / 2);
+            
+            // Uneven blocks: state (and the mono pipeline) must carry over
+            size_t pos = 0;
+            for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+                biquad_cascade_process(&cascade, &buffer[pos * channels], blocks[b]);
+                pos += blocks[b];
+            }
+            assert(pos == FRAMES);
+            
+            for (unsigned int c = 0; c < channels; c++) {
+                float z1[BIQUAD_MAX_SECTIONS] = { 0 }, z2[BIQUAD_MAX_SECTIONS] = { 0 };
+                reference_cascade(&cascade, z1, z2, expected, FRAMES, channels, c);
+                for (unsigned int s = 0; s < cascade.sections; s++) {
+                    assert(cascade.z1[s][c] == z1[s] && cascade.z2[s][c] == z2[s]);
+                }
+            }
+            assert(memcmp(buffer, expected, sizeof(float) * FRAMES * channels) == 0);
+        }
+    }
+    
+    biquad_cascade_t cascade;
+    assert(biquad_cascade_lowpass(&cascade, 48000.0f, 1000.0f, 3, 1) == -1);
+    assert(biquad_cascade_lowpass(&cascade, 48000.0f, 1000.0f, 10, 1) == -1);
+    assert(biquad_cascade_highpass(&cascade, 48000.0f, 1000.0f, 4, EFFECT_MAX_CHANNELS + 1) == -1);
+}
+
+static float sine_gain_db(biquad_cascade_t *cascade, float freq) {
+    enum { N = 48000 };
+    static float buffer[N];
+    for (size_t i = 0; i < N; i++) {
+        buffer[i] = sinf(2.0f * 3.14159265f * freq * i / 48000.0f);
+    }
+    biquad_cascade_reset(cascade);
+    biquad_cascade_process(cascade, buffer, N);
+    
+    // Skip the transient, then compare RMS against the input's 1/sqrt(2)
+    double sum = 0.0;
+    for (size_t i = N / 2; i < N; i++) {
+        sum += (double)buffer[i] * buffer[i];
+    }
+    return 10.0f * log10f((float)(sum / (N / 2)) / 0.5f);
+}
+
+// Test 4: Butterworth cascades: flat passband, -3 dB at cutoff, steeper with order
+TEST(butterworth_response) {
+    float previous_stop = 0.0f;
+    
+    for (unsigned int order = 2; order <= 2 * BIQUAD_MAX_SECTIONS; order += 2) {
+        biquad_cascade_t cascade;
+        assert(biquad_cascade_lowpass(&cascade, 48000.0f, 1000.0f, order, 1) == 0);
+        
+        assert(fabsf(sine_gain_db(&cascade, 100.0f)) < 0.1f);
+        assert(fabsf(sine_gain_db(&cascade, 1000.0f) + 3.01f) < 0.2f);
+        
+        // About -6 dB per octave per order, an octave above cutoff
+        float stop = sine_gain_db(&cascade, 2000.0f);
+        assert(stop < -10.0f && stop < previous_stop - 8.0f);
+        previous_stop = stop;
+    }
+}
+
+// Test 5: A wrapped frame ring span processes like one contiguous block
+TEST(process_split_wrapped_frames) {
+    enum { FRAMES = 64, CHANNELS = 6 };
+    float whole[FRAMES * CHANNELS];
+    float split[FRAMES * CHANNELS];
+    fill_test_signal(whole, FRAMES * CHANNELS);
+    
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = 2.0f, .lowpass_freq = 4000.0f, .compress = true,
+    };
+    effect_chain_t a, b;
+    effect_chain_configure(&a, &config, 48000.0f, CHANNELS);
+    effect_chain_configure(&b, &config, 48000.0f, CHANNELS);
+    
+    // 20 frames in, so the span wraps after 44 whole frames
+    frame_ring_t *ring = frame_ring_f32_create(FRAMES, CHANNELS, NULL);
+    assert(ring != NULL);
+    assert(frame_ring_f32_write(ring, split, 20) == 20);
+    assert(frame_ring_f32_read(ring, split, 20) == 20);
+    assert(frame_ring_f32_write(ring, whole, FRAMES) == FRAMES);
+    
+    frame_ring_span_t span;
+    assert(frame_ring_read_acquire(ring, FRAMES, &span) == FRAMES);
+    assert(span.frames1 == 44 && span.frames2 == 20);
+    effect_chain_process(&b, span.data1, span.frames1);
+    effect_chain_process(&b, span.data2, span.frames2);
+    memcpy(split, span.data1, span.frames1 * ring->stride);
+    memcpy(&split[span.frames1 * CHANNELS], span.data2, span.frames2 * ring->stride);
+    frame_ring_read_release(ring, FRAMES);
+    
+    effect_chain_process(&a, whole, FRAMES);
+    assert(memcmp(whole, split, sizeof(whole)) == 0);
+    frame_ring_free(ring);
+}
+
+/**
+ * Reference compressor: the exact powf gain curve.
+ */
+static void reference_compressor(compressor_t *comp, float *buffer, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        float input = fabsf(buffer[i]);
+        float coef = input > comp->envelope ? comp->attack_coef : comp->release_coef;
+        comp->envelope = coef * comp->envelope + (1.0f - coef) * input;
+        
+        float gain = 1.0f;
+        if (comp->envelope > comp->threshold) {
+            gain = powf(comp->envelope / comp->threshold, (1.0f / comp->ratio) - 1.0f);
+        }
+        buffer[i] *= gain;
+    }
+}
+
+// Test 6: The fast gain computer tracks the powf curve within the stated tolerance
+TEST(compressor_matches_curve) {
+    enum { N = 8192 };
+    static float input[N], expected[N], output[N];
+    static const float ratios[] = { 1.5f, 4.0f, 20.0f, 1000.0f };
+    
+    // Exponential sweep from -100 dBFS to +40 dBFS with alternating sign
+    for (size_t i = 0; i < N; i++) {
+        float db = -100.0f + 140.0f * (float)i / N;
+        input[i] = powf(10.0f, db / 20.0f) * ((i & 1) ? -1.0f : 1.0f);
+    }
+    
+    for (size_t r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+        compressor_t fast, exact;
+        compressor_init(&fast, -20.0f, ratios[r], 1.0f, 50.0f, 48000.0f);
+        exact = fast;
+        memcpy(expected, input, sizeof(expected));
+        memcpy(output, input, sizeof(output));
+        reference_compressor(&exact, expected, N);
+        compressor_process(&fast, output, N);
+        
+        compressor_multi_t multi;
+        float stereo[2 * 256];
+        compressor_init(&fast, -20.0f, ratios[r], 1.0f, 50.0f, 48000.0f);
+        compressor_multi_init(&multi, &fast, 2);
+        
+        for (size_t i = 0; i < N; i++) {
+            float error_db = 20.0f * log10f(output[i] / expected[i]);
+            assert(fabsf(error_db) < COMPRESSOR_GAIN_TOLERANCE_DB);
+        }
+        
+        // Both channels of the multichannel compressor see the same sweep
+        for (size_t pos = 0; pos < N; pos += 256) {
+            for (size_t i = 0; i < 256; i++) {
+                stereo[2 * i] = stereo[2 * i + 1] = input[pos + i];
+            }
+            compressor_multi_process(&multi, stereo, 256);
+            for (size_t i = 0; i < 256; i++) {
+                assert(stereo[2 * i] == output[pos + i] && stereo[2 * i + 1] == output[pos + i]);
+            }
+        }
+    }
+}
+
+// Test 7: Every fused chain kernel matches running the stages one by one
+TEST(fused_chain_matches_stages) {
+    enum { FRAMES = 3001 };  // Several chunks plus a partial one
+    static float input[FRAMES * 6], fused[FRAMES * 6], staged[FRAMES * 6];
+    static const unsigned int layouts[] = { 1, 2, 6 };
+    fill_test_signal(input, FRAMES * 6);
+    
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        unsigned int channels = layouts[l];
+        size_t samples = FRAMES * channels;
+        
+        for (unsigned int mask = 0; mask < 8; mask++) {
+            effect_chain_config_t config = {
+                .enabled = true,
+                .gain_db = (mask & 1) ? 9.0f : 0.0f,
+                .lowpass_freq = (mask & 2) ? 3000.0f : 0.0f,
+                .filter_order = 4,
+                .compress = (mask & 4) != 0,
+            };
+            effect_chain_t chain;
+            effect_chain_configure(&chain, &config, 48000.0f, channels);
+            effect_chain_t stages = chain;
+            
+            memcpy(fused, input, samples * sizeof(float));
+            memcpy(staged, input, samples * sizeof(float));
+            effect_chain_process(&chain, fused, FRAMES);
+            
+            if (stages.gain_enabled) gain_process(&stages.gain, staged, samples);
+            if (stages.filter_enabled) biquad_cascade_process(&stages.filter, staged, FRAMES);
+            if (stages.compressor_enabled) {
+                compressor_multi_process(&stages.compressor, staged, FRAMES);
+            }
+            
+            assert(memcmp(fused, staged, samples * sizeof(float)) == 0);
+        }
+    }
+    
+    // Flags changed by hand take effect after effect_chain_update()
+    effect_chain_t chain;
+    effect_chain_init(&chain, 48000.0f, 1);
+    gain_init(&chain.gain, 6.0f);
+    chain.gain_enabled = true;
+    effect_chain_update(&chain);
+    memcpy(fused, input, FRAMES * sizeof(float));
+    effect_chain_process(&chain, fused, FRAMES);
+    for (size_t i = 0; i < FRAMES; i++) {
+        assert(fused[i] == input[i] * chain.gain.gain);
+    }
+}
+
+// Test 8: Each channel of a multichannel chain matches a mono chain run on
+// that channel alone, sample for sample
+TEST(channels_match_mono) {
+    enum { FRAMES = 2047 };
+    static float input[FRAMES * EFFECT_MAX_CHANNELS], multi[FRAMES * EFFECT_MAX_CHANNELS];
+    static float mono[FRAMES];
+    static const unsigned int layouts[] = { 2, 3, 6, 8 };
+    fill_test_signal(input, FRAMES * EFFECT_MAX_CHANNELS);
+    
+    effect_chain_config_t config = {
+        .enabled = true, .gain_db = 6.0f, .lowpass_freq = 5000.0f, .highpass_freq = 100.0f,
+        .filter_order = 4, .compress = true,
+    };
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        unsigned int channels = layouts[l];
+        effect_chain_t chain;
+        effect_chain_configure(&chain, &config, 48000.0f, channels);
+        memcpy(multi, input, FRAMES * channels * sizeof(float));
+        effect_chain_process(&chain, multi, FRAMES);
+        
+        for (unsigned int c = 0; c < channels; c++) {
+            effect_chain_t alone;
+            effect_chain_configure(&alone, &config, 48000.0f, 1);
+            for (size_t i = 0; i < FRAMES; i++) {
+                mono[i] = input[i * channels + c];
+            }
+            effect_chain_process(&alone, mono, FRAMES);
+            for (size_t i = 0; i < FRAMES; i++) {
+                assert(multi[i * channels + c] == mono[i]);
+            }
+        }
+    }
+}
+
+int main(void) {
+    printf("===== Effects Tests =====\n");
+    printf("Gain kernel: %s\n", gain_kernel_name());
+    
+    RUN_TEST(gain_kernels_match_scalar);
+    RUN_TEST(gain_smooth_ramp);
+    RUN_TEST(cascade_matches_reference);
+    RUN_TEST(butterworth_response);
+    RUN_TEST(process_split_wrapped_frames);
+    RUN_TEST(compressor_matches_curve);
+    RUN_TEST(fused_chain_matches_stages);
+    RUN_TEST(channels_match_mono);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
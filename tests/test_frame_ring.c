@@ -0,0 +1,297 @@
+#include "../src/frame_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define THREADING_FRAMES 200000
+
+// Test 1: Geometry follows element size, count and stride
+TEST(create_destroy) {
+    frame_ring_t *ring = frame_ring_create(256, sizeof(float), 2, 0, NULL);
+    assert(ring != NULL);
+    assert(ring->capacity == 256 && ring->mask == 255);
+    assert(ring->stride == 2 * sizeof(float));
+    assert(ring->elements == 2 && ring->element_size == sizeof(float));
+    assert(((uintptr_t)ring->buffer & (RING_BUFFER_CACHE_LINE - 1)) == 0);
+    frame_ring_free(ring);
+    
+    ring = frame_ring_create(256, sizeof(float), 3, 16, NULL);
+    assert(ring != NULL && ring->stride == 16);
+    frame_ring_free(ring);
+}
+
+// Test 2: Bad geometry is refused
+TEST(reject_invalid) {
+    assert(frame_ring_create(1000, sizeof(float), 2, 0, NULL) == NULL);
+    assert(frame_ring_create(256, sizeof(float), 0, 0, NULL) == NULL);
+    assert(frame_ring_create(256, 0, 2, 0, NULL) == NULL);
+    assert(frame_ring_create(256, sizeof(float), 4, 8, NULL) == NULL);  // Stride < frame
+}
+
+// Test 3: Counts are in frames; a full ring never takes part of a frame
+TEST(whole_frames) {
+    frame_ring_t *ring = frame_ring_f32_create(8, 3, NULL);
+    assert(ring != NULL);
+    
+    float in[10 * 3], out[10 * 3];
+    for (int i = 0; i < 30; i++) in[i] = (float)i;
+    
+    assert(frame_ring_f32_write(ring, in, 10) == 8);
+    assert(frame_ring_read_available(ring) == 8);
+    assert(frame_ring_write_available(ring) == 0);
+    
+    assert(frame_ring_f32_read(ring, out, 5) == 5);
+    assert(memcmp(out, in, 5 * 3 * sizeof(float)) == 0);
+    assert(frame_ring_write_available(ring) == 5);
+    
+    // Wrap around: frames 8, 9 land at the start of the storage
+    assert(frame_ring_f32_write(ring, &in[8 * 3], 2) == 2);
+    assert(frame_ring_f32_read(ring, out, 10) == 5);
+    assert(memcmp(out, &in[5 * 3], 5 * 3 * sizeof(float)) == 0);
+    assert(frame_ring_read_available(ring) == 0);
+    
+    frame_ring_free(ring);
+}
+
+// Test 4: int16 I/O frames through the typed front end
+TEST(int16_frames) {
+    frame_ring_t *ring = frame_ring_s16_create(64, 2, NULL);
+    assert(ring != NULL && ring->stride == 2 * sizeof(int16_t));
+    
+    int16_t in[40 * 2], out[40 * 2];
+    for (int i = 0; i < 80; i++) in[i] = (int16_t)(i * 409 - 16000);
+    
+    frame_ring_span_t span;
+    assert(frame_ring_write_acquire(ring, 40, &span) == 40);
+    memcpy(frame_ring_s16_data1(&span), in, span.frames1 * ring->stride);
+    frame_ring_write_commit(ring, 40);
+    
+    assert(frame_ring_read_acquire(ring, 40, &span) == 40);
+    assert(span.frames1 == 40 && span.frames2 == 0);
+    assert(frame_ring_s16_data1(&span)[79] == in[79]);
+    frame_ring_read_release(ring, 40);
+    
+    // Zero-copy spans split at a frame boundary
+    assert(frame_ring_s16_write(ring, in, 40) == 40);
+    assert(frame_ring_read_acquire(ring, 40, &span) == 40);
+    assert(span.frames1 == 24 && span.frames2 == 16);
+    assert(frame_ring_s16_data2(&span)[0] == in[24 * 2]);
+    frame_ring_read_release(ring, 40);
+    
+    assert(frame_ring_s16_write(ring, in, 40) == 40);
+    assert(frame_ring_s16_read(ring, out, 40) == 40);
+    assert(memcmp(out, in, sizeof(in)) == 0);
+    
+    frame_ring_free(ring);
+}
+
+// Test 5: Padded frames start on SIMD-width boundaries
+TEST(padded_stride) {
+    frame_ring_t *ring = frame_ring_create(32, sizeof(float), 3, 4 * sizeof(float), NULL);
+    assert(ring != NULL);
+    
+    float in[20 * 4];
+    for (int i = 0; i < 80; i++) in[i] = (float)i;
+    assert(frame_ring_write(ring, in, 20) == 20);
+    
+    frame_ring_span_t span;
+    assert(frame_ring_read_acquire(ring, 20, &span) == 20);
+    float *frame = (float*)span.data1;
+    for (size_t i = 0; i < span.frames1; i++) {
+        assert(((uintptr_t)&frame[i * 4] & 15) == 0);
+        assert(frame[i * 4 + 2] == in[i * 4 + 2]);
+    }
+    frame_ring_read_release(ring, 20);
+    
+    frame_ring_free(ring);
+}
+
+// Test 6: Metadata records travel as frames
+typedef struct {
+    uint64_t timestamp;
+    uint32_t frames;
+    uint32_t flags;
+} block_info_t;
+
+TEST(metadata) {
+    frame_ring_t *ring = frame_ring_create(16, sizeof(block_info_t), 1, 0, NULL);
+    assert(ring != NULL);
+    
+    for (uint32_t i = 0; i < 40; i++) {
+        block_info_t info = { .timestamp = 1000u * i, .frames = 256, .flags = i & 1 };
+        assert(frame_ring_write(ring, &info, 1) == 1);
+        
+        block_info_t got;
+        assert(frame_ring_read(ring, &got, 1) == 1);
+        assert(got.timestamp == info.timestamp && got.flags == info.flags);
+    }
+    
+    frame_ring_free(ring);
+}
+
+// Test 7: Mirrored frame rings hand out single spans, or fall back cleanly
+TEST(mirrored) {
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.mirrored = true;
+    
+    // 1024 frames of 6 floats: 24 KiB, a whole number of pages
+    frame_ring_t *ring = frame_ring_f32_create(1024, 6, &options);
+    assert(ring != NULL);
+    printf(" (%s)", ring->mirrored ? "mirrored" : "fallback");
+    
+    static float in[700 * 6], out[700 * 6];
+    for (int i = 0; i < 700 * 6; i++) in[i] = (float)i;
+    
+    for (int pass = 0; pass < 4; pass++) {
+        assert(frame_ring_f32_write(ring, in, 700) == 700);
+        frame_ring_span_t span;
+        assert(frame_ring_read_acquire(ring, 700, &span) == 700);
+        if (ring->mirrored) {
+            assert(span.frames2 == 0);
+        }
+        frame_ring_read_release(ring, 0);
+        assert(frame_ring_f32_read(ring, out, 700) == 700);
+        assert(memcmp(out, in, sizeof(in)) == 0);
+    }
+    
+    frame_ring_free(ring);
+}
+
+// Test 8: Fill level, high water and reset are in frames
+TEST(fill_level_reset) {
+    frame_ring_t *ring = frame_ring_f32_create(64, 2, NULL);
+    float in[48 * 2] = { 0 };
+    
+    assert(frame_ring_f32_write(ring, in, 48) == 48);
+    assert(frame_ring_fill_level(ring) == 48);
+    
+    frame_ring_span_t span;
+    frame_ring_read_acquire(ring, 1, &span);
+    assert(frame_ring_high_water(ring) == 48);
+    
+    frame_ring_reset(ring);
+    assert(frame_ring_fill_level(ring) == 0);
+    assert(frame_ring_high_water(ring) == 0);
+    assert(frame_ring_write_available(ring) == 64);
+    
+    frame_ring_free(ring);
+}
+
+// Test 9: Producer and consumer never see a torn frame
+typedef struct {
+    frame_ring_t *ring;
+    int consumed;
+} frame_thread_t;
+
+static void* frame_producer(void *arg) {
+    frame_thread_t *data = (frame_thread_t*)arg;
+    int32_t block[7 * 4];
+    int sent = 0;
+    
+    while (sent < THREADING_FRAMES) {
+        int n = THREADING_FRAMES - sent < 7 ? THREADING_FRAMES - sent : 7;
+        for (int i = 0; i < n; i++) {
+            for (int c = 0; c < 4; c++) block[i * 4 + c] = (sent + i) * 4 + c;
+        }
+        sent += (int)frame_ring_s32_write(data->ring, block, (size_t)n);
+    }
+    return NULL;
+}
+
+static void* frame_consumer(void *arg) {
+    frame_thread_t *data = (frame_thread_t*)arg;
+    
+    while (data->consumed < THREADING_FRAMES) {
+        frame_ring_span_t span;
+        size_t n = frame_ring_read_acquire(data->ring, 5, &span);
+        for (size_t i = 0; i < n; i++) {
+            const int32_t *frame = i < span.frames1
+                ? &frame_ring_s32_data1(&span)[i * 4]
+                : &frame_ring_s32_data2(&span)[(i - span.frames1) * 4];
+            for (int c = 0; c < 4; c++) {
+                assert(frame[c] == (data->consumed + (int)i) * 4 + c);
+            }
+        }
+        frame_ring_read_release(data->ring, n);
+        data->consumed += (int)n;
+    }
+    return NULL;
+}
+
+TEST(threading) {
+    frame_ring_t *ring = frame_ring_s32_create(64, 4, NULL);
+    assert(ring != NULL);
+    
+    frame_thread_t data = { .ring = ring, .consumed = 0 };
+    pthread_t prod, cons;
+    pthread_create(&cons, NULL, frame_consumer, &data);
+    pthread_create(&prod, NULL, frame_producer, &data);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    
+    assert(data.consumed == THREADING_FRAMES);
+    frame_ring_free(ring);
+}
+
+// Test 10: Blocking waits count frames
+static void* close_later(void *arg) {
+    frame_ring_t *ring = (frame_ring_t*)arg;
+    float frame[2] = { 1.0f, -1.0f };
+    
+    frame_ring_f32_write(ring, frame, 1);
+    frame_ring_close(ring);
+    return NULL;
+}
+
+TEST(wait_frames) {
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.waitable = true;
+    
+    frame_ring_t *ring = frame_ring_f32_create(16, 2, &options);
+    assert(frame_ring_wait_readable(ring, 1, 1000000) == 0);
+    assert(frame_ring_wait_writable(ring, 16, 0) == 16);
+    
+    // Parked for 4 frames: the single frame doesn't wake it, the close does
+    pthread_t thread;
+    pthread_create(&thread, NULL, close_later, ring);
+    size_t got = frame_ring_wait_readable(ring, 4, RING_BUFFER_WAIT_FOREVER);
+    pthread_join(thread, NULL);
+    assert(got <= 1 && frame_ring_read_available(ring) == 1);
+    
+    frame_ring_free(ring);
+}
+
+int main(void) {
+    printf("===== Frame Ring Tests =====\n");
+    
+    RUN_TEST(create_destroy);
+    RUN_TEST(reject_invalid);
+    RUN_TEST(whole_frames);
+    RUN_TEST(int16_frames);
+    RUN_TEST(padded_stride);
+    RUN_TEST(metadata);
+    RUN_TEST(mirrored);
+    RUN_TEST(fill_level_reset);
+    RUN_TEST(threading);
+    RUN_TEST(wait_frames);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include "../src/limiter.h"
+#include "../src/effects.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define RATE 48000.0f
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float* make_sine(size_t frames, unsigned int channels, float amplitude) {
+    float *x = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            x[i * channels + c] = (float)(amplitude * sin(2.0 * M_PI * 440.0 * (double)i / RATE + c));
+        }
+    }
+    return x;
+}
+
+static float peak(const float *x, size_t samples) {
+    float p = 0.0f;
+    for (size_t i = 0; i < samples; i++) {
+        if (fabsf(x[i]) > p) p = fabsf(x[i]);
+    }
+    return p;
+}
+
+/**
+ * The naive sliding maximum the deque replaces: rescan the window per frame.
+ */
+static float window_max(const float *x, size_t frame, size_t window, unsigned int channels) {
+    size_t start = frame + 1 >= window ? frame + 1 - window : 0;
+    return peak(&x[start * channels], (frame + 1 - start) * channels);
+}
+
+// Test 1: Bad parameters are refused
+TEST(reject_invalid) {
+    assert(limiter_create(0, RATE, -1.0f, 5.0f, 50.0f) == NULL);
+    assert(limiter_create(EFFECT_MAX_CHANNELS + 1, RATE, -1.0f, 5.0f, 50.0f) == NULL);
+    assert(limiter_create(2, 0.0f, -1.0f, 5.0f, 50.0f) == NULL);
+    assert(limiter_create(2, RATE, NAN, 5.0f, 50.0f) == NULL);
+    assert(limiter_create(2, RATE, -1.0f, -1.0f, 50.0f) == NULL);
+    assert(limiter_create(2, RATE, -1.0f, 5.0f, -1.0f) == NULL);
+}
+
+// Test 2: Below the ceiling the output is the input, delayed by the latency
+TEST(transparent_delay) {
+    enum { FRAMES = 2000, CHANNELS = 2 };
+    limiter_t *lim = limiter_create(CHANNELS, RATE, -1.0f, 5.0f, 50.0f);
+    assert(lim != NULL);
+    size_t delay = limiter_latency(lim);
+    assert(delay == 240);
+    
+    float *x = make_sine(FRAMES, CHANNELS, 0.5f);
+    float *y = malloc(FRAMES * CHANNELS * sizeof(float));
+    memcpy(y, x, FRAMES * CHANNELS * sizeof(float));
+    limiter_process(lim, y, FRAMES);
+    
+    assert(peak(y, delay * CHANNELS) == 0.0f);
+    for (size_t i = delay * CHANNELS; i < FRAMES * CHANNELS; i++) {
+        assert(y[i] == x[i - delay * CHANNELS]);
+    }
+    assert(limiter_max_reduction_db(lim) == 0.0f);
+    
+    free(y);
+    free(x);
+    limiter_free(lim);
+}
+
+// Test 3: A sudden loud burst never gets past the ceiling, even on its first sample
+TEST(brickwall) {
+    enum { FRAMES = 8000, CHANNELS = 2 };
+    limiter_t *lim = limiter_create(CHANNELS, RATE, -1.0f, 2.0f, 20.0f);
+    assert(lim != NULL);
+    float ceiling = powf(10.0f, -1.0f / 20.0f);
+    
+    float *x = make_sine(FRAMES, CHANNELS, 0.2f);
+    for (size_t i = 3000 * CHANNELS; i < 3500 * CHANNELS; i++) {
+        x[i] *= 20.0f;
+    }
+    x[5000 * CHANNELS + 1] = 8.0f;  // A lone spike on one channel
+    
+    limiter_process(lim, x, FRAMES);
+    assert(peak(x, FRAMES * CHANNELS) <= ceiling * 1.0001f);
+    
+    // The spike took the gain down to about ceiling / 8
+    float reduction = limiter_max_reduction_db(lim);
+    assert(fabsf(reduction - 20.0f * log10f(ceiling / 8.0f)) < 0.1f);
+    
+    // Reset: back to unity and a silent delay line
+    limiter_reset(lim);
+    assert(limiter_max_reduction_db(lim) == 0.0f);
+    float *quiet = make_sine(FRAMES, CHANNELS, 0.2f);
+    memcpy(x, quiet, FRAMES * CHANNELS * sizeof(float));
+    limiter_process(lim, x, FRAMES);
+    size_t delay = limiter_latency(lim);
+    for (size_t i = delay * CHANNELS; i < FRAMES * CHANNELS; i++) {
+        assert(x[i] == quiet[i - delay * CHANNELS]);
+    }
+    
+    free(quiet);
+    free(x);
+    limiter_free(lim);
+}
+
+// Test 4: The gain eases down before a peak rather than stepping
+TEST(smooth_attack) {
+    enum { FRAMES = 4000 };
+    limiter_t *lim = limiter_create(1, RATE, 0.0f, 5.0f, 50.0f);
+    assert(lim != NULL);
+    size_t delay = limiter_latency(lim);
+    
+    // DC at 0.5 with a step to 2.0: the gain has to reach 0.5 at the step
+    float *x = malloc(FRAMES * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        x[i] = i < 2000 ? 0.5f : 2.0f;
+    }
+    limiter_process(lim, x, FRAMES);
+    
+    // Output frame delay + i is input frame i
+    for (size_t i = 2000 - delay; i < 2000; i++) {
+        float step = x[delay + i] - x[delay + i - 1];
+        assert(step <= 0.0f);                   // Falls steadily...
+        assert(step > -0.5f / (float)delay);    // ...over the whole lookahead
+    }
+    assert(x[delay + 2000] <= 1.0001f);
+    assert(x[delay + 2000 - delay - 1] == 0.5f);  // Untouched before the ramp
+    
+    free(x);
+    limiter_free(lim);
+}
+
+// Test 5: The sliding maximum matches a rescan of the window
+TEST(sliding_max) {
+    enum { FRAMES = 3000, CHANNELS = 3 };
+    limiter_t *lim = limiter_create(CHANNELS, RATE, -6.0f, 1.0f, 0.0f);
+    assert(lim != NULL);
+    size_t window = lim->window;
+    
+    srand(7);
+    float *x = malloc(FRAMES * CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+        x[i] = 2.0f * ((float)rand() / (float)RAND_MAX) - 1.0f;
+        if (rand() % 50 == 0) x[i] *= 3.0f;
+    }
+    
+    // One frame at a time, so the deque head can be checked after each
+    float *frame = malloc(CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        memcpy(frame, &x[i * CHANNELS], CHANNELS * sizeof(float));
+        limiter_process(lim, frame, 1);
+        float max = lim->deque_peak[lim->deque_head & lim->deque_mask];
+        assert(max == window_max(x, i, window, CHANNELS));
+        assert(lim->deque_tail - lim->deque_head <= window);
+    }
+    
+    free(frame);
+    free(x);
+    limiter_free(lim);
+}
+
+// Test 6: Block size doesn't change the output
+TEST(chunk_independent) {
+    enum { FRAMES = 5000, CHANNELS = 2 };
+    float *x = make_sine(FRAMES, CHANNELS, 1.5f);
+    float *a = malloc(FRAMES * CHANNELS * sizeof(float));
+    float *b = malloc(FRAMES * CHANNELS * sizeof(float));
+    memcpy(a, x, FRAMES * CHANNELS * sizeof(float));
+    memcpy(b, x, FRAMES * CHANNELS * sizeof(float));
+    
+    limiter_t *la = limiter_create(CHANNELS, RATE, -3.0f, 3.0f, 30.0f);
+    limiter_t *lb = limiter_create(CHANNELS, RATE, -3.0f, 3.0f, 30.0f);
+    limiter_process(la, a, FRAMES);
+    for (size_t pos = 0; pos < FRAMES; pos += 77) {
+        size_t n = FRAMES - pos < 77 ? FRAMES - pos : 77;
+        limiter_process(lb, &b[pos * CHANNELS], n);
+    }
+    assert(memcmp(a, b, FRAMES * CHANNELS * sizeof(float)) == 0);
+    
+    // No lookahead: no delay, and still nothing over the ceiling
+    limiter_t *lz = limiter_create(CHANNELS, RATE, -3.0f, 0.0f, 30.0f);
+    assert(limiter_latency(lz) == 0);
+    limiter_process(lz, x, FRAMES);
+    assert(peak(x, FRAMES * CHANNELS) <= powf(10.0f, -3.0f / 20.0f) * 1.0001f);
+    
+    limiter_free(lz);
+    limiter_free(lb);
+    limiter_free(la);
+    free(b);
+    free(a);
+    free(x);
+}
+
+// Test 7: A window that is a power of 2 fills the deque's ring exactly;
+// the sliding maximum and the ceiling still hold
+TEST(power_of_2_window) {
+    // 1 frame of lookahead: a window of 2, on a falling run where every
+    // frame stays a candidate
+    limiter_t *lim = limiter_create(1, RATE, 0.0f, 1000.0f / RATE, 0.0f);
+    assert(lim != NULL && lim->window == 2);
+    float x[] = { 4.0f, 3.0f, 2.0f, 1.0f, 0.5f, 0.0f };
+    limiter_process(lim, x, 6);
+    assert(peak(x, 6) <= 1.0001f);
+    limiter_free(lim);
+    
+    // 255 frames of lookahead: a window of 256
+    enum { FRAMES = 6000, CHANNELS = 2 };
+    lim = limiter_create(CHANNELS, RATE, -1.0f, 255.0f * 1000.0f / RATE, 0.0f);
+    assert(lim != NULL && lim->window == 256);
+    float ceiling = powf(10.0f, -1.0f / 20.0f);
+    size_t window = lim->window;
+    
+    // Falling ramps longer than the window: every frame stays a candidate
+    float *in = malloc(FRAMES * CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        float level = 1.0f + 2.0f * (float)(600 - i % 600) / 600.0f;
+        for (unsigned int c = 0; c < CHANNELS; c++) {
+            in[i * CHANNELS + c] = c % 2 ? -level : level;
+        }
+    }
+    
+    // One frame at a time, so the deque head can be checked after each
+    float *frame = malloc(CHANNELS * sizeof(float));
+    float *out = malloc(FRAMES * CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        memcpy(frame, &in[i * CHANNELS], CHANNELS * sizeof(float));
+        limiter_process(lim, frame, 1);
+        memcpy(&out[i * CHANNELS], frame, CHANNELS * sizeof(float));
+        float max = lim->deque_peak[lim->deque_head & lim->deque_mask];
+        assert(max == window_max(in, i, window, CHANNELS));
+    }
+    assert(peak(out, FRAMES * CHANNELS) <= ceiling * 1.0001f);
+    
+    free(out);
+    free(frame);
+    free(in);
+    limiter_free(lim);
+}
+
+int main(void) {
+    printf("===== Limiter Tests =====\n");
+    
+    RUN_TEST(reject_invalid);
+    RUN_TEST(transparent_delay);
+    RUN_TEST(brickwall);
+    RUN_TEST(smooth_attack);
+    RUN_TEST(sliding_max);
+    RUN_TEST(chunk_independent);
+    RUN_TEST(power_of_2_window);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
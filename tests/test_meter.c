@@ -0,0 +1,186 @@
+#include "../src/meter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RATE 48000
+#define PERIOD 480
+#define TONE 0.0707946    // -23 dBFS
+
+/**
+ * frames of a stereo sine at amplitude (both channels), from phase.
+ */
+static float* make_sine(size_t frames, double freq, double amplitude, double phase) {
+    float *samples = malloc(frames * 2 * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        float x = (float)(amplitude * sin(2.0 * M_PI * freq * i / RATE + phase));
+        samples[i * 2] = x;
+        samples[i * 2 + 1] = x;
+    }
+    return samples;
+}
+
+/**
+ * Tap frames in periods into a meter whose ring holds all of them, so
+ * nothing is summarized or dropped, and read it once it has stopped.
+ */
+static void measure(const float *samples, size_t frames, meter_reading_t *reading) {
+    meter_t *meter = meter_create(2, RATE, frames + frames / PERIOD * 2);
+    assert(meter);
+    for (size_t i = 0; i < frames; i += PERIOD) {
+        size_t n = frames - i < PERIOD ? frames - i : PERIOD;
+        meter_tap(meter, &samples[i * 2], n);
+    }
+    meter_stop(meter);
+    meter_read(meter, reading);
+    meter_free(meter);
+    assert(reading->frames_metered == frames);
+    assert(reading->frames_summarized == 0 && reading->frames_dropped == 0);
+}
+
+// Test 1: The EBU Tech 3341 calibration: a 997 Hz sine at -23 dBFS on both
+// channels reads -23 LUFS
+TEST(calibration) {
+    size_t frames = 5 * RATE;
+    float *samples = make_sine(frames, 997.0, TONE, 0.0);
+    meter_reading_t reading;
+    measure(samples, frames, &reading);
+    
+    assert(fabsf(reading.momentary_lufs + 23.0f) < 0.1f);
+    assert(fabsf(reading.short_term_lufs + 23.0f) < 0.1f);
+    assert(fabsf(reading.integrated_lufs + 23.0f) < 0.1f);
+    assert(fabsf(reading.peak_db + 23.0f) < 0.01f);
+    assert(fabsf(reading.rms_db + 26.01f) < 0.02f);
+    assert(reading.true_peak_db >= reading.peak_db && reading.true_peak_db < -22.9f);
+    free(samples);
+}
+
+// Test 2: Silence after the tone is gated out of the integrated loudness,
+// not out of the windows
+TEST(gating) {
+    size_t frames = 8 * RATE;
+    float *samples = make_sine(frames, 997.0, TONE, 0.0);
+    memset(&samples[4 * RATE * 2], 0, 4 * RATE * 2 * sizeof(float));
+    meter_reading_t reading;
+    measure(samples, frames, &reading);
+    
+    // 37 gating blocks of tone and 3 fading out pass the gates, 37 silent
+    // ones don't: -23 + 10 log10(38.5 / 40), where ungated would be -26
+    assert(fabsf(reading.integrated_lufs + 23.166f) < 0.05f);
+    assert(reading.momentary_lufs < -100.0f);
+    assert(reading.short_term_lufs < -100.0f);
+    assert(reading.rms_db < -100.0f);
+    free(samples);
+}
+
+// Test 3: A sine at a quarter of the rate, sampled 45 degrees off its crests,
+// peaks 3 dB above its samples
+TEST(true_peak) {
+    size_t frames = RATE;
+    float *samples = make_sine(frames, RATE / 4.0, 0.5, M_PI / 4.0);
+    meter_reading_t reading;
+    measure(samples, frames, &reading);
+    
+    assert(fabsf(reading.peak_db - 20.0f * log10f(0.5f * sqrtf(0.5f))) < 0.01f);
+    assert(fabsf(reading.true_peak_db - 20.0f * log10f(0.5f)) < 0.2f);
+    free(samples);
+}
+
+// Test 4: A meter that can't keep up summarizes, then drops, and every
+// tapped frame is accounted for either way
+TEST(falls_behind) {
+    size_t frames = 2 * RATE;
+    float *samples = make_sine(frames, 997.0, TONE, 0.0);
+    
+    // Blocks bigger than the ring only ever get through as summaries
+    meter_t *meter = meter_create(2, RATE, 256);
+    assert(meter);
+    for (size_t i = 0; i < frames; i += 4 * PERIOD) {
+        meter_tap(meter, &samples[i * 2], 4 * PERIOD);
+    }
+    meter_stop(meter);
+    meter_reading_t reading;
+    meter_read(meter, &reading);
+    meter_free(meter);
+    assert(reading.frames_metered == 0);
+    assert(reading.frames_summarized + reading.frames_dropped == frames);
+    if (reading.frames_summarized == frames) {
+        // Summaries keep the peak and the RMS exact
+        assert(fabsf(reading.peak_db + 23.0f) < 0.01f);
+        assert(fabsf(reading.rms_db + 26.01f) < 0.02f);
+    }
+    
+    // Flooding a small ring drops without ever blocking the tap
+    meter = meter_create(2, RATE, 1024);
+    assert(meter);
+    for (int pass = 0; pass < 50; pass++) {
+        for (size_t i = 0; i < frames; i += PERIOD) {
+            meter_tap(meter, &samples[i * 2], PERIOD);
+        }
+    }
+    meter_stop(meter);
+    meter_read(meter, &reading);
+    meter_free(meter);
+    assert(reading.frames_metered + reading.frames_summarized + reading.frames_dropped ==
+           50 * frames);
+    assert(reading.frames_dropped > 0 || reading.frames_summarized > 0);
+    free(samples);
+}
+
+// Test 5: Rates other than 48 kHz get their own K-weighting
+TEST(other_rates) {
+    unsigned int rates[] = { 44100, 96000 };
+    for (size_t r = 0; r < 2; r++) {
+        size_t frames = 3 * rates[r];
+        float *samples = malloc(frames * sizeof(float));
+        for (size_t i = 0; i < frames; i++) {
+            samples[i] = (float)(0.1 * sin(2.0 * M_PI * 997.0 * i / rates[r]));
+        }
+        meter_t *meter = meter_create(1, rates[r], frames + frames / PERIOD * 2);
+        assert(meter);
+        for (size_t i = 0; i < frames; i += PERIOD) {
+            meter_tap(meter, &samples[i], frames - i < PERIOD ? frames - i : PERIOD);
+        }
+        meter_stop(meter);
+        meter_reading_t reading;
+        meter_read(meter, &reading);
+        meter_free(meter);
+        
+        // One channel 3 dB up reads as loud as the stereo tone
+        assert(fabsf(reading.integrated_lufs + 23.0f) < 0.1f);
+        free(samples);
+    }
+    assert(meter_create(0, RATE, 0) == NULL);
+    assert(meter_create(METER_MAX_CHANNELS + 1, RATE, 0) == NULL);
+}
+
+int main(void) {
+    printf("===== Meter Tests =====\n");
+    
+    RUN_TEST(calibration);
+    RUN_TEST(gating);
+    RUN_TEST(true_peak);
+    RUN_TEST(falls_behind);
+    RUN_TEST(other_rates);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,268 @@
+#define _GNU_SOURCE
+#include "../src/net_audio.h"
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RATE 48000
+
+/**
+ * Wait (up to 2 s) for the receiver thread to have taken packets.
+ */
+static void wait_received(net_receiver_t *rx, uint64_t packets) {
+    net_receiver_stats_t st;
+    uint64_t deadline = utils_now_ns() + 2000000000ull;
+    do {
+        net_receiver_stats(rx, &st);
+        if (st.packets_received >= packets) {
+            return;
+        }
+        utils_sleep_ns(10000);
+    } while (utils_now_ns() < deadline);
+    assert(!"receiver never got the packets");
+}
+
+static double rms(const float *samples, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (double)samples[i] * samples[i];
+    }
+    return sqrt(sum / count);
+}
+
+// Test 1: Packets carry the header and the samples bit for bit, and
+// anything else is turned away
+TEST(pack_unpack) {
+    unsigned char packet[NET_AUDIO_HEADER_BYTES + NET_AUDIO_MAX_PAYLOAD];
+    float frames[20], back[NET_AUDIO_MAX_PAYLOAD / sizeof(float)];
+    for (int i = 0; i < 20; i++) {
+        frames[i] = (float)(i - 10) / 7.0f;
+    }
+    net_audio_header_t header = { 0xBEEF, 0xFFFFFFF0u, 0x12345678u, true }, parsed;
+    size_t bytes = net_audio_pack(packet, &header, frames, 10, 2);
+    assert(bytes == NET_AUDIO_HEADER_BYTES + 80);
+    assert(packet[0] == 0x80 && packet[1] == (0x80 | NET_AUDIO_PAYLOAD_TYPE));
+    
+    assert(net_audio_unpack(packet, bytes, 2, &parsed, back) == 10);
+    assert(parsed.sequence == 0xBEEF && parsed.timestamp == 0xFFFFFFF0u);
+    assert(parsed.ssrc == 0x12345678u && parsed.marker);
+    assert(memcmp(frames, back, sizeof(frames)) == 0);
+    
+    assert(net_audio_unpack(packet, bytes, 3, &parsed, back) == -1);   // Not whole frames
+    assert(net_audio_unpack(packet, NET_AUDIO_HEADER_BYTES, 2, &parsed, back) == -1);
+    packet[1] = 0;   // Payload type 0 (PCMU) isn't ours
+    assert(net_audio_unpack(packet, bytes, 2, &parsed, back) == -1);
+    
+    net_audio_config_t cfg;
+    net_audio_config_init(&cfg);
+    assert(net_audio_packet_frames(&cfg, RATE, 2) == 120);
+    cfg.packet_ms = 20.0;
+    assert(net_audio_packet_frames(&cfg, RATE, 2) == NET_AUDIO_MAX_PAYLOAD / 8);
+}
+
+// Test 2: A stream over loopback comes out whole, behind a buffer of the
+// configured depth
+TEST(round_trip) {
+    net_audio_config_t cfg;
+    net_audio_config_init(&cfg);
+    cfg.min_delay_ms = 20.0;    // Lockstep sending makes the arrival jitter
+    cfg.max_delay_ms = 20.0;    // meaningless: pin the target
+    net_receiver_t *rx = net_receiver_open("127.0.0.1:0", 2, RATE, &cfg);
+    assert(rx);
+    char dest[32];
+    snprintf(dest, sizeof(dest), "127.0.0.1:%u", net_receiver_port(rx));
+    net_sender_t *tx = net_sender_open(dest, 2, RATE, &cfg);
+    assert(tx);
+    size_t packet = tx->packet_frames;
+    
+    size_t frames = RATE / 2;
+    float *in = malloc(frames * 2 * sizeof(float));
+    float *out = malloc(frames * 2 * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        in[i * 2] = (float)(0.5 * sin(2.0 * M_PI * 440.0 * i / RATE));
+        in[i * 2 + 1] = in[i * 2];
+    }
+    
+    // One packet out, one packet's worth read, like two clocks in step
+    uint64_t sent = 0;
+    for (size_t i = 0; i + packet <= frames; i += packet) {
+        sent += net_sender_send(tx, &in[i * 2], packet);
+        wait_received(rx, sent);
+        assert(net_receiver_read(rx, &out[i * 2], packet) == packet);
+    }
+    net_receiver_stats_t st;
+    net_receiver_stats(rx, &st);
+    assert(st.packets_received == sent && sent == frames / packet);
+    assert(st.packets_lost == 0 && st.packets_late == 0 && st.packets_reordered == 0);
+    assert(st.underruns == 0 && st.frames_concealed == 0 && st.frames_skipped == 0);
+    assert(st.resyncs == 0);
+    assert(fabs(st.target_ms - 20.0) < 0.01);
+    assert(st.latency_ms_avg > 19.5 && st.latency_ms_avg < 25.0);
+    
+    // Silence while the buffer fills, then the tone at its own level
+    assert(rms(out, 2 * (size_t)(0.015 * RATE)) == 0.0);
+    size_t start = (size_t)(0.1 * RATE);
+    double level = rms(&out[start * 2], (frames - start - packet) * 2);
+    assert(fabs(level - 0.5 / sqrt(2.0)) < 0.005);
+    
+    net_sender_close(tx);
+    net_receiver_close(rx);
+    free(in);
+    free(out);
+}
+
+static void send_bytes(int fd, unsigned int port, const void *bytes, size_t length) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(sendto(fd, bytes, length, 0, (struct sockaddr*)&addr, sizeof(addr)) ==
+           (ssize_t)length);
+}
+
+/**
+ * Send one crafted packet of constant value to port.
+ */
+static void send_packet(int fd, unsigned int port, uint32_t ssrc, uint32_t index,
+                        size_t frames) {
+    unsigned char packet[NET_AUDIO_HEADER_BYTES + NET_AUDIO_MAX_PAYLOAD];
+    float samples[NET_AUDIO_MAX_PAYLOAD / sizeof(float)];
+    for (size_t i = 0; i < frames; i++) {
+        samples[i] = 0.25f;
+    }
+    net_audio_header_t header = { (uint16_t)index, 1000 + index * (uint32_t)frames, ssrc,
+                                  index == 0 };
+    send_bytes(fd, port, packet, net_audio_pack(packet, &header, samples, frames, 1));
+}
+
+// Test 3: Loss is concealed once enough has overtaken it; reordering within
+// the stash is put right; duplicates, stragglers and garbage are dropped
+TEST(loss_and_reorder) {
+    net_audio_config_t cfg;
+    net_audio_config_init(&cfg);
+    net_receiver_t *rx = net_receiver_open("127.0.0.1:0", 1, RATE, &cfg);
+    assert(rx);
+    unsigned int port = net_receiver_port(rx);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(fd >= 0);
+    size_t frames = 120;
+    
+    // 3 goes missing; 4-6 wait in the stash, 7 overflows it
+    uint32_t order[] = { 0, 1, 2, 4, 5, 6, 7, 9, 8, 9, 3, 10 };
+    size_t count = sizeof(order) / sizeof(order[0]);
+    for (size_t i = 0; i < count; i++) {
+        send_packet(fd, port, 7, order[i], frames);
+        if (i == 5) {
+            send_bytes(fd, port, "not audio", 9);
+        }
+    }
+    wait_received(rx, count);
+    
+    net_receiver_stats_t st;
+    net_receiver_stats(rx, &st);
+    assert(st.packets_received == count);
+    assert(st.packets_lost == 1);
+    assert(st.frames_concealed == frames);
+    assert(st.packets_reordered == 1);    // 8, after 9
+    assert(st.packets_late == 2);         // 9 again, and 3 after it was concealed
+    assert(st.resyncs == 0 && st.frames_overflowed == 0);
+    assert(ring_buffer_read_available(rx->ring) == 11 * frames);
+    
+    // The sender restarting (a new SSRC) starts the stream over
+    send_packet(fd, port, 8, 0, frames);
+    wait_received(rx, count + 1);
+    net_receiver_stats(rx, &st);
+    assert(st.resyncs == 1 && st.packets_late == 2);
+    
+    close(fd);
+    net_receiver_close(rx);
+}
+
+// Test 4: A sender whose clock runs 800 ppm fast is followed: the estimate
+// settles on it and the buffer neither runs dry nor overflows
+TEST(clock_drift) {
+    net_audio_config_t cfg;
+    net_audio_config_init(&cfg);
+    cfg.packet_ms = 5.0;
+    cfg.min_delay_ms = 20.0;
+    cfg.max_delay_ms = 60.0;
+    net_receiver_t *rx = net_receiver_open("127.0.0.1:0", 1, RATE, &cfg);
+    assert(rx);
+    char dest[32];
+    snprintf(dest, sizeof(dest), "127.0.0.1:%u", net_receiver_port(rx));
+    net_sender_t *tx = net_sender_open(dest, 1, RATE, &cfg);
+    assert(tx);
+    size_t packet = tx->packet_frames;
+    
+    // No wall clock involved: each read of a packet's worth is matched by
+    // 1.0008 packets' worth sent
+    float in[512], out[512];
+    for (size_t i = 0; i < packet; i++) {
+        in[i] = 0.1f;
+    }
+    uint64_t sent = 0;
+    double owed = 0.0;
+    for (int step = 0; step < 60 * RATE / (int)packet; step++) {
+        owed += packet * 1.0008;
+        size_t n = (size_t)owed;
+        owed -= (double)n;
+        while (n > 0) {
+            size_t chunk = n < packet ? n : packet;
+            sent += net_sender_send(tx, in, chunk);
+            n -= chunk;
+        }
+        wait_received(rx, sent);
+        net_receiver_read(rx, out, packet);
+    }
+    
+    net_receiver_stats_t st;
+    net_receiver_stats(rx, &st);
+    assert(st.packets_lost == 0 && st.packets_late == 0);
+    assert(st.underruns == 0 && st.frames_skipped == 0 && st.frames_overflowed == 0);
+    assert(fabs(st.drift_ppm - 800.0) < 100.0);
+    assert(fabs(st.latency_ms - st.target_ms) < 15.0);
+    assert(tx->packets_dropped == 0);
+    
+    net_sender_close(tx);
+    net_receiver_close(rx);
+    
+    assert(net_sender_open("nowhere", 1, RATE, NULL) == NULL);
+    assert(net_sender_open("127.0.0.1:5004", 0, RATE, NULL) == NULL);
+    assert(net_receiver_open("127.0.0.1:0", NET_AUDIO_MAX_CHANNELS + 1, RATE, NULL) == NULL);
+}
+
+int main(void) {
+    printf("===== Network Audio Tests =====\n");
+    
+    RUN_TEST(pack_unpack);
+    RUN_TEST(round_trip);
+    RUN_TEST(loss_and_reorder);
+    RUN_TEST(clock_drift);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
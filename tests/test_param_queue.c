@@ -0,0 +1,209 @@
+#include "../src/param_queue.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define RATE 48000.0f
+#define RAMP_FRAMES (BIQUAD_RAMP_FRAMES + 2)  // Glide plus settle
+
+static void fill_sine(float *buffer, size_t frames, unsigned int channels, float freq) {
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            buffer[i * channels + c] = 0.5f * sinf(2.0f * 3.14159265f * freq * i / RATE);
+        }
+    }
+}
+
+static float max_step(const float *buffer, size_t count) {
+    float step = 0.0f;
+    for (size_t i = 1; i < count; i++) {
+        float d = fabsf(buffer[i] - buffer[i - 1]);
+        if (d > step) step = d;
+    }
+    return step;
+}
+
+// Test 1: FIFO order, full and empty queues
+TEST(push_pop) {
+    assert(param_queue_create(6, RATE, 1) == NULL);
+    assert(param_queue_create(8, RATE, EFFECT_MAX_CHANNELS + 1) == NULL);
+    
+    param_queue_t *queue = param_queue_create(4, RATE, 1);
+    assert(queue != NULL);
+    
+    param_update_t update = { .type = PARAM_GAIN };
+    for (int i = 0; i < 4; i++) {
+        update.value.gain = (float)i;
+        assert(param_queue_push(queue, &update));
+    }
+    assert(!param_queue_push(queue, &update));
+    
+    for (int i = 0; i < 4; i++) {
+        assert(param_queue_pop(queue, &update));
+        assert(update.type == PARAM_GAIN && update.value.gain == (float)i);
+    }
+    assert(!param_queue_pop(queue, &update));
+    
+    assert(param_queue_set_filter(queue, 1000.0f, 0.0f, 3) == -1);  // Odd order
+    param_queue_free(queue);
+}
+
+// Test 2: A gain change glides over the next block and then holds
+TEST(gain_glide) {
+    param_queue_t *queue = param_queue_create(8, RATE, 1);
+    effect_chain_t chain;
+    effect_chain_init(&chain, RATE, 1);
+    
+    assert(param_queue_set_gain(queue, 6.0f) == 0);
+    assert(param_queue_apply(queue, &chain) == 1);
+    assert(chain.gain_enabled);
+    
+    float buffer[256];
+    for (size_t i = 0; i < 256; i++) buffer[i] = 1.0f;
+    effect_chain_process(&chain, buffer, 256);
+    
+    float target = powf(10.0f, 6.0f / 20.0f);
+    for (size_t i = 1; i < 256; i++) {
+        assert(buffer[i] > buffer[i - 1]);
+    }
+    assert(fabsf(buffer[0] - 1.0f) < 0.01f && buffer[255] == target);
+    
+    for (size_t i = 0; i < 256; i++) buffer[i] = 1.0f;
+    effect_chain_process(&chain, buffer, 256);
+    for (size_t i = 0; i < 256; i++) {
+        assert(buffer[i] == target);
+    }
+    param_queue_free(queue);
+}
+
+// Test 3: Retuning ramps to the exact new design without a step, across orders
+TEST(filter_ramp) {
+    enum { FRAMES = 4096, CHANNELS = 2 };
+    static float buffer[FRAMES * CHANNELS];
+    param_queue_t *queue = param_queue_create(8, RATE, CHANNELS);
+    
+    effect_chain_config_t config = { .enabled = true, .lowpass_freq = 1000.0f, .filter_order = 2 };
+    effect_chain_t chain;
+    effect_chain_configure(&chain, &config, RATE, CHANNELS);
+    
+    fill_sine(buffer, FRAMES, CHANNELS, 100.0f);
+    effect_chain_process(&chain, buffer, 1024);  // Settle on the old design
+    
+    assert(param_queue_set_filter(queue, 4000.0f, 0.0f, 8) == 0);
+    assert(param_queue_apply(queue, &chain) == 1);
+    
+    // Odd block sizes so ramp steps land mid-block
+    for (size_t pos = 1024; pos < FRAMES; pos += 100) {
+        size_t count = FRAMES - pos < 100 ? FRAMES - pos : 100;
+        effect_chain_process(&chain, &buffer[pos * CHANNELS], count);
+    }
+    
+    assert(chain.filter_ramp == 0 && chain.filter.sections == 4);
+    biquad_cascade_t design;
+    biquad_cascade_lowpass(&design, RATE, 4000.0f, 8, CHANNELS);
+    assert(memcmp(chain.filter.b0, design.b0, sizeof(design.b0)) == 0);
+    assert(memcmp(chain.filter.a2, design.a2, sizeof(design.a2)) == 0);
+    
+    // A 100 Hz sine moves at most ~0.0066 per sample: no click anywhere
+    for (unsigned int c = 0; c < CHANNELS; c++) {
+        float mono[FRAMES];
+        for (size_t i = 0; i < FRAMES; i++) mono[i] = buffer[i * CHANNELS + c];
+        assert(max_step(&mono[256], FRAMES - 256) < 0.01f);
+    }
+    
+    // Mismatched channel counts are refused
+    biquad_cascade_lowpass(&design, RATE, 4000.0f, 2, 1);
+    assert(effect_chain_set_filter(&chain, &design) == -1);
+    param_queue_free(queue);
+}
+
+// Test 4: Switching the filter on and off ramps in and out, then bypasses exactly
+TEST(filter_on_off) {
+    enum { FRAMES = 2048 };
+    float input[FRAMES], buffer[FRAMES];
+    param_queue_t *queue = param_queue_create(8, RATE, 1);
+    effect_chain_t chain;
+    effect_chain_init(&chain, RATE, 1);
+    
+    fill_sine(input, FRAMES, 1, 200.0f);
+    memcpy(buffer, input, sizeof(buffer));
+    
+    assert(param_queue_set_filter(queue, 0.0f, 50.0f, 4) == 0);
+    param_queue_apply(queue, &chain);
+    assert(chain.filter_enabled);
+    effect_chain_process(&chain, buffer, FRAMES);
+    assert(max_step(buffer, FRAMES) < 0.03f);
+    
+    assert(param_queue_set_filter(queue, 0.0f, 0.0f, 0) == 0);
+    param_queue_apply(queue, &chain);
+    memcpy(buffer, input, sizeof(buffer));
+    effect_chain_process(&chain, buffer, RAMP_FRAMES);
+    assert(!chain.filter_enabled);
+    
+    // Bypassed: bit-exact passthrough
+    effect_chain_process(&chain, &buffer[RAMP_FRAMES], FRAMES - RAMP_FRAMES);
+    assert(memcmp(&buffer[RAMP_FRAMES], &input[RAMP_FRAMES],
+                  (FRAMES - RAMP_FRAMES) * sizeof(float)) == 0);
+    param_queue_free(queue);
+}
+
+// Test 5: Control thread and audio thread running concurrently
+#define THREAD_UPDATES 100000
+
+static void* control_thread(void *arg) {
+    param_queue_t *queue = (param_queue_t*)arg;
+    param_update_t update = { .type = PARAM_GAIN };
+    
+    for (int i = 1; i <= THREAD_UPDATES; i++) {
+        update.value.gain = (float)i;
+        while (!param_queue_push(queue, &update)) {
+            // Audio thread is behind; spin
+        }
+    }
+    return NULL;
+}
+
+TEST(threaded) {
+    param_queue_t *queue = param_queue_create(64, RATE, 1);
+    pthread_t thread;
+    pthread_create(&thread, NULL, control_thread, queue);
+    
+    param_update_t update;
+    int expected = 1;
+    while (expected <= THREAD_UPDATES) {
+        if (param_queue_pop(queue, &update)) {
+            assert(update.type == PARAM_GAIN && update.value.gain == (float)expected);
+            expected++;
+        }
+    }
+    pthread_join(thread, NULL);
+    assert(!param_queue_pop(queue, &update));
+    param_queue_free(queue);
+}
+
+int main(void) {
+    printf("===== Parameter Queue Tests =====\n");
+    
+    RUN_TEST(push_pop);
+    RUN_TEST(gain_glide);
+    RUN_TEST(filter_ramp);
+    RUN_TEST(filter_on_off);
+    RUN_TEST(threaded);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include "../src/pipeline.h"
+#include "../src/effect_graph.h"
+#include "../src/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "../src/dr_wav.h"
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IN_PATH "/tmp/test_pipeline_in.wav"
+#define OUT_PATH "/tmp/test_pipeline_out.wav"
+#define RATE 48000
+#define CHANNELS 2
+#define FRAMES (3 * RATE + 777)     // Not a whole number of chunks
+
+static const effect_chain_config_t effects = {
+    .enabled = true, .gain_db = 6.0f, .lowpass_freq = 6000.0f, .highpass_freq = 80.0f,
+    .filter_order = 4, .compress = true,
+    .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 2.0f,
+};
+
+/**
+ * A stereo tone with bursts, as 32-bit float (mapped) or 16-bit (decoded).
+ */
+static void write_input(bool as_float) {
+    float *samples = malloc(FRAMES * CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        double level = (i / 10000) % 3 == 2 ? 0.05 : 0.8;
+        for (unsigned int c = 0; c < CHANNELS; c++) {
+            samples[i * CHANNELS + c] = (float)(level * sin(2.0 * M_PI * 220.0 * (c + 1) *
+                                                            (double)i / RATE));
+        }
+    }
+    
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = as_float ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels = CHANNELS;
+    format.sampleRate = RATE;
+    format.bitsPerSample = as_float ? 32 : 16;
+    assert(drwav_init_file_write(&wav, IN_PATH, &format, NULL));
+    if (as_float) {
+        drwav_write_pcm_frames(&wav, FRAMES, samples);
+    } else {
+        int16_t *pcm = malloc(FRAMES * CHANNELS * sizeof(int16_t));
+        drwav_f32_to_s16(pcm, samples, FRAMES * CHANNELS);
+        drwav_write_pcm_frames(&wav, FRAMES, pcm);
+        free(pcm);
+    }
+    drwav_uninit(&wav);
+    free(samples);
+}
+
+/**
+ * The buffered path: the whole file through one graph in a single call,
+ * the latency flushed with silence and dropped from the front.
+ */
+static float* render_buffered(void) {
+    unsigned int channels, rate;
+    drwav_uint64 total;
+    float *in = drwav_open_file_and_read_pcm_frames_f32(IN_PATH, &channels, &rate, &total, NULL);
+    assert(in && channels == CHANNELS && total == FRAMES);
+    
+    effect_graph_t *graph = effect_graph_from_config(&effects, RATE, CHANNELS, 0);
+    size_t delay = effect_graph_latency(graph);
+    float *buffer = calloc((FRAMES + delay) * CHANNELS, sizeof(float));
+    memcpy(buffer, in, FRAMES * CHANNELS * sizeof(float));
+    effect_graph_process(graph, buffer, FRAMES + delay);
+    memmove(buffer, &buffer[delay * CHANNELS], FRAMES * CHANNELS * sizeof(float));
+    effect_graph_free(graph);
+    drwav_free(in, NULL);
+    return buffer;
+}
+
+static void pipeline_config(pipeline_config_t *config, const char *output) {
+    memset(config, 0, sizeof(*config));
+    config->input_file = IN_PATH;
+    config->output_file = output;
+    config->map_input = true;
+    config->effects = effects;
+    config->ring_frames = 2048;
+    config->chunk_frames = 500;
+    rt_config_init(&config->rt);
+}
+
+typedef struct {
+    pipeline_config_t config;
+    pipeline_stats_t stats;
+    int result;
+    atomic_bool done;
+} pipeline_job_t;
+
+static void* pipeline_job(void *arg) {
+    pipeline_job_t *job = arg;
+    job->result = pipeline_run(&job->config, &job->stats);
+    atomic_store(&job->done, true);
+    return NULL;
+}
+
+/**
+ * pipeline_run on a thread of its own, failing the test rather than
+ * hanging if it doesn't return within 10 s.
+ */
+static int run_with_deadline(pipeline_job_t *job) {
+    atomic_init(&job->done, false);
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, pipeline_job, job) == 0);
+    uint64_t deadline = utils_now_ns() + 10000000000ull;
+    while (!atomic_load(&job->done)) {
+        assert(utils_now_ns() < deadline && "pipeline_run hung");
+        utils_sleep_ns(1000000);
+    }
+    pthread_join(thread, NULL);
+    return job->result;
+}
+
+// Test 1: The three-thread render is sample-identical to the buffered one,
+// whether the input is mapped or decoded
+TEST(matches_buffered) {
+    for (int as_float = 0; as_float < 2; as_float++) {
+        write_input(as_float);
+        float *expected = render_buffered();
+        
+        pipeline_job_t job;
+        pipeline_config(&job.config, OUT_PATH);
+        assert(run_with_deadline(&job) == 0);
+        assert(job.stats.input_mapped == (as_float == 1));
+        assert(job.stats.channels == CHANNELS && job.stats.sample_rate == RATE);
+        assert(job.stats.total_frames == FRAMES);
+        assert(job.stats.encode.frames == FRAMES);
+        
+        unsigned int channels, rate;
+        drwav_uint64 frames;
+        float *got = drwav_open_file_and_read_pcm_frames_f32(OUT_PATH, &channels, &rate,
+                                                             &frames, NULL);
+        assert(got && channels == CHANNELS && rate == RATE && frames == FRAMES);
+        assert(memcmp(got, expected, FRAMES * CHANNELS * sizeof(float)) == 0);
+        drwav_free(got, NULL);
+        free(expected);
+        remove(OUT_PATH);
+    }
+}
+
+// Test 2: An encoder that can't write closes both rings: the decode and DSP
+// stages stop early instead of staying parked, and the run reports failure
+TEST(encoder_failure) {
+    write_input(true);
+    
+    // Writes to /dev/full fail once drwav's stdio buffer first flushes
+    pipeline_job_t job;
+    pipeline_config(&job.config, "/dev/full");
+    assert(run_with_deadline(&job) != 0);
+    
+    // Neither upstream stage got further than the rings could hold beyond
+    // what the encoder took
+    uint64_t ring_frames = job.config.ring_frames;
+    assert(job.stats.encode.frames < FRAMES);
+    assert(job.stats.dsp.frames <= job.stats.encode.frames + 2 * ring_frames);
+    assert(job.stats.decode.frames <= job.stats.dsp.frames + ring_frames);
+    assert(job.stats.decode.frames < FRAMES);
+}
+
+int main(void) {
+    printf("===== Pipeline Tests =====\n");
+    
+    RUN_TEST(matches_buffered);
+    RUN_TEST(encoder_failure);
+    
+    remove(IN_PATH);
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
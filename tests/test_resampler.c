@@ -0,0 +1,244 @@
+#include "../src/resampler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float* make_sine(size_t frames, unsigned int channels, double freq, double rate) {
+    float *x = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            x[i * channels + c] = (float)(0.5 * sin(2.0 * M_PI * freq * (double)i / rate + c));
+        }
+    }
+    return x;
+}
+
+/**
+ * Convert a whole signal in calls of chunk input frames, then drain to the
+ * stream's full output length. Returns the output (*out_frames frames).
+ */
+static float* convert(resampler_t *rs, const float *in, size_t frames, size_t chunk,
+                      size_t *out_frames) {
+    unsigned int channels = rs->channels;
+    size_t total = resampler_output_frames(frames, rs->in_rate, rs->out_rate);
+    float *out = malloc((total + resampler_max_output(rs, frames)) * channels * sizeof(float));
+    size_t produced = 0;
+    
+    for (size_t pos = 0; pos < frames; pos += chunk) {
+        size_t n = frames - pos < chunk ? frames - pos : chunk;
+        size_t room = resampler_max_output(rs, n);
+        size_t used;
+        produced += resampler_process(rs, &in[pos * channels], n, &used,
+                                      &out[produced * channels], room);
+        assert(used == n);
+    }
+    if (produced < total) {
+        produced += resampler_drain(rs, &out[produced * channels], total - produced);
+    }
+    
+    *out_frames = produced;
+    return out;
+}
+
+/**
+ * Largest difference from the ideal sine at the output rate, skipping the
+ * filter's reach at both ends.
+ */
+static double sine_error(const float *y, size_t frames, unsigned int channels,
+                         double freq, double rate) {
+    double err = 0.0;
+    for (size_t i = RESAMPLER_TAPS; i + RESAMPLER_TAPS < frames; i++) {
+        for (unsigned int c = 0; c < channels; c++) {
+            double ideal = 0.5 * sin(2.0 * M_PI * freq * (double)i / rate + c);
+            double e = fabs(y[i * channels + c] - ideal);
+            if (e > err) err = e;
+        }
+    }
+    return err;
+}
+
+// Test 1: Bad rates and ratios are refused
+TEST(reject_invalid) {
+    assert(resampler_create(0, 44100, 48000) == NULL);
+    assert(resampler_create(1, 0, 48000) == NULL);
+    assert(resampler_create(1, 44100, -1) == NULL);
+    assert(resampler_create(1, 8000, 96000) == NULL);
+    assert(resampler_create(1, 96000, 8000) == NULL);
+    
+    resampler_t *rs = resampler_create(2, 44100, 48000);
+    assert(rs != NULL && rs->channels == 2);
+    assert(fabs(rs->step - 44100.0 / 48000.0) < 1e-12);
+    resampler_free(rs);
+}
+
+// Test 2: A tone comes out at the same frequency and level, time-aligned
+TEST(sine_up_down) {
+    static const double rates[][2] = {
+        { 44100, 48000 }, { 48000, 44100 }, { 48000, 48000 }, { 22050, 48000 }, { 96000, 44100 },
+    };
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        size_t frames = 20000;
+        float *x = make_sine(frames, 1, 1000.0, rates[r][0]);
+        resampler_t *rs = resampler_create(1, rates[r][0], rates[r][1]);
+        size_t n;
+        float *y = convert(rs, x, frames, 512, &n);
+        
+        assert(n == resampler_output_frames(frames, rates[r][0], rates[r][1]));
+        double err = sine_error(y, n, 1, 1000.0, rates[r][1]);
+        assert(err < 1e-4);
+        
+        free(y);
+        free(x);
+        resampler_free(rs);
+    }
+}
+
+// Test 3: Whatever the output can't represent is filtered, not aliased
+TEST(anti_alias) {
+    size_t frames = 20000;
+    float *x = make_sine(frames, 1, 23000.0, 48000);
+    resampler_t *rs = resampler_create(1, 48000, 44100);
+    size_t n;
+    float *y = convert(rs, x, frames, 1000, &n);
+    
+    double energy = 0.0;
+    for (size_t i = RESAMPLER_TAPS; i + RESAMPLER_TAPS < n; i++) {
+        energy += (double)y[i] * y[i];
+    }
+    double rms = sqrt(energy / (double)(n - 2 * RESAMPLER_TAPS));
+    assert(rms < 1e-4);
+    
+    free(y);
+    free(x);
+    resampler_free(rs);
+}
+
+// Test 4: DC passes at unity gain
+TEST(dc_gain) {
+    size_t frames = 4000;
+    float *x = malloc(frames * sizeof(float));
+    for (size_t i = 0; i < frames; i++) x[i] = 0.25f;
+    
+    resampler_t *rs = resampler_create(1, 44100, 48000);
+    size_t n;
+    float *y = convert(rs, x, frames, 300, &n);
+    for (size_t i = RESAMPLER_TAPS; i + RESAMPLER_TAPS < n; i++) {
+        assert(fabsf(y[i] - 0.25f) < 1e-4f);
+    }
+    
+    free(y);
+    free(x);
+    resampler_free(rs);
+}
+
+// Test 5: Call sizes don't change the result
+TEST(chunk_independent) {
+    size_t frames = 6000;
+    float *x = make_sine(frames, 2, 3000.0, 44100);
+    
+    resampler_t *a = resampler_create(2, 44100, 48000);
+    resampler_t *b = resampler_create(2, 44100, 48000);
+    size_t na, nb;
+    float *ya = convert(a, x, frames, 1, &na);
+    float *yb = convert(b, x, frames, 4096, &nb);
+    
+    assert(na == nb);
+    for (size_t i = 0; i < na * 2; i++) {
+        assert(fabsf(ya[i] - yb[i]) < 1e-6f);
+    }
+    
+    free(yb);
+    free(ya);
+    free(x);
+    resampler_free(b);
+    resampler_free(a);
+}
+
+// Test 6: Channels are converted independently
+TEST(multichannel) {
+    size_t frames = 5000;
+    float *x = make_sine(frames, 3, 500.0, 48000);
+    for (size_t i = 0; i < frames; i++) x[i * 3 + 1] = 0.0f;
+    
+    resampler_t *rs = resampler_create(3, 48000, 44100);
+    size_t n;
+    float *y = convert(rs, x, frames, 256, &n);
+    for (size_t i = 0; i < n; i++) {
+        assert(y[i * 3 + 1] == 0.0f);
+    }
+    for (size_t i = RESAMPLER_TAPS; i + RESAMPLER_TAPS < n; i++) {
+        assert(fabs(y[i * 3] - 0.5 * sin(2.0 * M_PI * 500.0 * (double)i / 44100.0)) < 1e-3);
+        assert(fabs(y[i * 3 + 2] - 0.5 * sin(2.0 * M_PI * 500.0 * (double)i / 44100.0 + 2)) < 1e-3);
+    }
+    
+    free(y);
+    free(x);
+    resampler_free(rs);
+}
+
+// Test 7: The correction factor trims the output rate, within its clamp
+TEST(drift_correction) {
+    size_t frames = 48000;
+    float *x = make_sine(frames, 1, 440.0, 48000);
+    size_t room = frames * 2;
+    float *y = malloc(room * sizeof(float));
+    
+    resampler_t *rs = resampler_create(1, 48000, 48000);
+    resampler_set_correction(rs, 1.002);
+    size_t n = resampler_process(rs, x, frames, NULL, y, room);
+    double expect = (double)(frames - RESAMPLER_TAPS / 2) / 1.002;
+    assert(fabs((double)n - expect) < 2.0);
+    
+    resampler_set_correction(rs, 0.5);
+    assert(rs->correction == 1.0 - RESAMPLER_MAX_CORRECTION);
+    resampler_set_correction(rs, 2.0);
+    assert(rs->correction == 1.0 + RESAMPLER_MAX_CORRECTION);
+    
+    // A full output stops the call early; the rest of the input waits
+    resampler_set_correction(rs, 1.002);
+    resampler_reset(rs);
+    size_t used;
+    assert(resampler_process(rs, x, frames, &used, y, 100) == 100);
+    assert(used < frames);
+    size_t rest;
+    n = 100 + resampler_process(rs, &x[used], frames - used, &rest, &y[100], room - 100);
+    assert(rest == frames - used);
+    assert(fabs((double)n - expect) < 2.0);
+    
+    free(y);
+    free(x);
+    resampler_free(rs);
+}
+
+int main(void) {
+    printf("===== Resampler Tests =====\n");
+    
+    RUN_TEST(reject_invalid);
+    RUN_TEST(sine_up_down);
+    RUN_TEST(anti_alias);
+    RUN_TEST(dc_gain);
+    RUN_TEST(chunk_independent);
+    RUN_TEST(multichannel);
+    RUN_TEST(drift_correction);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
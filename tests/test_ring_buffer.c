@@ -2,7 +2,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <pthread.h>
+#include <time.h>
 
 // Test utilities
 #define TEST(name) \
@@ -155,7 +158,384 @@ TEST(reset) {
     ring_buffer_free(rb);
 }
 
-// Test 9: Producer-consumer threading test
+// Test 9: Zero-copy acquire/commit spans, including wrap-around
+TEST(zero_copy_spans) {
+    ring_buffer_t *rb = ring_buffer_create(64);
+    assert(rb != NULL);
+    
+    ring_buffer_span_t span;
+    
+    // Advance indices so the next 40 samples wrap
+    float skip[48];
+    memset(skip, 0, sizeof(skip));
+    ring_buffer_write(rb, skip, 48);
+    ring_buffer_read(rb, skip, 48);
+    
+    size_t acquired = ring_buffer_write_acquire(rb, 40, &span);
+    assert(acquired == 40);
+    assert(span.data1 == (float*)rb->buffer + 48);
+    assert(span.size1 == 16);
+    assert(span.data2 == (float*)rb->buffer);
+    assert(span.size2 == 24);
+    for (size_t i = 0; i < span.size1; i++) span.data1[i] = (float)i;
+    for (size_t i = 0; i < span.size2; i++) span.data2[i] = (float)(span.size1 + i);
+    
+    // Nothing is visible until commit
+    assert(ring_buffer_read_available(rb) == 0);
+    ring_buffer_write_commit(rb, acquired);
+    assert(ring_buffer_read_available(rb) == 40);
+    
+    // Consumer modifies in place, then releases part of the region
+    acquired = ring_buffer_read_acquire(rb, 100, &span);
+    assert(acquired == 40);
+    assert(span.size1 + span.size2 == 40);
+    for (size_t i = 0; i < span.size1; i++) span.data1[i] *= 2.0f;
+    ring_buffer_read_release(rb, span.size1);
+    assert(ring_buffer_read_available(rb) == 24);
+    
+    float read_data[24];
+    size_t read = ring_buffer_read(rb, read_data, 24);
+    assert(read == 24);
+    for (int i = 0; i < 24; i++) {
+        assert(read_data[i] == (float)(16 + i));
+    }
+    
+    // Acquire on an empty ring yields an empty span
+    acquired = ring_buffer_read_acquire(rb, 8, &span);
+    assert(acquired == 0);
+    assert(span.size1 == 0 && span.size2 == 0);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 10: Indices on separate cache lines, cached peer index refreshes
+TEST(cached_indices) {
+    assert(offsetof(ring_buffer_t, read_index) - offsetof(ring_buffer_t, write_index)
+           >= RING_BUFFER_CACHE_LINE);
+    
+    ring_buffer_t *rb = ring_buffer_create(64);
+    assert(rb != NULL);
+    assert(((uintptr_t)rb % RING_BUFFER_CACHE_LINE) == 0);
+    
+    float data[64];
+    memset(data, 0, sizeof(data));
+    
+    // Producer's cached view goes stale once the consumer frees space
+    assert(ring_buffer_write(rb, data, 64) == 64);
+    assert(ring_buffer_write(rb, data, 1) == 0);
+    assert(ring_buffer_read(rb, data, 16) == 16);
+    assert(ring_buffer_write(rb, data, 32) == 16);
+    
+    // Consumer's cached view goes stale once the producer adds more
+    assert(ring_buffer_read(rb, data, 64) == 64);
+    assert(ring_buffer_read(rb, data, 1) == 0);
+    assert(ring_buffer_write(rb, data, 8) == 8);
+    assert(ring_buffer_read(rb, data, 64) == 8);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 11: Fill level and consumer-sampled high-water mark
+TEST(fill_level_high_water) {
+    ring_buffer_t *rb = ring_buffer_create(64);
+    assert(rb != NULL);
+    
+    float data[64];
+    memset(data, 0, sizeof(data));
+    
+    assert(ring_buffer_fill_level(rb) == 0);
+    assert(ring_buffer_high_water(rb) == 0);
+    
+    ring_buffer_write(rb, data, 48);
+    assert(ring_buffer_fill_level(rb) == 48);
+    assert(ring_buffer_high_water(rb) == 0);  // Consumer hasn't looked yet
+    
+    assert(ring_buffer_read(rb, data, 40) == 40);
+    assert(ring_buffer_high_water(rb) == 48);
+    assert(ring_buffer_fill_level(rb) == 8);
+    
+    // A lower fill never lowers the peak
+    ring_buffer_write(rb, data, 4);
+    assert(ring_buffer_read(rb, data, 64) == 12);
+    assert(ring_buffer_high_water(rb) == 48);
+    
+    ring_buffer_reset(rb);
+    assert(ring_buffer_high_water(rb) == 0);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 12: Storage alignment options
+TEST(aligned_storage) {
+    ring_buffer_t *rb = ring_buffer_create(1024);
+    assert((uintptr_t)rb->buffer % RING_BUFFER_CACHE_LINE == 0);
+    ring_buffer_free(rb);
+    
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.alignment = 4096;
+    rb = ring_buffer_create_ex(64, &options);
+    assert(rb != NULL && (uintptr_t)rb->buffer % 4096 == 0);
+    for (size_t i = 0; i < rb->capacity; i++) assert(((float*)rb->buffer)[i] == 0.0f);
+    ring_buffer_free(rb);
+    
+    options.alignment = 48;
+    assert(ring_buffer_create_ex(64, &options) == NULL);
+}
+
+// Test 13: Mirrored storage hands out one contiguous span across the wrap
+TEST(mirrored_spans) {
+    enum { CAPACITY = 4096 };  // 16 KiB: whole pages
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.mirrored = true;
+    
+    // Not a whole number of pages: falls back to the plain layout
+    ring_buffer_t *rb = ring_buffer_create_ex(64, &options);
+    assert(rb != NULL && !rb->mirrored && !(rb->storage & RING_BUFFER_MIRRORED));
+    ring_buffer_free(rb);
+    
+    rb = ring_buffer_create_ex(CAPACITY, &options);
+    assert(rb != NULL);
+    if (!rb->mirrored) {
+        printf(" (no memfd, skipped)");
+        ring_buffer_free(rb);
+        return;
+    }
+    assert(rb->storage & RING_BUFFER_MIRRORED);
+    
+    // The second mapping aliases the first. volatile: to the compiler these
+    // are different objects, so it may reorder the accesses otherwise
+    volatile float *mirror = rb->buffer;
+    mirror[5] = 1.5f;
+    assert(mirror[CAPACITY + 5] == 1.5f);
+    mirror[CAPACITY + 6] = 2.5f;
+    assert(mirror[6] == 2.5f);
+    ring_buffer_reset(rb);
+    
+    static float data[CAPACITY];
+    for (size_t i = 0; i < CAPACITY; i++) data[i] = (float)i;
+    assert(ring_buffer_write(rb, data, 3000) == 3000);
+    assert(ring_buffer_read(rb, data, 3000) == 3000);
+    
+    ring_buffer_span_t span;
+    assert(ring_buffer_write_acquire(rb, 2000, &span) == 2000);
+    assert(span.data1 == (float*)rb->buffer + 3000 && span.size1 == 2000 && span.size2 == 0);
+    for (size_t i = 0; i < 2000; i++) span.data1[i] = (float)(i + 7);
+    ring_buffer_write_commit(rb, 2000);
+    
+    assert(ring_buffer_read_acquire(rb, 2000, &span) == 2000);
+    assert(span.size1 == 2000 && span.size2 == 0);
+    for (size_t i = 0; i < 2000; i++) assert(span.data1[i] == (float)(i + 7));
+    ring_buffer_read_release(rb, 2000);
+    
+    // Wrapped samples sit at the start of the first mapping too
+    assert(((float*)rb->buffer)[0] == (float)(CAPACITY - 3000 + 7));
+    ring_buffer_free(rb);
+}
+
+// Test 14: Huge pages and locking are best effort but always give a working ring
+TEST(huge_locked) {
+    enum { CAPACITY = 1 << 19 };  // 2 MiB
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.huge_pages = true;
+    options.lock = true;
+    
+    for (int mirrored = 0; mirrored < 2; mirrored++) {
+        options.mirrored = mirrored;
+        ring_buffer_t *rb = ring_buffer_create_ex(CAPACITY, &options);
+        assert(rb != NULL);
+        
+        float in[1000], out[1000];
+        for (int i = 0; i < 1000; i++) in[i] = (float)i;
+        for (int lap = 0; lap < 600; lap++) {
+            assert(ring_buffer_write(rb, in, 1000) == 1000);
+            assert(ring_buffer_read(rb, out, 1000) == 1000);
+            assert(memcmp(in, out, sizeof(in)) == 0);
+        }
+        printf(" (%s%s%s)", (rb->storage & RING_BUFFER_MIRRORED) ? "mirrored " : "",
+               (rb->storage & RING_BUFFER_HUGETLB) ? "hugetlb" :
+               (rb->storage & RING_BUFFER_THP) ? "thp" : "small pages",
+               (rb->storage & RING_BUFFER_LOCKED) ? ", locked" : "");
+        ring_buffer_free(rb);
+    }
+}
+
+// Test 15: Waits time out, and return at once when already satisfied
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static ring_buffer_t* create_waitable(size_t capacity) {
+    ring_buffer_options_t options;
+    ring_buffer_options_init(&options);
+    options.waitable = true;
+    return ring_buffer_create_ex(capacity, &options);
+}
+
+static void sleep_ms(long ms) {
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = ms * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+TEST(wait_timeout) {
+    ring_buffer_t *rb = create_waitable(64);
+    struct timespec start;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(ring_buffer_wait_readable(rb, 1, 2000000) == 0);
+    assert(seconds_since(&start) >= 0.002);
+    assert(ring_buffer_wait_readable(rb, 1, 0) == 0);
+    
+    float data[16] = { 0 };
+    ring_buffer_write(rb, data, 16);
+    assert(ring_buffer_wait_readable(rb, 16, RING_BUFFER_WAIT_FOREVER) == 16);
+    assert(ring_buffer_wait_writable(rb, 48, RING_BUFFER_WAIT_FOREVER) == 48);
+    assert(ring_buffer_wait_writable(rb, 1000, 1000000) == 48);  // Capped at 64, times out
+    
+    // Nobody parked: commits and releases leave the event words alone
+    assert(atomic_load(&rb->readable.word) == 0);
+    ring_buffer_read(rb, data, 16);
+    ring_buffer_write(rb, data, 16);
+    assert(atomic_load(&rb->readable.word) == 0);
+    assert(atomic_load(&rb->writable.word) == 0);
+    
+    ring_buffer_free(rb);
+    
+    // Not waitable: waits still work, by polling
+    rb = ring_buffer_create(64);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(ring_buffer_wait_readable(rb, 1, 2000000) == 0);
+    assert(seconds_since(&start) >= 0.002);
+    ring_buffer_write(rb, data, 16);
+    assert(ring_buffer_wait_readable(rb, 16, RING_BUFFER_WAIT_FOREVER) == 16);
+    ring_buffer_free(rb);
+}
+
+// Test 16: A parked consumer sleeps through partial commits, wakes on its level
+typedef struct {
+    ring_buffer_t *rb;
+    size_t min;
+    size_t got;
+    atomic_bool done;
+    struct timespec woke;
+} waiter_t;
+
+static void* wait_readable_thread(void *arg) {
+    waiter_t *w = (waiter_t*)arg;
+    w->got = ring_buffer_wait_readable(w->rb, w->min, RING_BUFFER_WAIT_FOREVER);
+    clock_gettime(CLOCK_MONOTONIC, &w->woke);
+    atomic_store(&w->done, true);
+    return NULL;
+}
+
+static void* wait_writable_thread(void *arg) {
+    waiter_t *w = (waiter_t*)arg;
+    w->got = ring_buffer_wait_writable(w->rb, w->min, RING_BUFFER_WAIT_FOREVER);
+    atomic_store(&w->done, true);
+    return NULL;
+}
+
+TEST(wait_wakes) {
+    ring_buffer_t *rb = create_waitable(256);
+    waiter_t w = { .rb = rb, .min = 64 };
+    atomic_init(&w.done, false);
+    
+    pthread_t thread;
+    pthread_create(&thread, NULL, wait_readable_thread, &w);
+    sleep_ms(20);
+    assert(atomic_load(&rb->readable.word) & RING_BUFFER_EVENT_PARKED);
+    
+    float data[32] = { 0 };
+    ring_buffer_write(rb, data, 32);
+    sleep_ms(20);
+    assert(!atomic_load(&w.done));  // 32 of 64: stays parked
+    
+    struct timespec sent;
+    clock_gettime(CLOCK_MONOTONIC, &sent);
+    ring_buffer_write(rb, data, 32);
+    pthread_join(thread, NULL);
+    assert(w.got == 64);
+    printf(" (woke in %.1f us)", ((w.woke.tv_sec - sent.tv_sec) * 1e9 +
+                                  (w.woke.tv_nsec - sent.tv_nsec)) / 1e3);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 17: Closing wakes a parked side and keeps later waits from blocking
+TEST(wait_close) {
+    ring_buffer_t *rb = create_waitable(64);
+    float data[64] = { 0 };
+    ring_buffer_write(rb, data, 64);
+    
+    waiter_t w = { .rb = rb, .min = 16 };
+    atomic_init(&w.done, false);
+    pthread_t thread;
+    pthread_create(&thread, NULL, wait_writable_thread, &w);
+    sleep_ms(20);
+    assert(!atomic_load(&w.done));
+    
+    ring_buffer_close(rb);
+    pthread_join(thread, NULL);
+    assert(w.got == 0);
+    assert(ring_buffer_wait_writable(rb, 16, RING_BUFFER_WAIT_FOREVER) == 0);
+    
+    ring_buffer_reset(rb);
+    assert(ring_buffer_wait_readable(rb, 1, 0) == 0);
+    assert(atomic_load(&rb->readable.word) == 0);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 18: Blocking producer and consumer stream a sequence intact
+#define BLOCKING_SAMPLES 1000000
+#define BLOCKING_CHUNK 96
+
+static void* blocking_producer(void *arg) {
+    ring_buffer_t *rb = (ring_buffer_t*)arg;
+    float chunk[BLOCKING_CHUNK];
+    
+    for (int sent = 0; sent < BLOCKING_SAMPLES; ) {
+        ring_buffer_wait_writable(rb, BLOCKING_CHUNK, RING_BUFFER_WAIT_FOREVER);
+        int n = BLOCKING_SAMPLES - sent < BLOCKING_CHUNK ? BLOCKING_SAMPLES - sent : BLOCKING_CHUNK;
+        for (int i = 0; i < n; i++) chunk[i] = (float)(sent + i);
+        sent += (int)ring_buffer_write(rb, chunk, (size_t)n);
+    }
+    ring_buffer_close(rb);
+    return NULL;
+}
+
+TEST(blocking_threading) {
+    ring_buffer_t *rb = create_waitable(1024);
+    pthread_t thread;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, blocking_producer, rb);
+    
+    int consumed = 0;
+    float chunk[BLOCKING_CHUNK * 2];
+    while (consumed < BLOCKING_SAMPLES) {
+        if (ring_buffer_wait_readable(rb, 1, RING_BUFFER_WAIT_FOREVER) == 0) {
+            continue;  // Closed, but the last commit may still be on its way
+        }
+        size_t n = ring_buffer_read(rb, chunk, BLOCKING_CHUNK * 2);
+        for (size_t i = 0; i < n; i++) {
+            assert(chunk[i] == (float)(consumed + (int)i));
+        }
+        consumed += (int)n;
+    }
+    pthread_join(thread, NULL);
+    printf(" (%.1f Msamples/s)", BLOCKING_SAMPLES / seconds_since(&start) / 1e6);
+    
+    ring_buffer_free(rb);
+}
+
+// Test 19: Producer-consumer threading test
+#define THREADING_SAMPLES 10000
+
 typedef struct {
     ring_buffer_t *rb;
     int samples_to_produce;
@@ -199,11 +579,13 @@ TEST(threading) {
     
     thread_test_data_t data = {
         .rb = rb,
-        .samples_to_produce = 10000,
+        .samples_to_produce = THREADING_SAMPLES,
         .samples_consumed = 0
     };
     
     pthread_t prod_thread, cons_thread;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
     pthread_create(&cons_thread, NULL, consumer_thread, &data);
     pthread_create(&prod_thread, NULL, producer_thread, &data);
@@ -211,7 +593,11 @@ TEST(threading) {
     pthread_join(prod_thread, NULL);
     pthread_join(cons_thread, NULL);
     
-    assert(data.samples_consumed == 10000);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf(" (%.3f Msamples/s)", THREADING_SAMPLES / elapsed / 1e6);
+    
+    assert(data.samples_consumed == THREADING_SAMPLES);
     
     ring_buffer_free(rb);
 }
@@ -228,6 +614,16 @@ int main(void) {
     RUN_TEST(buffer_empty);
     RUN_TEST(wrap_around);
     RUN_TEST(reset);
+    RUN_TEST(zero_copy_spans);
+    RUN_TEST(cached_indices);
+    RUN_TEST(fill_level_high_water);
+    RUN_TEST(aligned_storage);
+    RUN_TEST(mirrored_spans);
+    RUN_TEST(huge_locked);
+    RUN_TEST(wait_timeout);
+    RUN_TEST(wait_wakes);
+    RUN_TEST(wait_close);
+    RUN_TEST(blocking_threading);
     RUN_TEST(threading);
     
     printf("\n✓ All tests passed!\n");
@@ -0,0 +1,116 @@
+#define _GNU_SOURCE
+#include "../src/rt_thread.h"
+#include <stdio.h>
+#include <float.h>
+#include <sched.h>
+#include <unistd.h>
+#include <assert.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+typedef struct {
+    volatile float input;    // volatile: computed at run time, in the thread
+    float result;
+    int cpu;
+} probe_t;
+
+static void* probe_thread(void *arg) {
+    probe_t *probe = (probe_t*)arg;
+    probe->result = probe->input * 0.5f;
+    probe->cpu = sched_getcpu();
+    return NULL;
+}
+
+// Test 1: Denormal results flush to zero on an RT thread
+TEST(flush_denormals) {
+    rt_config_t config;
+    rt_config_init(&config);
+    
+    probe_t probe = { .input = FLT_MIN };  // Halving the smallest normal gives a denormal
+    pthread_t thread;
+    unsigned int applied = 0;
+    assert(rt_thread_create(&thread, &config, 0, probe_thread, &probe, &applied) == 0);
+    pthread_join(thread, NULL);
+    
+    if (applied & RT_THREAD_NO_DENORMALS) {
+        assert(probe.result == 0.0f);
+    } else {
+        assert(probe.result > 0.0f);
+    }
+    printf(" (%s)", (applied & RT_THREAD_NO_DENORMALS) ? "FTZ/DAZ" : "no FTZ on this CPU");
+}
+
+// Test 2: Nothing is claimed that wasn't asked for
+TEST(defaults) {
+    rt_config_t config;
+    rt_config_init(&config);
+    assert(config.priority == 0 && config.cpu == -1 && !config.lock_memory);
+    
+    probe_t probe = { .input = 1.0f };
+    pthread_t thread;
+    unsigned int applied = ~0u;
+    assert(rt_thread_create(&thread, &config, 0, probe_thread, &probe, &applied) == 0);
+    pthread_join(thread, NULL);
+    
+    assert(probe.result == 0.5f);
+    assert((applied & (RT_THREAD_REALTIME | RT_THREAD_PINNED)) == 0);
+}
+
+// Test 3: Consecutive indices land on consecutive cores, wrapping around
+TEST(pinning) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    rt_config_t config;
+    rt_config_init(&config);
+    config.cpu = 0;
+    
+    for (unsigned int index = 0; index < 3; index++) {
+        probe_t probe = { .input = 1.0f, .cpu = -1 };
+        pthread_t thread;
+        unsigned int applied;
+        assert(rt_thread_create(&thread, &config, index, probe_thread, &probe, &applied) == 0);
+        pthread_join(thread, NULL);
+        
+        // Pinning can be refused inside a restricted cpuset
+        if (applied & RT_THREAD_PINNED) {
+            assert(probe.cpu == (int)(index % online));
+        }
+    }
+}
+
+// Test 4: A refused priority still runs the thread, just not SCHED_FIFO
+TEST(priority) {
+    rt_config_t config;
+    rt_config_init(&config);
+    config.priority = 10;
+    
+    probe_t probe = { .input = 1.0f };
+    pthread_t thread;
+    unsigned int applied;
+    assert(rt_thread_create(&thread, &config, 0, probe_thread, &probe, &applied) == 0);
+    pthread_join(thread, NULL);
+    
+    assert(probe.result == 0.5f);
+    printf(" (%s)", (applied & RT_THREAD_REALTIME) ? "SCHED_FIFO" : "refused");
+}
+
+int main(void) {
+    printf("===== RT Thread Tests =====\n");
+    
+    RUN_TEST(flush_denormals);
+    RUN_TEST(defaults);
+    RUN_TEST(pinning);
+    RUN_TEST(priority);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
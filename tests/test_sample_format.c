@@ -0,0 +1,197 @@
+#include "../src/sample_format.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define SAMPLES 1027   // Not a multiple of any SIMD width, so the tails run too
+
+static const char *kernels[] = { "sse2", "neon", "scalar" };
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+static void fill_ramp(float *x, size_t samples, float amplitude) {
+    for (size_t i = 0; i < samples; i++) {
+        x[i] = amplitude * (2.0f * (float)i / (float)(samples - 1) - 1.0f);
+    }
+}
+
+// Test 1: Names, sizes and parsing
+TEST(names) {
+    assert(sample_format_bytes(SAMPLE_FORMAT_F32) == 4);
+    assert(sample_format_bytes(SAMPLE_FORMAT_S32) == 4);
+    assert(sample_format_bytes(SAMPLE_FORMAT_S24_3) == 3);
+    assert(sample_format_bytes(SAMPLE_FORMAT_S16) == 2);
+    assert(strcmp(sample_format_name(SAMPLE_FORMAT_S24_3), "S24_3LE") == 0);
+    
+    sample_format_t format;
+    assert(sample_format_parse("s16", &format) == 0 && format == SAMPLE_FORMAT_S16);
+    assert(sample_format_parse("s24", &format) == 0 && format == SAMPLE_FORMAT_S24_3);
+    assert(sample_format_parse("float", &format) == 0 && format == SAMPLE_FORMAT_F32);
+    assert(sample_format_parse("S16", &format) == -1);
+    assert(sample_format_select_kernel("scalar") == 0);
+    assert(strcmp(sample_format_kernel_name(), "scalar") == 0);
+    assert(sample_format_select_kernel("mmx") == -1);
+    sample_format_select_kernel(NULL);
+}
+
+// Test 2: Integer full scale maps to [-1, 1) exactly, and back
+TEST(exact_values) {
+    int16_t s16[4] = { -32768, -1, 0, 32767 };
+    float f[4];
+    sample_format_to_float(SAMPLE_FORMAT_S16, s16, f, 4);
+    assert(f[0] == -1.0f && f[1] == -1.0f / 32768.0f && f[2] == 0.0f);
+    assert(f[3] == 32767.0f / 32768.0f);
+    
+    int16_t back[4];
+    sample_format_from_float(SAMPLE_FORMAT_S16, f, back, 4, NULL);
+    assert(memcmp(s16, back, sizeof(s16)) == 0);
+    
+    // S24_3: little-endian, sign in the top bit of the third byte
+    uint8_t s24[9] = { 0x00, 0x00, 0x80,  0xff, 0xff, 0xff,  0xff, 0xff, 0x7f };
+    sample_format_to_float(SAMPLE_FORMAT_S24_3, s24, f, 3);
+    assert(f[0] == -1.0f && f[1] == -1.0f / 8388608.0f && f[2] == 8388607.0f / 8388608.0f);
+    uint8_t s24_back[9];
+    sample_format_from_float(SAMPLE_FORMAT_S24_3, f, s24_back, 3, NULL);
+    assert(memcmp(s24, s24_back, sizeof(s24)) == 0);
+    
+    int32_t s32[2] = { INT32_MIN, 1 << 30 };
+    sample_format_to_float(SAMPLE_FORMAT_S32, s32, f, 2);
+    assert(f[0] == -1.0f && f[1] == 0.5f);
+}
+
+// Test 3: Out-of-range floats saturate instead of wrapping
+TEST(saturate) {
+    float f[4] = { 2.0f, -2.0f, 1.0f, -1.0f };
+    int16_t s16[4];
+    sample_format_from_float(SAMPLE_FORMAT_S16, f, s16, 4, NULL);
+    assert(s16[0] == 32767 && s16[1] == -32768 && s16[2] == 32767 && s16[3] == -32768);
+    
+    int32_t s32[4];
+    sample_format_from_float(SAMPLE_FORMAT_S32, f, s32, 4, NULL);
+    assert(s32[0] > 2147483000 && s32[1] == INT32_MIN && s32[2] > 2147483000);
+    
+    uint8_t s24[12];
+    float g[4];
+    sample_format_from_float(SAMPLE_FORMAT_S24_3, f, s24, 4, NULL);
+    sample_format_to_float(SAMPLE_FORMAT_S24_3, s24, g, 4);
+    assert(g[0] == 8388607.0f / 8388608.0f && g[1] == -1.0f);
+}
+
+// Test 4: Every kernel gives the same bits, dithered or not, in any format
+TEST(kernels_agree) {
+    static const sample_format_t formats[] = {
+        SAMPLE_FORMAT_S16, SAMPLE_FORMAT_S24_3, SAMPLE_FORMAT_S32,
+    };
+    float *x = malloc(SAMPLES * sizeof(float));
+    fill_ramp(x, SAMPLES, 1.2f);
+    
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        size_t bytes = SAMPLES * sample_format_bytes(formats[f]);
+        unsigned char *ref = malloc(bytes);
+        unsigned char *out = malloc(bytes);
+        float *ref_back = malloc(SAMPLES * sizeof(float));
+        float *back = malloc(SAMPLES * sizeof(float));
+        
+        for (size_t k = 0; k < KERNEL_COUNT; k++) {
+            if (sample_format_select_kernel(kernels[k]) != 0) {
+                continue;
+            }
+            
+            // Two calls, so the dither state carries over between blocks
+            sample_dither_t dither;
+            sample_dither_init(&dither, 42);
+            size_t bps = sample_format_bytes(formats[f]);
+            sample_format_from_float(formats[f], x, out, 500, &dither);
+            sample_format_from_float(formats[f], &x[500], &out[500 * bps], SAMPLES - 500, &dither);
+            sample_format_to_float(formats[f], out, back, SAMPLES);
+            
+            if (strcmp(kernels[k], "scalar") == 0) {
+                continue;
+            }
+            sample_format_select_kernel("scalar");
+            sample_dither_init(&dither, 42);
+            sample_format_from_float(formats[f], x, ref, 500, &dither);
+            sample_format_from_float(formats[f], &x[500], &ref[500 * bps], SAMPLES - 500, &dither);
+            sample_format_to_float(formats[f], ref, ref_back, SAMPLES);
+            assert(memcmp(ref, out, bytes) == 0);
+            assert(memcmp(ref_back, back, SAMPLES * sizeof(float)) == 0);
+        }
+        
+        free(back);
+        free(ref_back);
+        free(out);
+        free(ref);
+    }
+    
+    sample_format_select_kernel(NULL);
+    free(x);
+}
+
+// Test 5: Dither is triangular within +/- 1 LSB and averages out
+TEST(dither) {
+    enum { N = 65536 };
+    float *x = malloc(N * sizeof(float));
+    float *y = malloc(N * sizeof(float));
+    int16_t *s16 = malloc(N * sizeof(int16_t));
+    
+    // A quarter LSB of DC: plain rounding loses it, dither keeps it on average
+    for (size_t i = 0; i < N; i++) {
+        x[i] = 0.25f / 32768.0f;
+    }
+    sample_format_from_float(SAMPLE_FORMAT_S16, x, s16, N, NULL);
+    for (size_t i = 0; i < N; i++) {
+        assert(s16[i] == 0);
+    }
+    
+    sample_dither_t dither;
+    sample_dither_init(&dither, 7);
+    sample_format_from_float(SAMPLE_FORMAT_S16, x, s16, N, &dither);
+    double sum = 0.0;
+    size_t zero = 0;
+    for (size_t i = 0; i < N; i++) {
+        assert(s16[i] >= -1 && s16[i] <= 1);
+        sum += s16[i];
+        zero += s16[i] == 0;
+    }
+    assert(fabs(sum / N - 0.25) < 0.02);
+    // Rounds to 0 for dither in (-0.75, 0.25): 0.71875 - 0.03125 of the triangle
+    assert(fabs((double)zero / N - 0.6875) < 0.02);
+    
+    // A full-scale signal round-trips to within one LSB plus dither
+    fill_ramp(x, N, 0.9f);
+    sample_format_from_float(SAMPLE_FORMAT_S16, x, s16, N, &dither);
+    sample_format_to_float(SAMPLE_FORMAT_S16, s16, y, N);
+    for (size_t i = 0; i < N; i++) {
+        assert(fabsf(y[i] - x[i]) <= 1.5f / 32768.0f);
+    }
+    
+    free(s16);
+    free(y);
+    free(x);
+}
+
+int main(void) {
+    printf("===== Sample Format Tests =====\n");
+    
+    RUN_TEST(names);
+    RUN_TEST(exact_values);
+    RUN_TEST(saturate);
+    RUN_TEST(kernels_agree);
+    RUN_TEST(dither);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
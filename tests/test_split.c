@@ -0,0 +1,224 @@
+#include "../src/split.h"
+#include "../src/effect_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "../src/dr_wav.h"
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IN_PATH "/tmp/test_split_in.wav"
+#define OUT_PATH "/tmp/test_split_out.wav"
+#define RATE 48000
+#define CHANNELS 2
+#define FRAMES (4 * SPLIT_MIN_SEGMENT_FRAMES + 777)
+
+/**
+ * A stereo sweep-ish signal with some silence and bursts, as 32-bit float
+ * (mapped) or 16-bit (decoded).
+ */
+static void write_input(bool as_float) {
+    float *samples = malloc(FRAMES * CHANNELS * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        double t = (double)i / RATE;
+        double level = (i / 20000) % 3 == 2 ? 0.05 : 0.8;
+        for (unsigned int c = 0; c < CHANNELS; c++) {
+            samples[i * CHANNELS + c] = (float)(level * sin(2.0 * M_PI * (60.0 + 400.0 * t) *
+                                                            (c + 1) * t));
+        }
+    }
+    
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = as_float ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels = CHANNELS;
+    format.sampleRate = RATE;
+    format.bitsPerSample = as_float ? 32 : 16;
+    assert(drwav_init_file_write(&wav, IN_PATH, &format, NULL));
+    if (as_float) {
+        drwav_write_pcm_frames(&wav, FRAMES, samples);
+    } else {
+        int16_t *pcm = malloc(FRAMES * CHANNELS * sizeof(int16_t));
+        drwav_f32_to_s16(pcm, samples, FRAMES * CHANNELS);
+        drwav_write_pcm_frames(&wav, FRAMES, pcm);
+        free(pcm);
+    }
+    drwav_uninit(&wav);
+    free(samples);
+}
+
+/**
+ * The file rendered serially by one graph, latency compensated as
+ * --stream does.
+ */
+static float* render_serial(const effect_chain_config_t *effects) {
+    unsigned int channels, rate;
+    drwav_uint64 total;
+    float *in = drwav_open_file_and_read_pcm_frames_f32(IN_PATH, &channels, &rate, &total, NULL);
+    assert(in && total == FRAMES);
+    
+    effect_graph_t *graph = effect_graph_from_config(effects, RATE, CHANNELS, 0);
+    size_t delay = effect_graph_latency(graph);
+    float *buffer = calloc((FRAMES + delay) * CHANNELS, sizeof(float));
+    memcpy(buffer, in, FRAMES * CHANNELS * sizeof(float));
+    effect_graph_process(graph, buffer, FRAMES + delay);
+    memmove(buffer, &buffer[delay * CHANNELS], FRAMES * CHANNELS * sizeof(float));
+    effect_graph_free(graph);
+    drwav_free(in, NULL);
+    return buffer;
+}
+
+static float* read_output(void) {
+    unsigned int channels, rate;
+    drwav_uint64 frames;
+    float *out = drwav_open_file_and_read_pcm_frames_f32(OUT_PATH, &channels, &rate, &frames,
+                                                         NULL);
+    assert(out && channels == CHANNELS && rate == RATE && frames == FRAMES);
+    return out;
+}
+
+static float max_difference(const float *a, const float *b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+        worst = fmaxf(worst, fabsf(a[i] - b[i]));
+    }
+    return worst;
+}
+
+// Test 1: A gain-only chain splits bit-identically, mapped or decoded
+TEST(stateless_exact) {
+    effect_chain_config_t effects = { .enabled = true, .gain_db = -4.5f };
+    for (int as_float = 0; as_float <= 1; as_float++) {
+        write_input(as_float);
+        split_config_t config;
+        split_config_init(&config);
+        config.input_file = IN_PATH;
+        config.output_file = OUT_PATH;
+        config.effects = effects;
+        config.workers = 4;
+        config.chunk_frames = 1000;
+        
+        split_stats_t stats;
+        assert(split_run(&config, &stats) == 0);
+        assert(stats.segments == 4 && stats.total_frames == FRAMES);
+        assert(stats.exact && stats.preroll_frames == 0 && stats.warmup_frames == 0);
+        
+        float *serial = render_serial(&effects);
+        float *split = read_output();
+        assert(memcmp(serial, split, FRAMES * CHANNELS * sizeof(float)) == 0);
+        free(serial);
+        drwav_free(split, NULL);
+    }
+}
+
+// Test 2: With state in the chain, the warm-up keeps the seams within the bound
+TEST(stateful_bounded) {
+    effect_chain_config_t effects = {
+        .enabled = true, .gain_db = 6.0f, .lowpass_freq = 6000.0f, .highpass_freq = 150.0f,
+        .filter_order = 4, .compress = true,
+        .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 5.0f,
+    };
+    write_input(true);
+    float *serial = render_serial(&effects);
+    
+    split_config_t config;
+    split_config_init(&config);
+    config.input_file = IN_PATH;
+    config.output_file = OUT_PATH;
+    config.effects = effects;
+    config.workers = 3;
+    
+    split_stats_t stats;
+    assert(split_run(&config, &stats) == 0);
+    assert(stats.segments == 3 && !stats.exact && stats.error_db <= SPLIT_ERROR_DB);
+    assert(stats.warmup_frames == 2 * stats.preroll_frames);
+    float *split = read_output();
+    float warm = max_difference(serial, split);
+    assert(warm < 1e-5f);   // -100 dB: the bound, a constant, and rounding
+    drwav_free(split, NULL);
+    
+    // A high-pass this close to DC amplifies its own float rounding: serial
+    // and split each carry that noise, so they only agree to about it
+    effects.highpass_freq = 30.0f;
+    float *low = render_serial(&effects);
+    config.effects = effects;
+    assert(split_run(&config, &stats) == 0);
+    split = read_output();
+    assert(max_difference(low, split) < 1e-3f);
+    drwav_free(split, NULL);
+    free(low);
+    effects.highpass_freq = 150.0f;
+    config.effects = effects;
+    
+    // Without the warm-up the seams show
+    config.preroll_ms = 0.0;
+    assert(split_run(&config, &stats) == 0);
+    assert(stats.error_db == 0.0 && stats.preroll_frames == 0);
+    split = read_output();
+    assert(max_difference(serial, split) > 100.0f * warm);
+    drwav_free(split, NULL);
+    free(serial);
+}
+
+// Test 3: The preroll asked of an error bound meets it, and no more
+TEST(preroll_bound) {
+    effect_chain_config_t gain = { .enabled = true, .gain_db = 3.0f };
+    assert(split_preroll_frames(&gain, RATE, -120.0) == 0);
+    assert(isinf(split_error_db(&gain, RATE, 0)));
+    
+    effect_chain_config_t filter = { .enabled = true, .highpass_freq = 20.0f, .filter_order = 8 };
+    size_t preroll = split_preroll_frames(&filter, RATE, -120.0);
+    assert(preroll > 0);
+    assert(split_error_db(&filter, RATE, preroll) <= -120.0);
+    assert(split_error_db(&filter, RATE, preroll - 1) > -120.0);
+    assert(split_preroll_frames(&filter, RATE, -60.0) < preroll);
+    
+    // The limiter's window must be inside the warm-up before anything is bounded
+    effect_chain_config_t limit = {
+        .enabled = true, .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 5.0f,
+    };
+    assert(split_error_db(&limit, RATE, 100) == 0.0);
+    assert(split_error_db(&limit, RATE, split_preroll_frames(&limit, RATE, -90.0)) <= -90.0);
+}
+
+// Test 4: A missing input fails cleanly
+TEST(missing_input) {
+    split_config_t config;
+    split_config_init(&config);
+    config.input_file = "/tmp/test_split_missing.wav";
+    config.output_file = OUT_PATH;
+    assert(split_run(&config, NULL) != 0);
+}
+
+int main(void) {
+    printf("===== Split Tests =====\n");
+    
+    RUN_TEST(stateless_exact);
+    RUN_TEST(stateful_bounded);
+    RUN_TEST(preroll_bound);
+    RUN_TEST(missing_input);
+    
+    remove(IN_PATH);
+    remove(OUT_PATH);
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
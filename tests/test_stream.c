@@ -0,0 +1,161 @@
+#include "../src/stream.h"
+#include "../src/effect_graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "../src/dr_wav.h"
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define IN_PATH "/tmp/test_stream_in.wav"
+#define OUT_PATH "/tmp/test_stream_out.wav"
+#define RATE 48000
+#define CHUNK 256
+#define FRAMES (200 * CHUNK + 123)  // Ends on a partial block
+
+static const effect_chain_config_t effects = {
+    .enabled = true, .gain_db = 6.0f, .lowpass_freq = 6000.0f, .highpass_freq = 80.0f,
+    .filter_order = 4, .compress = true,
+    .limit = true, .limit_ceiling_db = -1.0f, .limit_lookahead_ms = 2.0f,
+};
+
+/**
+ * A tone with bursts, as 32-bit float (mapped) or 16-bit (decoded).
+ */
+static void write_input(unsigned int channels, bool as_float) {
+    float *samples = malloc(FRAMES * channels * sizeof(float));
+    for (size_t i = 0; i < FRAMES; i++) {
+        double level = (i / 5000) % 3 == 2 ? 0.05 : 0.8;
+        for (unsigned int c = 0; c < channels; c++) {
+            samples[i * channels + c] = (float)(level * sin(2.0 * M_PI * 330.0 * (c + 1) *
+                                                            (double)i / RATE));
+        }
+    }
+    
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = as_float ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
+    format.channels = channels;
+    format.sampleRate = RATE;
+    format.bitsPerSample = as_float ? 32 : 16;
+    assert(drwav_init_file_write(&wav, IN_PATH, &format, NULL));
+    if (as_float) {
+        drwav_write_pcm_frames(&wav, FRAMES, samples);
+    } else {
+        int16_t *pcm = malloc(FRAMES * channels * sizeof(int16_t));
+        drwav_f32_to_s16(pcm, samples, FRAMES * channels);
+        drwav_write_pcm_frames(&wav, FRAMES, pcm);
+        free(pcm);
+    }
+    drwav_uninit(&wav);
+    free(samples);
+}
+
+/**
+ * The buffered path: the whole file through one graph in a single call,
+ * the latency flushed with silence and dropped from the front.
+ */
+static float* render_buffered(unsigned int channels) {
+    unsigned int got_channels, rate;
+    drwav_uint64 total;
+    float *in = drwav_open_file_and_read_pcm_frames_f32(IN_PATH, &got_channels, &rate, &total,
+                                                        NULL);
+    assert(in && got_channels == channels && total == FRAMES);
+    
+    effect_graph_t *graph = effect_graph_from_config(&effects, RATE, channels, 0);
+    size_t delay = effect_graph_latency(graph);
+    float *buffer = calloc((FRAMES + delay) * channels, sizeof(float));
+    memcpy(buffer, in, FRAMES * channels * sizeof(float));
+    effect_graph_process(graph, buffer, FRAMES + delay);
+    memmove(buffer, &buffer[delay * channels], FRAMES * channels * sizeof(float));
+    effect_graph_free(graph);
+    drwav_free(in, NULL);
+    return buffer;
+}
+
+static void count_progress(uint64_t processed, uint64_t total, void *ctx) {
+    uint64_t *last = ctx;
+    assert(processed >= *last && processed <= total);
+    *last = processed;
+}
+
+// Test 1: Streaming output is sample-identical to the buffered render, final
+// partial block included, mapped or decoded; three channels make the ring's
+// spans wrap at an odd frame
+TEST(matches_buffered) {
+    unsigned int layouts[] = { 2, 3 };
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        unsigned int channels = layouts[l];
+        for (int as_float = 0; as_float < 2; as_float++) {
+            write_input(channels, as_float);
+            float *expected = render_buffered(channels);
+            
+            uint64_t progress = 0;
+            stream_config_t config = {
+                .input_file = IN_PATH, .output_file = OUT_PATH, .map_input = true,
+                .effects = effects, .ring_frames = 4096, .chunk_frames = CHUNK,
+                .progress = count_progress, .progress_ctx = &progress,
+            };
+            wav_writer_config_init(&config.writer);
+            stream_stats_t stats;
+            assert(stream_run(&config, &stats) == 0);
+            assert(stats.input_mapped == (as_float == 1));
+            assert(stats.channels == channels && stats.sample_rate == RATE);
+            assert(stats.total_frames == FRAMES && stats.frames_processed >= FRAMES);
+            assert(progress == stats.frames_processed);
+            assert(stats.writer.frames_written == FRAMES && stats.writer.frames_dropped == 0);
+            
+            unsigned int got_channels, rate;
+            drwav_uint64 frames;
+            float *got = drwav_open_file_and_read_pcm_frames_f32(OUT_PATH, &got_channels, &rate,
+                                                                 &frames, NULL);
+            assert(got && got_channels == channels && rate == RATE && frames == FRAMES);
+            assert(memcmp(got, expected, FRAMES * channels * sizeof(float)) == 0);
+            drwav_free(got, NULL);
+            free(expected);
+            remove(OUT_PATH);
+        }
+    }
+}
+
+// Test 2: A missing input fails without writing anything
+TEST(missing_input) {
+    stream_config_t config = {
+        .input_file = "/tmp/test_stream_missing.wav", .output_file = OUT_PATH,
+        .effects = effects, .ring_frames = 4096, .chunk_frames = CHUNK,
+    };
+    wav_writer_config_init(&config.writer);
+    assert(stream_run(&config, NULL) != 0);
+    FILE *f = fopen(OUT_PATH, "rb");
+    assert(f == NULL);
+}
+
+int main(void) {
+    printf("===== Streaming Tests =====\n");
+    
+    RUN_TEST(matches_buffered);
+    RUN_TEST(missing_input);
+    
+    remove(IN_PATH);
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "../src/wav_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "../src/dr_wav.h"
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define WAV_PATH "/tmp/test_wav_io.wav"
+#define RATE 48000
+#define CHANNELS 3
+#define FRAMES 20
+
+static void write_file(const char *path, const float *samples, size_t frames) {
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = CHANNELS;
+    format.sampleRate = RATE;
+    format.bitsPerSample = 32;
+    assert(drwav_init_file_write(&wav, path, &format, NULL));
+    assert(drwav_write_pcm_frames(&wav, frames, samples) == frames);
+    drwav_uninit(&wav);
+}
+
+/**
+ * A wrapped span of frames frames over ring (RING_FRAMES frames): the last
+ * two frames, then the rest from the start.
+ */
+#define RING_FRAMES 11
+static frame_ring_span_t wrapped_span(float *ring, size_t frames) {
+    frame_ring_span_t span = { &ring[(RING_FRAMES - 2) * CHANNELS], 2, ring, frames - 2 };
+    return span;
+}
+
+// Test 1: Decoding into a wrapped span fills it in file order and stops
+// at the end of the file
+TEST(read_span_wrapped) {
+    float samples[FRAMES * CHANNELS];
+    for (size_t i = 0; i < FRAMES * CHANNELS; i++) {
+        samples[i] = (float)i;
+    }
+    write_file(WAV_PATH, samples, FRAMES);
+    
+    float ring[RING_FRAMES * CHANNELS];
+    drwav wav;
+    assert(drwav_init_file(&wav, WAV_PATH, NULL));
+    frame_ring_span_t span = wrapped_span(ring, 9);
+    assert(wav_io_read_span(&wav, &span) == 9);
+    for (size_t i = 0; i < 2 * CHANNELS; i++) {
+        assert(ring[27 + i] == (float)i);
+    }
+    for (size_t i = 2 * CHANNELS; i < 9 * CHANNELS; i++) {
+        assert(ring[i - 2 * CHANNELS] == (float)i);
+    }
+    
+    // 11 frames left: a second 9-frame span then a short one
+    assert(wav_io_read_span(&wav, &span) == 9);
+    assert(ring[27] == 27.0f && ring[0] == 33.0f);
+    assert(wav_io_read_span(&wav, &span) == 2);
+    assert(wav_io_read_span(&wav, &span) == 0);
+    drwav_uninit(&wav);
+    remove(WAV_PATH);
+}
+
+// Test 2: Encoding from a wrapped span writes count frames in order, and
+// a skipped span drops its head
+TEST(write_span_and_skip) {
+    float ring[RING_FRAMES * CHANNELS];
+    for (size_t i = 0; i < 2 * CHANNELS; i++) {
+        ring[27 + i] = (float)i;
+    }
+    for (size_t i = 2 * CHANNELS; i < 9 * CHANNELS; i++) {
+        ring[i - 2 * CHANNELS] = (float)i;
+    }
+    frame_ring_span_t span = wrapped_span(ring, 9);
+    size_t stride = CHANNELS * sizeof(float);
+    
+    drwav wav;
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = CHANNELS;
+    format.sampleRate = RATE;
+    format.bitsPerSample = 32;
+    assert(drwav_init_file_write(&wav, WAV_PATH, &format, NULL));
+    assert(wav_io_write_span(&wav, &span, 9) == 9);
+    
+    // Skip a frame into data2, then write the next 3 frames
+    frame_ring_span_t rest = span;
+    frame_ring_span_skip(&rest, 3, stride);
+    assert(rest.data1 == &ring[CHANNELS] && rest.frames1 == 6 && rest.frames2 == 0);
+    assert(wav_io_write_span(&wav, &rest, 3) == 3);
+    
+    // Skipping within data1 keeps the wrap; past the end empties the span
+    rest = span;
+    frame_ring_span_skip(&rest, 1, stride);
+    assert(rest.data1 == &ring[30] && rest.frames1 == 1 && rest.frames2 == 7);
+    frame_ring_span_skip(&rest, 20, stride);
+    assert(rest.frames1 == 0 && rest.frames2 == 0);
+    drwav_uninit(&wav);
+    
+    unsigned int channels, rate;
+    drwav_uint64 frames;
+    float *got = drwav_open_file_and_read_pcm_frames_f32(WAV_PATH, &channels, &rate, &frames,
+                                                         NULL);
+    assert(got && channels == CHANNELS && frames == 12);
+    for (size_t i = 0; i < 9 * CHANNELS; i++) {
+        assert(got[i] == (float)i);
+    }
+    for (size_t i = 0; i < 3 * CHANNELS; i++) {
+        assert(got[9 * CHANNELS + i] == (float)(i + 3 * CHANNELS));
+    }
+    drwav_free(got, NULL);
+    remove(WAV_PATH);
+}
+
+int main(void) {
+    printf("===== WAV I/O Tests =====\n");
+    
+    RUN_TEST(read_span_wrapped);
+    RUN_TEST(write_span_and_skip);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "../src/wav_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define PATH "/tmp/test_wav_map.wav"
+
+static void put_u16(FILE *f, uint16_t v) {
+    fputc(v & 0xff, f);
+    fputc(v >> 8, f);
+}
+
+static void put_u32(FILE *f, uint32_t v) {
+    put_u16(f, (uint16_t)v);
+    put_u16(f, (uint16_t)(v >> 16));
+}
+
+static float sample(size_t i) {
+    return (float)i / 1000.0f - 1.0f;
+}
+
+/**
+ * A WAV with frames frames of sample(i); extensible uses
+ * WAVE_FORMAT_EXTENSIBLE, pad puts a chunk of pad bytes (odd ones get the
+ * RIFF pad byte) before data, data_size overrides the data chunk's size.
+ */
+static void write_wav(uint16_t format, uint16_t bits, uint16_t channels, size_t frames,
+                      int extensible, uint32_t pad, uint32_t data_size) {
+    FILE *f = fopen(PATH, "wb");
+    assert(f);
+    uint16_t block_align = (uint16_t)(channels * bits / 8);
+    uint32_t data = (uint32_t)(frames * block_align);
+    
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 0);   // Nobody here looks at it
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, extensible ? 40 : 16);
+    put_u16(f, extensible ? 0xfffe : format);
+    put_u16(f, channels);
+    put_u32(f, 48000);
+    put_u32(f, 48000u * block_align);
+    put_u16(f, block_align);
+    put_u16(f, bits);
+    if (extensible) {
+        put_u16(f, 22);
+        put_u16(f, bits);
+        put_u32(f, 0);
+        put_u16(f, format);   // Subformat GUID: the format tag, then a fixed tail
+        for (int i = 0; i < 14; i++) fputc(0, f);
+    }
+    if (pad) {
+        fwrite("LIST", 1, 4, f);
+        put_u32(f, pad);
+        for (uint32_t i = 0; i < pad + (pad & 1); i++) fputc(0, f);
+    }
+    fwrite("data", 1, 4, f);
+    put_u32(f, data_size ? data_size : data);
+    for (size_t i = 0; i < frames * channels; i++) {
+        if (bits == 32) {
+            float v = sample(i);
+            fwrite(&v, sizeof(v), 1, f);
+        } else {
+            put_u16(f, (uint16_t)i);
+        }
+    }
+    fclose(f);
+}
+
+// Test 1: A float file maps, and reads walk it in order
+TEST(read_float) {
+    enum { FRAMES = 5000 };
+    write_wav(3, 32, 2, FRAMES, 0, 0, 0);
+    
+    wav_map_t map;
+    assert(wav_map_open(&map, PATH) == 0);
+    assert(map.channels == 2 && map.sample_rate == 48000 && map.total_frames == FRAMES);
+    
+    size_t done = 0, got;
+    while (true) {
+        const float *p = wav_map_read(&map, 777, &got);
+        if (got == 0) break;
+        for (size_t i = 0; i < got * 2; i++) {
+            assert(p[i] == sample(done * 2 + i));
+        }
+        done += got;
+        assert(wav_map_frames_left(&map) == FRAMES - done);
+    }
+    assert(done == FRAMES);
+    wav_map_close(&map);
+    remove(PATH);
+}
+
+// Test 2: WAVE_FORMAT_EXTENSIBLE and chunks before data are followed
+TEST(extensible_and_chunks) {
+    write_wav(3, 32, 1, 100, 1, 7, 0);   // 7 and a pad byte
+    wav_map_t map;
+    assert(wav_map_open(&map, PATH) == 0);
+    size_t got;
+    const float *p = wav_map_read(&map, 1000, &got);
+    assert(got == 100 && p[0] == sample(0) && p[99] == sample(99));
+    wav_map_close(&map);
+    
+    // A chunk of 6 bytes leaves data misaligned for floats: left to dr_wav
+    write_wav(3, 32, 1, 100, 0, 6, 0);
+    assert(wav_map_open(&map, PATH) == -1);
+    remove(PATH);
+}
+
+// Test 3: Integer PCM and missing files are refused
+TEST(refused) {
+    wav_map_t map;
+    write_wav(1, 16, 2, 100, 0, 0, 0);
+    assert(wav_map_open(&map, PATH) == -1);
+    write_wav(1, 32, 2, 100, 0, 0, 0);   // 32-bit integer
+    assert(wav_map_open(&map, PATH) == -1);
+    remove(PATH);
+    assert(wav_map_open(&map, PATH) == -1);
+}
+
+// Test 4: A data size past the end of the file (never patched) is clamped
+TEST(unpatched_size) {
+    write_wav(3, 32, 2, 300, 0, 0, 0xffffffff);
+    wav_map_t map;
+    assert(wav_map_open(&map, PATH) == 0);
+    assert(map.total_frames == 300);
+    wav_map_close(&map);
+    remove(PATH);
+}
+
+int main(void) {
+    printf("===== WAV Map Tests =====\n");
+    
+    RUN_TEST(read_float);
+    RUN_TEST(extensible_and_chunks);
+    RUN_TEST(refused);
+    RUN_TEST(unpatched_size);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "../src/wav_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+// Test utilities
+#define TEST(name) \
+    static void test_##name(); \
+    static void run_test_##name() { \
+        printf("Running: %s...", #name); \
+        test_##name(); \
+        printf(" PASSED\n"); \
+    } \
+    static void test_##name()
+
+#define RUN_TEST(name) run_test_##name()
+
+#define PATH "/tmp/test_wav_writer.wav"
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t get_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static unsigned char* read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = malloc(*size);
+    assert(fread(data, 1, *size, f) == *size);
+    fclose(f);
+    return data;
+}
+
+static void check_header(const unsigned char *h, size_t size, uint16_t tag, unsigned int channels,
+                         unsigned int rate, unsigned int bits) {
+    assert(memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVEfmt ", 8) == 0);
+    assert(get_u32(h + 4) == size - 8);
+    assert(get_u16(h + 20) == tag);
+    assert(get_u16(h + 22) == channels);
+    assert(get_u32(h + 24) == rate);
+    assert(get_u16(h + 32) == channels * bits / 8);
+    assert(get_u16(h + 34) == bits);
+    assert(memcmp(h + 36, "data", 4) == 0);
+    assert(get_u32(h + 40) == size - WAV_WRITER_HEADER_BYTES);
+}
+
+static float test_signal(size_t i) {
+    return 0.8f * sinf((float)i * 0.01f);
+}
+
+// Writes frames of test_signal in uneven pieces
+static void write_signal(wav_writer_t *w, unsigned int channels, size_t frames) {
+    float *x = malloc(frames * channels * sizeof(float));
+    for (size_t i = 0; i < frames * channels; i++) {
+        x[i] = test_signal(i);
+    }
+    size_t done = 0;
+    size_t piece = 1;
+    while (done < frames) {
+        size_t n = frames - done < piece ? frames - done : piece;
+        assert(wav_writer_write(w, &x[done * channels], n) == n);
+        done += n;
+        piece = piece * 3 % 1013 + 1;
+    }
+    free(x);
+}
+
+// Test 1: Float samples reach the file bit for bit behind a valid header
+TEST(float_round_trip) {
+    enum { FRAMES = 100000 };
+    wav_writer_config_t config;
+    wav_writer_config_init(&config);
+    config.block = true;
+    config.queue_frames = 4096;     // Much less than the file, so the producer waits
+    config.chunk_bytes = 16384;
+    wav_writer_t *w = wav_writer_open(PATH, 2, 48000, &config);
+    assert(w);
+    write_signal(w, 2, FRAMES);
+    
+    wav_writer_stats_t stats;
+    assert(wav_writer_close(w, &stats) == 0);
+    assert(stats.frames_written == FRAMES && stats.frames_dropped == 0 && !stats.failed);
+    assert(stats.bytes == WAV_WRITER_HEADER_BYTES + FRAMES * 2 * sizeof(float));
+    
+    size_t size;
+    unsigned char *data = read_file(PATH, &size);
+    assert(size == stats.bytes);
+    check_header(data, size, 3, 2, 48000, 32);
+    const unsigned char *samples = data + WAV_WRITER_HEADER_BYTES;
+    for (size_t i = 0; i < FRAMES * 2; i++) {
+        float v;
+        memcpy(&v, samples + i * sizeof(float), sizeof(float));
+        assert(v == test_signal(i));
+    }
+    free(data);
+    remove(PATH);
+}
+
+// Test 2: Integer formats are PCM, dithered to within a couple of LSBs
+TEST(integer_formats) {
+    enum { FRAMES = 20000 };
+    static const sample_format_t formats[] = { SAMPLE_FORMAT_S16, SAMPLE_FORMAT_S24_3 };
+    
+    for (size_t f = 0; f < 2; f++) {
+        wav_writer_config_t config;
+        wav_writer_config_init(&config);
+        config.format = formats[f];
+        config.block = true;
+        wav_writer_t *w = wav_writer_open(PATH, 1, 44100, &config);
+        assert(w);
+        write_signal(w, 1, FRAMES);
+        assert(wav_writer_close(w, NULL) == 0);
+        
+        size_t size;
+        unsigned char *data = read_file(PATH, &size);
+        size_t bytes = sample_format_bytes(formats[f]);
+        assert(size == WAV_WRITER_HEADER_BYTES + FRAMES * bytes);
+        check_header(data, size, 1, 1, 44100, (unsigned int)bytes * 8);
+        
+        float *back = malloc(FRAMES * sizeof(float));
+        sample_format_to_float(formats[f], data + WAV_WRITER_HEADER_BYTES, back, FRAMES);
+        float lsb = formats[f] == SAMPLE_FORMAT_S16 ? 1.0f / 32768.0f : 1.0f / 8388608.0f;
+        for (size_t i = 0; i < FRAMES; i++) {
+            assert(fabsf(back[i] - test_signal(i)) <= 1.5f * lsb);
+        }
+        free(back);
+        free(data);
+    }
+    remove(PATH);
+}
+
+// Test 3: A full ring drops whole frames and counts them, never blocks
+TEST(drops_when_full) {
+    enum { FRAMES = 1 << 20, PIECE = 4096 };
+    wav_writer_config_t config;
+    wav_writer_config_init(&config);
+    config.queue_frames = 512;
+    wav_writer_t *w = wav_writer_open(PATH, 2, 48000, &config);
+    assert(w);
+    
+    float *x = calloc(PIECE * 2, sizeof(float));
+    uint64_t queued = 0;
+    for (size_t done = 0; done < FRAMES; done += PIECE) {
+        queued += wav_writer_write(w, x, PIECE);
+    }
+    free(x);
+    
+    wav_writer_stats_t stats;
+    assert(wav_writer_close(w, &stats) == -1);
+    assert(stats.frames_dropped > 0 && !stats.failed);
+    assert(stats.frames_written == queued);
+    assert(stats.frames_written + stats.frames_dropped == FRAMES);
+    assert(stats.queue_high_water <= 512);
+    
+    size_t size;
+    unsigned char *data = read_file(PATH, &size);
+    check_header(data, size, 3, 2, 48000, 32);
+    assert(size == WAV_WRITER_HEADER_BYTES + queued * 2 * sizeof(float));
+    free(data);
+    remove(PATH);
+}
+
+// Test 4: O_DIRECT and io_uring (where granted) leave the same file, with
+// the last chunk's padding cut back off
+TEST(direct_and_io_uring) {
+    enum { FRAMES = 30001 };
+    for (int mode = 0; mode < 4; mode++) {
+        wav_writer_config_t config;
+        wav_writer_config_init(&config);
+        config.block = true;
+        config.chunk_bytes = WAV_WRITER_ALIGN;
+        config.direct = mode & 1;
+        config.io_uring = mode & 2;
+        config.sync = WAV_WRITER_SYNC_PERIODIC;
+        config.sync_bytes = 64 * 1024;
+        wav_writer_t *w = wav_writer_open(PATH, 3, 48000, &config);
+        assert(w);
+        write_signal(w, 3, FRAMES);
+        
+        wav_writer_stats_t stats;
+        assert(wav_writer_close(w, &stats) == 0);
+        assert(stats.frames_written == FRAMES);
+        
+        size_t size;
+        unsigned char *data = read_file(PATH, &size);
+        assert(size == WAV_WRITER_HEADER_BYTES + FRAMES * 3 * sizeof(float));
+        check_header(data, size, 3, 3, 48000, 32);
+        for (size_t i = 0; i < FRAMES * 3; i += 7) {
+            float v;
+            memcpy(&v, data + WAV_WRITER_HEADER_BYTES + i * sizeof(float), sizeof(float));
+            assert(v == test_signal(i));
+        }
+        free(data);
+    }
+    remove(PATH);
+}
+
+// Test 5: A wrapped frame ring span is queued in order
+TEST(write_span) {
+    enum { CAPACITY = 16, CHANNELS = 3 };
+    frame_ring_t *ring = frame_ring_f32_create(CAPACITY, CHANNELS, NULL);
+    float x[CAPACITY * CHANNELS];
+    
+    // Start 12 frames in, so 4 of the 10 frames sit before the wrap
+    for (size_t i = 0; i < 12 * CHANNELS; i++) x[i] = 0.0f;
+    frame_ring_f32_write(ring, x, 12);
+    frame_ring_f32_read(ring, x, 12);
+    for (size_t i = 0; i < 30; i++) x[i] = test_signal(i);
+    frame_ring_f32_write(ring, x, 10);
+    frame_ring_span_t span;
+    assert(frame_ring_read_acquire(ring, 10, &span) == 10 && span.frames1 == 4);
+    
+    wav_writer_config_t config;
+    wav_writer_config_init(&config);
+    config.block = true;
+    wav_writer_t *w = wav_writer_open(PATH, CHANNELS, 48000, &config);
+    assert(w);
+    assert(wav_writer_write_span(w, &span, 10) == 10);
+    frame_ring_read_release(ring, 10);
+    assert(wav_writer_close(w, NULL) == 0);
+    
+    size_t size;
+    unsigned char *data = read_file(PATH, &size);
+    assert(size == WAV_WRITER_HEADER_BYTES + 30 * sizeof(float));
+    for (size_t i = 0; i < 30; i++) {
+        float v;
+        memcpy(&v, data + WAV_WRITER_HEADER_BYTES + i * sizeof(float), sizeof(float));
+        assert(v == test_signal(i));
+    }
+    free(data);
+    frame_ring_free(ring);
+    remove(PATH);
+}
+
+int main(void) {
+    printf("===== WAV Writer Tests =====\n");
+    
+    RUN_TEST(float_round_trip);
+    RUN_TEST(integer_formats);
+    RUN_TEST(drops_when_full);
+    RUN_TEST(direct_and_io_uring);
+    RUN_TEST(write_span);
+    
+    printf("\n✓ All tests passed!\n");
+    return 0;
+}